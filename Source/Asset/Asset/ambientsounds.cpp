@@ -103,6 +103,10 @@ const char* AmbientSound::GetLoadErrorString() {
     }
 }
 
+size_t AmbientSound::GetResidentBytes() {
+    return sizeof(AmbientSound) + path_.capacity() + sound_path.capacity();
+}
+
 void AmbientSound::ReportLoad() {
 }
 
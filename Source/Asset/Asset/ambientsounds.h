@@ -58,6 +58,7 @@ class AmbientSound : public AssetInfo {
 
     void Reload();
     void ReportLoad() override;
+    size_t GetResidentBytes() override;
 
     float GetDelayNoLower();
     void ReturnPaths(PathSet& path_set) override;
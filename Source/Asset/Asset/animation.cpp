@@ -43,14 +43,17 @@
 
 #include <Graphics/retargetfile.h>
 #include <Graphics/models.h>
+#include <Graphics/bonetransformblend.h>
 
 #include <Logging/logdata.h>
 #include <Main/engine.h>
+#include <Threading/thread_sanity.h>
 #include <Utility/assert.h>
 
 #include <algorithm>
 #include <cmath>
 #include <cassert>
+#include <set>
 #include <sstream>
 
 using std::endl;
@@ -133,40 +136,6 @@ static void SwitchStringRL(string& the_string) {
     LOGD << "New string: " << the_string << endl;
 }
 
-void Animation::CalcInvertBoneMats() {
-    size_t num_keyframes = keyframes.size();
-    for (size_t i = 0; i < num_keyframes; i++) {
-        Keyframe& k = keyframes[i];
-        vector<BoneTransform>& bm = k.bone_mats;
-        vector<BoneTransform>& ibm = k.invert_bone_mats;
-        size_t num_bones = bm.size();
-        ibm.resize(num_bones);
-        for (int j = 0; j < num_bones; j++) {
-            ibm[j] = invert(bm[j]);
-        }
-    }
-}
-
-void Animation::UpdateIKBones() {
-    for (auto& k : keyframes) {
-        // Initialize uses_ik vector
-        size_t num_bones = k.bone_mats.size();
-        k.uses_ik.resize(num_bones);
-        for (size_t i = 0; i < num_bones; i++) {
-            k.uses_ik[i] = false;
-        }
-        // Travel down each ik chain to specify that each bone uses ik
-        size_t num_ik_bones = k.ik_bones.size();
-        for (size_t i = 0; i < num_ik_bones; i++) {
-            const BonePath& bone_path = k.ik_bones[i].bone_path;
-            size_t bone_path_len = bone_path.size();
-            for (int j = 0; j < bone_path_len; j++) {
-                k.uses_ik[bone_path[j]] = true;
-            }
-        }
-    }
-}
-
 void Animation::WriteToFile(FILE* file) {
     int version = _animation_version;
     fwrite(&version, sizeof(int), 1, file);
@@ -180,27 +149,29 @@ void Animation::WriteToFile(FILE* file) {
     ;
     fwrite(&num_keyframes, sizeof(int), 1, file);
 
-    for (auto& keyframe : keyframes) {
+    for (int i = 0; i < num_keyframes; i++) {
+        const Keyframe& keyframe = keyframes[i];
         fwrite(&keyframe.time, sizeof(int), 1, file);
 
-        size_t num_weights = keyframe.weights.size();
+        int num_weights = tracks.num_weight_tracks();
         fwrite(&num_weights, sizeof(int), 1, file);
-        if (num_weights) {
-            fwrite(&keyframe.weights[0], sizeof(float), num_weights, file);
+        for (int j = 0; j < num_weights; j++) {
+            float weight = tracks.GetWeight(i, j);
+            fwrite(&weight, sizeof(float), 1, file);
         }
 
-        int num_bone_mats = (int)keyframe.bone_mats.size();
+        int num_weapon_mats = (int)keyframe.weapon_relative_id.size();
+        int num_bone_mats = tracks.num_transform_tracks() - num_weapon_mats;
         fwrite(&num_bone_mats, sizeof(int), 1, file);
         mat4 temp;
-        for (unsigned j = 0; j < keyframe.bone_mats.size(); j++) {
-            temp = keyframe.bone_mats[j].GetMat4();
+        for (int j = 0; j < num_bone_mats; j++) {
+            temp = tracks.GetTransform(i, j).GetMat4();
             fwrite(&temp.entries, sizeof(float), 16, file);
         }
 
-        int num_weapon_mats = (int)keyframe.weapon_mats.size();
         fwrite(&num_weapon_mats, sizeof(int), 1, file);
-        for (unsigned j = 0; j < keyframe.weapon_mats.size(); j++) {
-            temp = keyframe.weapon_mats[j].GetMat4();
+        for (int j = 0; j < num_weapon_mats; j++) {
+            temp = tracks.GetTransform(i, num_bone_mats + j).GetMat4();
             fwrite(&temp.entries, sizeof(float), 16, file);
             fwrite(&keyframe.weapon_relative_id[j], sizeof(int), 1, file);
             fwrite(&keyframe.weapon_relative_weight[j], sizeof(float), 1, file);
@@ -357,19 +328,38 @@ void Animation::Center() {
         last_offset = k.center_offset;
         k.center_offset = new_co;
     }
-    RecalcCaches();
+}
+
+// ref keeps the skeleton loaded when there is no RetargetSkeletons to hold it
+static const SkeletonFileData* GetRetargetSkeleton(const AnimInput& anim_input, const string& path, SkeletonAssetRef& ref) {
+    if (anim_input.retarget_skeletons) {
+        return anim_input.retarget_skeletons->Get(path);
+    }
+    ref = Engine::Instance()->GetAssetManager()->LoadSync<SkeletonAsset>(path);
+    return &ref->GetData();
 }
 
 void Retarget(const AnimInput& anim_input, AnimOutput& anim_output, const string& old_path) {
     PROFILER_ZONE(g_profiler_ctx, "Retargeting");
-    PROFILER_ENTER(g_profiler_ctx, "Get SkeletonAssetRefs");
-    SkeletonAssetRef old_sar = Engine::Instance()->GetAssetManager()->LoadSync<SkeletonAsset>(old_path);
-    SkeletonAssetRef new_sar = Engine::Instance()->GetAssetManager()->LoadSync<SkeletonAsset>(anim_input.retarget_new);
-    PROFILER_LEAVE(g_profiler_ctx);
     PROFILER_ENTER(g_profiler_ctx, "Get SkeletonFileData");
-    const SkeletonFileData& old_data = old_sar->GetData();
-    const SkeletonFileData& new_data = new_sar->GetData();
+    SkeletonAssetRef old_sar, new_sar, mirror_sar;
+    const SkeletonFileData* old_data_ptr = GetRetargetSkeleton(anim_input, old_path, old_sar);
+    const SkeletonFileData* new_data_ptr = GetRetargetSkeleton(anim_input, anim_input.retarget_new, new_sar);
+    const SkeletonFileData* mirror_data_ptr = NULL;
+    if (anim_input.mirrored) {
+        mirror_data_ptr = GetRetargetSkeleton(anim_input, AnimationRetargeter::Instance()->GetSkeletonFile(anim_input.retarget_new), mirror_sar);
+    }
     PROFILER_LEAVE(g_profiler_ctx);
+    if (!old_data_ptr || !new_data_ptr || (anim_input.mirrored && !mirror_data_ptr)) {
+        // Keep the bone count the character expects, even though the pose is off
+        if (anim_input.parents) {
+            anim_output.matrices.resize(anim_input.parents->size());
+            anim_output.physics_weights.resize(anim_input.parents->size());
+        }
+        return;
+    }
+    const SkeletonFileData& old_data = *old_data_ptr;
+    const SkeletonFileData& new_data = *new_data_ptr;
     // Add bones that don't exist in original skeleton
     anim_output.matrices.resize(new_data.bone_mats.size());
     anim_output.physics_weights.resize(new_data.bone_mats.size());
@@ -501,10 +491,7 @@ void Retarget(const AnimInput& anim_input, AnimOutput& anim_output, const string
 
     if (anim_input.mirrored) {
         PROFILER_ZONE(g_profiler_ctx, "Mirror animation");
-        SkeletonAssetRef sar = Engine::Instance()->GetAssetManager()->LoadSync<SkeletonAsset>(AnimationRetargeter::Instance()->GetSkeletonFile(anim_input.retarget_new));
-        // SkeletonAssets::Instance()->ReturnRef(AnimationRetargeter::Instance()->GetSkeletonFile(anim_input.retarget_new));
-
-        const SkeletonFileData& skeleton_file_data = sar->GetData();
+        const SkeletonFileData& skeleton_file_data = *mirror_data_ptr;
         const vector<int>& symmetry = skeleton_file_data.symmetry;
 
         // Mirror all rotations
@@ -811,10 +798,21 @@ int Animation::ReadFromFile(FILE* file) {
         }
     }
 
+    keyframes_in_order = true;
+    for (size_t i = 1; i < keyframes.size(); ++i) {
+        if (keyframes[i].time < keyframes[i - 1].time) {
+            LOGW << "Keyframes are out of order in animation " << path_ << endl;
+            keyframes_in_order = false;
+            break;
+        }
+    }
+
     if (!centered) {
         Center();
-    } else {
-        RecalcCaches();
+    }
+    if (!PackTracks()) {
+        sub_error = 2;
+        return kLoadErrorCorruptFile;
     }
 
     return kLoadOk;
@@ -850,205 +848,224 @@ BoneTransform BlendFourBones(BoneTransform* transforms, float* weights) {
     return transform;
 }
 
-AnimOutput mix(const AnimOutput& a, const AnimOutput& b, float alpha) {
+WeapAnimInfo* WeapAnimInfoMap::find(int item_id) {
+    for (int i = 0; i < num_entries_; ++i) {
+        if (entries_[i].item_id == item_id) {
+            return &entries_[i].info;
+        }
+    }
+    return NULL;
+}
+
+const WeapAnimInfo* WeapAnimInfoMap::find(int item_id) const {
+    return const_cast<WeapAnimInfoMap*>(this)->find(item_id);
+}
+
+WeapAnimInfo* WeapAnimInfoMap::insert(int item_id) {
+    int index = 0;
+    while (index < num_entries_ && entries_[index].item_id < item_id) {
+        ++index;
+    }
+    if (index < num_entries_ && entries_[index].item_id == item_id) {
+        return &entries_[index].info;
+    }
+    if (num_entries_ == kCapacity) {
+        LOGW_ONCE("Too many animated items to blend, ignoring the rest");
+        return NULL;
+    }
+    for (int i = num_entries_; i > index; --i) {
+        entries_[i] = entries_[i - 1];
+    }
+    entries_[index].item_id = item_id;
+    entries_[index].info = WeapAnimInfo();
+    ++num_entries_;
+    return &entries_[index].info;
+}
+
+static const string& BlendLabel(const BlendedBonePath& blend) {
+    return blend.ik_bone.label;
+}
+
+static const string& BlendLabel(const ShapeKeyBlend& blend) {
+    return blend.label;
+}
+
+static const string& BlendLabel(const StatusKeyBlend& blend) {
+    return blend.label;
+}
+
+// Index of the blend with this label among the first num_blends, or -1
+template <typename T>
+static int FindBlend(const ReusableVector<T>& blends, size_t num_blends, const string& label) {
+    for (size_t i = 0; i < num_blends; ++i) {
+        if (BlendLabel(blends[i]) == label) {
+            return (int)i;
+        }
+    }
+    return -1;
+}
+
+template <typename T>
+static bool BlendLabelLess(const T& a, const T& b) {
+    return BlendLabel(a) < BlendLabel(b);
+}
+
+// Blends used to be merged through a map, keep them in the order it gave them
+template <typename T>
+static void SortBlends(ReusableVector<T>& blends) {
+    sort(blends.begin(), blends.end(), BlendLabelLess<T>);
+}
+
+void mix_in_place(AnimOutput& a, const AnimOutput& b, float alpha) {
     LOG_ASSERT(a.matrices.size() == b.matrices.size());
 
-    AnimOutput result;
     size_t num_bones = a.matrices.size();
-    result.matrices.resize(num_bones);
-    for (unsigned i = 0; i < num_bones; i++) {
-        result.matrices[i] = mix(a.matrices[i], b.matrices[i], alpha);
+    if (num_bones > 0) {
+        BlendBoneTransforms(&a.matrices[0], &b.matrices[0], num_bones, alpha);
     }
-    result.center_offset = mix(a.center_offset, b.center_offset, alpha);
-    result.rotation = mix(a.rotation, b.rotation, alpha);
-    result.delta_offset = mix(a.delta_offset, b.delta_offset, alpha);
-    result.delta_rotation = mix(a.delta_rotation, b.delta_rotation, alpha);
+    a.center_offset = mix(a.center_offset, b.center_offset, alpha);
+    a.rotation = mix(a.rotation, b.rotation, alpha);
+    a.delta_offset = mix(a.delta_offset, b.delta_offset, alpha);
+    a.delta_rotation = mix(a.delta_rotation, b.delta_rotation, alpha);
 
-    size_t num_weapon_bones = max(a.weapon_matrices.size(),
+    size_t num_a_weapon_bones = a.weapon_matrices.size();
+    size_t num_weapon_bones = max(num_a_weapon_bones,
                                   b.weapon_matrices.size());
-    result.weapon_matrices.resize(num_weapon_bones);
-    result.weapon_weights.resize(num_weapon_bones);
-    result.weapon_weight_weights.resize(num_weapon_bones);
-    result.weapon_relative_ids.resize(num_weapon_bones);
-    result.weapon_relative_weights.resize(num_weapon_bones);
+    a.weapon_matrices.resize(num_weapon_bones);
+    a.weapon_weights.resize(num_weapon_bones);
+    a.weapon_weight_weights.resize(num_weapon_bones);
+    a.weapon_relative_ids.resize(num_weapon_bones);
+    a.weapon_relative_weights.resize(num_weapon_bones);
     for (size_t i = 0; i < num_weapon_bones; i++) {
         if (i >= b.weapon_matrices.size()) {
-            result.weapon_matrices[i] = a.weapon_matrices[i];
-            result.weapon_weights[i] = a.weapon_weights[i] * (1.0f - alpha);
-            result.weapon_weight_weights[i] = a.weapon_weight_weights[i] * (1.0f - alpha);
-            result.weapon_relative_ids[i] = a.weapon_relative_ids[i];
-            result.weapon_relative_weights[i] = a.weapon_relative_weights[i];
-        } else if (i >= a.weapon_matrices.size()) {
-            result.weapon_matrices[i] = b.weapon_matrices[i];
-            result.weapon_weights[i] = b.weapon_weights[i] * alpha;
-            result.weapon_weight_weights[i] = b.weapon_weight_weights[i] * alpha;
-            result.weapon_relative_ids[i] = b.weapon_relative_ids[i];
-            result.weapon_relative_weights[i] = b.weapon_relative_weights[i];
+            a.weapon_weights[i] *= 1.0f - alpha;
+            a.weapon_weight_weights[i] *= 1.0f - alpha;
+        } else if (i >= num_a_weapon_bones) {
+            a.weapon_matrices[i] = b.weapon_matrices[i];
+            a.weapon_weights[i] = b.weapon_weights[i] * alpha;
+            a.weapon_weight_weights[i] = b.weapon_weight_weights[i] * alpha;
+            a.weapon_relative_ids[i] = b.weapon_relative_ids[i];
+            a.weapon_relative_weights[i] = b.weapon_relative_weights[i];
         } else {
-            result.weapon_matrices[i] =
+            a.weapon_matrices[i] =
                 mix(a.weapon_matrices[i], b.weapon_matrices[i], alpha);
-            result.weapon_weights[i] =
+            a.weapon_weights[i] =
                 mix(a.weapon_weights[i], b.weapon_weights[i], alpha);
-            result.weapon_weight_weights[i] =
+            a.weapon_weight_weights[i] =
                 mix(a.weapon_weight_weights[i], b.weapon_weight_weights[i], alpha);
-            result.weapon_relative_ids[i] = max(a.weapon_relative_ids[i], b.weapon_relative_ids[i]);
-            result.weapon_relative_weights[i] = a.weapon_relative_weights[i];
+            a.weapon_relative_ids[i] = max(a.weapon_relative_ids[i], b.weapon_relative_ids[i]);
         }
     }
 
     // Add ik bone paths from both sources, and adjust their weights
     {
-        map<string, BlendedBonePath> ik_bones;
-        map<string, BlendedBonePath>::iterator iter;
-
-        for (const auto& ik_bone : a.ik_bones) {
-            const string& label = ik_bone.ik_bone.label;
-            ik_bones[label] = ik_bone;
-            ik_bones[label].weight *= 1.0f - alpha;
+        size_t num_a_ik_bones = a.ik_bones.size();
+        for (auto& ik_bone : a.ik_bones) {
+            ik_bone.weight *= 1.0f - alpha;
         }
 
         for (const auto& ik_bone : b.ik_bones) {
-            const string& label = ik_bone.ik_bone.label;
-            iter = ik_bones.find(label);
-            if (iter == ik_bones.end()) {
-                ik_bones[label] = ik_bone;
-                ik_bones[label].weight *= alpha;
+            int index = FindBlend(a.ik_bones, num_a_ik_bones, ik_bone.ik_bone.label);
+            if (index == -1) {
+                a.ik_bones.push_back(ik_bone);
+                a.ik_bones.back().weight *= alpha;
             } else {
-                ik_bones[label].weight = ik_bones[label].weight + ik_bone.weight * alpha;
-                ik_bones[label].transform = mix(ik_bones[label].transform, ik_bone.transform, alpha);
+                BlendedBonePath& a_ik_bone = a.ik_bones[index];
+                a_ik_bone.weight = a_ik_bone.weight + ik_bone.weight * alpha;
+                a_ik_bone.transform = mix(a_ik_bone.transform, ik_bone.transform, alpha);
             }
         }
-
-        result.ik_bones.resize(ik_bones.size());
-        iter = ik_bones.begin();
-        int index = 0;
-        for (; iter != ik_bones.end(); ++iter) {
-            result.ik_bones[index++] = (*iter).second;
-        }
+        SortBlends(a.ik_bones);
     }
 
-    size_t num_joints = max(a.physics_weights.size(), b.physics_weights.size());
-    size_t min_num_joints = min(a.physics_weights.size(), b.physics_weights.size());
-    result.physics_weights.resize(num_joints, 1.0f);
+    size_t num_a_joints = a.physics_weights.size();
+    size_t num_joints = max(num_a_joints, b.physics_weights.size());
+    size_t min_num_joints = min(num_a_joints, b.physics_weights.size());
+    a.physics_weights.resize(num_joints, 1.0f);
 
-    if (a.physics_weights.empty()) {
+    if (num_a_joints == 0) {
         for (unsigned i = 0; i < num_joints; i++) {
-            result.physics_weights[i] = mix(1.0f,
-                                            b.physics_weights[i],
-                                            alpha);
+            a.physics_weights[i] = mix(1.0f,
+                                       b.physics_weights[i],
+                                       alpha);
         }
     } else if (b.physics_weights.empty()) {
         for (unsigned i = 0; i < num_joints; i++) {
-            result.physics_weights[i] = mix(a.physics_weights[i],
-                                            1.0f,
-                                            alpha);
+            a.physics_weights[i] = mix(a.physics_weights[i],
+                                       1.0f,
+                                       alpha);
         }
     } else {
         for (unsigned i = 0; i < min_num_joints; i++) {
-            result.physics_weights[i] = mix(a.physics_weights[i],
-                                            b.physics_weights[i],
-                                            alpha);
+            a.physics_weights[i] = mix(a.physics_weights[i],
+                                       b.physics_weights[i],
+                                       alpha);
+        }
+        for (size_t i = min_num_joints; i < num_joints; i++) {
+            a.physics_weights[i] = 1.0f;
         }
     }
 
     // Add shape keys from both sources, and adjust their weights
     {
-        map<string, ShapeKeyBlend> shape_keys;
-        map<string, ShapeKeyBlend>::iterator iter;
-
-        // Add shape keys from A
-        for (const auto& shape_key : a.shape_keys) {
-            const string& label = shape_key.label;
-            shape_keys[label] = shape_key;
-            shape_keys[label].weight_weight *= 1.0f - alpha;
+        size_t num_a_shape_keys = a.shape_keys.size();
+        for (auto& shape_key : a.shape_keys) {
+            shape_key.weight_weight *= 1.0f - alpha;
         }
 
-        // Merge shape keys from B
         for (const auto& shape_key : b.shape_keys) {
-            const string& label = shape_key.label;
-            iter = shape_keys.find(label);
-            if (iter == shape_keys.end()) {
-                shape_keys[label] = shape_key;
-                shape_keys[label].weight_weight *= alpha;
+            int index = FindBlend(a.shape_keys, num_a_shape_keys, shape_key.label);
+            if (index == -1) {
+                a.shape_keys.push_back(shape_key);
+                a.shape_keys.back().weight_weight *= alpha;
             } else {
-                shape_keys[label].weight = mix(shape_keys[label].weight, shape_key.weight, alpha);
-                shape_keys[label].weight_weight = shape_keys[label].weight_weight + shape_key.weight_weight * alpha;
+                ShapeKeyBlend& a_key = a.shape_keys[index];
+                a_key.weight = mix(a_key.weight, shape_key.weight, alpha);
+                a_key.weight_weight = a_key.weight_weight + shape_key.weight_weight * alpha;
             }
         }
-
-        // Add shape keys from merging map into result array
-        result.shape_keys.resize(shape_keys.size());
-        iter = shape_keys.begin();
-        int index = 0;
-        for (; iter != shape_keys.end(); ++iter) {
-            result.shape_keys[index++] = (*iter).second;
-        }
+        SortBlends(a.shape_keys);
     }
 
     // Add status keys from both sources, and adjust their weights
     {
-        map<string, StatusKeyBlend> status_keys;
-        map<string, StatusKeyBlend>::iterator iter;
-
-        for (const auto& status_key : a.status_keys) {
-            const string& label = status_key.label;
-            status_keys[label] = status_key;
-            status_keys[label].weight_weight *= 1.0f - alpha;
+        size_t num_a_status_keys = a.status_keys.size();
+        for (auto& status_key : a.status_keys) {
+            status_key.weight_weight *= 1.0f - alpha;
         }
 
         for (const auto& status_key : b.status_keys) {
-            const string& label = status_key.label;
-            iter = status_keys.find(label);
-            if (iter == status_keys.end()) {
-                status_keys[label] = status_key;
-                status_keys[label].weight_weight *= alpha;
+            int index = FindBlend(a.status_keys, num_a_status_keys, status_key.label);
+            if (index == -1) {
+                a.status_keys.push_back(status_key);
+                a.status_keys.back().weight_weight *= alpha;
             } else {
-                status_keys[label].weight = mix(status_keys[label].weight, status_key.weight, alpha);
-                status_keys[label].weight_weight = status_keys[label].weight_weight + status_key.weight_weight * alpha;
+                StatusKeyBlend& a_key = a.status_keys[index];
+                a_key.weight = mix(a_key.weight, status_key.weight, alpha);
+                a_key.weight_weight = a_key.weight_weight + status_key.weight_weight * alpha;
             }
         }
-
-        result.status_keys.resize(status_keys.size());
-        iter = status_keys.begin();
-        int index = 0;
-        for (; iter != status_keys.end(); ++iter) {
-            result.status_keys[index++] = (*iter).second;
-        }
-
-        if (result.status_keys.empty() && (!a.status_keys.empty() || !b.status_keys.empty())) {
-            LOGD << "Lost status keys." << endl;
-        }
+        SortBlends(a.status_keys);
     }
 
-    map<int, WeapAnimInfo>::const_iterator iter_a = a.weap_anim_info_map.begin();
-    map<int, WeapAnimInfo>::const_iterator iter_b = b.weap_anim_info_map.begin();
-
-    while (iter_a != a.weap_anim_info_map.end() ||
-           iter_b != b.weap_anim_info_map.end()) {
-        int iter_a_id = -1;
-        int iter_b_id = -1;
-        if (iter_a != a.weap_anim_info_map.end()) {
-            iter_a_id = iter_a->first;
-        }
-        if (iter_b != b.weap_anim_info_map.end()) {
-            iter_b_id = iter_b->first;
-        }
-        if (iter_b_id != -1 && (iter_a_id == -1 || iter_a_id > iter_b_id)) {
-            result.weap_anim_info_map[iter_b_id] = iter_b->second;
-            result.weap_anim_info_map[iter_b_id].weight *= alpha;
-            ++iter_b;
-        } else if (iter_b_id == -1 || iter_b_id > iter_a_id) {
-            result.weap_anim_info_map[iter_a_id] = iter_a->second;
-            result.weap_anim_info_map[iter_a_id].weight *= (1.0f - alpha);
-            ++iter_a;
+    // Items in a first, inserting the ones only in b would move them around
+    for (auto& entry : a.weap_anim_info_map) {
+        const WeapAnimInfo* b_info = b.weap_anim_info_map.find(entry.item_id);
+        if (b_info) {
+            entry.info = mix(entry.info, *b_info, alpha);
         } else {
-            result.weap_anim_info_map[iter_a_id] = mix(iter_a->second, iter_b->second, alpha);
-            ++iter_a;
-            ++iter_b;
+            entry.info.weight *= (1.0f - alpha);
+        }
+    }
+    for (const auto& entry : b.weap_anim_info_map) {
+        if (!a.weap_anim_info_map.find(entry.item_id)) {
+            WeapAnimInfo* info = a.weap_anim_info_map.insert(entry.item_id);
+            if (info) {
+                *info = entry.info;
+                info->weight *= alpha;
+            }
         }
     }
-
-    return result;
 }
 
 WeapAnimInfo mix(const WeapAnimInfo& a, const WeapAnimInfo& b, float b_weight) {
@@ -1060,173 +1077,193 @@ WeapAnimInfo mix(const WeapAnimInfo& a, const WeapAnimInfo& b, float b_weight) {
     return result;
 }
 
-AnimOutput add_mix(const AnimOutput& a, const AnimOutput& b, float alpha) {
+void add_mix_in_place(AnimOutput& a, const AnimOutput& b, float alpha) {
     LOG_ASSERT(a.matrices.size() == b.matrices.size());
 
-    AnimOutput result = a;
     size_t num_bones = a.matrices.size();
-
-    vector<float> bone_weights = b.physics_weights;
-    bone_weights.resize(num_bones, 1.0f);
+    size_t num_bone_weights = b.physics_weights.size();
 
     float clamped_alpha = clamp(alpha, 0.0f, 1.0f);
 
-    result.matrices.resize(num_bones);
-    for (size_t i = 0; i < num_bones; i++) {
-        result.matrices[i] = mix(a.matrices[i], b.matrices[i], alpha * (bone_weights[i]));
+    if (num_bones > 0) {
+        BlendBoneTransforms(&a.matrices[0], &b.matrices[0], num_bones, alpha,
+                            num_bone_weights > 0 ? &b.physics_weights[0] : NULL, num_bone_weights);
     }
 
     // Add shape keys from both sources, and adjust their weights
     {
-        map<string, ShapeKeyBlend> shape_keys;
-        map<string, ShapeKeyBlend>::iterator iter;
-
-        // Add shape keys from A
-        for (const auto& shape_key : a.shape_keys) {
-            const string& label = shape_key.label;
-            shape_keys[label] = shape_key;
-        }
-
-        // Merge shape keys from B
+        size_t num_a_shape_keys = a.shape_keys.size();
         for (const auto& shape_key : b.shape_keys) {
-            const string& label = shape_key.label;
-            iter = shape_keys.find(label);
-            if (iter == shape_keys.end()) {
-                shape_keys[label] = shape_key;
-                shape_keys[label].weight_weight *= clamped_alpha;
+            int index = FindBlend(a.shape_keys, num_a_shape_keys, shape_key.label);
+            if (index == -1) {
+                a.shape_keys.push_back(shape_key);
+                a.shape_keys.back().weight_weight *= clamped_alpha;
             } else {
-                ShapeKeyBlend& a_key = shape_keys[label];
+                ShapeKeyBlend& a_key = a.shape_keys[index];
                 const ShapeKeyBlend& b_key = shape_key;
                 a_key.weight = mix(a_key.weight, b_key.weight, b_key.weight_weight * clamped_alpha);
                 a_key.weight_weight = max(a_key.weight_weight, b_key.weight_weight * clamped_alpha);
             }
         }
-
-        // Add shape keys from merging map into result array
-        result.shape_keys.resize(shape_keys.size());
-        iter = shape_keys.begin();
-        int index = 0;
-        for (; iter != shape_keys.end(); ++iter) {
-            result.shape_keys[index++] = (*iter).second;
-        }
+        SortBlends(a.shape_keys);
     }
 
     // Add status keys from both sources, and adjust their weights
     {
-        map<string, StatusKeyBlend> status_keys;
-        map<string, StatusKeyBlend>::iterator iter;
-
-        for (const auto& status_key : a.status_keys) {
-            const string& label = status_key.label;
-            status_keys[label] = status_key;
-        }
-
+        size_t num_a_status_keys = a.status_keys.size();
         for (const auto& status_key : b.status_keys) {
-            const string& label = status_key.label;
-            iter = status_keys.find(label);
-            if (iter == status_keys.end()) {
-                status_keys[label] = status_key;
-                status_keys[label].weight_weight *= clamped_alpha;
+            int index = FindBlend(a.status_keys, num_a_status_keys, status_key.label);
+            if (index == -1) {
+                a.status_keys.push_back(status_key);
+                a.status_keys.back().weight_weight *= clamped_alpha;
             } else {
-                StatusKeyBlend& a_key = status_keys[label];
+                StatusKeyBlend& a_key = a.status_keys[index];
                 const StatusKeyBlend& b_key = status_key;
                 a_key.weight = mix(a_key.weight, b_key.weight, b_key.weight_weight * clamped_alpha);
                 a_key.weight_weight = max(a_key.weight_weight, b_key.weight_weight * clamped_alpha);
             }
         }
-
-        result.status_keys.resize(status_keys.size());
-        iter = status_keys.begin();
-        int index = 0;
-        for (; iter != status_keys.end(); ++iter) {
-            result.status_keys[index++] = (*iter).second;
-        }
+        SortBlends(a.status_keys);
     }
 
-    size_t num_weapon_bones = max(a.weapon_matrices.size(),
+    size_t num_a_weapon_bones = a.weapon_matrices.size();
+    size_t num_weapon_bones = max(num_a_weapon_bones,
                                   b.weapon_matrices.size());
-    result.weapon_matrices.resize(num_weapon_bones);
-    result.weapon_weights.resize(num_weapon_bones);
-    result.weapon_weight_weights.resize(num_weapon_bones);
-    result.weapon_relative_ids.resize(num_weapon_bones);
-    result.weapon_relative_weights.resize(num_weapon_bones);
+    a.weapon_matrices.resize(num_weapon_bones);
+    a.weapon_weights.resize(num_weapon_bones);
+    a.weapon_weight_weights.resize(num_weapon_bones);
+    a.weapon_relative_ids.resize(num_weapon_bones);
+    a.weapon_relative_weights.resize(num_weapon_bones);
     for (unsigned i = 0; i < num_weapon_bones; i++) {
         if (i >= b.weapon_matrices.size()) {
-            result.weapon_matrices[i] = a.weapon_matrices[i];
-            result.weapon_weights[i] = a.weapon_weights[i];
-            result.weapon_weight_weights[i] = a.weapon_weight_weights[i];
-            result.weapon_relative_ids[i] = a.weapon_relative_ids[i];
-            result.weapon_relative_weights[i] = a.weapon_relative_weights[i];
-        } else if (i >= a.weapon_matrices.size()) {
-            result.weapon_matrices[i] = b.weapon_matrices[i];
-            result.weapon_weights[i] = b.weapon_weights[i] * clamped_alpha;
-            result.weapon_weight_weights[i] = b.weapon_weight_weights[i] * clamped_alpha;
-            result.weapon_relative_ids[i] = b.weapon_relative_ids[i];
-            result.weapon_relative_weights[i] = b.weapon_relative_weights[i];
+            // Stays as it is in a
+        } else if (i >= num_a_weapon_bones) {
+            a.weapon_matrices[i] = b.weapon_matrices[i];
+            a.weapon_weights[i] = b.weapon_weights[i] * clamped_alpha;
+            a.weapon_weight_weights[i] = b.weapon_weight_weights[i] * clamped_alpha;
+            a.weapon_relative_ids[i] = b.weapon_relative_ids[i];
+            a.weapon_relative_weights[i] = b.weapon_relative_weights[i];
         } else {
-            result.weapon_matrices[i] =
+            a.weapon_matrices[i] =
                 mix(a.weapon_matrices[i], b.weapon_matrices[i], alpha * b.weapon_weight_weights[i]);
-            result.weapon_weights[i] =
+            a.weapon_weights[i] =
                 mix(a.weapon_weights[i], b.weapon_weights[i], clamped_alpha * b.weapon_weight_weights[i]);
-            result.weapon_weight_weights[i] = max(a.weapon_weight_weights[i], b.weapon_weight_weights[i] * clamped_alpha);
-            result.weapon_relative_ids[i] = max(a.weapon_relative_ids[i], b.weapon_relative_ids[i]);
-            result.weapon_relative_weights[i] = a.weapon_relative_weights[i];
+            a.weapon_weight_weights[i] = max(a.weapon_weight_weights[i], b.weapon_weight_weights[i] * clamped_alpha);
+            a.weapon_relative_ids[i] = max(a.weapon_relative_ids[i], b.weapon_relative_ids[i]);
         }
     }
 
-    size_t num_joints = max(a.physics_weights.size(),
+    size_t num_a_joints = a.physics_weights.size();
+    size_t num_joints = max(num_a_joints,
                             b.physics_weights.size());
-    size_t min_num_joints = min(a.physics_weights.size(),
+    size_t min_num_joints = min(num_a_joints,
                                 b.physics_weights.size());
-    result.physics_weights.resize(num_joints, 1.0f);
+    a.physics_weights.resize(num_joints, 1.0f);
 
-    if (a.physics_weights.empty()) {
+    if (num_a_joints == 0) {
         for (size_t i = 0; i < num_joints; i++) {
-            result.physics_weights[i] = mix(0.0f,
-                                            b.physics_weights[i],
-                                            clamped_alpha);
+            a.physics_weights[i] = mix(0.0f,
+                                       b.physics_weights[i],
+                                       clamped_alpha);
         }
     } else if (b.physics_weights.empty()) {
         for (size_t i = 0; i < num_joints; i++) {
-            result.physics_weights[i] = mix(a.physics_weights[i],
-                                            0.0f,
-                                            clamped_alpha);
+            a.physics_weights[i] = mix(a.physics_weights[i],
+                                       0.0f,
+                                       clamped_alpha);
         }
     } else {
         for (size_t i = 0; i < min_num_joints; i++) {
-            result.physics_weights[i] = max(a.physics_weights[i],
-                                            b.physics_weights[i] * clamped_alpha);
+            a.physics_weights[i] = max(a.physics_weights[i],
+                                       b.physics_weights[i] * clamped_alpha);
         }
     }
 
-    map<int, WeapAnimInfo>::const_iterator iter_a = a.weap_anim_info_map.begin();
-    map<int, WeapAnimInfo>::const_iterator iter_b = b.weap_anim_info_map.begin();
-
-    while (iter_a != a.weap_anim_info_map.end() ||
-           iter_b != b.weap_anim_info_map.end()) {
-        int iter_a_id = -1;
-        int iter_b_id = -1;
-        if (iter_a != a.weap_anim_info_map.end()) {
-            iter_a_id = iter_a->first;
+    for (auto& entry : a.weap_anim_info_map) {
+        const WeapAnimInfo* b_info = b.weap_anim_info_map.find(entry.item_id);
+        if (b_info) {
+            entry.info = mix(entry.info, *b_info, clamped_alpha);
         }
-        if (iter_b != b.weap_anim_info_map.end()) {
-            iter_b_id = iter_b->first;
-        }
-        if (iter_b_id != -1 && (iter_a_id == -1 || iter_a_id > iter_b_id)) {
-            result.weap_anim_info_map[iter_b_id] = iter_b->second;
-            result.weap_anim_info_map[iter_b_id].weight *= clamped_alpha;
-            ++iter_b;
-        } else if (iter_b_id == -1 || iter_b_id > iter_a_id) {
-            result.weap_anim_info_map[iter_a_id] = iter_a->second;
-            ++iter_a;
-        } else {
-            result.weap_anim_info_map[iter_a_id] = mix(iter_a->second, iter_b->second, clamped_alpha);
-            ++iter_a;
-            ++iter_b;
+    }
+    for (const auto& entry : b.weap_anim_info_map) {
+        if (!a.weap_anim_info_map.find(entry.item_id)) {
+            WeapAnimInfo* info = a.weap_anim_info_map.insert(entry.item_id);
+            if (info) {
+                *info = entry.info;
+                info->weight *= clamped_alpha;
+            }
         }
     }
+}
 
-    return result;
+AnimOutput& AnimOutputPool::Acquire() {
+    if (num_used_ == outputs_.size()) {
+        outputs_.resize(num_used_ + 1);
+    }
+    return outputs_[num_used_++];
+}
+
+void AnimOutputPool::Release() {
+    LOG_ASSERT(num_used_ > 0);
+    --num_used_;
+}
+
+// Main thread only, so a missing skeleton is reported once and not by every character
+static void LogRetargetSkeletonOnce(const string& path, const char* problem) {
+    static std::set<string> logged;
+    if (logged.insert(path).second) {
+        LOGE << "Skeleton \"" << path << "\" " << problem << endl;
+    }
+}
+
+void RetargetSkeletons::Preload(const string& skeleton_path) {
+    skeleton_path_ = skeleton_path;
+    generation_ = AnimationRetargeter::Instance()->GetGeneration();
+    skeletons_.clear();
+    missing_.clear();
+    vector<string> paths = AnimationRetargeter::Instance()->GetSkeletonFiles();
+    paths.push_back(skeleton_path);
+    // Mirroring reads the skeleton this maps to
+    paths.push_back(AnimationRetargeter::Instance()->GetSkeletonFile(skeleton_path));
+    for (const auto& path : paths) {
+        Get(path);
+    }
+}
+
+void RetargetSkeletons::Refresh() {
+    if (skeleton_path_.empty()) {
+        return;
+    }
+    if (generation_ != AnimationRetargeter::Instance()->GetGeneration()) {
+        Preload(skeleton_path_);
+    }
+    for (const auto& path : missing_) {
+        LogRetargetSkeletonOnce(path, "was not preloaded for retargeting, loading it for the next update");
+        Get(path);
+    }
+    missing_.clear();
+}
+
+const SkeletonFileData* RetargetSkeletons::Get(const string& path) {
+    map<string, SkeletonAssetRef>::iterator iter = skeletons_.find(path);
+    if (iter == skeletons_.end()) {
+        if (!IsMainThread()) {
+            if (std::find(missing_.begin(), missing_.end(), path) == missing_.end()) {
+                missing_.push_back(path);
+            }
+            return NULL;
+        }
+        SkeletonAssetRef ref = Engine::Instance()->GetAssetManager()->LoadSync<SkeletonAsset>(path);
+        if (!ref.valid()) {
+            LogRetargetSkeletonOnce(path, "could not be loaded for retargeting");
+        }
+        // Failures are kept too, so they aren't tried again every update
+        iter = skeletons_.insert(std::make_pair(path, ref)).first;
+    }
+    if (!iter->second.valid()) {
+        return NULL;
+    }
+    return &iter->second->GetData();
 }
 
 /*
@@ -1266,6 +1303,59 @@ bool Animation::LoadCache(unsigned short checksum) {
 }
 */
 
+KeyframeCursors::KeyframeCursors() : next_cursor_(0) {
+    for (auto& cursor : cursors_) {
+        cursor.animation = NULL;
+        cursor.frame_id = -1;
+    }
+}
+
+int& KeyframeCursors::Get(const Animation* animation) {
+    for (auto& cursor : cursors_) {
+        if (cursor.animation == animation) {
+            return cursor.frame_id;
+        }
+    }
+    Cursor& cursor = cursors_[next_cursor_];
+    next_cursor_ = (next_cursor_ + 1) % kNumCursors;
+    cursor.animation = animation;
+    cursor.frame_id = -1;
+    return cursor.frame_id;
+}
+
+static bool TimeBeforeKeyframe(float local_time, const Keyframe& keyframe) {
+    return local_time < keyframe.time;
+}
+
+int Animation::FindFrame(float local_time, int* cursor) const {
+    int num_keyframes = (int)keyframes.size();
+    if (!keyframes_in_order) {
+        int frame_id = -1;
+        for (int i = 0; i < num_keyframes; i++) {
+            if (keyframes[i].time <= local_time) {
+                frame_id = i;
+            }
+        }
+        return frame_id;
+    }
+    if (cursor) {
+        // Playing on from the last lookup mostly stays on its frame or moves to the next one.
+        // The cursor may be from an animation that was unloaded since, so don't trust it any further
+        for (int frame_id = *cursor, last = min(*cursor + 1, num_keyframes - 1); frame_id >= 0 && frame_id <= last; ++frame_id) {
+            if (keyframes[frame_id].time <= local_time &&
+                (frame_id + 1 == num_keyframes || keyframes[frame_id + 1].time > local_time)) {
+                *cursor = frame_id;
+                return frame_id;
+            }
+        }
+    }
+    int frame_id = (int)(std::upper_bound(keyframes.begin(), keyframes.end(), local_time, TimeBeforeKeyframe) - keyframes.begin()) - 1;
+    if (cursor) {
+        *cursor = frame_id;
+    }
+    return frame_id;
+}
+
 void Animation::GetMatrices(float normalized_time, AnimOutput& anim_output, const AnimInput& anim_input) const {
     PROFILER_ZONE(g_profiler_ctx, "Animation::GetMatrices");
     float local_time = LocalFromNormalized(normalized_time);
@@ -1273,28 +1363,28 @@ void Animation::GetMatrices(float normalized_time, AnimOutput& anim_output, cons
     anim_output.weap_anim_info_map.clear();
 
     // Get the id of the previous frame
-    int frame_id = -1;
     int num_keyframes = (int)keyframes.size();
     if (num_keyframes > 0) {
-        for (int i = 0; i < num_keyframes; i++) {
-            if (keyframes[i].time <= local_time) {
-                frame_id = i;
-            }
-        }
+        int* cursor = anim_input.keyframe_cursors ? &anim_input.keyframe_cursors->Get(this) : NULL;
+        int frame_id = FindFrame(local_time, cursor);
 
         // Get the 4 frames for interpolation:
         // two frames ahead of the current time and two frames behind
+        int frame_ids[4];
         const Keyframe* frames[4];
         if (looping) {
             for (int i = 0; i < 4; ++i) {
-                frames[i] = &keyframes[(frame_id + num_keyframes + i - 1) % num_keyframes];
+                frame_ids[i] = (frame_id + num_keyframes + i - 1) % num_keyframes;
             }
         } else {
             int last_frame = num_keyframes - 1;
             for (int i = 0; i < 4; ++i) {
-                frames[i] = &keyframes[min(last_frame, max(0, frame_id + i - 1))];
+                frame_ids[i] = min(last_frame, max(0, frame_id + i - 1));
             }
         }
+        for (int i = 0; i < 4; ++i) {
+            frames[i] = &keyframes[frame_ids[i]];
+        }
 
         // Get bilinear time weight between the last frame and the next frame
         float interp = 0.0f;
@@ -1336,7 +1426,8 @@ void Animation::GetMatrices(float normalized_time, AnimOutput& anim_output, cons
         }
 
         // Get per-bone info
-        size_t num_matrices = keyframes[0].bone_mats.size();
+        size_t num_weapon_matrices = keyframes[0].weapon_relative_id.size();
+        size_t num_matrices = tracks.num_transform_tracks() - num_weapon_matrices;
         anim_output.matrices.resize(num_matrices);
         {
             PROFILER_ZONE(g_profiler_ctx, "Getting bone transforms");
@@ -1345,7 +1436,7 @@ void Animation::GetMatrices(float normalized_time, AnimOutput& anim_output, cons
                 if (anim_input.parents && i < anim_input.parents->size() && anim_input.parents->at(i) != -1) {
                     BoneTransform bone_transforms[4];
                     for (int j = 0; j < 4; ++j) {
-                        bone_transforms[j] = frames[j]->invert_bone_mats[anim_input.parents->at(i)] * frames[j]->bone_mats[i];
+                        bone_transforms[j] = invert(tracks.GetTransform(frame_ids[j], anim_input.parents->at(i))) * tracks.GetTransform(frame_ids[j], i);
                     }
                     BoneTransform transform = BlendFourBones(bone_transforms, weights);
                     anim_output.matrices[i] = transform;
@@ -1355,7 +1446,7 @@ void Animation::GetMatrices(float normalized_time, AnimOutput& anim_output, cons
 
                     BoneTransform bone_transforms[4];
                     for (int j = 0; j < 4; ++j) {
-                        bone_transforms[j] = frames[j]->bone_mats[i];
+                        bone_transforms[j] = tracks.GetTransform(frame_ids[j], i);
                     }
                     BoneTransform transform = BlendFourBones(bone_transforms, weights);
                     anim_output.matrices[i] = transform;
@@ -1364,7 +1455,6 @@ void Animation::GetMatrices(float normalized_time, AnimOutput& anim_output, cons
         }
 
         // Get per-weapon info
-        size_t num_weapon_matrices = keyframes[0].weapon_mats.size();
         anim_output.weapon_weights.resize(num_weapon_matrices);
         anim_output.weapon_weight_weights.resize(num_weapon_matrices);
         for (int i = 0; i < num_weapon_matrices; ++i) {
@@ -1377,9 +1467,9 @@ void Animation::GetMatrices(float normalized_time, AnimOutput& anim_output, cons
         for (size_t i = 0; i < num_weapon_matrices; i++) {
             BoneTransform bone_transforms[4];
             for (int j = 0; j < 4; ++j) {
-                bone_transforms[j] = frames[j]->weapon_mats[i];
+                bone_transforms[j] = tracks.GetTransform(frame_ids[j], num_matrices + i);
                 if (frames[j]->weapon_relative_weight[i] > 0.0f) {
-                    bone_transforms[j] = invert(frames[j]->bone_mats[frames[j]->weapon_relative_id[i]]) * bone_transforms[j];
+                    bone_transforms[j] = invert(tracks.GetTransform(frame_ids[j], frames[j]->weapon_relative_id[i])) * bone_transforms[j];
                 }
             }
             BoneTransform transform = BlendFourBones(bone_transforms, weights);
@@ -1387,46 +1477,42 @@ void Animation::GetMatrices(float normalized_time, AnimOutput& anim_output, cons
         }
 
         // Get physics weights
-        size_t num_weights = keyframes[0].weights.size();
+        size_t num_weights = tracks.num_weight_tracks();
         anim_output.physics_weights.resize(num_weights);
         for (size_t i = 0; i < num_weights; i++) {
             anim_output.physics_weights[i] = 0.0f;
             for (int j = 0; j < 4; ++j) {
-                anim_output.physics_weights[i] += frames[j]->weights[i] * weights[j];
+                anim_output.physics_weights[i] += tracks.GetWeight(frame_ids[j], i) * weights[j];
             }
         }
 
         anim_output.center_offset = frames[1]->center_offset * (1.0f - interp) + frames[2]->center_offset * interp;
         anim_output.rotation = frames[1]->rotation * (1.0f - interp) + frames[2]->rotation * interp;
 
-        typedef map<string, BlendedBonePath> IKBoneMap;
-        IKBoneMap ik_bone_weights;
+        anim_output.ik_bones.clear();
         for (int j = 0; j < 4; ++j) {
             for (unsigned i = 0; i < frames[j]->ik_bones.size(); ++i) {
-                BlendedBonePath& weighted_ik_bone = ik_bone_weights[frames[j]->ik_bones[i].label];
+                const IKBone& ik_bone = frames[j]->ik_bones[i];
+                int index = FindBlend(anim_output.ik_bones, anim_output.ik_bones.size(), ik_bone.label);
+                if (index == -1) {
+                    index = (int)anim_output.ik_bones.size();
+                    anim_output.ik_bones.resize(index + 1);
+                    anim_output.ik_bones[index].weight = 0.0f;
+                    anim_output.ik_bones[index].unmodified_transform = BoneTransform();
+                }
+                BlendedBonePath& weighted_ik_bone = anim_output.ik_bones[index];
                 weighted_ik_bone.weight += weights[j];
-                weighted_ik_bone.ik_bone = frames[j]->ik_bones[i];
+                weighted_ik_bone.ik_bone = ik_bone;
             }
         }
+        SortBlends(anim_output.ik_bones);
 
-        for (auto& ik_bone_weight : ik_bone_weights) {
-            BlendedBonePath& blended_bone_path = ik_bone_weight.second;
+        for (auto& blended_bone_path : anim_output.ik_bones) {
             int bone = blended_bone_path.ik_bone.bone_path.back();
-            BoneTransform bone_transforms[4];
-            for (int j = 0; j < 4; ++j) {
-                bone_transforms[j] = frames[j]->bone_mats[bone];
-            }
-            BoneTransform transform = mix(bone_transforms[1], bone_transforms[2], interp);  // BlendFourBones(bone_transforms, weights);
+            BoneTransform transform = mix(tracks.GetTransform(frame_ids[1], bone), tracks.GetTransform(frame_ids[2], bone), interp);
             blended_bone_path.transform = transform;
         }
 
-        anim_output.ik_bones.resize(ik_bone_weights.size());
-        int index = 0;
-        for (auto& ik_bone_weight : ik_bone_weights) {
-            anim_output.ik_bones[index] = ik_bone_weight.second;
-            ++index;
-        }
-
         anim_output.shape_keys.resize(frames[0]->shape_keys.size());
         for (unsigned i = 0; i < anim_output.shape_keys.size(); i++) {
             anim_output.shape_keys[i].weight = 0.0f;
@@ -1485,6 +1571,8 @@ const char* Animation::GetLoadErrorString() {
             return "";
         case 1:
             return "Animation data has a negative number of keyframes.";
+        case 2:
+            return "Animation keyframes have different numbers of bones.";
         default:
             return "Undefined error";
     }
@@ -1493,6 +1581,8 @@ const char* Animation::GetLoadErrorString() {
 void Animation::clear() {
     looping = false;
     keyframes.clear();
+    tracks.clear();
+    keyframes_in_order = true;
 }
 
 float Animation::GetFrequency(const BlendMap& blendmap) const {
@@ -1555,26 +1645,38 @@ vector<NormalizedAnimationEvent> Animation::GetEvents(int& anim_id, bool mirror)
     return normalized_events;
 }
 
-void Animation::RecalcCaches() {
-    // Cache which bones use IK in each frame
+bool Animation::PackTracks() {
+    int num_keyframes = (int)keyframes.size();
+    size_t num_bones = keyframes[0].bone_mats.size();
+    size_t num_weapons = keyframes[0].weapon_mats.size();
+    size_t num_weights = keyframes[0].weights.size();
+    size_t num_transforms = num_bones + num_weapons;
+    // Sizes have always gone by the first keyframe, values past them in later keyframes are dropped
+    vector<BoneTransform> transforms(num_transforms * num_keyframes);
+    vector<float> weights(num_weights * num_keyframes);
+    for (int i = 0; i < num_keyframes; i++) {
+        Keyframe& k = keyframes[i];
+        if (k.bone_mats.size() < num_bones || k.weapon_mats.size() < num_weapons || k.weights.size() < num_weights) {
+            LOGE << "Keyframe " << i << " of animation " << path_ << " has fewer bones than the first one" << endl;
+            return false;
+        }
+        std::copy(k.bone_mats.begin(), k.bone_mats.begin() + num_bones, transforms.begin() + i * num_transforms);
+        std::copy(k.weapon_mats.begin(), k.weapon_mats.begin() + num_weapons, transforms.begin() + i * num_transforms + num_bones);
+        std::copy(k.weights.begin(), k.weights.begin() + num_weights, weights.begin() + i * num_weights);
+        k.weapon_relative_id.resize(num_weapons);
+        k.weapon_relative_weight.resize(num_weapons);
+    }
+    tracks.Pack(num_keyframes, (int)num_transforms, transforms.empty() ? NULL : &transforms[0],
+                (int)num_weights, weights.empty() ? NULL : &weights[0]);
     for (auto& k : keyframes) {
-        // Initialize uses_ik vector
-        size_t num_bones = k.bone_mats.size();
-        k.uses_ik.resize(num_bones);
-        for (int i = 0; i < num_bones; i++) {
-            k.uses_ik[i] = false;
-        }
-        // Travel down each ik chain to specify that each bone uses ik
-        size_t num_ik_bones = k.ik_bones.size();
-        for (int i = 0; i < num_ik_bones; i++) {
-            const BonePath& bone_path = k.ik_bones[i].bone_path;
-            size_t bone_path_len = bone_path.size();
-            for (size_t j = 0; j < bone_path_len; j++) {
-                k.uses_ik[bone_path[j]] = true;
-            }
-        }
+        k.bone_mats.clear();
+        k.bone_mats.shrink_to_fit();
+        k.weights.clear();
+        k.weights.shrink_to_fit();
+        k.weapon_mats.clear();
+        k.weapon_mats.shrink_to_fit();
     }
-    CalcInvertBoneMats();
+    return true;
 }
 
 void Animation::Reload() {
@@ -1584,6 +1686,20 @@ void Animation::Reload() {
 void Animation::ReportLoad() {
 }
 
+size_t Animation::GetResidentBytes() {
+    size_t bytes = sizeof(Animation) + path_.capacity() + keyframes.capacity() * sizeof(Keyframe);
+    bytes += tracks.GetResidentBytes();
+    for (const auto& keyframe : keyframes) {
+        bytes += keyframe.weapon_relative_id.capacity() * sizeof(int);
+        bytes += keyframe.weapon_relative_weight.capacity() * sizeof(float);
+        bytes += keyframe.ik_bones.capacity() * sizeof(IKBone);
+        bytes += keyframe.shape_keys.capacity() * sizeof(ShapeKey);
+        bytes += keyframe.status_keys.capacity() * sizeof(StatusKey);
+        bytes += keyframe.events.capacity() * sizeof(AnimationEvent);
+    }
+    return bytes;
+}
+
 void MirrorBT(BoneTransform& bt, bool xy_flip) {
     bt.origin[0] *= -1.0f;
 
@@ -29,7 +29,12 @@
 #include <Asset/assetbase.h>
 #include <Asset/assetinfobase.h>
 #include <Asset/assettypes.h>
+#include <Asset/Asset/packedanimationclip.h>
+#include <Asset/Asset/skeletonasset.h>
 
+#include <Utility/reusable_vector.h>
+
+#include <deque>
 #include <map>
 #include <string>
 
@@ -107,14 +112,44 @@ struct WeapAnimInfo {
 
 WeapAnimInfo mix(const WeapAnimInfo& a, const WeapAnimInfo& b, float b_weight);
 
+// Weapon animation info by item id, kept sorted by id in a fixed size table
+class WeapAnimInfoMap {
+   public:
+    enum { kCapacity = 16 };
+
+    struct Entry {
+        int item_id;
+        WeapAnimInfo info;
+    };
+
+    WeapAnimInfoMap() : num_entries_(0) {}
+
+    // Returns NULL if it isn't there
+    WeapAnimInfo* find(int item_id);
+    const WeapAnimInfo* find(int item_id) const;
+    // Adds an entry if it isn't there, returns NULL if the table is full
+    WeapAnimInfo* insert(int item_id);
+    void clear() { num_entries_ = 0; }
+    int size() const { return num_entries_; }
+    bool empty() const { return num_entries_ == 0; }
+
+    Entry* begin() { return entries_; }
+    Entry* end() { return entries_ + num_entries_; }
+    const Entry* begin() const { return entries_; }
+    const Entry* end() const { return entries_ + num_entries_; }
+
+   private:
+    Entry entries_[kCapacity];
+    int num_entries_;
+};
+
 struct Keyframe {
-    // Per-bone info
+    // Per-bone info, only filled while loading. Animation packs it into
+    // its tracks afterwards, which is where GetMatrices() reads it from
     vector<BoneTransform> bone_mats;
-    vector<BoneTransform> invert_bone_mats;
-    vector<bool> uses_ik;
     vector<float> weights;
     // Per-weapon info
-    vector<BoneTransform> weapon_mats;
+    vector<BoneTransform> weapon_mats;  // Packed like bone_mats
     vector<int> weapon_relative_id;
     vector<float> weapon_relative_weight;
     // Misc
@@ -131,17 +166,55 @@ struct Keyframe {
 
 const int _animation_version = 11;
 
+class Animation;
+class AnimOutputPool;
+class RetargetSkeletons;
+
+// Remembers which keyframe the last few animations sampled were on, so
+// sampling them again a little later finds the current keyframe without
+// searching for it. The least recently added animation makes room.
+class KeyframeCursors {
+   public:
+    enum { kNumCursors = 4 };
+
+    KeyframeCursors();
+    // Frame id of the last lookup in this animation, -1 if there was none
+    int& Get(const Animation* animation);
+
+   private:
+    struct Cursor {
+        const Animation* animation;
+        int frame_id;
+    };
+    Cursor cursors_[kNumCursors];
+    int next_cursor_;
+};
+
 struct AnimInput {
     const BlendMap& blendmap;
     const vector<int>* parents;
     bool mirrored;
-    string retarget_new;
-    AnimInput(const BlendMap& _blendmap, const vector<int>* _parents)
+    const string& retarget_new;
+    AnimOutputPool* pool;  // Where blends get their extra AnimOutputs from, they are allocated on the spot without one
+    KeyframeCursors* keyframe_cursors;  // Keyframes are looked up from scratch without these
+    RetargetSkeletons* retarget_skeletons;  // Skeletons are loaded through the asset manager without these
+    AnimInput(const BlendMap& _blendmap, const vector<int>* _parents, const string& _retarget_new = NoRetargeting())
         : blendmap(_blendmap),
           parents(_parents),
-          mirrored(false) {}
+          mirrored(false),
+          retarget_new(_retarget_new),
+          pool(NULL),
+          keyframe_cursors(NULL),
+          retarget_skeletons(NULL) {}
+
+    static const string& NoRetargeting() {
+        static const string empty;
+        return empty;
+    }
 };
 
+// Arrays holding strings are ReusableVectors, so filling an AnimOutput that
+// has been used before doesn't allocate unless it needs more room than ever
 struct AnimOutput {
     // Get directly from animations
     vector<BoneTransform> weapon_matrices;
@@ -151,15 +224,15 @@ struct AnimOutput {
     vector<int> weapon_relative_ids;        // What bone is this weapon relative to?
     vector<BoneTransform> matrices;
     vector<float> physics_weights;
-    vector<BlendedBonePath> ik_bones;
-    vector<ShapeKeyBlend> shape_keys;
-    vector<StatusKeyBlend> status_keys;
+    ReusableVector<BlendedBonePath> ik_bones;
+    ReusableVector<ShapeKeyBlend> shape_keys;
+    ReusableVector<StatusKeyBlend> status_keys;
     string old_path;
     vec3 center_offset;
     float rotation;
 
     // Used for blending animations
-    map<int, WeapAnimInfo> weap_anim_info_map;
+    WeapAnimInfoMap weap_anim_info_map;
 
     // Added by animation client
     vector<BoneTransform> unmodified_matrices;
@@ -171,8 +244,62 @@ struct AnimOutput {
     AnimOutput() {}
 };
 
-AnimOutput mix(const AnimOutput& a, const AnimOutput& b, float alpha);
-AnimOutput add_mix(const AnimOutput& a, const AnimOutput& b, float alpha);
+// Blend b into a, in place so a's buffers are reused
+void mix_in_place(AnimOutput& a, const AnimOutput& b, float alpha);
+void add_mix_in_place(AnimOutput& a, const AnimOutput& b, float alpha);
+
+// Spare AnimOutputs for blends that need a second one, kept from update to
+// update so their buffers are only allocated once. Give them back in the
+// opposite order they were taken, which ScopedAnimOutput takes care of.
+class AnimOutputPool {
+   public:
+    AnimOutputPool() : num_used_(0) {}
+    AnimOutput& Acquire();
+    void Release();
+
+   private:
+    std::deque<AnimOutput> outputs_;  // Doesn't move elements when it grows
+    size_t num_used_;
+};
+
+class ScopedAnimOutput {
+   public:
+    explicit ScopedAnimOutput(AnimOutputPool* pool) : pool_(pool),
+                                                      output_(pool ? &pool->Acquire() : &fallback_) {}
+    ~ScopedAnimOutput() {
+        if (pool_) {
+            pool_->Release();
+        }
+    }
+    AnimOutput& get() { return *output_; }
+
+   private:
+    AnimOutputPool* pool_;
+    AnimOutput fallback_;
+    AnimOutput* output_;
+};
+
+// The skeletons retargeting reads, loaded ahead of time so an AnimationClient
+// can be sampled on a worker thread without going through the asset manager
+class RetargetSkeletons {
+   public:
+    RetargetSkeletons() : generation_(-1) {}
+    // The character's own skeleton and every skeleton animations are made for
+    void Preload(const string& skeleton_path);
+    // Main thread only. Preloads again if retarget.xml was reloaded, and loads
+    // whatever other threads asked for since the last call.
+    void Refresh();
+    // Loads skeletons that weren't preloaded on the main thread. Other threads
+    // get NULL, and the skeleton is loaded on the next Refresh().
+    const SkeletonFileData* Get(const string& path);
+
+   private:
+    string skeleton_path_;
+    int generation_;  // Of the AnimationRetargeter when preloaded
+    map<string, SkeletonAssetRef> skeletons_;  // Invalid refs for skeletons that failed to load
+    vector<string> missing_;
+};
+
 void MirrorBT(BoneTransform& bt, bool xy_flip);
 
 class AnimationAsset : public AssetInfo {
@@ -220,9 +347,9 @@ class Animation : public AnimationAsset {
     float LocalFromNormalized(float normalized_time) const;
     float NormalizedFromLocal(float local_time) const;
     bool IsLooping() const override;
-    void UpdateIKBones();
     void Reload();
     void ReportLoad() override;
+    size_t GetResidentBytes() override;
     float AbsoluteTimeFromNormalized(float normalized_time) const override;
     void ReturnPaths(PathSet& path_set) override;
 
@@ -231,11 +358,17 @@ class Animation : public AnimationAsset {
    private:
     int length;  // in ms
     vector<Keyframe> keyframes;
+    // Transforms of every bone then every weapon, and the physics weights, for each keyframe
+    PackedAnimationClip tracks;
+    bool keyframes_in_order;  // By time, which lets FindFrame() binary search them
     bool looping;
     ModID modsource_;
 
-    void CalcInvertBoneMats();
-    void RecalcCaches();
+    // Id of the last keyframe at or before local_time, -1 if there is none
+    int FindFrame(float local_time, int* cursor) const;
+
+    // Moves the keyframes' transforms and weights into tracks, false if keyframes are missing some
+    bool PackTracks();
     // void SaveCache(unsigned short checksum);
     // bool LoadCache(unsigned short checksum);
     void Center();
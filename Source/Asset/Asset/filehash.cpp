@@ -25,6 +25,7 @@
 #include "filehash.h"
 
 #include <Asset/AssetLoader/fallbackassetloader.h>
+#include <Internal/filefingerprint.h>
 
 FileHashAsset::FileHashAsset(AssetManager* owner, uint32_t asset_id) : Asset(owner, asset_id), sub_error(0) {
 }
@@ -33,7 +34,7 @@ int FileHashAsset::Load(const std::string& path, uint32_t load_flags) {
     Path file = FindFilePath(path, kAnyPath);
 
     if (file.isValid()) {
-        hash = GetFileHash(file.GetAbsPathStr().c_str());
+        hash = FileFingerprintStore::Instance().GetHash(file.GetAbsPathStr());
         return kLoadOk;
     } else {
         return kLoadErrorMissingFile;
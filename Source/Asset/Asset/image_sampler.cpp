@@ -154,6 +154,10 @@ void ImageSampler::Reload() {
 void ImageSampler::ReportLoad() {
 }
 
+size_t ImageSampler::GetResidentBytes() {
+    return sizeof(ImageSampler) + path_.capacity() + pixels_.capacity() * sizeof(byte4);
+}
+
 bool ImageSampler::GetCachePath(std::string* dst) {
     if (!CacheFile::CheckForCache(path_, suffix, dst, &checksum_)) {
         DisplayError("Error", ("Could not find cache file for " + path_).c_str());
@@ -55,6 +55,7 @@ class ImageSampler : public Asset {
     void Unload();
     void Reload();
     void ReportLoad() override;
+    size_t GetResidentBytes() override;
 
     vec4 GetInterpolatedColorUV(float x, float y) const;
     bool GetCachePath(std::string* dst);
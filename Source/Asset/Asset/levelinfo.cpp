@@ -63,6 +63,12 @@ int LevelInfoAsset::Load(const std::string& _path, uint32_t load_flags) {
     }
 }
 
+size_t LevelInfoAsset::GetResidentBytes() {
+    return sizeof(LevelInfoAsset) + path_.capacity() + path.capacity() + levelparser.hash.capacity() + levelparser.name.capacity() +
+           levelparser.description.capacity() + levelparser.shader.capacity() + levelparser.script.capacity() +
+           levelparser.player_script.capacity() + levelparser.enemy_script.capacity() + levelparser.loading_screen.image.capacity();
+}
+
 void LevelInfoAsset::ReportLoad() {
 }
 
@@ -45,6 +45,7 @@ class LevelInfoAsset : public Asset {
 
     int Load(const std::string& path, uint32_t load_flags);
     void ReportLoad() override;
+    size_t GetResidentBytes() override;
     AssetLoaderBase* NewLoader() override;
     void Unload();
 
@@ -77,6 +77,14 @@ void LevelSet::Reload() {
     Load(path_, 0x0);
 }
 
+size_t LevelSet::GetResidentBytes() {
+    size_t bytes = sizeof(LevelSet) + path_.capacity();
+    for (LevelPaths::iterator it = level_paths_.begin(); it != level_paths_.end(); ++it) {
+        bytes += kContainerNodeOverhead + sizeof(*it) + it->capacity();
+    }
+    return bytes;
+}
+
 void LevelSet::ReportLoad() {
 }
 
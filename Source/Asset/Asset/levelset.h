@@ -50,6 +50,7 @@ class LevelSet : public AssetInfo {
     void Unload();
     void Reload();
     void ReportLoad() override;
+    size_t GetResidentBytes() override;
 
     void clear();
 
@@ -116,6 +116,14 @@ void LipSyncFile::GetWeights(float time,
     weights = keys[marker].keys;
 }
 
+size_t LipSyncFile::GetResidentBytes() {
+    size_t bytes = sizeof(LipSyncFile) + path_.capacity() + keys.capacity() * sizeof(LipSyncKey);
+    for (size_t i = 0; i < keys.size(); i++) {
+        bytes += keys[i].keys.capacity() * sizeof(KeyWeight);
+    }
+    return bytes;
+}
+
 AssetLoaderBase* LipSyncFile::NewLoader() {
     return new FallbackAssetLoader<LipSyncFile>();
 }
@@ -59,6 +59,7 @@ class LipSyncFile : public Asset {
     void Unload();
     void Reload();
     void GetWeights(float time, int& marker, std::vector<KeyWeight>& weights);
+    size_t GetResidentBytes() override;
 
     AssetLoaderBase* NewLoader() override;
 };
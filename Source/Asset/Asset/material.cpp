@@ -147,6 +147,24 @@ void Material::Reload() {
     Load(path_, 0x0);
 }
 
+size_t Material::GetResidentBytes() {
+    size_t bytes = sizeof(Material) + path_.capacity();
+    for (std::map<std::string, std::map<std::string, MaterialEvent> >::iterator it = event_map.begin(); it != event_map.end(); ++it) {
+        bytes += kContainerNodeOverhead + sizeof(*it) + it->first.capacity();
+        for (std::map<std::string, MaterialEvent>::iterator event = it->second.begin(); event != it->second.end(); ++event) {
+            bytes += kContainerNodeOverhead + sizeof(*event) + event->first.capacity() + event->second.soundgroup.capacity();
+        }
+    }
+    for (std::map<std::string, MaterialDecal>::iterator it = decal_map.begin(); it != decal_map.end(); ++it) {
+        bytes += kContainerNodeOverhead + sizeof(*it) + it->first.capacity() + it->second.color_path.capacity() +
+                 it->second.normal_path.capacity() + it->second.shader.capacity();
+    }
+    for (std::map<std::string, MaterialParticle>::iterator it = particle_map.begin(); it != particle_map.end(); ++it) {
+        bytes += kContainerNodeOverhead + sizeof(*it) + it->first.capacity() + it->second.particle_path.capacity();
+    }
+    return bytes;
+}
+
 void Material::ReportLoad() {
 }
 
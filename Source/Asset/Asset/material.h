@@ -67,6 +67,7 @@ class Material : public AssetInfo {
     void Unload();
     void Reload();
     void ReportLoad() override;
+    size_t GetResidentBytes() override;
     void HandleEvent(const std::string &the_event, const vec3 &pos);
     const MaterialEvent &GetEvent(const std::string &the_event);
     const MaterialEvent &GetEvent(const std::string &the_event, const std::string &mod);
@@ -246,6 +246,28 @@ void ObjectFile::Reload() {
     Load(path_, 0x0);
 }
 
+size_t ObjectFile::GetResidentBytes() {
+    size_t bytes = sizeof(ObjectFile) + path_.capacity() + model_name.capacity() + color_map.capacity() + normal_map.capacity() +
+                   translucency_map.capacity() + shader_name.capacity() + wind_map.capacity() + sharpness_map.capacity() +
+                   label.capacity() + material_path.capacity() + weight_map.capacity() + palette_map_path.capacity();
+    for (int i = 0; i < max_palette_elements; i++) {
+        bytes += palette_label[i].capacity();
+    }
+    const std::vector<std::string>* detail_paths[] = {&m_detail_color_maps, &m_detail_normal_maps, &m_detail_materials};
+    for (int i = 0; i < 3; i++) {
+        bytes += detail_paths[i]->capacity() * sizeof(std::string);
+        for (size_t j = 0; j < detail_paths[i]->size(); j++) {
+            bytes += (*detail_paths[i])[j].capacity();
+        }
+    }
+    bytes += m_detail_object_layers.capacity() * sizeof(DetailObjectLayer);
+    for (size_t i = 0; i < m_detail_object_layers.size(); i++) {
+        bytes += m_detail_object_layers[i].obj_path.capacity() + m_detail_object_layers[i].weight_path.capacity();
+    }
+    bytes += m_detail_map_scale.capacity() * sizeof(float) + (avg_color.capacity() + avg_color_srgb.capacity()) * sizeof(int);
+    return bytes;
+}
+
 void ObjectFile::ReportLoad() {
 }
 
@@ -82,6 +82,7 @@ class ObjectFile : public AssetInfo {
 
     void Reload();
     void ReportLoad() override;
+    size_t GetResidentBytes() override;
 
     void ReturnPaths(PathSet& path_set) override;
 
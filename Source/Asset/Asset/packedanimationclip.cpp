@@ -0,0 +1,259 @@
+//-----------------------------------------------------------------------------
+//           Name: packedanimationclip.cpp
+//      Developer: Wolfire Games LLC
+//    Description: Quantized keyframe tracks in one block of memory
+//        License: Read below
+//-----------------------------------------------------------------------------
+//
+//   Copyright 2022 Wolfire Games LLC
+//
+//   Licensed under the Apache License, Version 2.0 (the "License");
+//   you may not use this file except in compliance with the License.
+//   You may obtain a copy of the License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//   Unless required by applicable law or agreed to in writing, software
+//   distributed under the License is distributed on an "AS IS" BASIS,
+//   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//   See the License for the specific language governing permissions and
+//   limitations under the License.
+//
+//-----------------------------------------------------------------------------
+#include "packedanimationclip.h"
+
+#include <Utility/assert.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+// The three smallest components end up within 0.00002 of where they were,
+// which can move the largest one by about three times that
+const float PackedAnimationClip::kMaxRotationError = 0.0001f;
+const float PackedAnimationClip::kMaxRangeError = 1.0f / 65535.0f;
+
+namespace {
+// Values this close to the first keyframe's count as the same
+const float kConstantTolerance = 0.000001f;
+// No component other than the largest can be bigger than this
+const float kSqrtHalf = 0.70710678f;
+const float kRotationSteps = 32767.0f;  // 15 bits
+const float kRangeSteps = 65535.0f;     // 16 bits
+
+uint16_t PackUnit(float value, float steps) {
+    return (uint16_t)(std::max(0.0f, std::min(1.0f, value)) * steps + 0.5f);
+}
+
+void PackRotation(const quaternion& rotation, uint16_t* values) {
+    float length = sqrtf(rotation[0] * rotation[0] + rotation[1] * rotation[1] +
+                         rotation[2] * rotation[2] + rotation[3] * rotation[3]);
+    float scale = length > 0.0f ? 1.0f / length : 1.0f;
+    int largest = 0;
+    for (int i = 1; i < 4; ++i) {
+        if (fabsf(rotation[i]) > fabsf(rotation[largest])) {
+            largest = i;
+        }
+    }
+    uint16_t packed[3];
+    int num_packed = 0;
+    for (int i = 0; i < 4; ++i) {
+        if (i != largest) {
+            packed[num_packed++] = PackUnit(rotation[i] * scale / kSqrtHalf * 0.5f + 0.5f, kRotationSteps);
+        }
+    }
+    // The spare bits hold which component was left out, and its sign
+    values[0] = (uint16_t)((packed[0] << 1) | (largest & 1));
+    values[1] = (uint16_t)((packed[1] << 1) | (largest >> 1));
+    values[2] = (uint16_t)((packed[2] << 1) | (rotation[largest] < 0.0f ? 1 : 0));
+}
+
+quaternion UnpackRotation(const uint16_t* values) {
+    int largest = (values[0] & 1) | ((values[1] & 1) << 1);
+    quaternion rotation;
+    float sum_squares = 0.0f;
+    int num_unpacked = 0;
+    for (int i = 0; i < 4; ++i) {
+        if (i != largest) {
+            float value = ((values[num_unpacked++] >> 1) / kRotationSteps * 2.0f - 1.0f) * kSqrtHalf;
+            rotation.entries[i] = value;
+            sum_squares += value * value;
+        }
+    }
+    float largest_value = sqrtf(std::max(0.0f, 1.0f - sum_squares));
+    rotation.entries[largest] = (values[2] & 1) ? -largest_value : largest_value;
+    return rotation;
+}
+}  // namespace
+
+PackedAnimationClip::PackedAnimationClip()
+    : num_frames_(0),
+      num_transform_tracks_(0),
+      num_weight_tracks_(0),
+      frames_start_(0),
+      frame_size_(0) {
+}
+
+void PackedAnimationClip::clear() {
+    data_.clear();
+    data_.shrink_to_fit();
+    num_frames_ = 0;
+    num_transform_tracks_ = 0;
+    num_weight_tracks_ = 0;
+    frames_start_ = 0;
+    frame_size_ = 0;
+}
+
+void PackedAnimationClip::Pack(int num_frames,
+                               int num_transform_tracks,
+                               const BoneTransform* transforms,
+                               int num_weight_tracks,
+                               const float* weights) {
+    clear();
+    num_frames_ = num_frames;
+    num_transform_tracks_ = num_transform_tracks;
+    num_weight_tracks_ = num_weight_tracks;
+
+    // Find out which tracks change, and the range they change in
+    std::vector<TransformTrack> transform_headers(num_transform_tracks);
+    for (int track = 0; track < num_transform_tracks; ++track) {
+        TransformTrack& header = transform_headers[track];
+        const BoneTransform& first = transforms[track];
+        bool constant_rotation = true;
+        vec3 origin_min = first.origin;
+        vec3 origin_max = first.origin;
+        for (int frame = 1; frame < num_frames; ++frame) {
+            const BoneTransform& transform = transforms[frame * num_transform_tracks + track];
+            for (int i = 0; i < 4; ++i) {
+                if (fabsf(transform.rotation[i] - first.rotation[i]) > kConstantTolerance) {
+                    constant_rotation = false;
+                }
+            }
+            for (int i = 0; i < 3; ++i) {
+                origin_min[i] = std::min(origin_min[i], transform.origin[i]);
+                origin_max[i] = std::max(origin_max[i], transform.origin[i]);
+            }
+        }
+        for (int i = 0; i < 4; ++i) {
+            header.rotation[i] = first.rotation[i];
+        }
+        header.rotation_offset = constant_rotation ? kConstant : (int32_t)frame_size_;
+        if (!constant_rotation) {
+            frame_size_ += 3;
+        }
+
+        bool constant_origin = true;
+        for (int i = 0; i < 3; ++i) {
+            float range = origin_max[i] - origin_min[i];
+            header.origin_min[i] = origin_min[i];
+            header.origin_scale[i] = range / kRangeSteps;
+            if (range > kConstantTolerance) {
+                constant_origin = false;
+            }
+        }
+        if (constant_origin) {
+            for (int i = 0; i < 3; ++i) {
+                header.origin_min[i] = first.origin[i];
+            }
+        }
+        header.origin_offset = constant_origin ? kConstant : (int32_t)frame_size_;
+        if (!constant_origin) {
+            frame_size_ += 3;
+        }
+    }
+
+    std::vector<WeightTrack> weight_headers(num_weight_tracks);
+    for (int track = 0; track < num_weight_tracks; ++track) {
+        WeightTrack& header = weight_headers[track];
+        float weight_min = weights[track];
+        float weight_max = weights[track];
+        for (int frame = 1; frame < num_frames; ++frame) {
+            weight_min = std::min(weight_min, weights[frame * num_weight_tracks + track]);
+            weight_max = std::max(weight_max, weights[frame * num_weight_tracks + track]);
+        }
+        bool constant = weight_max - weight_min <= kConstantTolerance;
+        header.min = constant ? weights[track] : weight_min;
+        header.scale = (weight_max - weight_min) / kRangeSteps;
+        header.offset = constant ? kConstant : (int32_t)frame_size_;
+        if (!constant) {
+            frame_size_ += 1;
+        }
+    }
+
+    // Both header types are made of 4-byte values, so the keyframe blocks after them stay aligned
+    frames_start_ = sizeof(TransformTrack) * num_transform_tracks + sizeof(WeightTrack) * num_weight_tracks;
+    data_.resize(frames_start_ + sizeof(uint16_t) * frame_size_ * num_frames);
+    if (num_transform_tracks > 0) {
+        memcpy(&data_[0], &transform_headers[0], sizeof(TransformTrack) * num_transform_tracks);
+    }
+    if (num_weight_tracks > 0) {
+        memcpy(&data_[sizeof(TransformTrack) * num_transform_tracks], &weight_headers[0], sizeof(WeightTrack) * num_weight_tracks);
+    }
+
+    for (int frame = 0; frame < num_frames; ++frame) {
+        uint16_t* values = reinterpret_cast<uint16_t*>(data_.data() + frames_start_) + frame_size_ * frame;
+        for (int track = 0; track < num_transform_tracks; ++track) {
+            const TransformTrack& header = transform_headers[track];
+            const BoneTransform& transform = transforms[frame * num_transform_tracks + track];
+            if (header.rotation_offset != kConstant) {
+                PackRotation(transform.rotation, values + header.rotation_offset);
+            }
+            if (header.origin_offset != kConstant) {
+                for (int i = 0; i < 3; ++i) {
+                    float range = header.origin_scale[i] * kRangeSteps;
+                    float unit = range > 0.0f ? (transform.origin[i] - header.origin_min[i]) / range : 0.0f;
+                    values[header.origin_offset + i] = PackUnit(unit, kRangeSteps);
+                }
+            }
+        }
+        for (int track = 0; track < num_weight_tracks; ++track) {
+            const WeightTrack& header = weight_headers[track];
+            if (header.offset != kConstant) {
+                float unit = (weights[frame * num_weight_tracks + track] - header.min) / (header.scale * kRangeSteps);
+                values[header.offset] = PackUnit(unit, kRangeSteps);
+            }
+        }
+    }
+}
+
+BoneTransform PackedAnimationClip::GetTransform(int frame, int track) const {
+    LOG_ASSERT(track >= 0 && track < num_transform_tracks_);
+    const TransformTrack& header = transform_tracks()[track];
+    const uint16_t* values = frame_values(frame);
+    BoneTransform transform;
+    if (header.rotation_offset == kConstant) {
+        transform.rotation = quaternion(header.rotation[0], header.rotation[1], header.rotation[2], header.rotation[3]);
+    } else {
+        transform.rotation = UnpackRotation(values + header.rotation_offset);
+    }
+    if (header.origin_offset == kConstant) {
+        transform.origin = vec3(header.origin_min[0], header.origin_min[1], header.origin_min[2]);
+    } else {
+        for (int i = 0; i < 3; ++i) {
+            transform.origin[i] = header.origin_min[i] + values[header.origin_offset + i] * header.origin_scale[i];
+        }
+    }
+    return transform;
+}
+
+float PackedAnimationClip::GetWeight(int frame, int track) const {
+    LOG_ASSERT(track >= 0 && track < num_weight_tracks_);
+    const WeightTrack& header = weight_tracks()[track];
+    if (header.offset == kConstant) {
+        return header.min;
+    }
+    return header.min + frame_values(frame)[header.offset] * header.scale;
+}
+
+const PackedAnimationClip::TransformTrack* PackedAnimationClip::transform_tracks() const {
+    return reinterpret_cast<const TransformTrack*>(data_.data());
+}
+
+const PackedAnimationClip::WeightTrack* PackedAnimationClip::weight_tracks() const {
+    return reinterpret_cast<const WeightTrack*>(data_.data() + sizeof(TransformTrack) * num_transform_tracks_);
+}
+
+const uint16_t* PackedAnimationClip::frame_values(int frame) const {
+    LOG_ASSERT(frame >= 0 && frame < num_frames_);
+    return reinterpret_cast<const uint16_t*>(data_.data() + frames_start_) + frame_size_ * frame;
+}
@@ -0,0 +1,96 @@
+//-----------------------------------------------------------------------------
+//           Name: packedanimationclip.h
+//      Developer: Wolfire Games LLC
+//    Description: Quantized keyframe tracks in one block of memory
+//        License: Read below
+//-----------------------------------------------------------------------------
+//
+//   Copyright 2022 Wolfire Games LLC
+//
+//   Licensed under the Apache License, Version 2.0 (the "License");
+//   you may not use this file except in compliance with the License.
+//   You may obtain a copy of the License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//   Unless required by applicable law or agreed to in writing, software
+//   distributed under the License is distributed on an "AS IS" BASIS,
+//   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//   See the License for the specific language governing permissions and
+//   limitations under the License.
+//
+//-----------------------------------------------------------------------------
+#pragma once
+
+#include <Graphics/bonetransform.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/*
+ * The bone transforms and weights of every keyframe in an animation, packed
+ * into one allocation that starts with a header per track and continues with
+ * a block of 16-bit values per keyframe.
+ *
+ * Rotations keep their three smallest components in 15 bits each, with the
+ * index and sign of the largest one in the spare bits. Origins and weights
+ * are scaled to the range their track covers and kept in 16 bits. Anything
+ * that is the same in every keyframe is kept once in the track header, so
+ * it takes no room in the keyframe blocks.
+ */
+class PackedAnimationClip {
+   public:
+    // Largest difference between a rotation and its unpacked copy, per quaternion component
+    static const float kMaxRotationError;
+    // Largest difference between an origin or weight and its unpacked copy, as a fraction of its track's range
+    static const float kMaxRangeError;
+
+    PackedAnimationClip();
+
+    // transforms holds num_transform_tracks values and weights holds
+    // num_weight_tracks values for each frame, one frame after another
+    void Pack(int num_frames,
+              int num_transform_tracks,
+              const BoneTransform* transforms,
+              int num_weight_tracks,
+              const float* weights);
+    void clear();
+
+    int num_frames() const { return num_frames_; }
+    int num_transform_tracks() const { return num_transform_tracks_; }
+    int num_weight_tracks() const { return num_weight_tracks_; }
+
+    BoneTransform GetTransform(int frame, int track) const;
+    float GetWeight(int frame, int track) const;
+    size_t GetResidentBytes() const { return data_.capacity(); }
+
+   private:
+    enum { kConstant = -1 };
+
+    // Offsets are in 16-bit values from the start of a keyframe block, or kConstant
+    struct TransformTrack {
+        float rotation[4];  // Only used if rotation_offset is kConstant
+        float origin_min[3];
+        float origin_scale[3];
+        int32_t rotation_offset;
+        int32_t origin_offset;
+    };
+
+    struct WeightTrack {
+        float min;
+        float scale;
+        int32_t offset;
+    };
+
+    std::vector<char> data_;
+    int num_frames_;
+    int num_transform_tracks_;
+    int num_weight_tracks_;
+    size_t frames_start_;  // In bytes
+    size_t frame_size_;    // In 16-bit values
+
+    const TransformTrack* transform_tracks() const;
+    const WeightTrack* weight_tracks() const;
+    const uint16_t* frame_values(int frame) const;
+};
@@ -29,7 +29,7 @@
 #include <Graphics/models.h>
 #include <Graphics/skeleton.h>
 
-#include <Internal/checksum.h>
+#include <Internal/filefingerprint.h>
 #include <Internal/filesystem.h>
 #include <Internal/error.h>
 
@@ -94,17 +94,17 @@ int SkeletonAsset::Load(const std::string &rel_path, uint32_t load_flags) {
         return kLoadErrorCouldNotOpenXML;
     }
 
-    checksum_ = Checksum(abs_path);
+    checksum_ = FileFingerprintStore::Instance().GetChecksum(abs_path);
     TiXmlHandle h_doc(&doc);
     TiXmlElement *rig = h_doc.FirstChildElement().ToElement();
 
     if (rig) {
         std::string bone_path = rig->Attribute("bone_path");
         FindFilePath(bone_path.c_str(), abs_path, kPathSize, kDataPaths | kModPaths);
-        checksum_ += Checksum(abs_path);
+        checksum_ += FileFingerprintStore::Instance().GetChecksum(abs_path);
         std::string model_path = rig->Attribute("model_path");
         FindFilePath(model_path.c_str(), abs_path, kPathSize, kDataPaths | kModPaths);
-        checksum_ += Checksum(abs_path);
+        checksum_ += FileFingerprintStore::Instance().GetChecksum(abs_path);
         const char *mass_path_cstr = rig->Attribute("mass_path");
         SkeletonAssetRef mass_path_ref;
         if (mass_path_cstr) {
@@ -371,6 +371,18 @@ void SkeletonAsset::Reload() {
 void SkeletonAsset::ReportLoad() {
 }
 
+size_t SkeletonAsset::GetResidentBytes() {
+    return sizeof(SkeletonAsset) + path_.capacity() +
+           data.points.capacity() * sizeof(vec3) +
+           (data.bone_ends.capacity() + data.hier_parents.capacity() + data.point_parents.capacity() + data.bone_parents.capacity() + data.symmetry.capacity()) * sizeof(int) +
+           data.bone_mass.capacity() * sizeof(float) +
+           data.bone_com.capacity() * sizeof(vec3) +
+           data.bone_mats.capacity() * sizeof(mat4) +
+           data.joints.capacity() * sizeof(JointData) +
+           data.simple_ik_bones.size() * sizeof(SimpleIKBone) +
+           (data.model_bone_weights.capacity() + data.model_bone_ids.capacity()) * sizeof(vec4);
+}
+
 SkeletonAsset::SkeletonAsset(AssetManager *owner, uint32_t asset_id) : Asset(owner, asset_id), sub_error(0) {
 }
 
@@ -99,6 +99,7 @@ class SkeletonAsset : public Asset {
 
     void Reload();
     void ReportLoad() override;
+    size_t GetResidentBytes() override;
     static AssetType GetType() { return SKELETON_ASSET; };
     static const char* GetTypeName() { return "SKELETON_ASSET"; }
     static bool AssetWarning() { return true; }
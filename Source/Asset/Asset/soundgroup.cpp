@@ -89,6 +89,10 @@ std::string SoundGroup::GetSoundPath() {
     return sound_group_info->GetSoundPath(choice);
 }
 
+size_t SoundGroup::GetResidentBytes() {
+    return sizeof(SoundGroup) + path_.capacity() + history.capacity() * sizeof(int);
+}
+
 std::string SoundGroup::GetPath() const {
     return path_;
 }
@@ -48,6 +48,7 @@ class SoundGroup : public Asset {
     const char* GetLoadErrorStringExtended() { return ""; }
     void Unload();
     void ReportLoad() override {}
+    size_t GetResidentBytes() override;
     void Reload();
     std::string GetPath() const;
     int GetNumVariants() const;
@@ -172,27 +172,23 @@ void SyncedAnimationGroup::GetMatrices(int first,
                                        float normalized_time,
                                        AnimOutput& anim_output,
                                        const AnimInput& anim_input) const {
-    AnimOutput prev_anim_output;
-    GetMatricesFromSyncedAnimation(animations[first], normalized_time, prev_anim_output, anim_input);
-    AnimOutput next_anim_output;
+    GetMatricesFromSyncedAnimation(animations[first], normalized_time, anim_output, anim_input);
+    ScopedAnimOutput scoped_next_anim_output(anim_input.pool);
+    AnimOutput& next_anim_output = scoped_next_anim_output.get();
     GetMatricesFromSyncedAnimation(animations[second], normalized_time, next_anim_output, anim_input);
     if (animation_config.kDisableAnimationMix) {
         weight = floorf(weight + 0.5f);
     }
-    std::string old_path;
-    if (prev_anim_output.old_path != next_anim_output.old_path) {
-        if (prev_anim_output.old_path != "retargeted") {
-            Retarget(anim_input, prev_anim_output, prev_anim_output.old_path);
+    if (anim_output.old_path != next_anim_output.old_path) {
+        if (anim_output.old_path != "retargeted") {
+            Retarget(anim_input, anim_output, anim_output.old_path);
         }
         if (next_anim_output.old_path != "retargeted") {
             Retarget(anim_input, next_anim_output, next_anim_output.old_path);
         }
-        old_path = "retargeted";
-    } else {
-        old_path = prev_anim_output.old_path;
+        anim_output.old_path = "retargeted";
     }
-    anim_output = mix(prev_anim_output, next_anim_output, weight);
-    anim_output.old_path = old_path;
+    mix_in_place(anim_output, next_anim_output, weight);
 }
 
 void SyncedAnimationGroup::GetMatrices(float normalized_time,
@@ -62,6 +62,10 @@ AssetLoaderBase* TextureAsset::NewLoader() {
     return new FallbackAssetLoader<TextureAsset>();
 }
 
+size_t TextureAsset::GetResidentBytes() {
+    return sizeof(TextureAsset) + path_.capacity() + Textures::Instance()->GetResidentBytes(id);
+}
+
 unsigned int TextureAsset::GetTexID() {
     return id;
 }
@@ -62,6 +62,7 @@ class TextureAsset : public Asset {
     AssetLoaderBase* NewLoader() override;
 
     unsigned int GetTexID();
+    size_t GetResidentBytes() override;
 };
 
 typedef AssetRef<TextureAsset> TextureAssetRef;
@@ -37,6 +37,9 @@ class AssetRef;
 
 class AssetManager;
 
+// Rough heap cost of a std::map, std::set or std::list node on top of its value, for GetResidentBytes()
+const size_t kContainerNodeOverhead = 4 * sizeof(void*);
+
 class Asset {
    private:
     friend class AssetManager;
@@ -47,6 +50,8 @@ class Asset {
     AssetManager* owner;
 
     virtual void ReportLoad() {}
+    // Approximate memory held by the loaded asset, used for the asset manager memory budgets.
+    virtual size_t GetResidentBytes() { return sizeof(Asset) + path_.capacity(); }
     virtual bool Valid() { return true; }
     virtual const char* GetName() { return typeid(*this).name(); }
 
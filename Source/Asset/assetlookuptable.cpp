@@ -0,0 +1,114 @@
+//-----------------------------------------------------------------------------
+//           Name: assetlookuptable.cpp
+//      Developer: Wolfire Games LLC
+//    Description:
+//        License: Read below
+//-----------------------------------------------------------------------------
+//
+//
+//   Copyright 2022 Wolfire Games LLC
+//
+//   Licensed under the Apache License, Version 2.0 (the "License");
+//   you may not use this file except in compliance with the License.
+//   You may obtain a copy of the License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//   Unless required by applicable law or agreed to in writing, software
+//   distributed under the License is distributed on an "AS IS" BASIS,
+//   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//   See the License for the specific language governing permissions and
+//   limitations under the License.
+//
+//-----------------------------------------------------------------------------
+#include "assetlookuptable.h"
+
+const uint32_t AssetLookupTable::kInvalidSlot;
+
+bool AssetLookupTable::Key::operator==(const Key& other) const {
+    return name_id == other.name_id && load_flags == other.load_flags && type == other.type;
+}
+
+size_t AssetLookupTable::KeyHash::operator()(const Key& key) const {
+    uint64_t h = ((uint64_t)key.name_id << 32) | (uint64_t)(key.load_flags ^ (key.type << 24));
+    // 64-bit finalizer from MurmurHash3, the flat map wants well mixed low bits.
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return (size_t)h;
+}
+
+AssetLookupTable::AssetLookupTable() {
+}
+
+uint32_t AssetLookupTable::FindSlot(AssetType type, uint32_t load_flags, const std::string& rel_name) const {
+    ska::flat_hash_map<std::string, uint32_t>::const_iterator name_it = name_ids.find(rel_name);
+    if (name_it == name_ids.end()) {
+        return kInvalidSlot;
+    }
+
+    Key key;
+    key.name_id = name_it->second;
+    key.load_flags = load_flags;
+    key.type = (uint32_t)type;
+
+    ska::flat_hash_map<Key, uint32_t, KeyHash>::const_iterator asset_it = asset_ids.find(key);
+    if (asset_it == asset_ids.end()) {
+        return kInvalidSlot;
+    }
+    return GetSlot(asset_it->second);
+}
+
+uint32_t AssetLookupTable::GetSlot(uint32_t asset_id) const {
+    if (asset_id < slots.size()) {
+        return slots[asset_id];
+    }
+    return kInvalidSlot;
+}
+
+uint32_t AssetLookupTable::Insert(AssetType type, uint32_t load_flags, const std::string& rel_name, uint32_t asset_id, uint32_t slot) {
+    // Interned names are never released, there are only as many as there are distinct paths ever loaded.
+    uint32_t name_id = name_ids.insert(std::make_pair(rel_name, (uint32_t)name_ids.size())).first->second;
+
+    Key key;
+    key.name_id = name_id;
+    key.load_flags = load_flags;
+    key.type = (uint32_t)type;
+    asset_ids[key] = asset_id;
+
+    SetSlot(asset_id, slot);
+
+    return name_id;
+}
+
+void AssetLookupTable::Remove(AssetType type, uint32_t load_flags, uint32_t name_id, uint32_t asset_id) {
+    Key key;
+    key.name_id = name_id;
+    key.load_flags = load_flags;
+    key.type = (uint32_t)type;
+
+    ska::flat_hash_map<Key, uint32_t, KeyHash>::iterator asset_it = asset_ids.find(key);
+    if (asset_it != asset_ids.end() && asset_it->second == asset_id) {
+        asset_ids.erase(asset_it);
+    }
+
+    if (asset_id < slots.size()) {
+        slots[asset_id] = kInvalidSlot;
+    }
+}
+
+void AssetLookupTable::SetSlot(uint32_t asset_id, uint32_t slot) {
+    if (asset_id >= slots.size()) {
+        // Asset ids are handed out sequentially, so this stays dense.
+        slots.resize(asset_id + asset_id / 2 + 1024, kInvalidSlot);
+    }
+    slots[asset_id] = slot;
+}
+
+void AssetLookupTable::Clear() {
+    name_ids.clear();
+    asset_ids.clear();
+    slots.clear();
+}
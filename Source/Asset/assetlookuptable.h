@@ -0,0 +1,74 @@
+//-----------------------------------------------------------------------------
+//           Name: assetlookuptable.h
+//      Developer: Wolfire Games LLC
+//    Description: Hash index from (type, load flags, path) to asset id, and
+//                 from asset id to its slot in the asset manager list.
+//        License: Read below
+//-----------------------------------------------------------------------------
+//
+//
+//   Copyright 2022 Wolfire Games LLC
+//
+//   Licensed under the Apache License, Version 2.0 (the "License");
+//   you may not use this file except in compliance with the License.
+//   You may obtain a copy of the License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//   Unless required by applicable law or agreed to in writing, software
+//   distributed under the License is distributed on an "AS IS" BASIS,
+//   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//   See the License for the specific language governing permissions and
+//   limitations under the License.
+//
+//-----------------------------------------------------------------------------
+#pragma once
+
+#include <Asset/assettypes.h>
+#include <Internal/integer.h>
+#include <Utility/flat_hash_map.hpp>
+
+#include <string>
+#include <vector>
+
+/*
+ * Keeps AssetManager lookups O(1) regardless of how many assets are resident.
+ * Paths are interned to a small integer once, so the key compare on a hit is
+ * three integer compares instead of a strcmp.
+ */
+class AssetLookupTable {
+   public:
+    static const uint32_t kInvalidSlot = 0xFFFFFFFF;
+
+    AssetLookupTable();
+
+    // Returns the list slot of a matching asset, or kInvalidSlot.
+    uint32_t FindSlot(AssetType type, uint32_t load_flags, const std::string& rel_name) const;
+    // Returns the list slot of the asset with this id, or kInvalidSlot.
+    uint32_t GetSlot(uint32_t asset_id) const;
+
+    // Registers a new asset, returns the interned name id to pass to Remove().
+    uint32_t Insert(AssetType type, uint32_t load_flags, const std::string& rel_name, uint32_t asset_id, uint32_t slot);
+    void Remove(AssetType type, uint32_t load_flags, uint32_t name_id, uint32_t asset_id);
+    // Called when an asset is moved to another slot in the list.
+    void SetSlot(uint32_t asset_id, uint32_t slot);
+
+    void Clear();
+
+   private:
+    struct Key {
+        uint32_t name_id;
+        uint32_t load_flags;
+        uint32_t type;
+
+        bool operator==(const Key& other) const;
+    };
+
+    struct KeyHash {
+        size_t operator()(const Key& key) const;
+    };
+
+    ska::flat_hash_map<std::string, uint32_t> name_ids;
+    ska::flat_hash_map<Key, uint32_t, KeyHash> asset_ids;
+    std::vector<uint32_t> slots;
+};
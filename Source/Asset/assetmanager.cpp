@@ -55,12 +55,19 @@
 
 #include <Logging/logdata.h>
 #include <Utility/strings.h>
+#include <Compat/fileio.h>
+#include <XML/Parsers/levelassetspreloadparser.h>
 
 #include <cstdlib>
 #include <stdint.h>
 #include <stdio.h>
 #include <set>
 #include <limits>
+#include <algorithm>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
 
 #ifdef MEASURE_LOADS
 AssetLoadTime::AssetLoadTime(uint64_t time, uint32_t time_ms, const char* asset_type_name, AssetType asset_type) : time(time),
@@ -70,47 +77,155 @@ AssetLoadTime::AssetLoadTime(uint64_t time, uint32_t time_ms, const char* asset_
 }
 #endif
 
+AssetBatchLoadEntry::AssetBatchLoadEntry(AssetType type, const std::string& path, uint32_t load_flags) : type(type),
+                                                                                                        path(path),
+                                                                                                        load_flags(load_flags) {
+}
+
+AssetLoadTraceEntry::AssetLoadTraceEntry(AssetType type, const std::string& path, uint32_t load_flags, uint64_t load_time_ns) : type(type),
+                                                                                                                               path(path),
+                                                                                                                               load_flags(load_flags),
+                                                                                                                               load_time_ns(load_time_ns) {
+}
+
 AssetManager::AssetManager() : asset_id_counter(1),
                                asset_list(NULL),
                                asset_list_count(0),
                                asset_list_size(0),
                                load_id_counter(1),
                                loading_instances(256, 128),
-                               io_thread_manager(1),
-                               loading_thread_manager(1),
+                               io_thread_manager(&loaded_queue, 1),
+                               loading_thread_manager(&loaded_queue, 1),
                                load_warning_activated(false),
+                               load_trace_active(false),
+                               load_trace_time_left(0.0f),
                                asset_warning_count(0),
-                               asset_hold_count(0) {
+                               asset_hold_count(0),
+                               memory_budget(0),
+                               resident_bytes(0),
+                               use_clock(0) {
     LOG_ASSERT((int)ASSET_TYPE_FINAL < MAX_ASSET_TYPE_COUNT);
 
     memset(asset_type_count, 0, sizeof(int) * MAX_ASSET_TYPE_COUNT);
+    memset(type_memory_budget, 0, sizeof(size_t) * MAX_ASSET_TYPE_COUNT);
+    memset(type_resident_bytes, 0, sizeof(size_t) * MAX_ASSET_TYPE_COUNT);
 }
 
 AssetManager::~AssetManager() {
     free(asset_list);
     asset_list = NULL;
+    asset_lookup.Clear();
     asset_list_count = 0;
     asset_list_size = 0;
 }
 
 void AssetManager::Initialize() {
+    file_watcher.Initialize();
+}
+
+void AssetManager::SetWorkerThreadCount(int io_threads, int decode_threads) {
+    int cores = (int)std::thread::hardware_concurrency();
+    if (io_threads <= 0) {
+        io_threads = 2;
+    }
+    if (decode_threads <= 0) {
+        // Leave one core for the main thread.
+        decode_threads = std::max(1, std::min(cores - 1, 8));
+    }
+
+    io_thread_manager.SetThreadCount(io_threads);
+    loading_thread_manager.SetThreadCount(decode_threads);
+    LOGI << "Asset manager using " << io_thread_manager.GetThreadCount() << " io threads and " << loading_thread_manager.GetThreadCount() << " decode threads" << std::endl;
+}
+
+void AssetManager::UnloadAsset(uint32_t index) {
+    // LOGI << "Unloading unreferenced " << asset_list[index].asset_type_name << std::endl;
+    Asset* asset = asset_list[index].asset;
+    AssetLoaderBase* loader = asset->NewLoader();
+    loader->Initialize(asset_list[index].rel_name, asset_list[index].load_flags, asset);
+    for (unsigned k = 0; k < loader->GetAssetUnloadStepCount(); k++) {
+        loader->DoUnloadStep(k);
+    }
+    delete loader;
+    DeallocateAsset(asset_list[index].id);
+}
+
+bool AssetManager::IsOverBudget(AssetType type) {
+    return (memory_budget > 0 && resident_bytes > memory_budget) ||
+           (type_memory_budget[(int)type] > 0 && type_resident_bytes[(int)type] > type_memory_budget[(int)type]);
+}
+
+bool AssetManager::HasAnyBudget() {
+    if (memory_budget > 0) {
+        return true;
+    }
+    for (int i = 0; i < MAX_ASSET_TYPE_COUNT; i++) {
+        if (type_memory_budget[i] > 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool AssetManager::IsAnyOverBudget() {
+    if (memory_budget > 0 && resident_bytes > memory_budget) {
+        return true;
+    }
+    for (int i = 0; i < MAX_ASSET_TYPE_COUNT; i++) {
+        if (type_memory_budget[i] > 0 && type_resident_bytes[i] > type_memory_budget[i]) {
+            return true;
+        }
+    }
+    return false;
+}
+
+int AssetManager::EvictOverBudget(int limit) {
+    if (!IsAnyOverBudget()) {
+        return 0;
+    }
+
+    // Sort the unreferenced assets once, oldest first, then unload until back under budget.
+    // Ids are kept instead of indices because unloading moves the last entry into the freed slot.
+    eviction_candidates.clear();
+    for (uint32_t i = 0; i < asset_list_count; i++) {
+        const AssetInstanceCounter& entry = asset_list[i];
+        if (entry.count <= 0 && entry.hold_load_mask == 0x0 && entry.load_state == ASSET_LOADING_LOADED) {
+            eviction_candidates.push_back(std::make_pair(entry.last_used, entry.id));
+        }
+    }
+    std::sort(eviction_candidates.begin(), eviction_candidates.end());
+
+    int removes = 0;
+    for (size_t i = 0; i < eviction_candidates.size() && (removes < limit || limit <= 0); i++) {
+        uint32_t index = asset_lookup.GetSlot(eviction_candidates[i].second);
+        if (index == AssetLookupTable::kInvalidSlot || !IsOverBudget(asset_list[index].type)) {
+            continue;
+        }
+        UnloadAsset(index);
+        removes++;
+    }
+    return removes;
 }
 
 bool AssetManager::UnloadUnreferenced(int limit, unsigned int required_attempts) {
     int removes = 0;
+
+    if (HasAnyBudget()) {
+        size_t pre_bytes = resident_bytes;
+        removes = EvictOverBudget(limit);
+
+        if (removes > 0) {
+            LOGI << "Evicted " << removes << " unreferenced assets (" << (pre_bytes - resident_bytes) / (1024 * 1024) << "MiB), "
+                 << resident_bytes / (1024 * 1024) << "MiB resident, " << memory_budget / (1024 * 1024) << "MiB global budget" << std::endl;
+        }
+        return removes > 0;
+    }
+
     for (int i = (int)asset_list_count - 1; i >= 0; i--) {
         if (asset_list[i].count <= 0) {
             if (asset_list[i].hold_load_mask == 0x0) {
                 if (asset_list[i].deallocate_attempts >= required_attempts) {
-                    // LOGI << "Unloading unreferenced " << asset_list[i].asset_type_name << std::endl;
-                    Asset* asset = asset_list[i].asset;
-                    AssetLoaderBase* loader = asset->NewLoader();
-                    loader->Initialize(asset_list[i].rel_name, asset_list[i].load_flags, asset);
-                    for (unsigned k = 0; k < loader->GetAssetUnloadStepCount(); k++) {
-                        loader->DoUnloadStep(k);
-                    }
-                    delete loader;
-                    DeallocateAsset(asset_list[i].id, i);
+                    UnloadAsset(i);
                     removes++;
                 } else {
                     asset_list[i].deallocate_attempts++;
@@ -126,38 +241,111 @@ bool AssetManager::UnloadUnreferenced(int limit, unsigned int required_attempts)
     return removes > 0;
 }
 
-uint32_t AssetManager::GetAsset(uint32_t asset_id) {
-    for (unsigned i = 0; i < asset_list_count; i++) {
-        if (asset_list[i].id == asset_id) {
-            return i;
+bool AssetManager::UnloadAllUnreferenced() {
+    int removes = 0;
+    for (int i = (int)asset_list_count - 1; i >= 0; i--) {
+        if (asset_list[i].count <= 0 && asset_list[i].hold_load_mask == 0x0) {
+            UnloadAsset(i);
+            removes++;
         }
     }
-    return std::numeric_limits<uint32_t>::max();
+    return removes > 0;
 }
 
-void AssetManager::DeallocateAsset(uint32_t asset_id, uint32_t starting_id) {
-    bool shifting = false;
-    for (unsigned int i = starting_id; i < asset_list_count; i++) {
-        if (shifting) {  // Moving all other assets one step
-            asset_list[i - 1] = asset_list[i];
-        } else {  // Searching
-            if (asset_list[i].id == asset_id) {
-                if (asset_list[i].load_warning) {
-                    asset_warning_count--;
-                }
-                if (asset_list[i].hold_load_mask != 0x0) {
-                    asset_hold_count--;
-                }
+void AssetManager::UpdateResidentBytes(uint32_t index) {
+    AssetInstanceCounter& entry = asset_list[index];
+    resident_bytes -= entry.resident_bytes;
+    type_resident_bytes[(int)entry.type] -= entry.resident_bytes;
 
-                delete asset_list[i].asset;
-                asset_type_count[(int)asset_list[i].type]--;
-                shifting = true;
-            }
+    entry.resident_bytes = entry.asset->GetResidentBytes();
+
+    resident_bytes += entry.resident_bytes;
+    type_resident_bytes[(int)entry.type] += entry.resident_bytes;
+}
+
+void AssetManager::WatchAssetFile(uint32_t index) {
+    AssetInstanceCounter& entry = asset_list[index];
+    if (!file_watcher.IsActive() || entry.watch_id != FileWatcher::kInvalidWatch) {
+        return;
+    }
+
+    Path file_path = FindFilePath(entry.rel_name, kDataPaths | kModPaths | kAbsPath, false);
+    if (file_path.isValid()) {
+        entry.watch_id = file_watcher.Watch(file_path.GetFullPathStr());
+    }
+}
+
+void AssetManager::PollFileChanges() {
+    changed_watch_ids.clear();
+    file_watcher.GetChangedFiles(changed_watch_ids);
+    if (changed_watch_ids.empty()) {
+        return;
+    }
+
+    std::sort(changed_watch_ids.begin(), changed_watch_ids.end());
+    for (uint32_t i = 0; i < asset_list_count; i++) {
+        if (asset_list[i].watch_id != FileWatcher::kInvalidWatch &&
+            std::binary_search(changed_watch_ids.begin(), changed_watch_ids.end(), asset_list[i].watch_id)) {
+            asset_list[i].file_changed = true;
         }
     }
+}
+
+void AssetManager::SetMemoryBudget(size_t bytes) {
+    memory_budget = bytes;
+}
+
+void AssetManager::SetMemoryBudget(AssetType type, size_t bytes) {
+    type_memory_budget[(int)type] = bytes;
+}
+
+size_t AssetManager::GetMemoryBudget() {
+    return memory_budget;
+}
+
+size_t AssetManager::GetMemoryBudget(AssetType type) {
+    return type_memory_budget[(int)type];
+}
+
+size_t AssetManager::GetResidentBytes() {
+    return resident_bytes;
+}
+
+size_t AssetManager::GetResidentBytes(AssetType type) {
+    return type_resident_bytes[(int)type];
+}
+
+uint32_t AssetManager::GetAsset(uint32_t asset_id) {
+    return asset_lookup.GetSlot(asset_id);
+}
+
+void AssetManager::DeallocateAsset(uint32_t asset_id) {
+    uint32_t index = asset_lookup.GetSlot(asset_id);
+    if (index == AssetLookupTable::kInvalidSlot) {
+        return;
+    }
+
+    AssetInstanceCounter& entry = asset_list[index];
+    if (entry.load_warning) {
+        asset_warning_count--;
+    }
+    if (entry.hold_load_mask != 0x0) {
+        asset_hold_count--;
+    }
+
+    delete entry.asset;
+    asset_type_count[(int)entry.type]--;
+    resident_bytes -= entry.resident_bytes;
+    type_resident_bytes[(int)entry.type] -= entry.resident_bytes;
+    asset_lookup.Remove(entry.type, entry.load_flags, entry.name_id, asset_id);
+    if (entry.watch_id != FileWatcher::kInvalidWatch) {
+        file_watcher.Unwatch(entry.watch_id);
+    }
 
-    if (shifting) {  // We removed something
-        asset_list_count--;
+    asset_list_count--;
+    if (index != asset_list_count) {
+        asset_list[index] = asset_list[asset_list_count];
+        asset_lookup.SetSlot(asset_list[index].id, index);
     }
 }
 
@@ -169,7 +357,7 @@ void AssetManager::Dispose() {
     LOGI << "Releasing hold on all preloaded assets" << std::endl;
     ReleaseAssetHoldLoad(HOLD_LOAD_MASK_PRELOAD);
     LOGI << "Disposing asset manager" << std::endl;
-    while (UnloadUnreferenced(0, 0)) {
+    while (UnloadAllUnreferenced()) {
     };
 
     if (asset_list_count > 0) {
@@ -197,25 +385,22 @@ void AssetManager::ReallocAssetInstanceCounter(size_t new_size) {
 }
 
 void AssetManager::IncrementAsset(uint32_t asset_id) {
-    for (size_t i = 0; i < asset_list_count; i++) {
-        if (asset_list[i].id == asset_id) {
-            asset_list[i].deallocate_attempts = 0;
-            asset_list[i].count++;
-            return;
-        }
+    uint32_t index = asset_lookup.GetSlot(asset_id);
+    if (index != AssetLookupTable::kInvalidSlot) {
+        asset_list[index].deallocate_attempts = 0;
+        asset_list[index].last_used = use_clock++;
+        asset_list[index].count++;
+        return;
     }
     LOGW << "Unable to find asset of id for increment: " << asset_id << std::endl;
 }
 
 void AssetManager::DecrementAsset(uint32_t asset_id) {
-    for (size_t i = 0; i < asset_list_count; i++) {
-        if (asset_list[i].id == asset_id) {
-            asset_list[i].count--;
-            if (asset_list[i].count <= 0) {
-                // LOGI << "Asset count is " << asset_list[i].count << " " <<  asset_list[i].asset_type_name << " " << asset_list[i].asset->path_ << std::endl;
-            }
-            return;
-        }
+    uint32_t index = asset_lookup.GetSlot(asset_id);
+    if (index != AssetLookupTable::kInvalidSlot) {
+        asset_list[index].last_used = use_clock++;
+        asset_list[index].count--;
+        return;
     }
     LOGW << "Unable to find asset of id for decrement: " << asset_id << std::endl;
 }
@@ -322,23 +507,187 @@ void AssetManager::LoadSync(AssetType type, const std::string& str, uint32_t loa
     }
 }
 
+struct AssetBatchPrefetchJob {
+    const std::vector<AssetBatchLoadEntry>* entries;
+    std::vector<char>* found;
+    std::vector<char>* skip_prefetch;
+    std::atomic<size_t> next;
+    std::atomic<uint64_t> bytes_read;
+
+    std::mutex mutex;
+    std::condition_variable finished;
+    int pending_steps;  // Queued on the io threads and not done yet
+};
+
+static void AssetBatchPrefetch(AssetBatchPrefetchJob* job) {
+    static const size_t kReadSize = 64 * 1024;
+    std::vector<char> buffer(kReadSize);
+
+    for (size_t i = job->next++; i < job->entries->size(); i = job->next++) {
+        const AssetBatchLoadEntry& entry = (*job->entries)[i];
+        Path p = FindFilePath(entry.path, kAnyPath, false);
+        (*job->found)[i] = p.isValid();
+        if (!p.isValid() || (*job->skip_prefetch)[i]) {
+            continue;
+        }
+
+        // Textures are usually read from their converted dds rather than the source image.
+        if (entry.type == TEXTURE_ASSET) {
+            Path image_path = FindImagePath(entry.path.c_str(), kAnyPath, false);
+            if (image_path.isValid()) {
+                p = image_path;
+            }
+        }
+
+        // Pull the file into the OS file cache, so the serial load doesn't wait on the disk.
+        FILE* file = my_fopen(p.GetFullPath(), "rb");
+        if (file) {
+            size_t read;
+            while ((read = fread(&buffer[0], 1, kReadSize, file)) > 0) {
+                job->bytes_read += read;
+            }
+            fclose(file);
+        }
+    }
+}
+
+/*
+ * Runs AssetBatchPrefetch() as a load step on the asset io threads. It doesn't belong
+ * to an asset, its steps are queued with load id 0 which no loading instance has, so
+ * Update() drops them when they come back.
+ */
+class AssetBatchPrefetchLoader : public AssetLoaderBase {
+   public:
+    explicit AssetBatchPrefetchLoader(AssetBatchPrefetchJob* job) : job(job) {
+    }
+
+    void Initialize(const std::string& path, uint32_t load_flags, Asset* asset) override {
+    }
+
+    const AssetLoaderStepType* GetAssetLoadSteps() const override {
+        static const AssetLoaderStepType tl[] = {ASSET_LOADER_DISK_IO};
+        return tl;
+    }
+
+    const int GetAssetLoadStepCount() const override {
+        return 1;
+    }
+
+    int DoLoadStep(const int step_id) override {
+        AssetBatchPrefetchJob* job = this->job;
+        AssetBatchPrefetch(job);
+
+        // The batch may return and free this loader as soon as the last step is done.
+        std::lock_guard<std::mutex> lock(job->mutex);
+        job->pending_steps--;
+        job->finished.notify_all();
+        return kLoadOk;
+    }
+
+    const AssetLoaderStepType* GetAssetUnloadSteps() const override {
+        return NULL;
+    }
+
+    const unsigned GetAssetUnloadStepCount() const override {
+        return 0;
+    }
+
+    bool DoUnloadStep(const int step_id) override {
+        return true;
+    }
+
+    const char* GetTypeName() override {
+        return "AssetBatchPrefetch";
+    }
+
+    const char* GetLoadErrorString() override {
+        return "";
+    }
+
+    const char* GetLoadErrorStringExtended() override {
+        return "";
+    }
+
+   private:
+    AssetBatchPrefetchJob* job;
+};
+
+void AssetManager::LoadSyncBatch(const std::vector<AssetBatchLoadEntry>& entries, uint32_t hold_load_mask) {
+    PrecisionStopwatch total_watch;
+
+    std::vector<char> found(entries.size(), 0);
+    std::vector<char> skip_prefetch(entries.size(), 0);
+    for (size_t i = 0; i < entries.size(); i++) {
+        uint32_t index = asset_lookup.FindSlot(entries[i].type, entries[i].load_flags, SanitizePath(entries[i].path));
+        skip_prefetch[i] = index != AssetLookupTable::kInvalidSlot && asset_list[index].load_state == ASSET_LOADING_LOADED;
+    }
+
+    AssetBatchPrefetchJob job;
+    job.entries = &entries;
+    job.found = &found;
+    job.skip_prefetch = &skip_prefetch;
+    job.next = 0;
+    job.bytes_read = 0;
+
+    // One step per io thread, each works through the entries until they run out. This
+    // thread takes part as well, so the batch can't stall behind a busy io queue.
+    AssetBatchPrefetchLoader loader(&job);
+    int step_count = std::max(0, std::min(io_thread_manager.GetThreadCount(), (int)entries.size() - 1));
+    job.pending_steps = step_count;
+    for (int i = 0; i < step_count; i++) {
+        io_thread_manager.queue_in.Push(AssetLoaderThreadedInstance(&loader, 0, 0, ASSET_LOAD_PRIORITY_BLOCKING));
+    }
+    int thread_count = step_count + 1;
+
+    AssetBatchPrefetch(&job);
+    {
+        std::unique_lock<std::mutex> lock(job.mutex);
+        while (job.pending_steps > 0) {
+            job.finished.wait(lock);
+        }
+    }
+
+    uint64_t prefetch_ns = total_watch.StopAndReportNanoseconds();
+
+    int type_loads[MAX_ASSET_TYPE_COUNT] = {0};
+    uint64_t type_ns[MAX_ASSET_TYPE_COUNT] = {0};
+
+    PrecisionStopwatch watch;
+    for (size_t i = 0; i < entries.size(); i++) {
+        if (found[i]) {
+            watch.Start();
+            LoadSync(entries[i].type, entries[i].path, entries[i].load_flags, hold_load_mask);
+            type_ns[(int)entries[i].type] += watch.StopAndReportNanoseconds();
+            type_loads[(int)entries[i].type]++;
+        }
+    }
+
+    uint64_t load_ns = total_watch.StopAndReportNanoseconds();
+
+    LOGI << "Batch loaded " << entries.size() << " assets in " << (prefetch_ns + load_ns) / 1000000 << "ms, "
+         << prefetch_ns / 1000000 << "ms resolving and reading " << job.bytes_read / 1024 << "KiB on " << thread_count << " threads, "
+         << load_ns / 1000000 << "ms loading" << std::endl;
+
+    std::vector<int> order;
+    for (int i = 0; i < (int)ASSET_TYPE_FINAL; i++) {
+        if (type_loads[i] > 0) {
+            order.push_back(i);
+        }
+    }
+    std::sort(order.begin(), order.end(), [&type_ns](int a, int b) { return type_ns[a] > type_ns[b]; });
+    for (int type : order) {
+        LOGI << "    " << GetAssetTypeString((AssetType)type) << ": " << type_loads[type] << " assets, " << type_ns[type] / 1000000 << "ms" << std::endl;
+    }
+}
+
 void AssetManager::Update() {
     UnloadUnreferenced(1, 60 * 20);
 
     std::vector<uint32_t> remove_loading_instance_indexes;
 
     // Pop all finished async jobs.
-    while (io_thread_manager.queue_out.Count() > 0) {
-        AssetLoaderThreadedInstance alti = io_thread_manager.queue_out.Pop();
-        for (unsigned i = 0; i < loading_instances.Count(); i++) {
-            if (alti.load_id == loading_instances[i].load_id) {
-                loading_instances[i].in_queue = false;
-                loading_instances[i].load_step_result = alti.return_state;
-            }
-        }
-    }
-    while (loading_thread_manager.queue_out.Count() > 0) {
-        AssetLoaderThreadedInstance alti = loading_thread_manager.queue_out.Pop();
+    while (loaded_queue.Count() > 0) {
+        AssetLoaderThreadedInstance alti = loaded_queue.Pop();
         for (unsigned i = 0; i < loading_instances.Count(); i++) {
             if (alti.load_id == loading_instances[i].load_id) {
                 loading_instances[i].in_queue = false;
@@ -378,7 +727,8 @@ void AssetManager::Update() {
                         AssetLoaderThreadedInstance(
                             loading_instance.loader,
                             loading_instance.load_id,
-                            loading_instance.next_step_id));
+                            loading_instance.next_step_id,
+                            loading_instance.priority));
                 }
                 if (asset_type == ASSET_LOADER_ASYNC_JOB) {
                     loading_instance.in_queue = true;
@@ -386,7 +736,8 @@ void AssetManager::Update() {
                         AssetLoaderThreadedInstance(
                             loading_instance.loader,
                             loading_instance.load_id,
-                            loading_instance.next_step_id));
+                            loading_instance.next_step_id,
+                            loading_instance.priority));
                 }
                 if (asset_type == ASSET_LOADER_SYNC_JOB) {
                     loading_instance.load_step_result = loading_instance.loader->DoLoadStep(loading_instance.next_step_id);
@@ -395,6 +746,8 @@ void AssetManager::Update() {
             } else if ((int)loading_instance.next_step_id >= loading_instance.loader->GetAssetLoadStepCount()) {
                 uint32_t asset_index = GetAsset(loading_instance.asset_id);
                 asset_list[asset_index].load_state = ASSET_LOADING_LOADED;
+                UpdateResidentBytes(asset_index);
+                WatchAssetFile(asset_index);
 
                 if (loading_instance.load_step_result == kLoadOk) {
                     loading_instance.caller->AssetLoadedCallback(loading_instance.load_id, loading_instance.asset_ref);
@@ -413,6 +766,27 @@ void AssetManager::Update() {
     loading_instances.Deallocate(remove_loading_instance_indexes);
 }
 
+void AssetManager::PromoteAsyncLoad(uint32_t asset_id) {
+    for (unsigned i = 0; i < loading_instances.Count(); i++) {
+        LoadingInstance& loading_instance = loading_instances[i];
+        if (loading_instance.asset_id == asset_id && loading_instance.priority < ASSET_LOAD_PRIORITY_BLOCKING) {
+            loading_instance.priority = ASSET_LOAD_PRIORITY_BLOCKING;
+            io_thread_manager.queue_in.Promote(loading_instance.load_id, ASSET_LOAD_PRIORITY_BLOCKING);
+            loading_thread_manager.queue_in.Promote(loading_instance.load_id, ASSET_LOAD_PRIORITY_BLOCKING);
+        }
+    }
+}
+
+void AssetManager::WaitForAsyncLoad(uint32_t asset_id) {
+    for (unsigned i = 0; i < loading_instances.Count(); i++) {
+        if (loading_instances[i].asset_id == asset_id && loading_instances[i].in_queue) {
+            // Steps run on the main thread don't signal the queue, so don't sleep for long.
+            loaded_queue.WaitNonEmpty(16);
+            return;
+        }
+    }
+}
+
 void AssetManager::ReleaseAssetHoldLoad(uint32_t hold_load_mask) {
     for (unsigned i = 0; i < asset_list_count; i++) {
         if (asset_list[i].hold_load_mask != 0x0 && (asset_list[i].hold_load_mask & ~hold_load_mask) == 0x0) {
@@ -440,6 +814,87 @@ void AssetManager::DumpLoadWarningData(const char* destination) {
     }
 }
 
+void AssetManager::StartLoadTrace(const std::string& level_name, const std::string& manifest_path, float play_seconds) {
+    load_trace.clear();
+    load_trace_level_name = level_name;
+    load_trace_manifest_path = manifest_path;
+    load_trace_time_left = play_seconds;
+    load_trace_active = true;
+    LOGI << "Recording asset load trace for " << level_name << std::endl;
+}
+
+void AssetManager::UpdateLoadTrace(float timestep) {
+    if (load_trace_active) {
+        load_trace_time_left -= timestep;
+        if (load_trace_time_left <= 0.0f) {
+            StopLoadTrace();
+        }
+    }
+}
+
+bool AssetManager::IsLoadTraceActive() {
+    return load_trace_active;
+}
+
+void AssetManager::RecordLoadTrace(AssetType type, const std::string& path, uint32_t load_flags, uint64_t load_time_ns) {
+    load_trace.push_back(AssetLoadTraceEntry(type, path, load_flags, load_time_ns));
+}
+
+static bool AssetLoadTraceKeyLess(const AssetLoadTraceEntry& a, const AssetLoadTraceEntry& b) {
+    if (a.type != b.type) {
+        return a.type < b.type;
+    }
+    if (a.load_flags != b.load_flags) {
+        return a.load_flags < b.load_flags;
+    }
+    return a.path < b.path;
+}
+
+static bool AssetLoadTraceCostGreater(const LevelAssetPreloadParser::Asset& a, const LevelAssetPreloadParser::Asset& b) {
+    return a.load_time_us > b.load_time_us;
+}
+
+void AssetManager::StopLoadTrace() {
+    if (!load_trace_active) {
+        return;
+    }
+    load_trace_active = false;
+
+    // Deduplicate, keeping the cost of the request that actually did the load.
+    std::stable_sort(load_trace.begin(), load_trace.end(), AssetLoadTraceKeyLess);
+    LevelAssetPreloadParser manifest;
+    for (size_t i = 0; i < load_trace.size(); i++) {
+        const AssetLoadTraceEntry& entry = load_trace[i];
+        if (!manifest.assets.empty() && i > 0 && !AssetLoadTraceKeyLess(load_trace[i - 1], entry)) {
+            LevelAssetPreloadParser::Asset& last = manifest.assets.back();
+            last.load_time_us = std::max(last.load_time_us, (uint32_t)(entry.load_time_ns / 1000));
+            continue;
+        }
+
+        LevelAssetPreloadParser::Asset asset;
+        asset.path = entry.path;
+        asset.level_name = load_trace_level_name;
+        asset.all_levels = false;
+        asset.asset_type = entry.type;
+        asset.load_flags = entry.load_flags;
+        asset.size = GetFileSize(FindFilePath(entry.path, kAnyPath, false));
+        asset.load_time_us = (uint32_t)(entry.load_time_ns / 1000);
+        manifest.assets.push_back(asset);
+    }
+    load_trace.clear();
+
+    // Most expensive first, so they get the most overlap with the rest of the preload.
+    std::stable_sort(manifest.assets.begin(), manifest.assets.end(), AssetLoadTraceCostGreater);
+
+    std::string path = AssemblePath(GetWritePath(CoreGameModID), load_trace_manifest_path);
+    CreateParentDirs(path);
+    if (manifest.Save(path)) {
+        LOGI << "Wrote asset load manifest with " << manifest.assets.size() << " assets to " << path << std::endl;
+    } else {
+        LOGE << "Failed to write asset load manifest to " << path << std::endl;
+    }
+}
+
 size_t AssetManager::GetLoadedAssetCount() {
     return asset_list_count;
 }
@@ -456,6 +911,22 @@ int AssetManager::GetAssetHoldCount() {
     return asset_hold_count;
 }
 
+AssetQueueStats AssetManager::GetIOQueueStats() {
+    return io_thread_manager.queue_in.GetStats();
+}
+
+AssetQueueStats AssetManager::GetDecodeQueueStats() {
+    return loading_thread_manager.queue_in.GetStats();
+}
+
+int AssetManager::GetIOThreadCount() {
+    return io_thread_manager.GetThreadCount();
+}
+
+int AssetManager::GetDecodeThreadCount() {
+    return loading_thread_manager.GetThreadCount();
+}
+
 const char* AssetManager::GetAssetName(uint32_t index) {
     if (index >= 0 && index < asset_list_count) {
         return asset_list[index].rel_name;
@@ -29,13 +29,16 @@
 #include <Asset/assettypes.h>
 #include <Asset/assetmanagerthreadhandler.h>
 #include <Asset/assetloaderrors.h>
+#include <Asset/assetlookuptable.h>
 
 #include <Internal/common.h>
 #include <Internal/datemodified.h>
+#include <Internal/filewatcher.h>
 #include <Internal/error.h>
 
 #include <Logging/logdata.h>
 #include <Utility/timing.h>
+#include <Internal/stopwatch.h>
 #include <Threading/sdl_wrapper.h>
 #include <Utility/simple_vector.h>
 #include <XML/Parsers/assetloadwarningparser.h>
@@ -54,11 +57,16 @@ enum AssetLoadingState {
 
 struct AssetInstanceCounter {
     uint32_t id;
+    uint32_t name_id;
     uint32_t hold_load_mask;
     uint32_t load_flags;
     uint16_t count;
     int64_t modified;
+    int watch_id;       // FileWatcher id of the resolved path, kInvalidWatch if changes have to be polled for
+    bool file_changed;  // Set by PollFileChanges(), cleared by Reload()
     uint32_t deallocate_attempts;
+    uint64_t last_used;  // Value of the asset manager use clock when the reference count last changed
+    size_t resident_bytes;
     AssetType type;
     const char* asset_type_name;
     Asset* asset;
@@ -79,11 +87,29 @@ struct LoadingInstance {
     AssetLoaderBase* loader;
     AssetLoadedCallbackInterface* caller;
     bool in_queue;
+    int priority;
     uint32_t next_step_id;
     int load_step_result;
     AssetRefBase* asset_ref;
 };
 
+struct AssetBatchLoadEntry {
+    AssetBatchLoadEntry(AssetType type, const std::string& path, uint32_t load_flags);
+
+    AssetType type;
+    std::string path;
+    uint32_t load_flags;
+};
+
+struct AssetLoadTraceEntry {
+    AssetLoadTraceEntry(AssetType type, const std::string& path, uint32_t load_flags, uint64_t load_time_ns);
+
+    AssetType type;
+    std::string path;
+    uint32_t load_flags;
+    uint64_t load_time_ns;
+};
+
 #ifdef MEASURE_LOADS
 struct AssetLoadTime {
     AssetLoadTime(uint64_t time, uint32_t time_ms, const char* asset_type_name, AssetType asset_type);
@@ -110,33 +136,68 @@ class AssetManager {
     char load_warning_level_name[256];
     AssetLoadWarningParser load_warning_instances;
 
+    bool load_trace_active;
+    float load_trace_time_left;
+    std::string load_trace_level_name;
+    std::string load_trace_manifest_path;
+    std::vector<AssetLoadTraceEntry> load_trace;
+
+    void RecordLoadTrace(AssetType type, const std::string& path, uint32_t load_flags, uint64_t load_time_ns);
+
     uint32_t asset_id_counter;
 
     AssetInstanceCounter* asset_list;
     size_t asset_list_count;
     size_t asset_list_size;
 
+    AssetLookupTable asset_lookup;
+
     void ReallocAssetInstanceCounter(size_t new_size);
 
     uint32_t load_id_counter;
 
     SimpleVector<LoadingInstance> loading_instances;
 
+    // Shared by both thread pools so the main thread can wait on a single queue.
+    AssetManagerThreadedInstanceQueue loaded_queue;
     AssetManagerThreadHandler io_thread_manager;
     AssetManagerThreadHandler loading_thread_manager;
 
     static const int MAX_ASSET_TYPE_COUNT = 32;
     int asset_type_count[MAX_ASSET_TYPE_COUNT];
 
+    // Budgets in bytes, zero means no limit. Without any global or per type budget
+    // the old behavior of unloading anything unreferenced for long enough is used.
+    size_t memory_budget;
+    size_t type_memory_budget[MAX_ASSET_TYPE_COUNT];
+    size_t resident_bytes;
+    size_t type_resident_bytes[MAX_ASSET_TYPE_COUNT];
+    uint64_t use_clock;
+
+    void UpdateResidentBytes(uint32_t index);
+
+    FileWatcher file_watcher;
+    std::vector<int> changed_watch_ids;
+
+    void WatchAssetFile(uint32_t index);
+    // Flags assets whose watched file changed since the last call.
+    void PollFileChanges();
+    void UnloadAsset(uint32_t index);
+    bool IsOverBudget(AssetType type);
+    bool HasAnyBudget();
+    bool IsAnyOverBudget();
+    // Unloads unreferenced assets least recently used first while their budget is exceeded.
+    int EvictOverBudget(int limit);
+    std::vector<std::pair<uint64_t, uint32_t> > eviction_candidates;  // (last_used, id), reused between calls
+
     int asset_warning_count;
     int asset_hold_count;
 
     template <typename TAsset>
     uint32_t AllocateAsset(const std::string& rel_path, uint32_t load_flags) {
-        for (uint32_t id = 0; id < asset_list_count; id++) {
-            if (asset_list[id].type == TAsset::GetType() && asset_list[id].load_flags == load_flags && strcmp(asset_list[id].rel_name, rel_path.c_str()) == 0) {
-                return id;
-            }
+        uint32_t existing_index = asset_lookup.FindSlot(TAsset::GetType(), load_flags, rel_path);
+        if (existing_index != AssetLookupTable::kInvalidSlot) {
+            return existing_index;
         }
 
         if (asset_list_count == asset_list_size) {
@@ -161,7 +222,13 @@ class AssetManager {
         asset_list[asset_list_count].type = TAsset::GetType();
         asset_list[asset_list_count].asset_type_name = TAsset::GetTypeName();
         asset_list[asset_list_count].id = asset_id;
+        asset_list[asset_list_count].name_id = asset_lookup.Insert(TAsset::GetType(), load_flags, rel_path, asset_id, (uint32_t)asset_list_count);
         asset_list[asset_list_count].count = 0;
+        asset_list[asset_list_count].deallocate_attempts = 0;
+        asset_list[asset_list_count].last_used = use_clock++;
+        asset_list[asset_list_count].resident_bytes = 0;
+        asset_list[asset_list_count].watch_id = FileWatcher::kInvalidWatch;
+        asset_list[asset_list_count].file_changed = false;
         asset_list[asset_list_count].load_state = ASSET_LOADING_UNLOADED;
         asset_list[asset_list_count].load_warning = has_warning;
         strncpy(asset_list[asset_list_count].rel_name, rel_path.c_str(), kPathSize);
@@ -177,7 +244,13 @@ class AssetManager {
 
     uint32_t GetAsset(uint32_t asset_id);
 
-    void DeallocateAsset(uint32_t asset_id, uint32_t starting_id);
+    // Swaps the last asset into the freed slot, so list indices are not stable across this call.
+    void DeallocateAsset(uint32_t asset_id);
+
+    // Move queued steps for the asset ahead of other loads, used when the main thread blocks on it.
+    void PromoteAsyncLoad(uint32_t asset_id);
+    // Sleep until a worker finishes a step, if a worker is currently holding a step of the asset.
+    void WaitForAsyncLoad(uint32_t asset_id);
 
    public:
     // Increment reference count to asset, indicating there are more valid references in existance.
@@ -187,21 +260,48 @@ class AssetManager {
     void DecrementAsset(uint32_t asset_id);
 
     void Initialize();
+    // Zero picks a count based on the number of cores.
+    void SetWorkerThreadCount(int io_threads, int decode_threads);
 
+    // With a memory budget set, evicts least recently used unreferenced assets only while over budget
+    // and ignores required_attempts. Otherwise unloads assets that have been unreferenced for required_attempts calls.
     bool UnloadUnreferenced(int limit, unsigned int required_attempts);
+    bool UnloadAllUnreferenced();
+
+    void SetMemoryBudget(size_t bytes);
+    void SetMemoryBudget(AssetType type, size_t bytes);
+    size_t GetMemoryBudget();
+    size_t GetMemoryBudget(AssetType type);
+    size_t GetResidentBytes();
+    size_t GetResidentBytes(AssetType type);
 
+    /*
+     * Reloads assets of this type whose file has changed. Assets with a file watch
+     * are only touched if an event came in for them, the rest have their path
+     * resolved and modification date compared.
+     */
     template <typename TAsset>
     void Reload() {
         LOGI << "Reloading " << TAsset::GetTypeName() << std::endl;
+        PollFileChanges();
         int64_t new_modified;
         for (size_t i = 0; i < asset_list_count; i++) {
             if (asset_list[i].type == TAsset::GetType()) {
                 TAsset* asset = static_cast<TAsset*>(asset_list[i].asset);
+                if (asset_list[i].watch_id != FileWatcher::kInvalidWatch) {
+                    if (asset_list[i].file_changed) {
+                        asset_list[i].file_changed = false;
+                        asset->Reload();
+                        UpdateResidentBytes(i);
+                    }
+                    continue;
+                }
                 Path file_path = FindFilePath(asset->path_, kDataPaths | kModPaths | kAbsPath, false);
                 new_modified = GetDateModifiedInt64(file_path.GetFullPath());
                 if (asset_list[i].modified != new_modified) {
                     asset_list[i].modified = new_modified;
                     asset->Reload();
+                    UpdateResidentBytes(i);
                 }
             }
         }
@@ -228,6 +328,10 @@ class AssetManager {
         uint32_t asset_index = AllocateAsset<TAsset>(str, load_flags);
         uint32_t load_index = loading_instances.Allocate();
 
+        if (load_trace_active) {
+            RecordLoadTrace(TAsset::GetType(), str, load_flags, 0);
+        }
+
         loading_instances[load_index].load_id = load_id_counter++;
         loading_instances[load_index].asset_id = asset_list[asset_index].id;
 
@@ -239,6 +343,7 @@ class AssetManager {
 
         if (asset_list[asset_index].load_state == ASSET_LOADING_LOADED || asset_list[asset_index].load_state == ASSET_LOADING_LOADING) {
             loading_instances[load_index].in_queue = false;
+            loading_instances[load_index].priority = ASSET_LOAD_PRIORITY_NORMAL;
             loading_instances[load_index].next_step_id = std::numeric_limits<uint32_t>::max();  // If we loaded, we did all the steps.
             loading_instances[load_index].loader = NULL;
             loading_instances[load_index].caller = callback;
@@ -248,6 +353,7 @@ class AssetManager {
         } else if (asset_list[asset_index].load_state == ASSET_LOADING_UNLOADED) {
             asset_list[asset_index].load_state = ASSET_LOADING_LOADING;
             loading_instances[load_index].in_queue = false;
+            loading_instances[load_index].priority = ASSET_LOAD_PRIORITY_NORMAL;
             loading_instances[load_index].next_step_id = 0;
             loading_instances[load_index].loader = asset_list[asset_index].asset->NewLoader();
             loading_instances[load_index].caller = callback;
@@ -289,8 +395,10 @@ class AssetManager {
             LOGI << "Trying to synchronously load an asset being asynchronously loaded"
                     ", will wait until it's finished."
                  << std::endl;
+            PromoteAsyncLoad(asset_list[internal_id].id);
             while (asset_list[internal_id].load_state != ASSET_LOADING_LOADED) {
                 Update();
+                WaitForAsyncLoad(asset_list[internal_id].id);
             }
 
             // This was discovered when a SyncedAnimationGroup (A) required another SyncedAnimationGroup (B) which in turn required A
@@ -303,6 +411,7 @@ class AssetManager {
 
         if (!failed_load && asset_list[internal_id].load_state == ASSET_LOADING_UNLOADED) {
             asset_list[internal_id].load_state = ASSET_LOADING_LOADING;
+            PrecisionStopwatch trace_watch;
 #ifdef MEASURE_LOADS
             uint64_t start_load = getCPUTSC();
             uint32_t start_load_ms = SDL_TS_GetTicks();
@@ -355,7 +464,15 @@ class AssetManager {
 #endif
             asset_list[internal_id].modified = GetDateModifiedInt64(str.c_str());
             asset_list[internal_id].load_state = ASSET_LOADING_LOADED;
+            UpdateResidentBytes(internal_id);
+            WatchAssetFile(internal_id);
+            if (load_trace_active) {
+                RecordLoadTrace(TAsset::GetType(), str, load_flags, trace_watch.StopAndReportNanoseconds());
+            }
         } else if (asset_list[internal_id].load_state == ASSET_LOADING_LOADED) {
+            if (load_trace_active) {
+                RecordLoadTrace(TAsset::GetType(), str, load_flags, 0);
+            }
         } else {
             LOGE << "Unknown load state for asset" << std::endl;
         }
@@ -374,6 +491,14 @@ class AssetManager {
 
     void LoadSync(AssetType type, const std::string& str, uint32_t load_flags, uint32_t hold_load_mask);
 
+    /*
+     * Load a list of assets, resolving their paths and reading their files on the io threads
+     * before doing the loads themselves on the calling thread, which stay serial since most
+     * assets touch OpenGL or the asset manager itself while loading.
+     * Entries that can't be found are skipped. Logs a per asset type timing breakdown.
+     */
+    void LoadSyncBatch(const std::vector<AssetBatchLoadEntry>& entries, uint32_t hold_load_mask);
+
     /*
      * Main thread update step
      */
@@ -389,6 +514,13 @@ class AssetManager {
     // Clear and dump load warnings to write directory .xml
     void DumpLoadWarningData(const char* destination);
 
+    // Record every asset requested until play_seconds of UpdateLoadTrace() time has passed, or
+    // StopLoadTrace() is called, then write them as a preload manifest for the level ordered by load cost.
+    void StartLoadTrace(const std::string& level_name, const std::string& manifest_path, float play_seconds);
+    void UpdateLoadTrace(float timestep);
+    void StopLoadTrace();
+    bool IsLoadTraceActive();
+
     size_t GetLoadedAssetCount();
     const char* GetAssetName(uint32_t index);
     AssetType GetAssetType(uint32_t index);
@@ -400,6 +532,11 @@ class AssetManager {
 
     int GetAssetWarningCount();
     int GetAssetHoldCount();
+
+    AssetQueueStats GetIOQueueStats();
+    AssetQueueStats GetDecodeQueueStats();
+    int GetIOThreadCount();
+    int GetDecodeThreadCount();
 #ifdef MEASURE_LOADS
     void DumpTimingData();
 #endif
@@ -26,62 +26,141 @@
 
 #include <Memory/allocation.h>
 #include <Asset/assetloaderrors.h>
+#include <Threading/thread_name.h>
 
 #include <cstdlib>
 
-AssetLoaderThreadedInstance::AssetLoaderThreadedInstance() : loader(NULL), load_id(0), step(0), return_state(kLoadOk) {
+static uint64_t GetQueueTimeUs() {
+    return (uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
 }
 
-AssetLoaderThreadedInstance::AssetLoaderThreadedInstance(AssetLoaderBase* loader, uint32_t load_id, int step) : loader(loader), load_id(load_id), step(step), return_state(kLoadOk) {
+AssetLoaderThreadedInstance::AssetLoaderThreadedInstance() : loader(NULL), load_id(0), step(0), priority(ASSET_LOAD_PRIORITY_NORMAL), return_state(kLoadOk), queued_time_us(0) {
 }
 
-AssetManagerThreadedInstanceQueue::AssetManagerThreadedInstanceQueue() : queue(NULL), queue_count(0), queue_size(0) {
+AssetLoaderThreadedInstance::AssetLoaderThreadedInstance(AssetLoaderBase* loader, uint32_t load_id, int step, int priority) : loader(loader), load_id(load_id), step(step), priority(priority), return_state(kLoadOk), queued_time_us(0) {
+}
+
+AssetQueueStats::AssetQueueStats() : pushed(0), popped(0), depth(0), max_depth(0), total_wait_us(0), max_wait_us(0) {
+}
+
+AssetManagerThreadedInstanceQueue::AssetManagerThreadedInstanceQueue() {
     accessmutex = new std::mutex();
+    available = new std::condition_variable();
 }
 
 AssetManagerThreadedInstanceQueue::~AssetManagerThreadedInstanceQueue() {
-    OG_FREE(queue);
-    queue = NULL;
-    queue_count = 0;
-    queue_size = 0;
+    queue.clear();
 
+    delete available;
+    available = NULL;
     delete accessmutex;
     accessmutex = NULL;
 }
 
+// Expects accessmutex to be held.
+void AssetManagerThreadedInstanceQueue::InsertSorted(const AssetLoaderThreadedInstance& input) {
+    // Most pushes are normal priority and end up at the back, so search from there.
+    std::deque<AssetLoaderThreadedInstance>::iterator it = queue.end();
+    while (it != queue.begin() && (it - 1)->priority < input.priority) {
+        --it;
+    }
+    queue.insert(it, input);
+}
+
 AssetLoaderThreadedInstance AssetManagerThreadedInstanceQueue::Pop() {
     AssetLoaderThreadedInstance instance;
     accessmutex->lock();
-    if (queue_count > 0) {
-        instance = queue[0];
-        for (unsigned i = 1; i < queue_count; i++) {
-            queue[i - 1] = queue[i];
+    if (!queue.empty()) {
+        instance = queue.front();
+        queue.pop_front();
+
+        uint64_t wait = GetQueueTimeUs() - instance.queued_time_us;
+        stats.popped++;
+        stats.depth = (uint32_t)queue.size();
+        stats.total_wait_us += wait;
+        if (wait > stats.max_wait_us) {
+            stats.max_wait_us = wait;
         }
-        queue_count -= 1;
     }
     accessmutex->unlock();
 
     return instance;
 }
 
+bool AssetManagerThreadedInstanceQueue::WaitPop(AssetLoaderThreadedInstance* out, const bool* stop) {
+    {
+        std::unique_lock<std::mutex> lock(*accessmutex);
+        while (queue.empty() && *stop == false) {
+            available->wait(lock);
+        }
+        if (*stop) {
+            return false;
+        }
+    }
+
+    // Another consumer may have emptied the queue in between, callers check for a NULL loader.
+    *out = Pop();
+    return true;
+}
+
+bool AssetManagerThreadedInstanceQueue::WaitNonEmpty(uint32_t timeout_ms) {
+    std::unique_lock<std::mutex> lock(*accessmutex);
+    if (queue.empty()) {
+        available->wait_for(lock, std::chrono::milliseconds(timeout_ms));
+    }
+    return !queue.empty();
+}
+
 void AssetManagerThreadedInstanceQueue::Push(const AssetLoaderThreadedInstance& input) {
+    AssetLoaderThreadedInstance instance = input;
+    instance.queued_time_us = GetQueueTimeUs();
+
     accessmutex->lock();
+    InsertSorted(instance);
 
-    if (queue_size >= queue_count) {
-        queue_size += 32;
-        queue = static_cast<AssetLoaderThreadedInstance*>(realloc(queue, sizeof(AssetLoaderThreadedInstance) * queue_size));
+    stats.pushed++;
+    stats.depth = (uint32_t)queue.size();
+    if (stats.depth > stats.max_depth) {
+        stats.max_depth = stats.depth;
     }
+    accessmutex->unlock();
 
-    queue[queue_count] = input;
-    queue_count += 1;
+    available->notify_one();
+}
 
+void AssetManagerThreadedInstanceQueue::Promote(uint32_t load_id, int priority) {
+    accessmutex->lock();
+    for (size_t i = 0; i < queue.size(); i++) {
+        if (queue[i].load_id == load_id && queue[i].priority < priority) {
+            AssetLoaderThreadedInstance instance = queue[i];
+            instance.priority = priority;
+            queue.erase(queue.begin() + i);
+            InsertSorted(instance);
+        }
+    }
     accessmutex->unlock();
 }
 
+void AssetManagerThreadedInstanceQueue::Shutdown(bool* stop) {
+    accessmutex->lock();
+    *stop = true;
+    accessmutex->unlock();
+
+    available->notify_all();
+}
+
 size_t AssetManagerThreadedInstanceQueue::Count() {
     size_t ret;
     accessmutex->lock();
-    ret = queue_count;
+    ret = queue.size();
+    accessmutex->unlock();
+    return ret;
+}
+
+AssetQueueStats AssetManagerThreadedInstanceQueue::GetStats() {
+    AssetQueueStats ret;
+    accessmutex->lock();
+    ret = stats;
     accessmutex->unlock();
     return ret;
 }
@@ -91,34 +170,42 @@ AssetManagerThreadInstance::AssetManagerThreadInstance(AssetManagerThreadedInsta
 
 void AssetManagerThreadHandler_Operate(void* userdata) {
     AssetManagerThreadInstance* data = static_cast<AssetManagerThreadInstance*>(userdata);
-    while (*(data->stop) == false) {
-        if (data->queue_in->Count() > 0) {
-            AssetLoaderThreadedInstance instance = data->queue_in->Pop();
+    NameCurrentThread("AssetWorker");
 
+    AssetLoaderThreadedInstance instance;
+    while (data->queue_in->WaitPop(&instance, data->stop)) {
+        if (instance.loader != NULL) {
             instance.return_state = instance.loader->DoLoadStep(instance.step);
 
             data->queue_out->Push(instance);
-        } else {
-            std::this_thread::sleep_for(std::chrono::milliseconds(16));
         }
     }
 
     delete data;
 }
 
-AssetManagerThreadHandler::AssetManagerThreadHandler(int thread_count) : stop(false) {
-    for (int i = 0; i < thread_count; i++) {
-        AssetManagerThreadInstance* threadInstance = new AssetManagerThreadInstance(&queue_in, &queue_out, &stop);
-        std::thread* thread = new std::thread(AssetManagerThreadHandler_Operate, threadInstance);
-        threads.push_back(thread);
-    }
+AssetManagerThreadHandler::AssetManagerThreadHandler(AssetManagerThreadedInstanceQueue* queue_out, int thread_count) : queue_out(queue_out), stop(false) {
+    SetThreadCount(thread_count);
 }
 
 AssetManagerThreadHandler::~AssetManagerThreadHandler() {
-    stop = true;
+    queue_in.Shutdown(&stop);
 
     for (auto& thread : threads) {
         thread->join();
+        delete thread;
         thread = NULL;
     }
 }
+
+void AssetManagerThreadHandler::SetThreadCount(int thread_count) {
+    while ((int)threads.size() < thread_count) {
+        AssetManagerThreadInstance* threadInstance = new AssetManagerThreadInstance(&queue_in, queue_out, &stop);
+        std::thread* thread = new std::thread(AssetManagerThreadHandler_Operate, threadInstance);
+        threads.push_back(thread);
+    }
+}
+
+int AssetManagerThreadHandler::GetThreadCount() {
+    return (int)threads.size();
+}
@@ -28,33 +28,69 @@
 
 #include <thread>
 #include <mutex>
+#include <condition_variable>
 #include <chrono>
+#include <deque>
+#include <vector>
+
+enum AssetLoadPriority {
+    ASSET_LOAD_PRIORITY_NORMAL = 0,
+    ASSET_LOAD_PRIORITY_BLOCKING = 1  // Something on the main thread is waiting for this load
+};
 
 struct AssetLoaderThreadedInstance {
     AssetLoaderThreadedInstance();
-    AssetLoaderThreadedInstance(AssetLoaderBase* loader, uint32_t load_id, int step);
+    AssetLoaderThreadedInstance(AssetLoaderBase* loader, uint32_t load_id, int step, int priority = ASSET_LOAD_PRIORITY_NORMAL);
 
     AssetLoaderBase* loader;
     uint32_t load_id;
     int step;
+    int priority;
     int return_state;
+    uint64_t queued_time_us;
+};
+
+struct AssetQueueStats {
+    AssetQueueStats();
+
+    uint64_t pushed;
+    uint64_t popped;
+    uint32_t depth;
+    uint32_t max_depth;
+    uint64_t total_wait_us;  // Time from push until pop, summed over all popped instances
+    uint64_t max_wait_us;
 };
 
+/*
+ * Ordered by priority, first in first out within the same priority.
+ */
 class AssetManagerThreadedInstanceQueue {
    public:
     AssetManagerThreadedInstanceQueue();
     ~AssetManagerThreadedInstanceQueue();
 
+    // Returns an instance with a NULL loader if the queue is empty.
     AssetLoaderThreadedInstance Pop();
+    // Blocks until there is something to pop or stop is set, returns false on stop.
+    bool WaitPop(AssetLoaderThreadedInstance* out, const bool* stop);
+    // Blocks until the queue is non-empty or the timeout passes, returns true if non-empty.
+    bool WaitNonEmpty(uint32_t timeout_ms);
     void Push(const AssetLoaderThreadedInstance& input);
+    // Raise the priority of queued steps belonging to load_id.
+    void Promote(uint32_t load_id, int priority);
+    // Sets stop under the queue lock and wakes every waiting worker.
+    void Shutdown(bool* stop);
     size_t Count();
+    AssetQueueStats GetStats();
 
    private:
+    void InsertSorted(const AssetLoaderThreadedInstance& input);
+
     std::mutex* accessmutex;
+    std::condition_variable* available;
 
-    AssetLoaderThreadedInstance* queue;
-    size_t queue_count;
-    size_t queue_size;
+    std::deque<AssetLoaderThreadedInstance> queue;
+    AssetQueueStats stats;
 };
 
 class AssetManagerThreadInstance {
@@ -69,12 +105,17 @@ class AssetManagerThreadInstance {
 class AssetManagerThreadHandler {
    public:
     AssetManagerThreadedInstanceQueue queue_in;
-    AssetManagerThreadedInstanceQueue queue_out;
 
-    AssetManagerThreadHandler(int thread_count);
+    // Finished instances are pushed to queue_out, which can be shared between handlers.
+    AssetManagerThreadHandler(AssetManagerThreadedInstanceQueue* queue_out, int thread_count);
     ~AssetManagerThreadHandler();
 
+    // Only grows the pool, idle workers are blocked on the queue and cost nothing.
+    void SetThreadCount(int thread_count);
+    int GetThreadCount();
+
    private:
+    AssetManagerThreadedInstanceQueue* queue_out;
     std::vector<std::thread*> threads;
 
     bool stop;
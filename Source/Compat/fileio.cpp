@@ -25,6 +25,8 @@
 #include <Internal/filesystem.h>
 #include <Internal/casecorrectpath.h>
 
+#include <cstring>
+
 #ifdef _WIN32
 #define NOMINMAX
 #include <windows.h>
@@ -56,6 +58,9 @@ string UTF8fromUTF16(const wstring& path_utf16) {
 #endif
 
 FILE* my_fopen(const char* abs_path, const char* mode) {
+    if (mode[0] != 'r' || strchr(mode, '+')) {
+        NotifyFileWritten(abs_path);
+    }
 #ifdef _WIN32
     FILE* file = _wfopen(UTF16fromUTF8(abs_path).c_str(), UTF16fromUTF8(mode).c_str());
 #else
@@ -81,6 +86,9 @@ FILE* my_fopen(const char* abs_path, const char* mode) {
 }
 
 void my_fstream_open(fstream& file, const string& path, ios_base::openmode mode) {
+    if (mode & (ios_base::out | ios_base::app)) {
+        NotifyFileWritten(path.c_str());
+    }
 #ifdef _WIN32
     file.open(UTF16fromUTF8(path).c_str(), mode);
 #else
@@ -97,6 +105,7 @@ void my_ifstream_open(ifstream& file, const string& path, ios_base::openmode mod
 }
 
 void my_ofstream_open(ofstream& file, const string& path, ios_base::openmode mode /*= ios_base::out*/) {
+    NotifyFileWritten(path.c_str());
 #ifdef _WIN32
     file.open(UTF16fromUTF8(path).c_str(), mode);
 #else
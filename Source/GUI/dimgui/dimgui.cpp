@@ -4371,7 +4371,7 @@ Mark Stockton\nMikko Tarmia\nDavid Lyhed Danielsson");
         }
 
         ImGui::Separator();
-        ImGui::Text("Total Active Assets: %d", assetmanager->GetLoadedAssetCount());
+        ImGui::Text("Total Active Assets: %d, %.1f MiB of %.1f MiB budget", assetmanager->GetLoadedAssetCount(), assetmanager->GetResidentBytes() / (1024.0 * 1024.0), assetmanager->GetMemoryBudget() / (1024.0 * 1024.0));
 
         if (ImGui::IsItemClicked()) {
             asset_detail_list.clear();
@@ -4409,6 +4409,11 @@ Mark Stockton\nMikko Tarmia\nDavid Lyhed Danielsson");
             }
         }
 
+        AssetQueueStats io_stats = assetmanager->GetIOQueueStats();
+        AssetQueueStats decode_stats = assetmanager->GetDecodeQueueStats();
+        ImGui::Text("Asset IO Queue: %u (max %u), %d threads, avg wait %.2fms, max wait %.2fms", io_stats.depth, io_stats.max_depth, assetmanager->GetIOThreadCount(), io_stats.popped > 0 ? io_stats.total_wait_us / (double)io_stats.popped / 1000.0 : 0.0, io_stats.max_wait_us / 1000.0);
+        ImGui::Text("Asset Decode Queue: %u (max %u), %d threads, avg wait %.2fms, max wait %.2fms", decode_stats.depth, decode_stats.max_depth, assetmanager->GetDecodeThreadCount(), decode_stats.popped > 0 ? decode_stats.total_wait_us / (double)decode_stats.popped / 1000.0 : 0.0, decode_stats.max_wait_us / 1000.0);
+
         ImGui::Text("Assets held (Likely Preloaded): %d", assetmanager->GetAssetHoldCount());
         if (ImGui::IsItemClicked()) {
             asset_detail_list.clear();
@@ -4431,7 +4436,11 @@ Mark Stockton\nMikko Tarmia\nDavid Lyhed Danielsson");
         int tot = 0;
         for (int i = 1; i < (int)ASSET_TYPE_FINAL; i++) {
             int c = assetmanager->GetAssetTypeCount((AssetType)i);
-            ImGui::Text("Active %s: %d", GetAssetTypeString((AssetType)i), c);
+            if (assetmanager->GetMemoryBudget((AssetType)i) > 0) {
+                ImGui::Text("Active %s: %d, %.1f MiB of %.1f MiB budget", GetAssetTypeString((AssetType)i), c, assetmanager->GetResidentBytes((AssetType)i) / (1024.0 * 1024.0), assetmanager->GetMemoryBudget((AssetType)i) / (1024.0 * 1024.0));
+            } else {
+                ImGui::Text("Active %s: %d, %.1f MiB", GetAssetTypeString((AssetType)i), c, assetmanager->GetResidentBytes((AssetType)i) / (1024.0 * 1024.0));
+            }
             tot += c;
 
             if (ImGui::IsItemClicked()) {
@@ -38,6 +38,7 @@
 #include <Objects/placeholderobject.h>
 
 #include <Main/scenegraph.h>
+#include <Physics/bulletoverlaptracker.h>
 #include <Main/engine.h>
 
 #include <Internal/comma_separated_list.h>
@@ -53,6 +54,8 @@
 #include <Logging/logdata.h>
 #include <Online/online.h>
 
+#include <algorithm>
+
 extern std::string script_dir_path;
 
 const char* Level::DEFAULT_ENEMY_SCRIPT = "enemycontrol.as";
@@ -75,7 +78,7 @@ void Level::Dispose() {
 
     Engine::Instance()->GetASNetwork()->DeRegisterASNetworkCallback(this);
 
-    old_col_map_.clear();
+    collisions_.clear();
     for (auto& text_element : text_elements) {
         text_element.in_use = false;
         text_element.text_canvas_texture.Reset();
@@ -328,158 +331,152 @@ void Level::LiveUpdateCheck() {
     }
 }
 
-void Level::HandleCollisions(CollisionPtrMap& col_map, SceneGraph& scenegraph) {
+bool Level::CollisionLess(const Collision& lhs, const Collision& rhs) {
+    return lhs.a < rhs.a || (lhs.a == rhs.a && lhs.b < rhs.b);
+}
+
+void Level::BeginCollision(const Collision& collision) {
+    Object* obj_a = collision.a;
+    Object* obj_b = collision.b;
+    if (obj_b->GetType() == _hotspot_object) {
+        std::swap(obj_a, obj_b);
+    }
+    if (obj_a->GetType() == _hotspot_object && obj_b->GetType() == _movement_object) {
+        Hotspot* hotspot = (Hotspot*)obj_a;
+        MovementObject* mo = (MovementObject*)obj_b;
+        enter_call_queue.push_back(std::pair<Hotspot*, MovementObject*>(hotspot, mo));
+    }
+    if (obj_a->GetType() == _hotspot_object && obj_b->GetType() == _item_object) {
+        Hotspot* hotspot = (Hotspot*)obj_a;
+        ItemObject* obj = (ItemObject*)obj_b;
+        hotspot->HandleEventItem("enter", obj);
+    }
+}
+
+void Level::EndCollision(const Collision& collision, SceneGraph& scenegraph) {
+    // Objects that were deleted while touching just stop, without an exit event
+    Object* obj_a = scenegraph.GetObjectFromID(collision.id_a);
+    Object* obj_b = scenegraph.GetObjectFromID(collision.id_b);
+    if (!obj_a || !obj_b || obj_a != collision.a || obj_b != collision.b) {
+        return;
+    }
+    if (obj_b->GetType() == _hotspot_object) {
+        std::swap(obj_a, obj_b);
+    }
+    if (obj_a->GetType() == _hotspot_object && obj_b->GetType() == _movement_object) {
+        Hotspot* hotspot = (Hotspot*)obj_a;
+        MovementObject* mo = (MovementObject*)obj_b;
+        exit_call_queue.push_back(std::pair<Hotspot*, MovementObject*>(hotspot, mo));
+    }
+    if (obj_a->GetType() == _hotspot_object && obj_b->GetType() == _item_object) {
+        Hotspot* hotspot = (Hotspot*)obj_a;
+        ItemObject* obj = (ItemObject*)obj_b;
+        hotspot->HandleEventItem("exit", obj);
+    }
+}
+
+void Level::HandleCollisions(const BulletOverlapTracker& overlaps, SceneGraph& scenegraph) {
     exit_call_queue.clear();
     enter_call_queue.clear();
 
-    // Convert old collision ids into pointers
-    {
-        PROFILER_ZONE(g_profiler_ctx, "A");
-        old_col_ptr_map.clear();
-        {
-            CollisionMap& map = old_col_map_;
-            for (auto& iter : map) {
-                int id = iter.first;
-                Object* obj_a_ptr = scenegraph.GetObjectFromID(id);
-                if (obj_a_ptr) {
-                    CollisionSet& set = iter.second;
-                    for (int id : set) {
-                        Object* obj_b_ptr = scenegraph.GetObjectFromID(id);
-                        if (obj_b_ptr) {
-                            old_col_ptr_map[obj_a_ptr].insert(obj_b_ptr);
-                        }
-                    }
-                }
+    // Both merges below go through vectors that keep their capacity, so once they have
+    // grown to fit the level this doesn't allocate anything
+    const std::vector<OverlapPair>& end_events = overlaps.GetEndEvents();
+    if (!end_events.empty()) {
+        PROFILER_ZONE(g_profiler_ctx, "End collisions");
+        collision_events_.resize(end_events.size());
+        for (size_t i = 0; i < end_events.size(); ++i) {
+            collision_events_[i].a = end_events[i].a;
+            collision_events_[i].b = end_events[i].b;
+        }
+        std::sort(collision_events_.begin(), collision_events_.end(), CollisionLess);
+
+        // Every end event takes out one matching collision
+        merged_collisions_.clear();
+        size_t event_index = 0;
+        for (const auto& collision : collisions_) {
+            while (event_index < collision_events_.size() && CollisionLess(collision_events_[event_index], collision)) {
+                ++event_index;
             }
+            if (event_index < collision_events_.size() && !CollisionLess(collision, collision_events_[event_index])) {
+                ++event_index;
+                EndCollision(collision, scenegraph);
+            } else {
+                merged_collisions_.push_back(collision);
+            }
+        }
+        std::swap(collisions_, merged_collisions_);
+    }
+
+    const std::vector<OverlapPair>& begin_events = overlaps.GetBeginEvents();
+    if (!begin_events.empty()) {
+        PROFILER_ZONE(g_profiler_ctx, "Begin collisions");
+        collision_events_.resize(begin_events.size());
+        for (size_t i = 0; i < begin_events.size(); ++i) {
+            Collision& collision = collision_events_[i];
+            collision.a = begin_events[i].a;
+            collision.b = begin_events[i].b;
+            collision.id_a = collision.a->GetID();
+            collision.id_b = collision.b->GetID();
+            BeginCollision(collision);
         }
+        std::sort(collision_events_.begin(), collision_events_.end(), CollisionLess);
+
+        merged_collisions_.resize(collisions_.size() + collision_events_.size());
+        std::merge(collisions_.begin(), collisions_.end(), collision_events_.begin(), collision_events_.end(), merged_collisions_.begin(), CollisionLess);
+        std::swap(collisions_, merged_collisions_);
     }
 
     {
-        PROFILER_ZONE(g_profiler_ctx, "B");
-        // Check for collisions that used to be happening, and are now gone
-        CollisionPtrMap::iterator oci = old_col_ptr_map.begin();
-        for (; oci != old_col_ptr_map.end(); ++oci) {
-            CollisionPtrMap::iterator ci = col_map.find(oci->first);
-            Object* obj_a = (Object*)oci->first;
-            CollisionPtrSet::iterator oci2 = oci->second.begin();
-            for (; oci2 != oci->second.end(); ++oci2) {
-                Object* obj_b = (Object*)(*oci2);
-                bool not_found = false;
-                if (ci == col_map.end()) {
-                    not_found = true;
-                } else {
-                    CollisionPtrSet::iterator ci2 = ci->second.find(*oci2);
-                    if (ci2 == ci->second.end()) {
-                        not_found = true;
-                    }
-                }
-                if (!not_found) {
-                    continue;
-                }
-                Object* temp_obj_a = obj_a;
-                if (obj_b->GetType() == _hotspot_object) {
-                    std::swap(temp_obj_a, obj_b);
-                }
-                if (temp_obj_a->GetType() == _hotspot_object && obj_b->GetType() == _movement_object) {
-                    Hotspot* hotspot = (Hotspot*)temp_obj_a;
-                    MovementObject* mo = (MovementObject*)obj_b;
-
-                    exit_call_queue.push_back(std::pair<Hotspot*, MovementObject*>(hotspot, mo));
-                }
-                if (temp_obj_a->GetType() == _hotspot_object && obj_b->GetType() == _item_object) {
-                    Hotspot* hotspot = (Hotspot*)temp_obj_a;
-                    ItemObject* obj = (ItemObject*)obj_b;
-                    hotspot->HandleEventItem("exit", obj);
-                }
+        PROFILER_ZONE(g_profiler_ctx, "Character collisions");
+        // Characters keep pushing each other apart for as long as they touch
+        const std::vector<OverlapPair>& touching = overlaps.GetTouching();
+        for (const auto& pair : touching) {
+            if (pair.a->GetType() == _movement_object && pair.b->GetType() == _movement_object) {
+                ((MovementObject*)pair.a)->CollideWith((MovementObject*)pair.b);
             }
         }
     }
 
     {
-        PROFILER_ZONE(g_profiler_ctx, "C");
-        // Check for collisions that now exist
-        CollisionPtrMap::iterator ci = col_map.begin();
-        for (; ci != col_map.end(); ++ci) {
-            CollisionPtrMap::iterator oci = old_col_ptr_map.find(ci->first);
-            Object* obj_a = (Object*)ci->first;
-            std::set<void*>::iterator ci2 = ci->second.begin();
-            for (; ci2 != ci->second.end(); ++ci2) {
-                Object* obj_b = (Object*)(*ci2);
-                if (obj_a->GetType() == _movement_object && obj_b->GetType() == _movement_object) {
-                    ((MovementObject*)obj_a)->CollideWith((MovementObject*)obj_b);
-                    continue;
-                }
-
-                bool not_found = false;
-                if (oci == old_col_ptr_map.end()) {
-                    not_found = true;
-                } else {
-                    std::set<void*>::iterator oci2 = oci->second.find(*ci2);
-                    if (oci2 == oci->second.end()) {
-                        not_found = true;
-                    }
-                }
-                if (!not_found) {
-                    continue;
-                }
-                Object* temp_obj_a = obj_a;
-                if (obj_b->GetType() == _hotspot_object) {
-                    std::swap(temp_obj_a, obj_b);
-                }
-                if (temp_obj_a->GetType() == _hotspot_object && obj_b->GetType() == _movement_object) {
-                    Hotspot* hotspot = (Hotspot*)temp_obj_a;
-                    MovementObject* mo = (MovementObject*)obj_b;
-                    enter_call_queue.push_back(std::pair<Hotspot*, MovementObject*>(hotspot, mo));
-                }
-                if (temp_obj_a->GetType() == _hotspot_object && obj_b->GetType() == _item_object) {
-                    Hotspot* hotspot = (Hotspot*)temp_obj_a;
-                    ItemObject* obj = (ItemObject*)obj_b;
-                    hotspot->HandleEventItem("enter", obj);
-                }
-            }
-        }
+        PROFILER_ZONE(g_profiler_ctx, "Hotspot calls");
+        CallHotspotQueues();
     }
+}
 
-    {
-        PROFILER_ZONE(g_profiler_ctx, "D");
-        // Convert old collision pointers to ids
-        CollisionPtrMap& map = col_map;
-        old_col_map_.clear();
-        for (auto& iter : map) {
-            int id_a = ((Object*)iter.first)->GetID();
-            CollisionPtrSet& set = iter.second;
-            for (auto iter : set) {
-                int id_b = ((Object*)iter)->GetID();
-                old_col_map_[id_a].insert(id_b);
-            }
-        }
+void Level::ClearCollisions(SceneGraph& scenegraph) {
+    exit_call_queue.clear();
+    enter_call_queue.clear();
+    for (const auto& collision : collisions_) {
+        EndCollision(collision, scenegraph);
     }
+    collisions_.clear();
+    CallHotspotQueues();
+}
 
-    {
-        PROFILER_ZONE(g_profiler_ctx, "E");
-        // Do the delayed calls
-        std::vector<std::pair<Hotspot*, MovementObject*> >::iterator exit_call_queue_it = exit_call_queue.begin();
-        for (; exit_call_queue_it != exit_call_queue.end(); exit_call_queue_it++) {
-            exit_call_queue_it->first->HandleEvent("exit", exit_call_queue_it->second);
-            ASArglist args;
-            args.AddObject((void*)&exit_call_queue_it->first->GetScriptFile());
-            args.AddAddress((void*)exit_call_queue_it->second);
+void Level::CallHotspotQueues() {
+    // Do the delayed calls
+    std::vector<std::pair<Hotspot*, MovementObject*> >::iterator exit_call_queue_it = exit_call_queue.begin();
+    for (; exit_call_queue_it != exit_call_queue.end(); exit_call_queue_it++) {
+        exit_call_queue_it->first->HandleEvent("exit", exit_call_queue_it->second);
+        ASArglist args;
+        args.AddObject((void*)&exit_call_queue_it->first->GetScriptFile());
+        args.AddAddress((void*)exit_call_queue_it->second);
 
-            for (auto& as_context : as_contexts_) {
-                as_context.ctx->CallScriptFunction(as_context.as_funcs.hotspot_exit, &args);
-            }
+        for (auto& as_context : as_contexts_) {
+            as_context.ctx->CallScriptFunction(as_context.as_funcs.hotspot_exit, &args);
         }
+    }
 
-        std::vector<std::pair<Hotspot*, MovementObject*> >::iterator enter_call_queue_it = enter_call_queue.begin();
-        for (; enter_call_queue_it != enter_call_queue.end(); enter_call_queue_it++) {
-            enter_call_queue_it->first->HandleEvent("enter", enter_call_queue_it->second);
-            ASArglist args;
-            args.AddObject((void*)&enter_call_queue_it->first->GetScriptFile());
-            args.AddAddress((void*)enter_call_queue_it->second);
+    std::vector<std::pair<Hotspot*, MovementObject*> >::iterator enter_call_queue_it = enter_call_queue.begin();
+    for (; enter_call_queue_it != enter_call_queue.end(); enter_call_queue_it++) {
+        enter_call_queue_it->first->HandleEvent("enter", enter_call_queue_it->second);
+        ASArglist args;
+        args.AddObject((void*)&enter_call_queue_it->first->GetScriptFile());
+        args.AddAddress((void*)enter_call_queue_it->second);
 
-            for (auto& as_context : as_contexts_) {
-                as_context.ctx->CallScriptFunction(as_context.as_funcs.hotspot_enter, &args);
-            }
+        for (auto& as_context : as_contexts_) {
+            as_context.ctx->CallScriptFunction(as_context.as_funcs.hotspot_enter, &args);
         }
     }
 }
@@ -782,17 +779,13 @@ void Level::DefineLevelTypePublic(ASContext* as_context) {
 }
 
 void Level::GetCollidingObjects(int id, CScriptArray* array) {
-    int collision[2];
-    for (auto& iter : old_col_map_) {
-        collision[0] = iter.first;
-        CollisionSet& set = iter.second;
-        for (int iter : set) {
-            collision[1] = iter;
-            if (collision[0] == id) {
-                array->InsertLast(&collision[1]);
-            } else if (collision[1] == id) {
-                array->InsertLast(&collision[0]);
-            }
+    for (const auto& collision : collisions_) {
+        if (collision.id_a == id) {
+            int other = collision.id_b;
+            array->InsertLast(&other);
+        } else if (collision.id_b == id) {
+            int other = collision.id_a;
+            array->InsertLast(&other);
         }
     }
 }
@@ -53,6 +53,8 @@ struct LevelInfo;
 class GUI;
 class CScriptArray;
 class ASCollisions;
+class BulletOverlapTracker;
+class Object;
 
 const int kMaxTextElements = 40;
 struct TextElement {
@@ -99,9 +101,6 @@ class Level : public ASNetworkCallback {
 
     std::vector<HookedASContext> as_contexts_;
 
-    typedef std::set<void*> CollisionPtrSet;
-    typedef std::map<void*, CollisionPtrSet> CollisionPtrMap;
-
     Level();
     virtual ~Level();
 
@@ -117,7 +116,9 @@ class Level : public ASNetworkCallback {
     void LiveUpdateCheck();
     void Dispose();
     void HotspotTriggered(Hotspot* hotspot, MovementObject* mo);
-    void HandleCollisions(CollisionPtrMap& col_map, SceneGraph& scenegraph);
+    void HandleCollisions(const BulletOverlapTracker& overlaps, SceneGraph& scenegraph);
+    // Ends every collision in progress, without the objects having to move apart
+    void ClearCollisions(SceneGraph& scenegraph);
     bool HasFunction(const std::string& function_definition);
     int QueryIntFunction(const std::string& func);
     void Execute(std::string code);
@@ -178,16 +179,25 @@ class Level : public ASNetworkCallback {
     std::vector<int> level_event_receivers;
     TextElement text_elements[kMaxTextElements];
     CharacterScriptGetter character_script_getter_;
-    typedef std::set<int> CollisionSet;
-    typedef std::map<int, CollisionSet> CollisionMap;
-    CollisionMap old_col_map_;
+    struct Collision {
+        Object* a;
+        Object* b;
+        // Checked before ending a collision, in case either object was deleted since it began
+        int id_a;
+        int id_b;
+    };
+    // Sorted by a then b, so each frame's begin and end events merge in with a single pass
+    std::vector<Collision> collisions_;
+    std::vector<Collision> collision_events_;
+    std::vector<Collision> merged_collisions_;
     HUDImages hud_images;
     typedef std::map<std::string, std::string> StringMap;
     StringMap level_script_paths;
-    // vvv These are just here to avoid per-frame mallocs vvv
-    CollisionPtrMap old_col_ptr_map;
-
     std::unique_ptr<ASCollisions> as_collisions;
 
     Path FindScript(const std::string& path);
+    static bool CollisionLess(const Collision& lhs, const Collision& rhs);
+    void BeginCollision(const Collision& collision);
+    void EndCollision(const Collision& collision, SceneGraph& scenegraph);
+    void CallHotspotQueues();
 };
@@ -148,6 +148,8 @@ void AnimationClient::Update(float timestep) {
     if (!reader.valid()) {
         return;
     }
+    // GetMatrices() may run on a worker next, so load what it will need now
+    retarget_skeletons.Refresh();
     if (reader.IncrementTime(blendmap, timestep)) {
         const std::string &callback = reader.GetCallbackString();
         if (!callback.empty()) {
@@ -168,10 +170,13 @@ const float _overshoot_amount = 0.3f;
 
 void AnimationClient::GetMatrices(AnimOutput &anim_output, const std::vector<int> *parents) {
     if (!reader.valid()) {
+        // anim_output may be reused from last update, don't leave its old pose in it
+        anim_output = AnimOutput();
         return;
     }
-    AnimInput ang_anim_input(blendmap, parents);
-    ang_anim_input.retarget_new = retarget_new;
+    AnimInput ang_anim_input(blendmap, parents, retarget_new);
+    ang_anim_input.pool = &anim_output_pool;
+    ang_anim_input.retarget_skeletons = &retarget_skeletons;
     {
         PROFILER_ZONE(g_profiler_ctx, "reader.GetMatrices()");
         reader.GetMatrices(ang_anim_output, ang_anim_input);
@@ -210,35 +215,30 @@ void AnimationClient::GetMatrices(AnimOutput &anim_output, const std::vector<int
     }
     if (!animation_config.kDisableAnimationLayers) {
         for (int i = (int)layers.size() - 1; i >= 0; i--) {
-            AnimInput old_ang_anim_input(blendmap, parents);
-            old_ang_anim_input.retarget_new = retarget_new;
+            AnimInput old_ang_anim_input(blendmap, parents, retarget_new);
+            old_ang_anim_input.pool = &anim_output_pool;
+            old_ang_anim_input.retarget_skeletons = &retarget_skeletons;
             layers[i].reader.GetMatrices(temp_ang_anim_output, old_ang_anim_input);
             if (layers[i].fade_out.fade_out.size()) {
                 layers[i].fade_out.ApplyAngular(old_ang_anim_input, temp_ang_anim_output, temp_ang_anim_output2, retarget_new, parents);
             }
-            ang_anim_output = add_mix(ang_anim_output, temp_ang_anim_output, layers[i].opac);
+            add_mix_in_place(ang_anim_output, temp_ang_anim_output, layers[i].opac);
         }
     }
     ang_anim_output.delta_offset += old_delta_offset;
     ang_anim_output.delta_rotation += old_delta_rotation;
 
-    std::vector<BoneTransform> matrices(ang_anim_output.matrices.size());
+    std::vector<BoneTransform> &matrices = anim_output.matrices;
+    matrices.resize(ang_anim_output.matrices.size());
     {
         PROFILER_ZONE(g_profiler_ctx, "Apply Parent Rotations");
         // Blend between angular and linear matrices based on IK weights
-        if (parents) {
-            std::vector<BoneTransform> temp_matrices(matrices.size());
-            for (unsigned j = 0; j < matrices.size(); j++) {
-                temp_matrices[j] = ApplyParentRotations(ang_anim_output.matrices, j, *parents);
-            }
-            matrices = temp_matrices;
+        for (unsigned j = 0; j < matrices.size(); j++) {
+            matrices[j] = parents ? ApplyParentRotations(ang_anim_output.matrices, j, *parents) : BoneTransform();
         }
     }
 
-    std::vector<BoneTransform> weapon_matrices = ang_anim_output.weapon_matrices;
-
     // Apply character rotation modifier
-    std::map<int, WeapAnimInfo> &weap_anim_info_map = ang_anim_output.weap_anim_info_map;
     for (auto &ik_bone : ang_anim_output.ik_bones) {
         ik_bone.unmodified_transform = ik_bone.transform;
     }
@@ -246,9 +246,8 @@ void AnimationClient::GetMatrices(AnimOutput &anim_output, const std::vector<int
     anim_output.unmodified_matrices = matrices;
 
     // Put together output
-    anim_output.matrices = matrices;
-    anim_output.weap_anim_info_map = weap_anim_info_map;
-    anim_output.weapon_matrices = weapon_matrices;
+    anim_output.weap_anim_info_map = ang_anim_output.weap_anim_info_map;
+    anim_output.weapon_matrices = ang_anim_output.weapon_matrices;
     anim_output.weapon_weights = ang_anim_output.weapon_weights;
     anim_output.weapon_weight_weights = ang_anim_output.weapon_weight_weights;
     anim_output.weapon_relative_ids = ang_anim_output.weapon_relative_ids;
@@ -307,8 +306,9 @@ void FadeCollection::ApplyAngular(AnimInput &ang_anim_input,
                                   const std::string &retarget_new,
                                   const std::vector<int> *parents) {
     for (int i = (int)fade_out.size() - 1; i >= 0; --i) {
-        AnimInput temp_ang_anim_input(fade_out[i].blendmap, parents);
-        temp_ang_anim_input.retarget_new = retarget_new;
+        AnimInput temp_ang_anim_input(fade_out[i].blendmap, parents, retarget_new);
+        temp_ang_anim_input.pool = ang_anim_input.pool;
+        temp_ang_anim_input.retarget_skeletons = ang_anim_input.retarget_skeletons;
         fade_out[i].reader.GetMatrices(temp_ang_anim_output, temp_ang_anim_input);
         float temp_opac;
         if (fade_out[i].overshoot) {
@@ -319,7 +319,7 @@ void FadeCollection::ApplyAngular(AnimInput &ang_anim_input,
         } else {
             temp_opac = fade_out[i].opac;
         }
-        ang_anim_output = mix(ang_anim_output, temp_ang_anim_output, temp_opac);
+        mix_in_place(ang_anim_output, temp_ang_anim_output, temp_opac);
     }
 }
 
@@ -422,6 +422,7 @@ void AnimationClient::SetSkeleton(Skeleton *_skeleton) {
 
 void AnimationClient::SetRetargeting(const std::string &new_path) {
     retarget_new = new_path;
+    retarget_skeletons.Preload(retarget_new);
 }
 
 int AnimationClient::AddLayer(const std::string &path, float fade_speed /*= _default_fade_speed*/, char flags /*= NULL*/) {
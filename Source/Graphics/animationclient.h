@@ -70,6 +70,7 @@ class AnimationClient {
     AnimOutput lin_anim_output;
     AnimOutput temp_lin_anim_output;
     AnimOutput temp_lin_anim_output2;
+    AnimOutputPool anim_output_pool;
 
     FadeCollection fade_out;
     std::vector<AnimationLayer> layers;
@@ -87,6 +88,7 @@ class AnimationClient {
     char flags;
 
     std::string retarget_new;
+    RetargetSkeletons retarget_skeletons;
 
     struct {
         ASFunctionHandle layer_removed;
@@ -114,6 +114,7 @@ float AnimationReader::GetTimeUntilEvent(const std::string &event) {
 void AnimationReader::GetMatrices(AnimOutput &anim_output,
                                   AnimInput &anim_input) {
     anim_input.mirrored = mirrored;
+    anim_input.keyframe_cursors = &keyframe_cursors;
     (*anim).GetMatrices(normalized_time, anim_output, anim_input);
     if (anim_output.old_path != "retargeted") {
         Retarget(anim_input, anim_output, anim_output.old_path);
@@ -129,22 +130,25 @@ void AnimationReader::GetMatrices(AnimOutput &anim_output,
     last_rotation = anim_output.rotation;
 
     if (blend_anim.valid()) {
-        AnimOutput blend_anim_output;
+        ScopedAnimOutput scoped_blend_anim_output(anim_input.pool);
+        AnimOutput &blend_anim_output = scoped_blend_anim_output.get();
         (*blend_anim).GetMatrices(normalized_time, blend_anim_output, anim_input);
         if (blend_anim_output.old_path != "retargeted") {
             Retarget(anim_input, blend_anim_output, blend_anim_output.old_path);
         }
-        anim_output = add_mix(anim_output, blend_anim_output, 1.0f);
+        add_mix_in_place(anim_output, blend_anim_output, 1.0f);
     }
 
     for (unsigned i = 0; i < anim_output.weapon_matrices.size(); ++i) {
         int item_id = animated_item_ids[i];
         if (item_id != -1) {
-            WeapAnimInfo &weap_anim_info = anim_output.weap_anim_info_map[item_id];
-            weap_anim_info.bone_transform = anim_output.weapon_matrices[i];
-            weap_anim_info.weight = anim_output.weapon_weights[i] * anim_output.weapon_weight_weights[i];
-            weap_anim_info.relative_id = anim_output.weapon_relative_ids[i];
-            weap_anim_info.relative_weight = anim_output.weapon_relative_weights[i];
+            WeapAnimInfo *weap_anim_info = anim_output.weap_anim_info_map.insert(item_id);
+            if (weap_anim_info) {
+                weap_anim_info->bone_transform = anim_output.weapon_matrices[i];
+                weap_anim_info->weight = anim_output.weapon_weights[i] * anim_output.weapon_weight_weights[i];
+                weap_anim_info->relative_id = anim_output.weapon_relative_ids[i];
+                weap_anim_info->relative_weight = anim_output.weapon_relative_weights[i];
+            }
         }
     }
 
@@ -240,6 +244,7 @@ const AnimationReader &AnimationReader::operator=(const AnimationReader &other)
     for (int i = 0; i < _max_animated_items; ++i) {
         animated_item_ids[i] = other.animated_item_ids[i];
     }
+    keyframe_cursors = other.keyframe_cursors;
     return *this;
 }
 
@@ -46,6 +46,7 @@ class AnimationReader {
     float speed_mult;
     std::string callback_string;
     int animated_item_ids[_max_animated_items];
+    KeyframeCursors keyframe_cursors;
 
    public:
     AnimationReader();
@@ -0,0 +1,150 @@
+//-----------------------------------------------------------------------------
+//           Name: bonetransformblend.cpp
+//      Developer: Wolfire Games LLC
+//    Description: Blends whole arrays of bone transforms with SSE
+//        License: Read below
+//-----------------------------------------------------------------------------
+//
+//   Copyright 2022 Wolfire Games LLC
+//
+//   Licensed under the Apache License, Version 2.0 (the "License");
+//   you may not use this file except in compliance with the License.
+//   You may obtain a copy of the License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//   Unless required by applicable law or agreed to in writing, software
+//   distributed under the License is distributed on an "AS IS" BASIS,
+//   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//   See the License for the specific language governing permissions and
+//   limitations under the License.
+//
+//-----------------------------------------------------------------------------
+#include "bonetransformblend.h"
+
+#include <xmmintrin.h>
+
+// The kernels load a bone's rotation and its w plus origin as two overlapping groups of four floats
+static_assert(sizeof(BoneTransform) == sizeof(float) * 7, "BoneTransform must be a quaternion followed by a vec3");
+
+namespace {
+// Slerp() lerps rotations closer than this, 1 - cos(angle)
+const float kSlerpLerpThreshold = 0.01f;
+
+const int kSlerpTerms = 8;
+// u[i] = 1 / (i * (2i + 1)) and v[i] = i / (2i + 1) for i = 1..8, with the last pair scaled to correct for the truncation
+const float kSlerpU[kSlerpTerms] = {1.0f / (1 * 3), 1.0f / (2 * 5), 1.0f / (3 * 7), 1.0f / (4 * 9),
+                                    1.0f / (5 * 11), 1.0f / (6 * 13), 1.0f / (7 * 15), 1.85298109240830f / (8 * 17)};
+const float kSlerpV[kSlerpTerms] = {1.0f / 3, 2.0f / 5, 3.0f / 7, 4.0f / 9,
+                                    5.0f / 11, 6.0f / 13, 7.0f / 15, 1.85298109240830f * 8 / 17};
+
+// sin(t * angle) / sin(angle), given cos(angle) - 1
+inline __m128 SlerpScale(__m128 t, __m128 cos_minus_one) {
+    __m128 one = _mm_set1_ps(1.0f);
+    __m128 t_squared = _mm_mul_ps(t, t);
+    __m128 result = one;
+    for (int i = kSlerpTerms - 1; i >= 0; --i) {
+        __m128 term = _mm_mul_ps(_mm_sub_ps(_mm_mul_ps(_mm_set1_ps(kSlerpU[i]), t_squared), _mm_set1_ps(kSlerpV[i])), cos_minus_one);
+        result = _mm_add_ps(one, _mm_mul_ps(term, result));
+    }
+    return _mm_mul_ps(t, result);
+}
+
+void Blend4(BoneTransform* a, const BoneTransform* b, __m128 t) {
+    // Rotations to one register per component
+    __m128 a_x = _mm_loadu_ps(a[0].rotation.entries);
+    __m128 a_y = _mm_loadu_ps(a[1].rotation.entries);
+    __m128 a_z = _mm_loadu_ps(a[2].rotation.entries);
+    __m128 a_w = _mm_loadu_ps(a[3].rotation.entries);
+    _MM_TRANSPOSE4_PS(a_x, a_y, a_z, a_w);
+    __m128 b_x = _mm_loadu_ps(b[0].rotation.entries);
+    __m128 b_y = _mm_loadu_ps(b[1].rotation.entries);
+    __m128 b_z = _mm_loadu_ps(b[2].rotation.entries);
+    __m128 b_w = _mm_loadu_ps(b[3].rotation.entries);
+    _MM_TRANSPOSE4_PS(b_x, b_y, b_z, b_w);
+    // Same for the origins, which come along with a copy of the rotation's w
+    __m128 a_ow = _mm_loadu_ps(a[0].rotation.entries + 3);
+    __m128 a_ox = _mm_loadu_ps(a[1].rotation.entries + 3);
+    __m128 a_oy = _mm_loadu_ps(a[2].rotation.entries + 3);
+    __m128 a_oz = _mm_loadu_ps(a[3].rotation.entries + 3);
+    _MM_TRANSPOSE4_PS(a_ow, a_ox, a_oy, a_oz);
+    __m128 b_ow = _mm_loadu_ps(b[0].rotation.entries + 3);
+    __m128 b_ox = _mm_loadu_ps(b[1].rotation.entries + 3);
+    __m128 b_oy = _mm_loadu_ps(b[2].rotation.entries + 3);
+    __m128 b_oz = _mm_loadu_ps(b[3].rotation.entries + 3);
+    _MM_TRANSPOSE4_PS(b_ow, b_ox, b_oy, b_oz);
+
+    __m128 one_minus_t = _mm_sub_ps(_mm_set1_ps(1.0f), t);
+    __m128 o_x = _mm_add_ps(_mm_mul_ps(a_ox, one_minus_t), _mm_mul_ps(b_ox, t));
+    __m128 o_y = _mm_add_ps(_mm_mul_ps(a_oy, one_minus_t), _mm_mul_ps(b_oy, t));
+    __m128 o_z = _mm_add_ps(_mm_mul_ps(a_oz, one_minus_t), _mm_mul_ps(b_oz, t));
+
+    // Go the short way around, like Slerp() does
+    __m128 cos_angle = _mm_mul_ps(a_x, b_x);
+    cos_angle = _mm_add_ps(cos_angle, _mm_mul_ps(a_y, b_y));
+    cos_angle = _mm_add_ps(cos_angle, _mm_mul_ps(a_z, b_z));
+    cos_angle = _mm_add_ps(cos_angle, _mm_mul_ps(a_w, b_w));
+    __m128 sign = _mm_and_ps(cos_angle, _mm_set1_ps(-0.0f));
+    __m128 cos_minus_one = _mm_sub_ps(_mm_xor_ps(cos_angle, sign), _mm_set1_ps(1.0f));
+    __m128 scale_a = SlerpScale(one_minus_t, cos_minus_one);
+    __m128 scale_b = SlerpScale(t, cos_minus_one);
+    __m128 lerp = _mm_cmpge_ps(cos_minus_one, _mm_set1_ps(-kSlerpLerpThreshold));
+    scale_a = _mm_or_ps(_mm_and_ps(lerp, one_minus_t), _mm_andnot_ps(lerp, scale_a));
+    scale_b = _mm_xor_ps(_mm_or_ps(_mm_and_ps(lerp, t), _mm_andnot_ps(lerp, scale_b)), sign);
+    __m128 r_x = _mm_add_ps(_mm_mul_ps(a_x, scale_a), _mm_mul_ps(b_x, scale_b));
+    __m128 r_y = _mm_add_ps(_mm_mul_ps(a_y, scale_a), _mm_mul_ps(b_y, scale_b));
+    __m128 r_z = _mm_add_ps(_mm_mul_ps(a_z, scale_a), _mm_mul_ps(b_z, scale_b));
+    __m128 r_w = _mm_add_ps(_mm_mul_ps(a_w, scale_a), _mm_mul_ps(b_w, scale_b));
+
+    // Back to one register per bone. The second store writes the same w again
+    __m128 o_w = r_w;
+    _MM_TRANSPOSE4_PS(r_x, r_y, r_z, r_w);
+    _MM_TRANSPOSE4_PS(o_w, o_x, o_y, o_z);
+    _mm_storeu_ps(a[0].rotation.entries, r_x);
+    _mm_storeu_ps(a[0].rotation.entries + 3, o_w);
+    _mm_storeu_ps(a[1].rotation.entries, r_y);
+    _mm_storeu_ps(a[1].rotation.entries + 3, o_x);
+    _mm_storeu_ps(a[2].rotation.entries, r_z);
+    _mm_storeu_ps(a[2].rotation.entries + 3, o_y);
+    _mm_storeu_ps(a[3].rotation.entries, r_w);
+    _mm_storeu_ps(a[3].rotation.entries + 3, o_z);
+}
+
+inline float BoneWeight(const float* weights, size_t num_weights, size_t index) {
+    return index < num_weights ? weights[index] : 1.0f;
+}
+}  // namespace
+
+void BlendBoneTransforms(BoneTransform* a, const BoneTransform* b, size_t count, float alpha, const float* weights, size_t num_weights) {
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128 t = _mm_set1_ps(alpha);
+        if (i < num_weights) {
+            t = _mm_mul_ps(t, _mm_setr_ps(BoneWeight(weights, num_weights, i),
+                                          BoneWeight(weights, num_weights, i + 1),
+                                          BoneWeight(weights, num_weights, i + 2),
+                                          BoneWeight(weights, num_weights, i + 3)));
+        }
+        Blend4(&a[i], &b[i], t);
+    }
+    if (i < count) {
+        // Blend the rest in a group padded with identities
+        BoneTransform a_rest[4];
+        BoneTransform b_rest[4];
+        float t_rest[4];
+        for (size_t j = 0; j < 4; ++j) {
+            if (i + j < count) {
+                a_rest[j] = a[i + j];
+                b_rest[j] = b[i + j];
+            } else {
+                a_rest[j].LoadIdentity();
+                b_rest[j].LoadIdentity();
+            }
+            t_rest[j] = alpha * BoneWeight(weights, num_weights, i + j);
+        }
+        Blend4(a_rest, b_rest, _mm_loadu_ps(t_rest));
+        for (size_t j = 0; i + j < count; ++j) {
+            a[i + j] = a_rest[j];
+        }
+    }
+}
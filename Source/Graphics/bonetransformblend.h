@@ -0,0 +1,44 @@
+//-----------------------------------------------------------------------------
+//           Name: bonetransformblend.h
+//      Developer: Wolfire Games LLC
+//    Description: Blends whole arrays of bone transforms with SSE
+//        License: Read below
+//-----------------------------------------------------------------------------
+//
+//   Copyright 2022 Wolfire Games LLC
+//
+//   Licensed under the Apache License, Version 2.0 (the "License");
+//   you may not use this file except in compliance with the License.
+//   You may obtain a copy of the License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//   Unless required by applicable law or agreed to in writing, software
+//   distributed under the License is distributed on an "AS IS" BASIS,
+//   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//   See the License for the specific language governing permissions and
+//   limitations under the License.
+//
+//-----------------------------------------------------------------------------
+#pragma once
+
+#include <Graphics/bonetransform.h>
+
+#include <cstddef>
+
+/*
+ * Four bones are blended at a time. Translations are lerped exactly like
+ * mix() does. Rotations are slerped with the polynomial from Eberly's "A Fast
+ * and Accurate Algorithm for Computing SLERP", which doesn't need trig
+ * functions or branches. It is furthest from Slerp() for rotations half a
+ * turn apart, where it is off by up to 0.00004 for blend weights between
+ * -0.5 and 1.5, and much closer for the small differences between most poses.
+ */
+
+// a[i] = mix(a[i], b[i], alpha * weights[i]), with weights past num_weights counting as 1
+void BlendBoneTransforms(BoneTransform* a,
+                         const BoneTransform* b,
+                         size_t count,
+                         float alpha,
+                         const float* weights = NULL,
+                         size_t num_weights = 0);
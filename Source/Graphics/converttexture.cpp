@@ -24,7 +24,7 @@
 #include "converttexture.h"
 
 #include <Internal/common.h>
-#include <Internal/checksum.h>
+#include <Internal/filefingerprint.h>
 #include <Internal/filesystem.h>
 #include <Internal/datemodified.h>
 #include <Internal/error.h>
@@ -93,7 +93,7 @@ bool ConvertImage(string src, string dst, string temp_conversion_path, TextureDa
     }
 
     if (successful_conversion) {
-        unsigned short checksum = Checksum(src);
+        unsigned short checksum = FileFingerprintStore::Instance().GetChecksum(src);
         FILE* file = my_fopen(temp_conversion_path.c_str(), "a");
         if (file) {
             fwrite(overgrowth_dds_cache_intro, strlen(overgrowth_dds_cache_intro), 1, file);
@@ -27,9 +27,10 @@
 #include <Graphics/graphics.h>
 #include <Graphics/shaders.h>
 #include <Graphics/drawbatch.h>
+#include <Graphics/modelcache.h>
 
 #include <Internal/collisiondetection.h>
-#include <Internal/checksum.h>
+#include <Internal/filefingerprint.h>
 #include <Internal/common.h>
 #include <Internal/datemodified.h>
 #include <Internal/stopwatch.h>
@@ -47,12 +48,14 @@
 #include <Compat/fileio.h>
 #include <Logging/logdata.h>
 #include <Utility/assert.h>
+#include <Utility/hash.h>
 #include <Main/engine.h>
 
 #include <Timing/timingevent.h>
 #include <Timing/intel_gl_perf.h>
 
 #include <cmath>
+#include <cstring>
 #include <set>
 
 //-----------------------------------------------------------------------------
@@ -159,6 +162,9 @@ Model &Model::operator=(const Model &copy) {
 
     path = copy.path;
 
+    std::lock_guard<std::mutex> lock(copy.bvh_mutex);
+    bvh = copy.bvh;
+
     return (*this);
 }
 
@@ -242,6 +248,154 @@ void Model::ReadFromFile(FILE *file) {
     fread(&average_triangle_edge_length, sizeof(float), 1, file);
 }
 
+static void StoreVec3(float *dst, const vec3 &src) {
+    dst[0] = src[0];
+    dst[1] = src[1];
+    dst[2] = src[2];
+}
+
+static vec3 LoadVec3(const float *src) {
+    return vec3(src[0], src[1], src[2]);
+}
+
+bool Model::WriteToCache(const std::string &abs_path, const MurmurHash &source_hash) {
+    ModelCacheHeader header;
+    ModelCache::InitHeader(&header);
+    header.checksum = checksum;
+    header.source_hash[0] = source_hash.hash[0];
+    header.source_hash[1] = source_hash.hash[1];
+    header.precollapse_num_vertices = precollapse_num_vertices;
+    StoreVec3(header.min_coords, min_coords);
+    StoreVec3(header.max_coords, max_coords);
+    StoreVec3(header.center_coords, center_coords);
+    StoreVec3(header.old_center, old_center);
+    StoreVec3(header.bounding_sphere_origin, bounding_sphere_origin);
+    header.bounding_sphere_radius = bounding_sphere_radius;
+    header.texel_density = texel_density;
+    header.average_triangle_edge_length = average_triangle_edge_length;
+
+    const void *sections[kModelCacheNumSections];
+    size_t sizes[kModelCacheNumSections];
+    sections[kModelCacheVertices] = vertices.empty() ? NULL : &vertices[0];
+    sizes[kModelCacheVertices] = vertices.size() * sizeof(GLfloat);
+    sections[kModelCacheNormals] = normals.empty() ? NULL : &normals[0];
+    sizes[kModelCacheNormals] = normals.size() * sizeof(GLfloat);
+    sections[kModelCacheTangents] = tangents.empty() ? NULL : &tangents[0];
+    sizes[kModelCacheTangents] = tangents.size() * sizeof(GLfloat);
+    sections[kModelCacheBitangents] = bitangents.empty() ? NULL : &bitangents[0];
+    sizes[kModelCacheBitangents] = bitangents.size() * sizeof(GLfloat);
+    sections[kModelCacheTexCoords] = tex_coords.empty() ? NULL : &tex_coords[0];
+    sizes[kModelCacheTexCoords] = tex_coords.size() * sizeof(GLfloat);
+    sections[kModelCacheTexCoords2] = tex_coords2.empty() ? NULL : &tex_coords2[0];
+    sizes[kModelCacheTexCoords2] = tex_coords2.size() * sizeof(GLfloat);
+    sections[kModelCacheFaces] = faces.empty() ? NULL : &faces[0];
+    sizes[kModelCacheFaces] = faces.size() * sizeof(GLuint);
+    sections[kModelCacheFaceNormals] = face_normals.empty() ? NULL : &face_normals[0];
+    sizes[kModelCacheFaceNormals] = face_normals.size() * sizeof(vec3);
+    sections[kModelCachePrecollapseVertReorder] = precollapse_vert_reorder.empty() ? NULL : &precollapse_vert_reorder[0];
+    sizes[kModelCachePrecollapseVertReorder] = precollapse_vert_reorder.size() * sizeof(int);
+    sections[kModelCacheOptimizeVertReorder] = optimize_vert_reorder.empty() ? NULL : &optimize_vert_reorder[0];
+    sizes[kModelCacheOptimizeVertReorder] = optimize_vert_reorder.size() * sizeof(int);
+    sections[kModelCacheBVHNodes] = bvh.nodes.empty() ? NULL : &bvh.nodes[0];
+    sizes[kModelCacheBVHNodes] = bvh.nodes.size() * sizeof(TriangleBVHNode);
+    sections[kModelCacheBVHTriangles] = bvh.triangles.empty() ? NULL : &bvh.triangles[0];
+    sizes[kModelCacheBVHTriangles] = bvh.triangles.size() * sizeof(uint32_t);
+
+    return ModelCache::Write(abs_path.c_str(), header, sections, sizes);
+}
+
+bool Model::ReadFromCache(ModelCache &cache) {
+    size_t sizes[kModelCacheNumSections];
+    for (int i = 0; i < kModelCacheNumSections; i++) {
+        sizes[i] = cache.GetSectionSize(i);
+    }
+
+    size_t vertex_bytes = sizes[kModelCacheVertices];
+    size_t tex_coord_bytes = vertex_bytes / 3 * 2;
+    size_t face_bytes = sizes[kModelCacheFaces];
+    if (vertex_bytes % (sizeof(GLfloat) * 3) != 0 || face_bytes % (sizeof(GLuint) * 3) != 0 ||
+        sizes[kModelCacheNormals] != vertex_bytes || sizes[kModelCacheTangents] != vertex_bytes ||
+        sizes[kModelCacheBitangents] != vertex_bytes || sizes[kModelCacheTexCoords] != tex_coord_bytes ||
+        (sizes[kModelCacheTexCoords2] != 0 && sizes[kModelCacheTexCoords2] != tex_coord_bytes) ||
+        sizes[kModelCacheFaceNormals] != face_bytes / (sizeof(GLuint) * 3) * sizeof(vec3) ||
+        sizes[kModelCachePrecollapseVertReorder] % sizeof(int) != 0 || sizes[kModelCacheOptimizeVertReorder] % sizeof(int) != 0 ||
+        sizes[kModelCacheBVHNodes] % sizeof(TriangleBVHNode) != 0 || sizes[kModelCacheBVHTriangles] % sizeof(uint32_t) != 0) {
+        return false;
+    }
+
+    ResizeVertices((int)(vertex_bytes / (sizeof(GLfloat) * 3)));
+    tex_coords2.resize(sizes[kModelCacheTexCoords2] / sizeof(GLfloat));
+    ResizeFaces((int)(face_bytes / (sizeof(GLuint) * 3)));
+    precollapse_vert_reorder.resize(sizes[kModelCachePrecollapseVertReorder] / sizeof(int));
+    optimize_vert_reorder.resize(sizes[kModelCacheOptimizeVertReorder] / sizeof(int));
+    std::vector<TriangleBVHNode> bvh_nodes(sizes[kModelCacheBVHNodes] / sizeof(TriangleBVHNode));
+    std::vector<uint32_t> bvh_triangles(sizes[kModelCacheBVHTriangles] / sizeof(uint32_t));
+
+    // Sections are laid out in this order, so the file is read front to back.
+    void *dst[kModelCacheNumSections];
+    dst[kModelCacheVertices] = vertices.empty() ? NULL : &vertices[0];
+    dst[kModelCacheNormals] = normals.empty() ? NULL : &normals[0];
+    dst[kModelCacheTangents] = tangents.empty() ? NULL : &tangents[0];
+    dst[kModelCacheBitangents] = bitangents.empty() ? NULL : &bitangents[0];
+    dst[kModelCacheTexCoords] = tex_coords.empty() ? NULL : &tex_coords[0];
+    dst[kModelCacheTexCoords2] = tex_coords2.empty() ? NULL : &tex_coords2[0];
+    dst[kModelCacheFaces] = faces.empty() ? NULL : &faces[0];
+    dst[kModelCacheFaceNormals] = face_normals.empty() ? NULL : &face_normals[0];
+    dst[kModelCachePrecollapseVertReorder] = precollapse_vert_reorder.empty() ? NULL : &precollapse_vert_reorder[0];
+    dst[kModelCacheOptimizeVertReorder] = optimize_vert_reorder.empty() ? NULL : &optimize_vert_reorder[0];
+    dst[kModelCacheBVHNodes] = bvh_nodes.empty() ? NULL : &bvh_nodes[0];
+    dst[kModelCacheBVHTriangles] = bvh_triangles.empty() ? NULL : &bvh_triangles[0];
+    for (int i = 0; i < kModelCacheNumSections; i++) {
+        if (!cache.ReadSection(i, dst[i])) {
+            Dispose();
+            return false;
+        }
+    }
+
+    const ModelCacheHeader &header = cache.GetHeader();
+    precollapse_num_vertices = header.precollapse_num_vertices;
+    min_coords = LoadVec3(header.min_coords);
+    max_coords = LoadVec3(header.max_coords);
+    center_coords = LoadVec3(header.center_coords);
+    old_center = LoadVec3(header.old_center);
+    bounding_sphere_origin = LoadVec3(header.bounding_sphere_origin);
+    bounding_sphere_radius = header.bounding_sphere_radius;
+    texel_density = header.texel_density;
+    average_triangle_edge_length = header.average_triangle_edge_length;
+
+    if (!bvh_nodes.empty()) {
+        std::lock_guard<std::mutex> lock(bvh_mutex);
+        // Left to be rebuilt on first use if it doesn't match the faces
+        bvh.Assign(&bvh_nodes[0], (int)bvh_nodes.size(), bvh_triangles.empty() ? NULL : &bvh_triangles[0], (int)bvh_triangles.size(), (int)faces.size() / 3);
+    }
+    return true;
+}
+
+bool Model::ReadFromCacheFile(const char *abs_path, unsigned short source_checksum, const MurmurHash &source_hash) {
+    ModelCache cache;
+    if (cache.Open(abs_path)) {
+        const ModelCacheHeader &header = cache.GetHeader();
+        return source_checksum == header.checksum && source_hash.hash[0] == header.source_hash[0] &&
+               source_hash.hash[1] == header.source_hash[1] && ReadFromCache(cache);
+    }
+
+    // Caches written before the version 2 format
+    bool read = false;
+    FILE *cache_file = my_fopen(abs_path, "rb");
+    if (cache_file) {
+        unsigned short file_checksum = 0;
+        fread(&file_checksum, sizeof(unsigned short), 1, cache_file);
+        unsigned short version = 0;
+        fread(&version, sizeof(unsigned short), 1, cache_file);
+        if (source_checksum == file_checksum && version == _model_cache_version) {
+            ReadFromFile(cache_file);
+            read = true;
+        }
+        fclose(cache_file);
+    }
+    return read;
+}
+
 void Model::Dispose() {
     vertices.clear();
     normals.clear();
@@ -264,6 +418,8 @@ void Model::Dispose() {
     optimize_vert_reorder.clear();
     precollapse_vert_reorder.clear();
 
+    VerticesChanged();
+
     if (vbo_enabled && vbo_loaded) {
         VBO_vertices.Dispose();
         VBO_tex_coords.Dispose();
@@ -955,24 +1111,18 @@ void Model::LoadObj(const std::string &rel_path, char flags, const std::string &
         name_to_load = fail_whale;
     }
 
+    FileFingerprint fingerprint;
+    memset(&fingerprint, 0, sizeof(fingerprint));
     if (found_model) {
-        checksum = Checksum(abs_path);
+        if (!FileFingerprintStore::Instance().Get(abs_path, &fingerprint)) {
+            LOGE << "Failed to open file " << abs_path << std::endl;
+        }
+        checksum = fingerprint.checksum;
     }
 
-    if (found_cache) {
-        FILE *cache_file = my_fopen(abs_cache_path, "rb");
-        if (cache_file) {
-            unsigned short file_checksum = 0;
-            fread(&file_checksum, sizeof(unsigned short), 1, cache_file);
-            unsigned short version;
-            fread(&version, sizeof(unsigned short), 1, cache_file);
-            if (checksum == file_checksum && version == _model_cache_version) {
-                ReadFromFile(cache_file);
-                load_model = false;
-                modsource_ = cache_modsource;
-            }
-            fclose(cache_file);
-        }
+    if (found_cache && ReadFromCacheFile(abs_cache_path, checksum, fingerprint.hash)) {
+        load_model = false;
+        modsource_ = cache_modsource;
     }
 
     if (load_model) {
@@ -1046,13 +1196,8 @@ void Model::LoadObj(const std::string &rel_path, char flags, const std::string &
             OptimizeTriangleOrder();
             OptimizeVertexOrder();
 
-            FILE *cache_file = my_fopen((GetWritePath(modsource) + cache_name_to_load + ".cache").c_str(), "wb");
-            if (cache_file) {
-                fwrite(&checksum, sizeof(unsigned short), 1, cache_file);
-                fwrite(&_model_cache_version, sizeof(unsigned short), 1, cache_file);
-                WriteToFile(cache_file);
-                fclose(cache_file);
-            }
+            BuildBVH();
+            WriteToCache(GetWritePath(modsource) + cache_name_to_load + ".cache", fingerprint.hash);
             modsource_ = modsource;
         } else {
             if (fail_whale == rel_path) {
@@ -1577,6 +1722,7 @@ void Model::calcBoundingSphere() {
 
 // must be called after center_coords has been set (i.e. after call to calcBoundingSphere
 void Model::CenterModel() {
+    VerticesChanged();
     for (int i = 0, len = vertices.size() / 3; i < len; i++) {
         vertices[3 * i] -= center_coords.x();
         vertices[3 * i + 1] -= center_coords.y();
@@ -1588,6 +1734,7 @@ void Model::CenterModel() {
 }
 
 void Model::ResizeVertices(int size) {
+    VerticesChanged();
     vertices.resize(size * 3);
     normals.resize(size * 3);
     tangents.resize(size * 3);
@@ -1602,6 +1749,7 @@ void Model::ResizeVertices(int size) {
 }
 
 void Model::ResizeFaces(int size) {
+    VerticesChanged();
     bool success = false;
     while (!success) {
         try {
@@ -1823,9 +1971,44 @@ class ChildHitCompare {
 };
 
 // Check a line against the model for collision
+static const int kMinBVHFaces = 32;
+
+void Model::VerticesChanged() {
+    std::lock_guard<std::mutex> lock(bvh_mutex);
+    bvh.Clear();
+}
+
+void Model::BuildBVH() {
+    std::lock_guard<std::mutex> lock(bvh_mutex);
+    int num_faces = (int)faces.size() / 3;
+    if (num_faces >= kMinBVHFaces) {
+        bvh.Build(&vertices[0], &faces[0], num_faces);
+    } else {
+        bvh.Clear();
+    }
+}
+
+const TriangleBVH *Model::GetBVH() const {
+    std::lock_guard<std::mutex> lock(bvh_mutex);
+    int num_faces = (int)faces.size() / 3;
+    if (num_faces < kMinBVHFaces) {
+        return NULL;
+    }
+    // Also catches faces that were added or removed without invalidating
+    if (!bvh.IsBuilt() || bvh.GetNumFaces() != num_faces) {
+        bvh.Build(&vertices[0], &faces[0], num_faces);
+    }
+    return &bvh;
+}
+
 int Model::lineCheck(const vec3 &p1, const vec3 &p2, vec3 *p, vec3 *normal, bool backface) const {
     if (!sphere_line_intersection(p1, p2, bounding_sphere_origin, bounding_sphere_radius)) return -1;
 
+    const TriangleBVH *tree = GetBVH();
+    if (tree) {
+        return tree->LineCheck(p1, p2, &vertices[0], &faces[0], &face_normals[0], p, normal);
+    }
+
     float distance;
     float olddistance = 0;
     int intersecting = 0;
@@ -1892,6 +2075,7 @@ void Model::CalcAverageTriangleEdge() {
 }
 
 void Model::CopyFacesFromModel(const Model &source_model, const std::vector<int> &copy_faces) {
+    VerticesChanged();
     vbo_loaded = false;
     vbo_enabled = false;
 
@@ -1999,7 +2183,7 @@ void Model::LoadObjMorph(const std::string &rel_path, const std::string &rel_bas
     bool load_model = true;
 
     size_t read_count = 0;
-    unsigned short checksum = Checksum(abs_path);
+    unsigned short checksum = FileFingerprintStore::Instance().GetChecksum(abs_path);
     FILE *cache_file = my_fopen((GetWritePath(modsource) + rel_path + ".mcache").c_str(), "rb");
     if (cache_file) {
         unsigned short file_checksum = 0;
@@ -2111,6 +2295,7 @@ bool operator!=(const VertInfo &a, const VertInfo &b) {
 }  // namespace
 
 void Model::RemoveDuplicatedVerts() {
+    VerticesChanged();
     if (vertices.empty()) {
         DisplayError("Warning", "Calling RemoveDuplicatedVerts on empty mesh.");
         return;
@@ -2165,6 +2350,7 @@ void Model::RemoveDuplicatedVerts() {
 }
 
 void Model::RemoveDegenerateTriangles() {
+    VerticesChanged();
     unsigned count = 0;
     unsigned index = 0;
     unsigned copy_index = 0;
@@ -2267,6 +2453,7 @@ void Model::PrintACMR() {
 }
 
 void Model::OptimizeTriangleOrder() {
+    VerticesChanged();
     std::vector<TriData> tris(faces.size() / 3);
     std::vector<VertData> verts(vertices.size() / 3);
 
@@ -2374,6 +2561,7 @@ void Model::OptimizeTriangleOrder() {
 }
 
 void Model::OptimizeVertexOrder() {
+    VerticesChanged();
     std::vector<int> order(vertices.size() / 3, -1);
     unsigned index = 0;
     for (unsigned int &face : faces) {
@@ -2406,6 +2594,7 @@ class TriScoreSorter {
 };
 
 void Model::SortTrianglesBackToFront(const vec3 &camera) {
+    VerticesChanged();
     std::vector<TriData> tris(faces.size() / 3);
 
     unsigned index = 0;
@@ -28,6 +28,7 @@
 #include "Math/mat3.h"
 
 #include "Graphics/vbocontainer.h"
+#include "Math/trianglebvh.h"
 #include "Internal/filesystem.h"
 #include "Asset/Asset/image_sampler.h"
 
@@ -36,9 +37,12 @@
 #include <vector>
 #include <stdio.h>
 #include <string>
+#include <mutex>
 
 class Mesh;
 class DrawBatch;
+class ModelCache;
+struct MurmurHash;
 
 //-----------------------------------------------------------------------------
 // Class Definition
@@ -110,6 +114,9 @@ class Model {
 
     int lineCheckNoBackface(const vec3 &p1, const vec3 &p2, vec3 *p, vec3 *normal = 0) const;
     int lineCheck(const vec3 &p1, const vec3 &p2, vec3 *p, vec3 *normal = 0, bool backface = true) const;
+    // Call after writing vertices or faces directly, drops what is derived from them. Line checks
+    // on models with enough faces go through a BVH, built on first use or loaded from the model cache.
+    void VerticesChanged();
     void LoadObj(const std::string &name, char flags = _MDL_CENTER, const std::string &alt_name = "", const PathFlags searchPaths = kAnyPath);
     void RemoveDoubledTriangles();
     void Draw();
@@ -129,6 +136,11 @@ class Model {
     void ResizeFaces(int size);
     void WriteToFile(FILE *file);
     void ReadFromFile(FILE *file);
+    bool WriteToCache(const std::string &abs_path, const MurmurHash &source_hash);
+    // Returns false if the cache sections don't fit together or can't be read.
+    bool ReadFromCache(ModelCache &cache);
+    // Reads either cache format, returns false if the cache is invalid or was made from a different source file.
+    bool ReadFromCacheFile(const char *abs_path, unsigned short source_checksum, const MurmurHash &source_hash);
     void CalcTexelDensity();
     void CalcAverageTriangleEdge();
     void Dispose();
@@ -157,6 +169,13 @@ class Model {
     const static int ERROR_MORE_THAN_ONE_OBJECT;
     int SimpleLoadTriangleCutObj(const std::string &name_to_load);
     const char *GetLoadErrorString(int err);
+
+   private:
+    const TriangleBVH *GetBVH() const;
+    void BuildBVH();
+
+    mutable TriangleBVH bvh;
+    mutable std::mutex bvh_mutex;
 };
 void CopyTexCoords2(Model &a, const Model &b);
 
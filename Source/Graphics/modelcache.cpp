@@ -0,0 +1,191 @@
+//-----------------------------------------------------------------------------
+//           Name: modelcache.cpp
+//      Developer: Wolfire Games LLC
+//    Description:
+//        License: Read below
+//-----------------------------------------------------------------------------
+//
+//
+//   Copyright 2022 Wolfire Games LLC
+//
+//   Licensed under the Apache License, Version 2.0 (the "License");
+//   you may not use this file except in compliance with the License.
+//   You may obtain a copy of the License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//   Unless required by applicable law or agreed to in writing, software
+//   distributed under the License is distributed on an "AS IS" BASIS,
+//   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//   See the License for the specific language governing permissions and
+//   limitations under the License.
+//
+//-----------------------------------------------------------------------------
+#include "modelcache.h"
+
+#include <Compat/fileio.h>
+#include <Internal/filesystem.h>
+#include <Internal/profiler.h>
+#include <Logging/logdata.h>
+
+#include <zstd.h>
+
+#include <sys/stat.h>
+#include <cstring>
+
+static const char kModelCacheMagic[4] = {'O', 'G', 'M', 'C'};
+static const size_t kSectionAlignment = 16;
+static const int kCompressionLevel = 3;
+
+static bool use_compression = false;
+
+static size_t AlignSection(size_t size) {
+    return (size + kSectionAlignment - 1) & ~(kSectionAlignment - 1);
+}
+
+ModelCache::ModelCache() : file(NULL) {
+    memset(&header, 0, sizeof(header));
+}
+
+ModelCache::~ModelCache() {
+    Close();
+}
+
+void ModelCache::SetUseCompression(bool value) {
+    use_compression = value;
+}
+
+void ModelCache::InitHeader(ModelCacheHeader* header) {
+    memset(header, 0, sizeof(*header));
+    header->version = _model_cache_v2_version;
+    memcpy(header->magic, kModelCacheMagic, sizeof(kModelCacheMagic));
+    header->header_size = sizeof(ModelCacheHeader);
+    header->num_sections = kModelCacheNumSections;
+}
+
+bool ModelCache::ValidateHeader(uint64_t file_size) const {
+    if (header.version != _model_cache_v2_version || memcmp(header.magic, kModelCacheMagic, sizeof(kModelCacheMagic)) != 0 ||
+        header.header_size != sizeof(ModelCacheHeader) || header.num_sections != kModelCacheNumSections) {
+        return false;
+    }
+    for (int i = 0; i < kModelCacheNumSections; i++) {
+        const ModelCacheSection& section = header.sections[i];
+        if (section.offset % kSectionAlignment != 0 || section.offset < sizeof(ModelCacheHeader) ||
+            section.offset > file_size || section.stored_size > file_size - section.offset) {
+            return false;
+        }
+        if (section.compression == kModelCacheUncompressed) {
+            if (section.stored_size != section.size) {
+                return false;
+            }
+        } else if (section.compression != kModelCacheZstd) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool ModelCache::Open(const char* abs_path) {
+    Close();
+
+    file = my_fopen(abs_path, "rb");
+    if (file == NULL) {
+        return false;
+    }
+
+    struct stat buf;
+    if (fstat(fileno(file), &buf) != 0 || fread(&header, sizeof(header), 1, file) != 1 || !ValidateHeader((uint64_t)buf.st_size)) {
+        Close();
+        return false;
+    }
+    return true;
+}
+
+void ModelCache::Close() {
+    if (file) {
+        fclose(file);
+        file = NULL;
+    }
+}
+
+size_t ModelCache::GetSectionSize(int id) const {
+    return (size_t)header.sections[id].size;
+}
+
+bool ModelCache::ReadSection(int id, void* dst) {
+    const ModelCacheSection& section = header.sections[id];
+    if (section.size == 0) {
+        return true;
+    }
+    if (file == NULL || fseek(file, (long)section.offset, SEEK_SET) != 0) {
+        return false;
+    }
+
+    if (section.compression == kModelCacheUncompressed) {
+        return fread(dst, (size_t)section.size, 1, file) == 1;
+    }
+
+    if (staging.size() < section.stored_size) {
+        staging.resize((size_t)section.stored_size);
+    }
+    if (fread(&staging[0], (size_t)section.stored_size, 1, file) != 1) {
+        return false;
+    }
+    size_t result = ZSTD_decompress(dst, (size_t)section.size, &staging[0], (size_t)section.stored_size);
+    return !ZSTD_isError(result) && result == section.size;
+}
+
+bool ModelCache::Write(const char* abs_path, ModelCacheHeader& header, const void* const* sections, const size_t* sizes) {
+    PROFILER_ZONE(g_profiler_ctx, "ModelCache::Write");
+    std::vector<std::vector<char> > compressed(kModelCacheNumSections);
+    const void* stored[kModelCacheNumSections];
+
+    size_t offset = AlignSection(sizeof(ModelCacheHeader));
+    for (int i = 0; i < kModelCacheNumSections; i++) {
+        ModelCacheSection& section = header.sections[i];
+        section.size = sizes[i];
+        section.stored_size = sizes[i];
+        section.compression = kModelCacheUncompressed;
+        section.padding = 0;
+        stored[i] = sections[i];
+
+        if (use_compression && sizes[i] > 0) {
+            compressed[i].resize(ZSTD_compressBound(sizes[i]));
+            size_t result = ZSTD_compress(&compressed[i][0], compressed[i].size(), sections[i], sizes[i], kCompressionLevel);
+            // Only worth decompressing if it saves at least a quarter of the reading.
+            if (!ZSTD_isError(result) && result < sizes[i] - sizes[i] / 4) {
+                section.stored_size = result;
+                section.compression = kModelCacheZstd;
+                stored[i] = &compressed[i][0];
+            }
+        }
+
+        section.offset = offset;
+        offset += AlignSection((size_t)section.stored_size);
+    }
+
+    FILE* file = my_fopen(abs_path, "wb");
+    if (file == NULL) {
+        return false;
+    }
+
+    static const char zeroes[kSectionAlignment] = {0};
+    bool ok = fwrite(&header, sizeof(header), 1, file) == 1;
+    size_t written = sizeof(header);
+    for (int i = 0; i < kModelCacheNumSections && ok; i++) {
+        const ModelCacheSection& section = header.sections[i];
+        size_t padding = (size_t)section.offset - written;
+        ok = fwrite(zeroes, 1, padding, file) == padding;
+        if (ok && section.stored_size > 0) {
+            ok = fwrite(stored[i], (size_t)section.stored_size, 1, file) == 1;
+        }
+        written = (size_t)(section.offset + section.stored_size);
+    }
+    fclose(file);
+
+    if (!ok) {
+        LOGE << "Failed to write model cache " << abs_path << std::endl;
+        deletefile(abs_path);
+    }
+    return ok;
+}
@@ -0,0 +1,126 @@
+//-----------------------------------------------------------------------------
+//           Name: modelcache.h
+//      Developer: Wolfire Games LLC
+//    Description: Version 2 model cache format, a header of section offsets
+//                 followed by 16 byte aligned, optionally compressed, sections.
+//        License: Read below
+//-----------------------------------------------------------------------------
+//
+//
+//   Copyright 2022 Wolfire Games LLC
+//
+//   Licensed under the Apache License, Version 2.0 (the "License");
+//   you may not use this file except in compliance with the License.
+//   You may obtain a copy of the License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//   Unless required by applicable law or agreed to in writing, software
+//   distributed under the License is distributed on an "AS IS" BASIS,
+//   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//   See the License for the specific language governing permissions and
+//   limitations under the License.
+//
+//-----------------------------------------------------------------------------
+#pragma once
+
+#include <Internal/integer.h>
+
+#include <cstddef>
+#include <cstdio>
+#include <vector>
+
+// Versions up to _model_cache_version are the old sequential format read by Model::ReadFromFile.
+const unsigned short _model_cache_v2_version = 101;
+
+enum ModelCacheSectionID {
+    kModelCacheVertices,
+    kModelCacheNormals,
+    kModelCacheTangents,
+    kModelCacheBitangents,
+    kModelCacheTexCoords,
+    kModelCacheTexCoords2,
+    kModelCacheFaces,
+    kModelCacheFaceNormals,
+    kModelCachePrecollapseVertReorder,
+    kModelCacheOptimizeVertReorder,
+    kModelCacheBVHNodes,
+    kModelCacheBVHTriangles,
+    kModelCacheNumSections
+};
+
+enum ModelCacheCompression {
+    kModelCacheUncompressed = 0,
+    kModelCacheZstd = 1
+};
+
+struct ModelCacheSection {
+    uint64_t offset;       // From the start of the file, 16 byte aligned
+    uint64_t stored_size;  // Bytes in the file
+    uint64_t size;         // Bytes once decompressed
+    uint32_t compression;
+    uint32_t padding;
+};
+
+struct ModelCacheHeader {
+    // Same place as in the old format, so older builds just see a version mismatch.
+    uint16_t checksum;
+    uint16_t version;
+    char magic[4];
+    uint32_t header_size;
+    uint32_t num_sections;
+    uint64_t source_hash[2];  // FileFingerprint hash of the source obj
+
+    int32_t precollapse_num_vertices;
+    float min_coords[3];
+    float max_coords[3];
+    float center_coords[3];
+    float old_center[3];
+    float bounding_sphere_origin[3];
+    float bounding_sphere_radius;
+    float texel_density;
+    float average_triangle_edge_length;
+    uint32_t padding[3];
+
+    ModelCacheSection sections[kModelCacheNumSections];
+};
+
+/*
+ * The header is read and checked against the file size when the cache is
+ * opened, then each section is read, or decompressed, straight into the
+ * storage it belongs in, with no copy in between. Compressed sections are
+ * staged in a buffer that is kept for the lifetime of the ModelCache, so one
+ * instance can be reused for a series of files without allocating.
+ */
+class ModelCache {
+   public:
+    ModelCache();
+    ~ModelCache();
+
+    // Returns false if abs_path can't be read or isn't a valid version 2 cache.
+    bool Open(const char* abs_path);
+    void Close();
+
+    const ModelCacheHeader& GetHeader() const { return header; }
+    // Uncompressed size of a section in bytes.
+    size_t GetSectionSize(int id) const;
+    // Reads GetSectionSize(id) bytes into dst.
+    bool ReadSection(int id, void* dst);
+
+    // Fills in header.sections from the section contents and writes the file,
+    // compressing sections where it saves enough space to be worth it.
+    static bool Write(const char* abs_path, ModelCacheHeader& header, const void* const* sections, const size_t* sizes);
+    static void InitHeader(ModelCacheHeader* header);
+
+    static void SetUseCompression(bool use_compression);
+
+   private:
+    ModelCache(const ModelCache& other);
+    ModelCache& operator=(const ModelCache& other);
+
+    bool ValidateHeader(uint64_t file_size) const;
+
+    ModelCacheHeader header;
+    FILE* file;
+    std::vector<char> staging;
+};
@@ -742,14 +742,13 @@ void Particle::Update(SceneGraph* scenegraph, float timestep, float curr_game_ti
         last_connected_pos = (*connected.begin())->position;
     }
 
+}
+
+void Particle::UpdateCollision(SceneGraph* scenegraph, float timestep, const RayQueryResult* level_hit) {
     if (particle_type->collision) {
-        SimpleRayResultCallbackInfo cb;
-        vec3 point, normal;
-        bool hit = (scenegraph->bullet_world_->CheckRayCollision(
-                        old_position,
-                        position,
-                        &point,
-                        &normal) != NULL);
+        vec3 point = level_hit->point;
+        vec3 normal = level_hit->normal;
+        bool hit = level_hit->object != NULL;
         vec3 new_pos = hit ? point : position;
         int char_id = -1;
         if (particle_type->character_collide) {
@@ -1283,9 +1282,39 @@ void ParticleSystem::Update(SceneGraph* scenegraph, float timestep, float curr_g
     }
     {
         PROFILER_ZONE(g_profiler_ctx, "Looping through all particles");
+        collision_queries.clear();
         for (int i = (int)particles.size() - 1; i >= 0; i--) {
-            particles[i]->Update(scenegraph, timestep, curr_game_time);
-            if (particles[i]->color[3] <= 0 || particles[i]->size <= 0) deleteParticle(i);
+            Particle* particle = particles[i];
+            particle->Update(scenegraph, timestep, curr_game_time);
+            if (particle->particle_type->collision) {
+                RayQuery query;
+                query.start = particle->old_position;
+                query.end = particle->position;
+                query.radius = 0.0f;
+                query.static_only = true;
+                collision_queries.push_back(query);
+            }
+        }
+    }
+    {
+        PROFILER_ZONE(g_profiler_ctx, "Particle level collisions");
+        collision_results.resize(collision_queries.size());
+        if (!collision_queries.empty()) {
+            scenegraph->bullet_world_->CheckRayCollisionBatch(&collision_queries[0], (int)collision_queries.size(), &collision_results[0]);
+        }
+    }
+    {
+        PROFILER_ZONE(g_profiler_ctx, "Handling particle collisions");
+        // Same order as the queries were made in, deleting only swaps in particles that were already handled
+        int next_result = 0;
+        for (int i = (int)particles.size() - 1; i >= 0; i--) {
+            Particle* particle = particles[i];
+            const RayQueryResult* level_hit = NULL;
+            if (particle->particle_type->collision) {
+                level_hit = &collision_results[next_result++];
+            }
+            particle->UpdateCollision(scenegraph, timestep, level_hit);
+            if (particle->color[3] <= 0 || particle->size <= 0) deleteParticle(i);
         }
     }
 }
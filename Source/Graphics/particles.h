@@ -34,6 +34,7 @@
 #include <Asset/Asset/particletype.h>
 
 #include <Scripting/angelscript/ascontext.h>
+#include <Physics/bulletworld.h>
 
 #include <map>
 #include <vector>
@@ -74,7 +75,9 @@ class Particle {
     bool collided;
 
     void Draw(SceneGraph *scenegraph, DrawType draw_type, const mat4 &proj_view_matrix);
+    // Moves the particle, UpdateCollision then handles whatever it hit on the way
     void Update(SceneGraph *scenegraph, float timestep, float curr_game_time);
+    void UpdateCollision(SceneGraph *scenegraph, float timestep, const RayQueryResult *level_hit);
 };
 
 class ParticleSystem {
@@ -103,6 +106,9 @@ class ParticleSystem {
     ParticleVector particles;
     typedef std::map<unsigned, Particle *> ParticleMap;
     ParticleMap particle_map;
+    // Level collisions for every colliding particle are checked together, these are kept to avoid per-frame mallocs
+    std::vector<RayQuery> collision_queries;
+    std::vector<RayQueryResult> collision_results;
 };
 
 void DrawGPUParticleField(SceneGraph *scenegraph, const char *type);
@@ -32,6 +32,8 @@
 
 #include <tinyxml.h>
 
+#include <algorithm>
+
 void AnimationRetargeter::Reload() {
     int64_t new_date_modified = GetDateModifiedInt64(path.c_str());
     if (new_date_modified > date_modified) {
@@ -86,6 +88,7 @@ void AnimationRetargeter::Load(const char* _path) {
                 }
             }
         }
+        ++generation;
     }
 }
 
@@ -100,6 +103,16 @@ const std::string& AnimationRetargeter::GetSkeletonFile(const std::string& anim)
     return iter->second;
 }
 
+std::vector<std::string> AnimationRetargeter::GetSkeletonFiles() const {
+    std::vector<std::string> skeleton_files;
+    for (const auto& entry : anim_skeleton) {
+        if (std::find(skeleton_files.begin(), skeleton_files.end(), entry.second) == skeleton_files.end()) {
+            skeleton_files.push_back(entry.second);
+        }
+    }
+    return skeleton_files;
+}
+
 bool AnimationRetargeter::GetNoRetarget(const std::string& anim) {
     std::map<std::string, bool>::iterator iter = anim_no_retarget.find(anim);
     if (iter != anim_no_retarget.end()) {
@@ -27,12 +27,14 @@
 
 #include <map>
 #include <string>
+#include <vector>
 
 class AnimationRetargeter {
     std::string path;
     int64_t date_modified;
     std::map<std::string, bool> anim_no_retarget;
     std::map<std::string, std::string> anim_skeleton;
+    int generation = 0;
 
    public:
     static AnimationRetargeter *Instance() {
@@ -43,5 +45,7 @@ class AnimationRetargeter {
     void Load(const char *path);
     void Reload();
     const std::string &GetSkeletonFile(const std::string &anim);
+    std::vector<std::string> GetSkeletonFiles() const;  // Each skeleton animations are made for, once
     bool GetNoRetarget(const std::string &anim);
+    int GetGeneration() const { return generation; }  // Goes up every time the file is loaded
 };
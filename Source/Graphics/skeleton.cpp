@@ -1584,6 +1584,32 @@ void Skeleton::UpdateCollisionWorldAABB() {
     col_bullet_world->UpdateAABB();
 }
 
+bool Skeleton::GetCollisionBounds(vec3 *center, float *radius) const {
+    if (!col_bullet_world || !col_bullet_world->dynamics_world_) {
+        return false;
+    }
+    // Collision queries only look at objects whose broadphase boxes they cross, so these boxes bound every hit
+    const btCollisionObjectArray &objects = col_bullet_world->dynamics_world_->getCollisionObjectArray();
+    btVector3 bounds_min(FLT_MAX, FLT_MAX, FLT_MAX);
+    btVector3 bounds_max(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+    bool any = false;
+    for (int i = 0, len = objects.size(); i < len; ++i) {
+        const btBroadphaseProxy *proxy = objects[i]->getBroadphaseHandle();
+        if (proxy) {
+            bounds_min.setMin(proxy->m_aabbMin);
+            bounds_max.setMax(proxy->m_aabbMax);
+            any = true;
+        }
+    }
+    if (!any) {
+        return false;
+    }
+    btVector3 bt_center = (bounds_min + bounds_max) * 0.5f;
+    *center = vec3(bt_center[0], bt_center[1], bt_center[2]);
+    *radius = (bounds_max - bt_center).length();
+    return true;
+}
+
 const btCollisionObject *Skeleton::CheckRayCollision(const vec3 &start, const vec3 &end, vec3 *point, vec3 *normal) {
     return col_bullet_world->CheckRayCollision(start, end, point, normal, false);
 }
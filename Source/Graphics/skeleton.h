@@ -140,6 +140,8 @@ class Skeleton {
     void DrawCollisionBulletWorld();
     void GetSweptSphereCollisionCharacter(const vec3 &pos, const vec3 &pos2, float radius, SphereCollision &as_col);
     void UpdateCollisionWorldAABB();
+    // A sphere around everything CheckRayCollision and GetSweptSphereCollisionCharacter can hit
+    bool GetCollisionBounds(vec3 *center, float *radius) const;
     const btCollisionObject *CheckRayCollision(const vec3 &start, const vec3 &end, vec3 *point, vec3 *normal);
     int CheckRayCollisionBone(const vec3 &start, const vec3 &end);
     ~Skeleton();
@@ -35,7 +35,7 @@
 #include <Graphics/pxdebugdraw.h>
 
 #include <Internal/common.h>
-#include <Internal/checksum.h>
+#include <Internal/filefingerprint.h>
 #include <Internal/collisiondetection.h>
 #include <Internal/filesystem.h>
 
@@ -290,7 +290,7 @@ bool Terrain::LoadCachedSimplifiedTerrain() {
     unsigned short uv2_checksum = 0;
     if (FindFilePath(uv2_rel_path, abs_uv2_path, kPathSize, kDataPaths | kModPaths, false, NULL) == 0) {
         // found_uv2 = true;
-        uv2_checksum = Checksum(abs_uv2_path);
+        uv2_checksum = FileFingerprintStore::Instance().GetChecksum(abs_uv2_path);
     }
 
     const int kMaxPaths = 5;
@@ -453,6 +453,7 @@ void Terrain::CalculateSimplifiedTerrain() {
         terrain_simplified_model.vertices[index] -= kHeightMapHeight;
         index += 3;
     }
+    terrain_simplified_model.VerticesChanged();
 
     AddLoadingText("Calculating terrain normals...");
     terrain_simplified_model.calcNormals();
@@ -474,7 +475,7 @@ void Terrain::CalculateSimplifiedTerrain() {
 
     if (FindFilePath(uv2_rel_path, abs_uv2_path, kPathSize, kDataPaths | kModPaths, false, NULL) == 0) {
         // found_uv2 = true;
-        uv2_checksum = Checksum(abs_uv2_path);
+        uv2_checksum = FileFingerprintStore::Instance().GetChecksum(abs_uv2_path);
 
         Model temp;
         temp.SimpleLoadTriangleCutObj(abs_uv2_path);
@@ -516,6 +517,7 @@ void Terrain::CalculateMinimalTerrain() {
         terrain_minimal_model.vertices[index] -= kHeightMapHeight;
         index += 3;
     }
+    terrain_minimal_model.VerticesChanged();
 
     terrain_minimal_model.calcNormals();
     terrain_minimal_model.calcTangents();
@@ -615,12 +617,16 @@ void Terrain::Load(const char *name, const std::string &model_override) {
         CalculateSimplifiedTerrain();
     }
 
+    Model &terrain_simplified_model = Models::Instance()->GetModel(model_id);
     if (!model_override.empty()) {
-        Model &terrain_simplified_model = Models::Instance()->GetModel(model_id);
         terrain_simplified_model.LoadObj(model_override, 0);
         for (float &i : terrain_simplified_model.tex_coords2) {
             i *= 2048.0f;
         }
+    } else {
+        // Names the physics mesh cache after the heightmap
+        terrain_simplified_model.path = heightmap_.path();
+        terrain_simplified_model.modsource_ = heightmap_.modsource_;
     }
 
     LOGI << "*****************" << std::endl;
@@ -2415,6 +2415,50 @@ int Textures::getHeight(const TextureAssetRef& which) {
     return textures[which->id].height;
 }
 
+size_t Textures::GetResidentBytes(unsigned int id) {
+    PROFILED_TEXTURE_MUTEX_LOCK
+    if (id >= textures.size()) {
+        return 0;
+    }
+    const Texture& t = textures[id];
+    if (t.gl_buffer_id != 0) {
+        return t.size;
+    }
+
+    // Bits per pixel for the formats the engine uses, anything else is counted as 8 bit RGBA.
+    size_t bits = 32;
+    switch (t.internal_format) {
+        case GL_COMPRESSED_RGB_S3TC_DXT1_EXT:
+        case GL_COMPRESSED_RGBA_S3TC_DXT1_EXT:
+        case GL_COMPRESSED_SRGB_S3TC_DXT1_EXT:
+        case GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT:
+            bits = 4;
+            break;
+        case GL_COMPRESSED_RGBA_S3TC_DXT3_EXT:
+        case GL_COMPRESSED_RGBA_S3TC_DXT5_EXT:
+        case GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT3_EXT:
+        case GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT:
+            bits = 8;
+            break;
+        case GL_RGBA16F:
+            bits = 64;
+            break;
+        case GL_RGBA32F:
+            bits = 128;
+            break;
+    }
+
+    size_t pixels = (size_t)std::max(t.width, 0) * (size_t)std::max(t.height, 0) * (size_t)std::max(t.depth, 1) * (size_t)std::max(t.num_slices, 1U);
+    if (t.cube_map) {
+        pixels *= 6;
+    }
+    size_t bytes = pixels * bits / 8;
+    if (!t.no_mipmap) {
+        bytes += bytes / 3;
+    }
+    return bytes;
+}
+
 /**
  *  @brief Returns the width multiplied with the texture reduction factor if the texture is reduced
  */
@@ -260,6 +260,9 @@ class Textures {
     int getWidth(const TextureAssetRef& which);
     int getHeight(const TextureAssetRef& which);
 
+    // Estimated size of the texture data, counting mipmaps and every slice or face.
+    size_t GetResidentBytes(unsigned int id);
+
     int getReducedWidth(const TextureRef& which);
     int getReducedHeight(const TextureRef& which);
 
@@ -22,7 +22,7 @@
 //-----------------------------------------------------------------------------
 #include "cachefile.h"
 
-#include <Internal/checksum.h>
+#include <Internal/filefingerprint.h>
 #include <Internal/datemodified.h>
 #include <Internal/filesystem.h>
 
@@ -71,7 +71,7 @@ bool CacheFile::CheckForCache(const std::string &path, const std::string &suffix
     }
 
     if (latest_base_date_modified != -1) {
-        *checksum = Checksum(base_path);
+        *checksum = FileFingerprintStore::Instance().GetChecksum(base_path);
     } else {
         *checksum = 0;
     }
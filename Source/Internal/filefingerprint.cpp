@@ -0,0 +1,219 @@
+//-----------------------------------------------------------------------------
+//           Name: filefingerprint.cpp
+//      Developer: Wolfire Games LLC
+//    Description:
+//        License: Read below
+//-----------------------------------------------------------------------------
+//
+//
+//   Copyright 2022 Wolfire Games LLC
+//
+//   Licensed under the Apache License, Version 2.0 (the "License");
+//   you may not use this file except in compliance with the License.
+//   You may obtain a copy of the License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//   Unless required by applicable law or agreed to in writing, software
+//   distributed under the License is distributed on an "AS IS" BASIS,
+//   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//   See the License for the specific language governing permissions and
+//   limitations under the License.
+//
+//-----------------------------------------------------------------------------
+#include "filefingerprint.h"
+
+#include <Compat/fileio.h>
+#include <Compat/platform.h>
+#include <Internal/profiler.h>
+#include <Logging/logdata.h>
+
+#include <sys/stat.h>
+#include <cstring>
+#include <cstdio>
+
+static const char kFingerprintStoreMagic[4] = {'O', 'G', 'F', 'P'};
+static const uint32_t kFingerprintStoreVersion = 1;
+
+static bool GetFileMetadata(const std::string& abs_path, FileFingerprint* fingerprint) {
+#ifdef _WIN32
+    struct _stat64 buf;
+    if (_wstat64(UTF16fromUTF8(abs_path).c_str(), &buf) != 0) {
+        return false;
+    }
+    fingerprint->mtime = (int64_t)buf.st_mtime;
+#else
+    struct stat buf;
+    if (stat(abs_path.c_str(), &buf) != 0) {
+        return false;
+    }
+#if PLATFORM_MACOSX
+    fingerprint->mtime = (int64_t)buf.st_mtimespec.tv_sec * 1000000000 + buf.st_mtimespec.tv_nsec;
+#else
+    fingerprint->mtime = (int64_t)buf.st_mtim.tv_sec * 1000000000 + buf.st_mtim.tv_nsec;
+#endif
+#endif
+    fingerprint->size = (uint64_t)buf.st_size;
+    fingerprint->inode = (uint64_t)buf.st_ino;
+    return true;
+}
+
+FileFingerprintStore& FileFingerprintStore::Instance() {
+    static FileFingerprintStore instance;
+    return instance;
+}
+
+FileFingerprintStore::FileFingerprintStore() : dirty(false) {
+}
+
+void FileFingerprintStore::Load(const std::string& store_path) {
+    std::lock_guard<std::mutex> lock(mutex);
+    path = store_path;
+    fingerprints.clear();
+    dirty = false;
+
+    FILE* file = my_fopen(path.c_str(), "rb");
+    if (file == NULL) {
+        return;
+    }
+
+    char magic[4];
+    uint32_t version = 0;
+    uint32_t count = 0;
+    if (fread(magic, sizeof(magic), 1, file) != 1 || memcmp(magic, kFingerprintStoreMagic, sizeof(magic)) != 0 ||
+        fread(&version, sizeof(version), 1, file) != 1 || version != kFingerprintStoreVersion ||
+        fread(&count, sizeof(count), 1, file) != 1) {
+        LOGW << "Ignoring fingerprint store " << path << " with unknown format" << std::endl;
+        fclose(file);
+        return;
+    }
+
+    std::string entry_path;
+    for (uint32_t i = 0; i < count; i++) {
+        uint16_t path_length;
+        FileFingerprint fingerprint;
+        if (fread(&path_length, sizeof(path_length), 1, file) != 1) {
+            break;
+        }
+        entry_path.resize(path_length);
+        if ((path_length > 0 && fread(&entry_path[0], path_length, 1, file) != 1) ||
+            fread(&fingerprint.size, sizeof(fingerprint.size), 1, file) != 1 ||
+            fread(&fingerprint.mtime, sizeof(fingerprint.mtime), 1, file) != 1 ||
+            fread(&fingerprint.inode, sizeof(fingerprint.inode), 1, file) != 1 ||
+            fread(fingerprint.hash.hash, sizeof(fingerprint.hash.hash), 1, file) != 1 ||
+            fread(&fingerprint.checksum, sizeof(fingerprint.checksum), 1, file) != 1) {
+            LOGW << "Fingerprint store " << path << " is truncated" << std::endl;
+            break;
+        }
+        fingerprints[entry_path] = fingerprint;
+    }
+    fclose(file);
+
+    LOGI << "Loaded " << fingerprints.size() << " file fingerprints from " << path << std::endl;
+}
+
+void FileFingerprintStore::Save() {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!dirty || path.empty()) {
+        return;
+    }
+
+    FILE* file = my_fopen(path.c_str(), "wb");
+    if (file == NULL) {
+        LOGE << "Unable to write fingerprint store " << path << std::endl;
+        return;
+    }
+
+    uint32_t count = (uint32_t)fingerprints.size();
+    fwrite(kFingerprintStoreMagic, sizeof(kFingerprintStoreMagic), 1, file);
+    fwrite(&kFingerprintStoreVersion, sizeof(kFingerprintStoreVersion), 1, file);
+    fwrite(&count, sizeof(count), 1, file);
+
+    for (ska::flat_hash_map<std::string, FileFingerprint>::const_iterator it = fingerprints.begin(); it != fingerprints.end(); ++it) {
+        uint16_t path_length = (uint16_t)it->first.size();
+        const FileFingerprint& fingerprint = it->second;
+        fwrite(&path_length, sizeof(path_length), 1, file);
+        fwrite(it->first.c_str(), path_length, 1, file);
+        fwrite(&fingerprint.size, sizeof(fingerprint.size), 1, file);
+        fwrite(&fingerprint.mtime, sizeof(fingerprint.mtime), 1, file);
+        fwrite(&fingerprint.inode, sizeof(fingerprint.inode), 1, file);
+        fwrite(fingerprint.hash.hash, sizeof(fingerprint.hash.hash), 1, file);
+        fwrite(&fingerprint.checksum, sizeof(fingerprint.checksum), 1, file);
+    }
+    fclose(file);
+    dirty = false;
+}
+
+bool FileFingerprintStore::Get(const std::string& abs_path, FileFingerprint* fingerprint) {
+    PROFILER_ZONE(g_profiler_ctx, "FileFingerprintStore::Get");
+    FileFingerprint current;
+    if (!GetFileMetadata(abs_path, &current)) {
+        return false;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        ska::flat_hash_map<std::string, FileFingerprint>::const_iterator it = fingerprints.find(abs_path);
+        if (it != fingerprints.end() && it->second.size == current.size && it->second.mtime == current.mtime && it->second.inode == current.inode) {
+            *fingerprint = it->second;
+            return true;
+        }
+    }
+
+    PROFILER_ZONE(g_profiler_ctx, "Hash file contents");
+    FILE* file = my_fopen(abs_path.c_str(), "rb");
+    if (file == NULL) {
+        return false;
+    }
+
+    MurmurHashStream stream;
+    uint16_t checksum = 0;
+    uint64_t total = 0;
+    // Even sized so the 16 bit sum never straddles two reads.
+    static const size_t kBufferSize = 64 * 1024;
+    unsigned char* buffer = new unsigned char[kBufferSize];
+    size_t read;
+    while ((read = fread(buffer, 1, kBufferSize, file)) > 0) {
+        stream.Update(buffer, read);
+        for (size_t i = 0; i + 1 < read; i += 2) {
+            uint16_t value;
+            memcpy(&value, buffer + i, sizeof(value));
+            checksum += value;
+        }
+        total += read;
+    }
+    delete[] buffer;
+    fclose(file);
+
+    current.checksum = checksum;
+    if (total > 0) {
+        current.hash = stream.Finish();
+    } else {
+        memset(&current.hash, 0, sizeof(current.hash));
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    fingerprints[abs_path] = current;
+    dirty = true;
+    *fingerprint = current;
+    return true;
+}
+
+uint16_t FileFingerprintStore::GetChecksum(const std::string& abs_path) {
+    FileFingerprint fingerprint;
+    if (Get(abs_path, &fingerprint)) {
+        return fingerprint.checksum;
+    }
+    LOGE << "Failed to open file " << abs_path << std::endl;
+    return 0;
+}
+
+MurmurHash FileFingerprintStore::GetHash(const std::string& abs_path) {
+    FileFingerprint fingerprint;
+    if (Get(abs_path, &fingerprint)) {
+        return fingerprint.hash;
+    }
+    MurmurHash hash;
+    memset(&hash, 0, sizeof(hash));
+    return hash;
+}
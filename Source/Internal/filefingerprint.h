@@ -0,0 +1,69 @@
+//-----------------------------------------------------------------------------
+//           Name: filefingerprint.h
+//      Developer: Wolfire Games LLC
+//    Description: Persistent store of file content hashes keyed on file metadata,
+//                 used to validate caches without reading their source files.
+//        License: Read below
+//-----------------------------------------------------------------------------
+//
+//
+//   Copyright 2022 Wolfire Games LLC
+//
+//   Licensed under the Apache License, Version 2.0 (the "License");
+//   you may not use this file except in compliance with the License.
+//   You may obtain a copy of the License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//   Unless required by applicable law or agreed to in writing, software
+//   distributed under the License is distributed on an "AS IS" BASIS,
+//   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//   See the License for the specific language governing permissions and
+//   limitations under the License.
+//
+//-----------------------------------------------------------------------------
+#pragma once
+
+#include <Internal/integer.h>
+#include <Utility/hash.h>
+#include <Utility/flat_hash_map.hpp>
+
+#include <mutex>
+#include <string>
+
+struct FileFingerprint {
+    uint64_t size;
+    int64_t mtime;  // Nanoseconds where the platform has them
+    uint64_t inode;
+    MurmurHash hash;
+    uint16_t checksum;  // Same value as Checksum(), for the cache formats that store it
+};
+
+/*
+ * A file is only read when its size, modification time or inode differ
+ * from what was recorded, at which point both hashes are recomputed in a
+ * single streaming pass. The store is kept in the write dir between runs,
+ * so a warm start never reads source assets just to validate their caches.
+ */
+class FileFingerprintStore {
+   public:
+    static FileFingerprintStore& Instance();
+
+    FileFingerprintStore();
+
+    void Load(const std::string& store_path);
+    // Writes the store back to where it was loaded from, if anything changed.
+    void Save();
+
+    // Returns false if the file can't be opened.
+    bool Get(const std::string& abs_path, FileFingerprint* fingerprint);
+    // Drop in replacements for Checksum() and GetFileHash(), zero for missing files.
+    uint16_t GetChecksum(const std::string& abs_path);
+    MurmurHash GetHash(const std::string& abs_path);
+
+   private:
+    std::mutex mutex;
+    std::string path;
+    bool dirty;
+    ska::flat_hash_map<std::string, FileFingerprint> fingerprints;
+};
@@ -23,14 +23,16 @@
 
 #include <Internal/modloading.h>
 #include <Internal/profiler.h>
-#include <Internal/checksum.h>
+#include <Internal/filefingerprint.h>
 #include <Internal/datemodified.h>
 #include <Internal/filesystem.h>
 #include <Internal/common.h>
 #include <Internal/error.h>
+#include <Internal/vfsindex.h>
 
 #include <Utility/assert.h>
 #include <Utility/strings.h>
+#include <Utility/flat_hash_map.hpp>
 
 #include <Compat/fileio.h>
 #include <Compat/compat.h>
@@ -46,6 +48,8 @@
 #include <set>
 #include <algorithm>
 #include <cerrno>
+#include <atomic>
+#include <mutex>
 
 using std::endl;
 using std::ifstream;
@@ -66,6 +70,66 @@ Paths mod_paths;
 char write_path[kPathSize];
 static bool write_path_set = false;
 
+// Resolved FindImagePath results by requested path, including failures. An entry is reused while
+// its generation is current and the newest source and converted file it chose between are unchanged.
+struct ImagePathCacheEntry {
+    PathFlagsBitfield flags;
+    bool allow_crn;
+    bool allow_dds;
+    uint32_t generation;
+    int result;
+    string resolved;
+    PathFlags resulting_path;
+    ModID modsource;
+    string orig_path;
+    int64_t orig_modified;
+    string converted_path;
+    int64_t converted_modified;
+};
+typedef std::vector<ImagePathCacheEntry> ImagePathCacheEntries;
+
+static std::atomic<uint32_t> image_path_generation(0);
+static std::mutex image_path_cache_mutex;
+static ska::flat_hash_map<string, ImagePathCacheEntries> image_path_cache;
+
+void InvalidateImagePathCache() {
+    image_path_generation++;
+}
+
+void InvalidateImagePathCache(const char* abs_path) {
+    // Writing a converted file affects lookups of the image it was converted from.
+    string image_path = abs_path;
+    const char* converted_suffixes[] = {"_converted.dds", "_converted.crn"};
+    for (int i = 0; i < 2; i++) {
+        if (endswith(image_path.c_str(), converted_suffixes[i])) {
+            image_path.resize(image_path.size() - strlen(converted_suffixes[i]));
+            break;
+        }
+    }
+
+    // Cached lookups are by relative path, so drop every trailing part of the path.
+    std::lock_guard<std::mutex> lock(image_path_cache_mutex);
+    if (image_path_cache.empty()) {
+        return;
+    }
+    image_path_cache.erase(image_path);
+    for (size_t i = 0; i < image_path.size(); i++) {
+        if (image_path[i] == '/' || image_path[i] == '\\') {
+            image_path_cache.erase(image_path.substr(i + 1));
+        }
+    }
+}
+
+void NotifyFileWritten(const char* abs_path) {
+    InvalidateImagePathCache(abs_path);
+    VFSIndex::Instance().AddFile(abs_path);
+}
+
+void NotifyFileRemoved(const char* abs_path) {
+    InvalidateImagePathCache(abs_path);
+    VFSIndex::Instance().RemoveFile(abs_path);
+}
+
 Paths::Paths() : num_paths(0) {
 }
 
@@ -75,7 +139,9 @@ int Paths::AddPath(const char* path) {
     if (num_paths < kMaxPaths) {
         FormatString(paths[num_paths], kPathSize, "%s", withTrailing.c_str());
         mod_path_ids[num_paths] = CoreGameModID;
+        vfs_roots[num_paths] = VFSIndex::Instance().AddRoot(paths[num_paths]);
         ++num_paths;
+        InvalidateImagePathCache();
         return num_paths - 1;
     } else {
         LOGE << "All preallocated filesystem paths are utilized, this isn't intended to occur, contact developer." << endl;
@@ -110,9 +176,11 @@ void Paths::RemovePath(const char* path) {
         if (push_down) {
             memcpy(paths[i - 1], paths[i], kPathSize);
             mod_path_ids[i - 1] = mod_path_ids[i];
+            vfs_roots[i - 1] = vfs_roots[i];
         }
 
-        if (strcmp(withTrailing.c_str(), paths[i]) == 0) {
+        if (!push_down && strcmp(withTrailing.c_str(), paths[i]) == 0) {
+            VFSIndex::Instance().RemoveRoot(vfs_roots[i]);
             push_down = true;
         }
     }
@@ -120,6 +188,7 @@ void Paths::RemovePath(const char* path) {
     // If we found and removed a path by pushing down all after it, we count down.
     if (push_down) {
         num_paths--;
+        InvalidateImagePathCache();
     }
 }
 
@@ -162,7 +231,7 @@ const int overgrowth_dds_cache_version = 1;
 // The case for looking for both the normal image and the converted became so common I felt the need for this simplification.
 
 // Currently ignoring the modsource, should set it to the correct source if it's not null TODO
-int FindImagePath(const char* path, char* buf, int buf_size, PathFlagsBitfield flags, bool is_necessary, PathFlags* resulting_path, bool allow_crn, bool allow_dds, ModID* modsource) {
+static int FindImagePathUncached(const char* path, char* buf, int buf_size, PathFlagsBitfield flags, PathFlags* resulting_path, bool allow_crn, bool allow_dds, ModID* modsource, ImagePathCacheEntry* sources) {
     const char* fallback = "Data/Textures/error.tga";
     // We might want a converted image, let's assume it's priority for reasons like performance
     string dds_converted = string(path) + "_converted.dds";
@@ -203,6 +272,14 @@ int FindImagePath(const char* path, char* buf, int buf_size, PathFlagsBitfield f
             latest_orig_id = i;
         }
     }
+    if (latest_dds_id != -1) {
+        sources->converted_path = &dds_paths[latest_dds_id * kPathSize];
+        sources->converted_modified = latest_dds_modified;
+    }
+    if (latest_orig_id != -1) {
+        sources->orig_path = &orig_paths[latest_orig_id * kPathSize];
+        sources->orig_modified = latest_orig_modified;
+    }
 
     if (latest_orig_modified > latest_dds_modified && num_orig_paths_found > 0) {
         FormatString(buf, buf_size, "%s", &orig_paths[latest_orig_id * kPathSize]);
@@ -213,7 +290,7 @@ int FindImagePath(const char* path, char* buf, int buf_size, PathFlagsBitfield f
             *modsource = orig_modsources[latest_orig_id];
         }
         if (num_dds_paths_found > 0) {
-            unsigned short checksum = Checksum(&orig_paths[latest_orig_id * kPathSize]);
+            unsigned short checksum = FileFingerprintStore::Instance().GetChecksum(&orig_paths[latest_orig_id * kPathSize]);
             FILE* file = my_fopen(&dds_paths[latest_dds_id * kPathSize], "rb");
             if (file) {
                 int intro_len = strlen(overgrowth_dds_cache_intro);
@@ -271,8 +348,122 @@ int FindImagePath(const char* path, char* buf, int buf_size, PathFlagsBitfield f
     }
 }
 
+int FindImagePath(const char* path, char* buf, int buf_size, PathFlagsBitfield flags, bool is_necessary, PathFlags* resulting_path, bool allow_crn, bool allow_dds, ModID* modsource) {
+    PROFILER_ZONE(g_profiler_ctx, "FindImagePath");
+    // Read before resolving, so a change that happens while resolving leaves the entry stale.
+    uint32_t generation = image_path_generation;
+    ImagePathCacheEntry entry;
+    bool cached = false;
+    {
+        std::lock_guard<std::mutex> lock(image_path_cache_mutex);
+        ska::flat_hash_map<string, ImagePathCacheEntries>::iterator it = image_path_cache.find(path);
+        if (it != image_path_cache.end()) {
+            for (size_t i = 0; i < it->second.size(); i++) {
+                const ImagePathCacheEntry& candidate = it->second[i];
+                if (candidate.flags == flags && candidate.allow_crn == allow_crn && candidate.allow_dds == allow_dds && candidate.generation == generation) {
+                    entry = candidate;
+                    cached = true;
+                    break;
+                }
+            }
+        }
+    }
+
+    // Files edited outside the game, such as a re-exported source image, only show up in the modification time.
+    if (cached && ((!entry.orig_path.empty() && GetDateModifiedInt64(entry.orig_path.c_str()) != entry.orig_modified) ||
+                   (!entry.converted_path.empty() && GetDateModifiedInt64(entry.converted_path.c_str()) != entry.converted_modified))) {
+        cached = false;
+    }
+
+    if (!cached) {
+        entry = ImagePathCacheEntry();
+        entry.flags = flags;
+        entry.allow_crn = allow_crn;
+        entry.allow_dds = allow_dds;
+        entry.generation = generation;
+        entry.resulting_path = kNoPath;
+        entry.modsource = CoreGameModID;
+        entry.orig_modified = -1;
+        entry.converted_modified = -1;
+        char resolved[kPathSize];
+        entry.result = FindImagePathUncached(path, resolved, kPathSize, flags, &entry.resulting_path, allow_crn, allow_dds, &entry.modsource, &entry);
+        if (entry.result == 0) {
+            entry.resolved = resolved;
+        }
+
+        std::lock_guard<std::mutex> lock(image_path_cache_mutex);
+        ImagePathCacheEntries& entries = image_path_cache[path];
+        size_t i = 0;
+        while (i < entries.size() && !(entries[i].flags == flags && entries[i].allow_crn == allow_crn && entries[i].allow_dds == allow_dds)) {
+            i++;
+        }
+        if (i == entries.size()) {
+            entries.push_back(entry);
+        } else {
+            entries[i] = entry;
+        }
+    }
+
+    if (entry.result == 0) {
+        FormatString(buf, buf_size, "%s", entry.resolved.c_str());
+        if (resulting_path) {
+            *resulting_path = entry.resulting_path;
+        }
+        if (modsource) {
+            *modsource = entry.modsource;
+        }
+    }
+    return entry.result;
+}
+
+// Looks the path up in the file index of the mod and data paths, filling in at most num_bufs results in priority order.
+// Clears the flags of the locations the index fully answered for, leaving only those still to be checked on the filesystem.
+static int FindIndexedFilePaths(const char* path, char* bufs, int buf_size, int num_bufs, PathFlagsBitfield* flags, PathFlags* resulting_paths, ModID* sourceids) {
+    int found_roots[Paths::kMaxPaths];
+    int num_mod_found = 0;
+    int num_data_found = 0;
+    if (*flags & kModPaths) {
+        num_mod_found = VFSIndex::Instance().Find(path, mod_paths.vfs_roots, mod_paths.num_paths, bufs, buf_size, num_bufs, found_roots);
+        for (int i = 0; i < num_mod_found; i++) {
+            if (resulting_paths) {
+                resulting_paths[i] = kModPaths;
+            }
+            if (sourceids) {
+                sourceids[i] = mod_paths.mod_path_ids[found_roots[i]];
+            }
+        }
+    }
+    if (*flags & kDataPaths) {
+        num_data_found = VFSIndex::Instance().Find(path, vanilla_data_paths.vfs_roots, vanilla_data_paths.num_paths, &bufs[num_mod_found * buf_size], buf_size, num_bufs - num_mod_found, found_roots);
+        for (int i = 0; i < num_data_found; i++) {
+            if (resulting_paths) {
+                resulting_paths[num_mod_found + i] = kDataPaths;
+            }
+            if (sourceids) {
+                sourceids[num_mod_found + i] = vanilla_data_paths.mod_path_ids[found_roots[i]];
+            }
+        }
+    }
+
+    if (num_mod_found + num_data_found > 0) {
+        *flags &= ~(kModPaths | kDataPaths);
+    } else {
+        // A miss is only final where the index watches for files created outside the game.
+        if (VFSIndex::Instance().IsAuthoritative(path, mod_paths.vfs_roots, mod_paths.num_paths)) {
+            *flags &= ~kModPaths;
+        }
+        if (VFSIndex::Instance().IsAuthoritative(path, vanilla_data_paths.vfs_roots, vanilla_data_paths.num_paths)) {
+            *flags &= ~kDataPaths;
+        }
+    }
+    return num_mod_found + num_data_found;
+}
+
 int FindFilePath(const char* path, char* buf, int buf_size, PathFlagsBitfield flags, bool is_necessary, PathFlags* resulting_path, ModID* modsource) {
     PROFILER_ZONE(g_profiler_ctx, "FindFilePath");
+    if (FindIndexedFilePaths(path, buf, buf_size, 1, &flags, resulting_path, modsource) > 0) {
+        return 0;
+    }
     if (flags & kModPaths) {
         for (int i = 0; i < mod_paths.num_paths; ++i) {
             AssemblePath(mod_paths.paths[i], path, buf, buf_size);
@@ -365,8 +556,11 @@ int FindFilePath(const char* path, char* buf, int buf_size, PathFlagsBitfield fl
 }
 
 int FindFilePaths(const char* path, char* bufs, int buf_size, int num_bufs, PathFlagsBitfield flags, bool is_necessary, PathFlags* resulting_paths, ModID* sourceids) {
-    int num_paths_found = 0;
-    char* buf = bufs;
+    int num_paths_found = FindIndexedFilePaths(path, bufs, buf_size, num_bufs, &flags, resulting_paths, sourceids);
+    char* buf = bufs + num_paths_found * buf_size;
+    if (num_paths_found >= num_bufs) {
+        return num_paths_found;
+    }
     if (flags & kModPaths) {
         for (int i = 0; i < mod_paths.num_paths; ++i) {
             AssemblePath(mod_paths.paths[i], path, buf, buf_size);
@@ -481,6 +675,7 @@ void AddPath(const char* path, PathFlags type) {
             LOGI << "Adding write path " << withTrailing << endl;
             FormatString(write_path, kPathSize, "%s", withTrailing.c_str());
             write_path_set = true;
+            InvalidateImagePathCache();
             break;
         case kModWriteDirs:
             LOGI << "It's invalid to add specific write dir for mods, it's relative to main write path."
@@ -847,22 +1042,28 @@ int CheckWritePermissions(const char* dir) {
 }
 
 int copyfile(const string& source, const string& dest) {
+    NotifyFileWritten(dest.c_str());
     return os_copyfile(source.c_str(), dest.c_str());
 }
 
 int copyfile(const char* source, const char* dest) {
+    NotifyFileWritten(dest);
     return os_copyfile(source, dest);
 }
 
 int movefile(const char* source, const char* dest) {
+    NotifyFileRemoved(source);
+    NotifyFileWritten(dest);
     return os_movefile(source, dest);
 }
 
 int deletefile(const char* filename) {
+    NotifyFileRemoved(filename);
     return os_deletefile(filename);
 }
 
 int createfile(const char* filename) {
+    NotifyFileWritten(filename);
     return os_createfile(filename);
 }
 
@@ -36,6 +36,7 @@ struct Paths {
     static const int kMaxPaths = 256;
     char paths[kMaxPaths][kPathSize];
     ModID mod_path_ids[kMaxPaths];
+    int vfs_roots[kMaxPaths];
     int num_paths;
     int AddPath(const char* path);
     bool AddModPath(const char* path, ModID modid);
@@ -51,6 +52,13 @@ Path FindFilePath(const char* path, PathFlagsBitfield flags = kAnyPath, bool is_
 int FindImagePath(const char* path, char* buf, int buf_size, PathFlagsBitfield flags, bool is_necessary = true, PathFlags* resulting_path = NULL, bool allow_crn = true, bool allow_dds = true, ModID* modsource = NULL);
 int FindFilePath(const char* path, char* buf, int buf_size, PathFlagsBitfield flags, bool is_necessary = true, PathFlags* resulting_path = NULL, ModID* modsource = NULL);
 int FindFilePaths(const char* path, char* bufs, int buf_size, int num_bufs, PathFlagsBitfield flags, bool is_necessary, PathFlags* resulting_paths, ModID* modsourceids);
+// Forgets all resolved FindImagePath results. Called whenever the search paths change.
+void InvalidateImagePathCache();
+// Forgets resolved FindImagePath results that a write to this absolute path could change.
+void InvalidateImagePathCache(const char* abs_path);
+// Keeps the path lookup caches in step with files created, written or deleted at an absolute path.
+void NotifyFileWritten(const char* abs_path);
+void NotifyFileRemoved(const char* abs_path);
 void AddPath(const char* path, PathFlags type);
 bool AddModPath(const char* path, ModID modid);
 void RemovePath(const char* path, PathFlags type);
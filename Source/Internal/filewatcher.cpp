@@ -0,0 +1,285 @@
+//-----------------------------------------------------------------------------
+//           Name: filewatcher.cpp
+//      Developer: Wolfire Games LLC
+//    Description:
+//        License: Read below
+//-----------------------------------------------------------------------------
+//
+//
+//   Copyright 2022 Wolfire Games LLC
+//
+//   Licensed under the Apache License, Version 2.0 (the "License");
+//   you may not use this file except in compliance with the License.
+//   You may obtain a copy of the License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//   Unless required by applicable law or agreed to in writing, software
+//   distributed under the License is distributed on an "AS IS" BASIS,
+//   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//   See the License for the specific language governing permissions and
+//   limitations under the License.
+//
+//-----------------------------------------------------------------------------
+#include "filewatcher.h"
+
+#include <Compat/platform.h>
+#include <Logging/logdata.h>
+
+#if PLATFORM_LINUX
+#include <sys/inotify.h>
+#include <unistd.h>
+#include <errno.h>
+#include <cstring>
+#endif
+
+const int FileWatcher::kInvalidWatch;
+
+FileWatcher::FileWatcher() : inotify_fd(-1), directory_changes_lost(false) {
+}
+
+FileWatcher::~FileWatcher() {
+    Dispose();
+}
+
+bool FileWatcher::Initialize() {
+#if PLATFORM_LINUX
+    std::lock_guard<std::mutex> lock(mutex);
+    if (inotify_fd == -1) {
+        inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        if (inotify_fd == -1) {
+            LOGW << "Unable to initialize inotify, falling back to polling for file changes: " << strerror(errno) << std::endl;
+        }
+    }
+#endif
+    return inotify_fd != -1;
+}
+
+void FileWatcher::Dispose() {
+    std::lock_guard<std::mutex> lock(mutex);
+#if PLATFORM_LINUX
+    if (inotify_fd != -1) {
+        // Closing the descriptor releases all watches on it.
+        close(inotify_fd);
+        inotify_fd = -1;
+    }
+#endif
+    files.clear();
+    free_files.clear();
+    file_ids.clear();
+    directories.clear();
+    pending_files.clear();
+    pending_directory_changes.clear();
+    directory_changes_lost = false;
+}
+
+bool FileWatcher::IsActive() const {
+    return inotify_fd != -1;
+}
+
+int FileWatcher::Watch(const std::string& full_path) {
+#if PLATFORM_LINUX
+    std::lock_guard<std::mutex> lock(mutex);
+    if (inotify_fd == -1) {
+        return kInvalidWatch;
+    }
+
+    ska::flat_hash_map<std::string, int>::iterator file_it = file_ids.find(full_path);
+    if (file_it != file_ids.end()) {
+        files[file_it->second].ref_count++;
+        return file_it->second;
+    }
+
+    size_t slash = full_path.find_last_of('/');
+    if (slash == std::string::npos) {
+        return kInvalidWatch;
+    }
+    std::string directory_path = full_path.substr(0, slash);
+    std::string file_name = full_path.substr(slash + 1);
+
+    // inotify hands back the same descriptor when a directory is already watched,
+    // IN_MASK_ADD keeps the events a directory watch asked for.
+    int directory = inotify_add_watch(inotify_fd, directory_path.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE | IN_MASK_ADD);
+    if (directory == -1) {
+        LOGW << "Unable to watch " << directory_path << " for changes: " << strerror(errno) << std::endl;
+        return kInvalidWatch;
+    }
+
+    int watch_id;
+    if (free_files.empty()) {
+        watch_id = (int)files.size();
+        files.resize(files.size() + 1);
+    } else {
+        watch_id = free_files.back();
+        free_files.pop_back();
+    }
+
+    WatchedFile& file = files[watch_id];
+    file.full_path = full_path;
+    file.directory = directory;
+    file.ref_count = 1;
+    file_ids[full_path] = watch_id;
+
+    WatchedDirectory& watched_directory = directories[directory];
+    watched_directory.ref_count++;
+    watched_directory.files[file_name] = watch_id;
+
+    return watch_id;
+#else
+    return kInvalidWatch;
+#endif
+}
+
+void FileWatcher::Unwatch(int watch_id) {
+#if PLATFORM_LINUX
+    std::lock_guard<std::mutex> lock(mutex);
+    if (watch_id < 0 || watch_id >= (int)files.size() || files[watch_id].ref_count <= 0) {
+        return;
+    }
+
+    WatchedFile& file = files[watch_id];
+    file.ref_count--;
+    if (file.ref_count > 0) {
+        return;
+    }
+
+    ska::flat_hash_map<int, WatchedDirectory>::iterator directory_it = directories.find(file.directory);
+    if (directory_it != directories.end()) {
+        directory_it->second.files.erase(file.full_path.substr(file.full_path.find_last_of('/') + 1));
+        ReleaseDirectory(file.directory);
+    }
+
+    file_ids.erase(file.full_path);
+    file.full_path.clear();
+    free_files.push_back(watch_id);
+#endif
+}
+
+void FileWatcher::GetChangedFiles(std::vector<int>& watch_ids) {
+    std::lock_guard<std::mutex> lock(mutex);
+    ReadEvents();
+    watch_ids.insert(watch_ids.end(), pending_files.begin(), pending_files.end());
+    pending_files.clear();
+}
+
+int FileWatcher::WatchDirectory(const std::string& directory_path) {
+#if PLATFORM_LINUX
+    std::lock_guard<std::mutex> lock(mutex);
+    if (inotify_fd == -1) {
+        return kInvalidWatch;
+    }
+
+    int directory = inotify_add_watch(inotify_fd, directory_path.c_str(), IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | IN_ONLYDIR | IN_MASK_ADD);
+    if (directory == -1) {
+        LOGW << "Unable to watch " << directory_path << " for changes: " << strerror(errno) << std::endl;
+        return kInvalidWatch;
+    }
+
+    WatchedDirectory& watched_directory = directories[directory];
+    if (!watched_directory.entries_watched) {
+        watched_directory.entries_watched = true;
+        watched_directory.ref_count++;
+    }
+    return directory;
+#else
+    return kInvalidWatch;
+#endif
+}
+
+void FileWatcher::UnwatchDirectory(int watch_id) {
+    std::lock_guard<std::mutex> lock(mutex);
+    ska::flat_hash_map<int, WatchedDirectory>::iterator directory_it = directories.find(watch_id);
+    if (directory_it != directories.end() && directory_it->second.entries_watched) {
+        directory_it->second.entries_watched = false;
+        ReleaseDirectory(watch_id);
+    }
+}
+
+bool FileWatcher::GetDirectoryChanges(std::vector<DirectoryChange>& changes) {
+    std::lock_guard<std::mutex> lock(mutex);
+    ReadEvents();
+    changes.insert(changes.end(), pending_directory_changes.begin(), pending_directory_changes.end());
+    pending_directory_changes.clear();
+
+    bool complete = !directory_changes_lost;
+    directory_changes_lost = false;
+    return complete;
+}
+
+void FileWatcher::ReleaseDirectory(int directory) {
+    ska::flat_hash_map<int, WatchedDirectory>::iterator directory_it = directories.find(directory);
+    if (directory_it == directories.end()) {
+        return;
+    }
+    directory_it->second.ref_count--;
+    if (directory_it->second.ref_count <= 0) {
+#if PLATFORM_LINUX
+        if (inotify_fd != -1) {
+            inotify_rm_watch(inotify_fd, directory);
+        }
+#endif
+        directories.erase(directory_it);
+    }
+}
+
+void FileWatcher::ReadEvents() {
+#if PLATFORM_LINUX
+    if (inotify_fd == -1) {
+        return;
+    }
+
+    char buffer[16 * 1024] __attribute__((aligned(__alignof__(struct inotify_event))));
+    while (true) {
+        ssize_t length = read(inotify_fd, buffer, sizeof(buffer));
+        if (length <= 0) {
+            // EAGAIN once the queue is drained.
+            break;
+        }
+
+        for (char* ptr = buffer; ptr < buffer + length;) {
+            const struct inotify_event* event = (const struct inotify_event*)ptr;
+            ptr += sizeof(struct inotify_event) + event->len;
+
+            if (event->mask & IN_Q_OVERFLOW) {
+                LOGW << "File watch queue overflowed, treating all watched files as changed" << std::endl;
+                for (size_t i = 0; i < files.size(); i++) {
+                    if (files[i].ref_count > 0) {
+                        pending_files.push_back((int)i);
+                    }
+                }
+                directory_changes_lost = true;
+                continue;
+            }
+
+            ska::flat_hash_map<int, WatchedDirectory>::iterator directory_it = directories.find(event->wd);
+            if (directory_it == directories.end()) {
+                continue;
+            }
+            if (event->mask & IN_IGNORED) {
+                // The directory itself is gone, the kernel has dropped the watch.
+                directories.erase(directory_it);
+                continue;
+            }
+            if (event->len == 0) {
+                continue;
+            }
+
+            WatchedDirectory& watched_directory = directory_it->second;
+            if (event->mask & (IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE)) {
+                ska::flat_hash_map<std::string, int>::iterator file_it = watched_directory.files.find(event->name);
+                if (file_it != watched_directory.files.end()) {
+                    pending_files.push_back(file_it->second);
+                }
+            }
+            if (watched_directory.entries_watched && (event->mask & (IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO))) {
+                DirectoryChange change;
+                change.watch_id = event->wd;
+                change.name = event->name;
+                change.is_directory = (event->mask & IN_ISDIR) != 0;
+                change.removed = (event->mask & (IN_DELETE | IN_MOVED_FROM)) != 0;
+                pending_directory_changes.push_back(change);
+            }
+        }
+    }
+#endif
+}
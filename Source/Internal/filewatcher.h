@@ -0,0 +1,105 @@
+//-----------------------------------------------------------------------------
+//           Name: filewatcher.h
+//      Developer: Wolfire Games LLC
+//    Description: Reports changes to a set of watched files, backed by inotify
+//                 on Linux.
+//        License: Read below
+//-----------------------------------------------------------------------------
+//
+//
+//   Copyright 2022 Wolfire Games LLC
+//
+//   Licensed under the Apache License, Version 2.0 (the "License");
+//   you may not use this file except in compliance with the License.
+//   You may obtain a copy of the License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//   Unless required by applicable law or agreed to in writing, software
+//   distributed under the License is distributed on an "AS IS" BASIS,
+//   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//   See the License for the specific language governing permissions and
+//   limitations under the License.
+//
+//-----------------------------------------------------------------------------
+#pragma once
+
+#include <Utility/flat_hash_map.hpp>
+
+#include <mutex>
+#include <string>
+#include <vector>
+
+/*
+ * Files are watched through their parent directory, editors tend to save by
+ * writing a temporary file and renaming it over the original, which a watch
+ * on the file itself would lose track of. Directories can also be watched for
+ * entries being created, deleted or renamed in them, which is how the file index
+ * keeps up with changes made outside the game. On platforms without inotify
+ * IsActive() returns false and callers should fall back to polling modification dates.
+ */
+class FileWatcher {
+   public:
+    static const int kInvalidWatch = -1;
+
+    struct DirectoryChange {
+        int watch_id;      // As returned by WatchDirectory()
+        std::string name;  // Entry inside the watched directory
+        bool is_directory;
+        bool removed;  // Deleted or renamed away, otherwise created or renamed into place
+    };
+
+    FileWatcher();
+    ~FileWatcher();
+
+    bool Initialize();
+    void Dispose();
+    bool IsActive() const;
+
+    // Takes an absolute path. Watches are reference counted per path,
+    // returns an id to pass to Unwatch(), or kInvalidWatch on failure.
+    int Watch(const std::string& full_path);
+    void Unwatch(int watch_id);
+
+    // Reads pending events and appends the ids of watched files that changed since the last call.
+    void GetChangedFiles(std::vector<int>& watch_ids);
+
+    // Takes an absolute path, does not recurse into subdirectories. Directory
+    // watch ids are separate from file watch ids, returns kInvalidWatch on failure.
+    int WatchDirectory(const std::string& directory_path);
+    void UnwatchDirectory(int watch_id);
+
+    // Reads pending events and appends the changes to watched directories since the last call.
+    // Returns false if events were lost and the directories have to be scanned again.
+    bool GetDirectoryChanges(std::vector<DirectoryChange>& changes);
+
+   private:
+    struct WatchedFile {
+        std::string full_path;
+        int directory;
+        int ref_count;
+    };
+
+    struct WatchedDirectory {
+        WatchedDirectory() : ref_count(0), entries_watched(false) {}
+
+        int ref_count;
+        bool entries_watched;  // Through WatchDirectory()
+        ska::flat_hash_map<std::string, int> files;
+    };
+
+    // Expects the mutex to be held. Events are read for both kinds of watches at
+    // once, and queued until they're asked for.
+    void ReadEvents();
+    void ReleaseDirectory(int directory);
+
+    std::mutex mutex;
+    int inotify_fd;
+    std::vector<WatchedFile> files;
+    std::vector<int> free_files;
+    ska::flat_hash_map<std::string, int> file_ids;
+    ska::flat_hash_map<int, WatchedDirectory> directories;
+    std::vector<int> pending_files;
+    std::vector<DirectoryChange> pending_directory_changes;
+    bool directory_changes_lost;
+};
@@ -0,0 +1,410 @@
+//-----------------------------------------------------------------------------
+//           Name: vfsindex.cpp
+//      Developer: Wolfire Games LLC
+//    Description:
+//        License: Read below
+//-----------------------------------------------------------------------------
+//
+//
+//   Copyright 2022 Wolfire Games LLC
+//
+//   Licensed under the Apache License, Version 2.0 (the "License");
+//   you may not use this file except in compliance with the License.
+//   You may obtain a copy of the License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//   Unless required by applicable law or agreed to in writing, software
+//   distributed under the License is distributed on an "AS IS" BASIS,
+//   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//   See the License for the specific language governing permissions and
+//   limitations under the License.
+//
+//-----------------------------------------------------------------------------
+#include "vfsindex.h"
+
+#include <Internal/common.h>
+#include <Internal/filesystem.h>
+#include <Compat/compat.h>
+#include <Logging/logdata.h>
+
+#include <chrono>
+#include <cstring>
+#include <cctype>
+
+const int VFSIndex::kInvalidRoot;
+
+VFSIndex& VFSIndex::Instance() {
+    static VFSIndex instance;
+    return instance;
+}
+
+VFSIndex::VFSIndex() : enabled(true) {
+    watcher.Initialize();
+    ResetStats();
+}
+
+bool VFSIndex::MakeKey(const char* path, char* key, int key_size) {
+    if (path[0] == '\0' || path[0] == '/' || path[0] == '.') {
+        return false;
+    }
+
+    int i = 0;
+    for (; path[i] != '\0'; i++) {
+        if (i + 1 >= key_size) {
+            return false;
+        }
+        char c = path[i];
+        if (c == '\\' || c == ':') {
+            return false;
+        }
+        if (c == '/' && (path[i + 1] == '/' || path[i + 1] == '.')) {
+            // Leave "//", "/./" and "/../" to the filesystem.
+            return false;
+        }
+        key[i] = (char)tolower((unsigned char)c);
+    }
+    key[i] = '\0';
+    return true;
+}
+
+int VFSIndex::AddRoot(const char* root_path) {
+    // Not using PrecisionStopwatch, the filesystem code is also built into tools without SDL.
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    std::string path = AssemblePath(std::string(root_path), std::string());
+    int root = kInvalidRoot;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (size_t i = 0; i < roots.size(); i++) {
+            if (!roots[i].in_use) {
+                root = (int)i;
+                break;
+            }
+        }
+        if (root == kInvalidRoot) {
+            root = (int)roots.size();
+            roots.resize(roots.size() + 1);
+        }
+        roots[root].path = path;
+        roots[root].in_use = true;
+        roots[root].watched = watcher.IsActive();
+    }
+
+    size_t num_files = AddDirectory(root, std::string());
+
+    LOGI << "Indexed " << num_files << " files under " << path << " in " << std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count() << "ms" << std::endl;
+    return root;
+}
+
+void VFSIndex::RemoveRoot(int root) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (root < 0 || root >= (int)roots.size() || !roots[root].in_use) {
+        return;
+    }
+
+    DropDirectory(root, std::string());
+    roots[root].path.clear();
+    roots[root].in_use = false;
+    roots[root].watched = false;
+}
+
+size_t VFSIndex::AddDirectory(int root, const std::string& rel_dir) {
+    std::string abs_dir;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!roots[root].in_use) {
+            return 0;
+        }
+        abs_dir = roots[root].path + rel_dir;
+    }
+
+    // Watching before scanning, so nothing created in between is missed.
+    std::vector<std::pair<int, std::string> > watches;
+    bool watched = watcher.IsActive() && WatchTree(abs_dir, rel_dir, watches);
+    std::vector<std::string> manifest;
+    GenerateManifest(abs_dir.c_str(), manifest);
+
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!roots[root].in_use || roots[root].path + rel_dir != abs_dir) {
+        // Removed while it was being scanned.
+        for (size_t i = 0; i < watches.size(); i++) {
+            watcher.UnwatchDirectory(watches[i].first);
+        }
+        return 0;
+    }
+    for (size_t i = 0; i < watches.size(); i++) {
+        WatchedDirectory& watched_directory = watched_directories[watches[i].first];
+        watched_directory.root = root;
+        watched_directory.rel_path = watches[i].second;
+    }
+    if (!watched) {
+        roots[root].watched = false;
+    }
+
+    char key[kPathSize];
+    std::string rel_path;
+    for (size_t i = 0; i < manifest.size(); i++) {
+        rel_path = rel_dir + manifest[i];
+        if (MakeKey(rel_path.c_str(), key, kPathSize)) {
+            AddEntry(root, key, rel_path);
+        }
+    }
+    return manifest.size();
+}
+
+bool VFSIndex::WatchTree(const std::string& abs_dir, const std::string& rel_dir, std::vector<std::pair<int, std::string> >& watches) {
+    int watch_id = watcher.WatchDirectory(abs_dir);
+    if (watch_id == FileWatcher::kInvalidWatch) {
+        return false;
+    }
+    watches.push_back(std::make_pair(watch_id, rel_dir));
+
+    std::vector<std::string> subdirectories;
+    getSubdirectories(abs_dir.c_str(), subdirectories);
+    for (size_t i = 0; i < subdirectories.size(); i++) {
+        std::string name = subdirectories[i].substr(abs_dir.size());
+        if (!WatchTree(subdirectories[i] + "/", rel_dir + name + "/", watches)) {
+            // Most likely out of watches, no point trying the rest.
+            return false;
+        }
+    }
+    return true;
+}
+
+void VFSIndex::DropDirectory(int root, const std::string& rel_dir) {
+    ska::flat_hash_map<std::string, std::vector<Entry> >::iterator it = files.begin();
+    while (it != files.end()) {
+        std::vector<Entry>& entries = it->second;
+        for (size_t i = 0; i < entries.size();) {
+            if (entries[i].root == root && entries[i].rel_path.compare(0, rel_dir.size(), rel_dir) == 0) {
+                entries.erase(entries.begin() + i);
+            } else {
+                i++;
+            }
+        }
+
+        if (entries.empty()) {
+            it = files.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    ska::flat_hash_map<int, WatchedDirectory>::iterator watch_it = watched_directories.begin();
+    while (watch_it != watched_directories.end()) {
+        if (watch_it->second.root == root && watch_it->second.rel_path.compare(0, rel_dir.size(), rel_dir) == 0) {
+            watcher.UnwatchDirectory(watch_it->first);
+            watch_it = watched_directories.erase(watch_it);
+        } else {
+            ++watch_it;
+        }
+    }
+}
+
+void VFSIndex::AddFile(const char* abs_path) {
+    char key[kPathSize];
+    std::lock_guard<std::mutex> lock(mutex);
+    for (size_t i = 0; i < roots.size(); i++) {
+        const Root& root = roots[i];
+        if (!root.in_use || strncmp(abs_path, root.path.c_str(), root.path.size()) != 0) {
+            continue;
+        }
+        const char* rel_path = abs_path + root.path.size();
+        if (MakeKey(rel_path, key, kPathSize)) {
+            AddEntry((int)i, key, rel_path);
+        }
+    }
+}
+
+void VFSIndex::RemoveFile(const char* abs_path) {
+    char key[kPathSize];
+    std::lock_guard<std::mutex> lock(mutex);
+    for (size_t i = 0; i < roots.size(); i++) {
+        const Root& root = roots[i];
+        if (!root.in_use || strncmp(abs_path, root.path.c_str(), root.path.size()) != 0) {
+            continue;
+        }
+        const char* rel_path = abs_path + root.path.size();
+        if (MakeKey(rel_path, key, kPathSize)) {
+            RemoveEntry((int)i, key, rel_path);
+        }
+    }
+}
+
+void VFSIndex::AddEntry(int root, const char* key, const std::string& rel_path) {
+    std::vector<Entry>& entries = files[key];
+    for (size_t i = 0; i < entries.size(); i++) {
+        if (entries[i].root == root && entries[i].rel_path == rel_path) {
+            return;
+        }
+    }
+    Entry entry;
+    entry.root = root;
+    entry.rel_path = rel_path;
+    entries.push_back(entry);
+}
+
+void VFSIndex::RemoveEntry(int root, const char* key, const std::string& rel_path) {
+    ska::flat_hash_map<std::string, std::vector<Entry> >::iterator it = files.find(key);
+    if (it == files.end()) {
+        return;
+    }
+    std::vector<Entry>& entries = it->second;
+    for (size_t i = 0; i < entries.size();) {
+        if (entries[i].root == root && entries[i].rel_path == rel_path) {
+            entries.erase(entries.begin() + i);
+        } else {
+            i++;
+        }
+    }
+    if (entries.empty()) {
+        files.erase(it);
+    }
+}
+
+void VFSIndex::Update() {
+    std::vector<FileWatcher::DirectoryChange> changes;
+    if (!watcher.GetDirectoryChanges(changes)) {
+        LOGW << "Missed changes to indexed files, scanning them again" << std::endl;
+        Rescan();
+        return;
+    }
+
+    char key[kPathSize];
+    for (size_t i = 0; i < changes.size(); i++) {
+        const FileWatcher::DirectoryChange& change = changes[i];
+        int root;
+        std::string rel_path;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            ska::flat_hash_map<int, WatchedDirectory>::const_iterator it = watched_directories.find(change.watch_id);
+            if (it == watched_directories.end()) {
+                continue;
+            }
+            root = it->second.root;
+            rel_path = it->second.rel_path + change.name;
+
+            if (!change.is_directory) {
+                if (MakeKey(rel_path.c_str(), key, kPathSize)) {
+                    if (change.removed) {
+                        RemoveEntry(root, key, rel_path);
+                    } else {
+                        AddEntry(root, key, rel_path);
+                    }
+                }
+                continue;
+            }
+            if (change.removed) {
+                DropDirectory(root, rel_path + "/");
+                continue;
+            }
+        }
+        // A directory created or moved into place, it may already have contents.
+        AddDirectory(root, rel_path + "/");
+    }
+}
+
+void VFSIndex::Rescan() {
+    std::vector<int> rescan_roots;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (size_t i = 0; i < roots.size(); i++) {
+            if (roots[i].in_use) {
+                DropDirectory((int)i, std::string());
+                roots[i].watched = watcher.IsActive();
+                rescan_roots.push_back((int)i);
+            }
+        }
+    }
+
+    for (size_t i = 0; i < rescan_roots.size(); i++) {
+        AddDirectory(rescan_roots[i], std::string());
+    }
+}
+
+bool VFSIndex::IsWatching() {
+    return watcher.IsActive();
+}
+
+void VFSIndex::SetEnabled(bool value) {
+    std::lock_guard<std::mutex> lock(mutex);
+    enabled = value;
+}
+
+bool VFSIndex::IsEnabled() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return enabled;
+}
+
+int VFSIndex::Find(const char* path, const int* search_roots, int num_roots, char* bufs, int buf_size, int num_bufs, int* found_roots) {
+    char key[kPathSize];
+    if (num_bufs <= 0 || !MakeKey(path, key, kPathSize)) {
+        return 0;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!enabled) {
+        return 0;
+    }
+
+    int num_found = 0;
+    ska::flat_hash_map<std::string, std::vector<Entry> >::const_iterator it = files.find(key);
+    if (it != files.end()) {
+        const std::vector<Entry>& entries = it->second;
+        for (int i = 0; i < num_roots && num_found < num_bufs; i++) {
+            const Entry* found = NULL;
+            for (size_t k = 0; k < entries.size(); k++) {
+                if (entries[k].root == search_roots[i]) {
+                    // Several files differing only in case, prefer the one asked for.
+                    if (found == NULL || entries[k].rel_path == path) {
+                        found = &entries[k];
+                    }
+                }
+            }
+
+            if (found) {
+                FormatString(&bufs[num_found * buf_size], buf_size, "%s%s", roots[found->root].path.c_str(), found->rel_path.c_str());
+                found_roots[num_found] = i;
+                num_found++;
+            }
+        }
+    }
+
+    if (num_found > 0) {
+        stats.hits++;
+    } else {
+        stats.misses++;
+    }
+    return num_found;
+}
+
+bool VFSIndex::IsAuthoritative(const char* path, const int* search_roots, int num_roots) {
+    char key[kPathSize];
+    if (!MakeKey(path, key, kPathSize)) {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!enabled) {
+        return false;
+    }
+    for (int i = 0; i < num_roots; i++) {
+        int root = search_roots[i];
+        if (root < 0 || root >= (int)roots.size() || !roots[root].in_use || !roots[root].watched) {
+            return false;
+        }
+    }
+    return true;
+}
+
+VFSIndex::Stats VFSIndex::GetStats() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return stats;
+}
+
+void VFSIndex::ResetStats() {
+    std::lock_guard<std::mutex> lock(mutex);
+    stats.hits = 0;
+    stats.misses = 0;
+}
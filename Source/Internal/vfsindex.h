@@ -0,0 +1,127 @@
+//-----------------------------------------------------------------------------
+//           Name: vfsindex.h
+//      Developer: Wolfire Games LLC
+//    Description: In-memory index of the files under the data and mod paths,
+//                 used by FindFilePath to avoid per-lookup filesystem calls.
+//        License: Read below
+//-----------------------------------------------------------------------------
+//
+//
+//   Copyright 2022 Wolfire Games LLC
+//
+//   Licensed under the Apache License, Version 2.0 (the "License");
+//   you may not use this file except in compliance with the License.
+//   You may obtain a copy of the License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//   Unless required by applicable law or agreed to in writing, software
+//   distributed under the License is distributed on an "AS IS" BASIS,
+//   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//   See the License for the specific language governing permissions and
+//   limitations under the License.
+//
+//-----------------------------------------------------------------------------
+#pragma once
+
+#include <Internal/integer.h>
+#include <Internal/filewatcher.h>
+#include <Utility/flat_hash_map.hpp>
+
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+/*
+ * Each search root (a data path or a mod path) is scanned once when it is
+ * added to the filesystem and dropped when it's removed. Files are keyed by
+ * their lower case path relative to the root, so lookups are case insensitive
+ * like caseCorrect() on a case sensitive filesystem.
+ *
+ * Lookups never touch the filesystem, the index is kept current instead. Files
+ * the game creates or deletes itself are passed to AddFile() and RemoveFile().
+ * Where a FileWatcher is available every directory under the roots is watched,
+ * and Update() applies what was created or deleted outside the game; a miss in
+ * watched roots is then as final as a hit. Without the watcher the roots have
+ * to be scanned again with Rescan(), and misses have to fall back to checking
+ * the filesystem.
+ */
+class VFSIndex {
+   public:
+    static const int kInvalidRoot = -1;
+
+    struct Stats {
+        uint64_t hits;
+        uint64_t misses;
+    };
+
+    static VFSIndex& Instance();
+
+    VFSIndex();
+
+    // Scans root_path recursively, returns the root id to use for lookups.
+    int AddRoot(const char* root_path);
+    void RemoveRoot(int root);
+
+    // Adds or drops an absolute path under any of the roots, other paths are ignored.
+    void AddFile(const char* abs_path);
+    void RemoveFile(const char* abs_path);
+
+    // Applies changes made outside the game, call regularly from the main thread.
+    void Update();
+    // Scans all roots again, for when changes can't be watched or were missed.
+    void Rescan();
+    bool IsWatching();
+
+    void SetEnabled(bool enabled);
+    bool IsEnabled();
+
+    /*
+     * Looks path up in the given roots in priority order, writing the on-disk
+     * path of up to num_bufs matches into bufs, buf_size apart, and their position
+     * in roots into found_roots. Returns the number of matches, which is zero
+     * when path isn't a plain relative path.
+     */
+    int Find(const char* path, const int* roots, int num_roots, char* bufs, int buf_size, int num_bufs, int* found_roots);
+    // True if Find() missing path in roots means it isn't in any of them.
+    bool IsAuthoritative(const char* path, const int* roots, int num_roots);
+
+    Stats GetStats();
+    void ResetStats();
+
+   private:
+    struct Entry {
+        int root;
+        std::string rel_path;  // Path relative to the root, as cased on disk
+    };
+
+    struct Root {
+        std::string path;  // With trailing slash
+        bool in_use;
+        bool watched;  // Every directory under it is watched for changes
+    };
+
+    struct WatchedDirectory {
+        int root;
+        std::string rel_path;  // With trailing slash, empty for the root itself
+    };
+
+    // Lower cases path into key, returns false for paths the index can't answer for.
+    static bool MakeKey(const char* path, char* key, int key_size);
+    // Scans rel_dir under root and watches it and everything below it, returns the number of files found.
+    size_t AddDirectory(int root, const std::string& rel_dir);
+    bool WatchTree(const std::string& abs_dir, const std::string& rel_dir, std::vector<std::pair<int, std::string> >& watches);
+    // Expects the mutex to be held.
+    void AddEntry(int root, const char* key, const std::string& rel_path);
+    void RemoveEntry(int root, const char* key, const std::string& rel_path);
+    void DropDirectory(int root, const std::string& rel_dir);
+
+    std::mutex mutex;
+    bool enabled;
+    FileWatcher watcher;
+    std::vector<Root> roots;
+    ska::flat_hash_map<int, WatchedDirectory> watched_directories;
+    ska::flat_hash_map<std::string, std::vector<Entry> > files;
+    Stats stats;
+};
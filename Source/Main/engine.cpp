@@ -39,6 +39,7 @@
 #include <Graphics/cubemap.h>
 #include <Graphics/flares.h>
 #include <Graphics/models.h>
+#include <Graphics/modelcache.h>
 #include <Graphics/particles.h>
 #include <Graphics/pxdebugdraw.h>
 #include <Graphics/retargetfile.h>
@@ -89,6 +90,8 @@
 #include <Internal/referencecounter.h>
 #include <Internal/profiler.h>
 #include <Internal/zip_util.h>
+#include <Internal/vfsindex.h>
+#include <Internal/filefingerprint.h>
 
 #include <Asset/Asset/levelinfo.h>
 #include <Asset/Asset/levelset.h>
@@ -102,11 +105,14 @@
 
 #include <Timing/timingevent.h>
 #include <Timing/intel_gl_perf.h>
+#include <Timing/steptimings.h>
 
 #include <Memory/stack_allocator.h>
 #include <Memory/allocation.h>
 
 #include <Physics/bulletworld.h>
+#include <Physics/bulletsimulationlod.h>
+#include <Physics/bullettaskscheduler.h>
 #include <Physics/physics.h>
 
 #include <Math/vec2math.h>
@@ -127,6 +133,7 @@
 #include <Wrappers/glm.h>
 #include <Images/image_export.hpp>
 #include <Threading/thread_name.h>
+#include <Threading/worker_pool.h>
 #include <Network/asnetwork.h>
 #include <Version/version.h>
 #include <Steam/steamworks.h>
@@ -465,6 +472,11 @@ static void LiveUpdate(SceneGraph* scenegraph, AssetManager* asset_manager, Scri
     Graphics* graphics = Graphics::Instance();
     Engine* engine = Engine::Instance();
 
+    if (!VFSIndex::Instance().IsWatching()) {
+        // Pick up files added or removed outside the game before reloading from them.
+        VFSIndex::Instance().Rescan();
+    }
+
     if (config.PrimarySourceModified()) {
         config.Load(config.GetPrimaryPath());
         engine->SetGameSpeed(config["global_time_scale_mult"].toNumber<float>(), true);
@@ -614,6 +626,7 @@ void Engine::Dispose() {
     Engine::instance_ = NULL;
 
     AssetPreload::Instance().Dispose();
+    FileFingerprintStore::Instance().Save();
 
 #ifdef OculusVR
     if (g_oculus_vr_activated) {
@@ -1744,6 +1757,11 @@ void Engine::Update() {
     }
 #endif
 
+    {
+        PROFILER_ZONE(g_profiler_ctx, "Update file index");
+        VFSIndex::Instance().Update();
+    }
+
 #if ENABLE_STEAMWORKS
     {
         PROFILER_ZONE(g_profiler_ctx, "Steam update");
@@ -2061,8 +2079,12 @@ void Engine::Update() {
         }
         Input::Instance()->ClearQuitRequested();
     }
+    StepTimings::Instance()->BeginFrame();
     sound.UpdateGameTimestep(game_timer.timestep);
-    sound.Update();
+    {
+        ScopedStepTiming step_timing(StepTimings::kAudio);
+        sound.Update();
+    }
 
     if (Online::Instance()->IsAwaitingShutdown()) {
         Online::Instance()->StopMultiplayer();
@@ -2146,6 +2168,10 @@ void Engine::Update() {
         } else {
             int num_game_timesteps = game_timer.GetStepsNeeded();
             num_game_timesteps = min(num_game_timesteps, _max_steps_per_frame);
+            if (input_recording_.mode() == InputRecording::kReplaying) {
+                // Run as fast as possible instead of keeping up with the clock
+                num_game_timesteps = 1;
+            }
             game_timer.updates_since_last_frame = num_game_timesteps;
 
             for (int curr_step = 0; curr_step < num_ui_timesteps; curr_step++) {
@@ -2166,10 +2192,14 @@ void Engine::Update() {
                 if (!paused) {
                     PROFILER_ZONE(g_profiler_ctx, "Update timer");
                     game_timer.Update();
+                    asset_manager.UpdateLoadTrace(game_timer.timestep);
                 }
                 {
                     PROFILER_ZONE(g_profiler_ctx, "Update controls");
                     UpdateControls(game_timer.timestep, false);
+                    if (input_recording_.mode() != InputRecording::kInactive) {
+                        input_recording_.Step(Input::Instance(), scenegraph_->level_path_.GetOriginalPathStr());
+                    }
                 }
                 {
                     PROFILER_ZONE(g_profiler_ctx, "Update flares");
@@ -2213,6 +2243,7 @@ void Engine::Update() {
                 }
                 {
                     PROFILER_ZONE(g_profiler_ctx, "Level update");
+                    ScopedStepTiming step_timing(StepTimings::kScripts);
                     scenegraph_->level->Update(paused);
                 }
                 HandleRabbotToggleControls();
@@ -2227,6 +2258,15 @@ void Engine::Update() {
                 for (auto active_context : active_contexts) {
                     active_context->profiler.Update();
                 }
+                StepTimings::Instance()->EndStep();
+                if (input_recording_.IsReplayFinished()) {
+                    LOGI << "Finished replaying " << input_recording_.num_steps() << " steps of input" << std::endl;
+                    input_recording_.Stop();
+                    StepTimings::Instance()->Close();
+                    // Straight out, there is nobody to answer the save dialog
+                    quitting_ = true;
+                    break;
+                }
             }
             sound.UpdateGameTimescale(powf(game_timer.time_scale / current_global_scale_mult, 0.5f));
         }
@@ -5485,21 +5525,38 @@ void Engine::LoadConfigFile() {
     }
 }
 
+// Recorded per-level preload manifests live in the write dir, mirroring the level path.
+static std::string GetLoadManifestPath(const Path& level_path) {
+    std::string level = level_path.GetOriginalPathStr();
+    if (level.compare(0, 5, "Data/") == 0) {
+        level = level.substr(5);
+    }
+    return "Data/LoadManifests/" + level;
+}
+
 void Engine::PreloadAssets(const Path& level_path) {
     // Release currently hold preloaded from previous level so they may get retagged.
     asset_manager.ReleaseAssetHoldLoad(HOLD_LOAD_MASK_PRELOAD);
 
     std::vector<LevelAssetPreloadParser::Asset>& preload_files = AssetPreload::Instance().GetPreloadFiles();
     LOGI << "Starting Preloading for: " << level_path << std::endl;
+    std::vector<AssetBatchLoadEntry> batch;
     for (auto& preload_file : preload_files) {
         if (preload_file.all_levels || preload_file.level_name == level_path.GetOriginalPathStr()) {
-            // LOGI << "Preloading: " << preload_files[i].path << " " << preload_files[i].asset_type << " " << preload_files[i].load_flags << std::endl;
-            Path p = FindFilePath(preload_file.path, kAnyPath, false);
-            if (p.isValid()) {
-                GetAssetManager()->LoadSync(preload_file.asset_type, preload_file.path, preload_file.load_flags, HOLD_LOAD_MASK_PRELOAD);
-            }
+            batch.push_back(AssetBatchLoadEntry(preload_file.asset_type, preload_file.path, preload_file.load_flags));
         }
     }
+
+    Path manifest_path = FindFilePath(GetLoadManifestPath(level_path), kAnyPath, false);
+    if (manifest_path.isValid()) {
+        LevelAssetPreloadParser manifest;
+        manifest.Load(manifest_path.GetFullPathStr());
+        LOGI << "Preloading " << manifest.assets.size() << " assets from recorded manifest " << manifest_path << std::endl;
+        for (auto& asset : manifest.assets) {
+            batch.push_back(AssetBatchLoadEntry(asset.asset_type, asset.path, asset.load_flags));
+        }
+    }
+    GetAssetManager()->LoadSyncBatch(batch, HOLD_LOAD_MASK_PRELOAD);
 }
 
 void Engine::LoadLevelData(const Path& level_path) {
@@ -5509,19 +5566,36 @@ void Engine::LoadLevelData(const Path& level_path) {
     NameCurrentThread("Level loading thread");
 #endif
     PROFILER_ZONE(g_profiler_ctx, "Loading level");
+    uint64_t load_start_ticks = SDL_TS_GetTicks();
+    VFSIndex::Instance().ResetStats();
+
+    if (config["record_load_manifest"].toBool()) {
+        asset_manager.StartLoadTrace(level_path.GetOriginalPathStr(), GetLoadManifestPath(level_path), config["record_load_manifest_seconds"].toNumber<float>());
+    }
 
     LOG_ASSERT(scenegraph_->bullet_world_ == NULL);
     scenegraph_->bullet_world_ = new BulletWorld();
-    scenegraph_->bullet_world_->Init();
+    scenegraph_->bullet_world_->Init(config["physics_threads"].toBool());
     scenegraph_->bullet_world_->SetGravity(Physics::Instance()->gravity);
     scenegraph_->bullet_world_->CreatePlane(vec3(0.0f, 1.0f, 0.0f), -100.0f);
 
     scenegraph_->abstract_bullet_world_ = new BulletWorld();
     scenegraph_->abstract_bullet_world_->Init();
+    scenegraph_->abstract_bullet_world_->EnableOverlapTracking();
 
     scenegraph_->plant_bullet_world_ = new BulletWorld();
     scenegraph_->plant_bullet_world_->Init();
 
+    if (config["physics_lod_radius"].toNumber<float>() > 0.0f) {
+        SimulationLODSettings lod_settings;
+        lod_settings.reduced_rate_radius = config["physics_lod_radius"].toNumber<float>();
+        lod_settings.sleep_radius = config["physics_lod_sleep_radius"].toNumber<float>();
+        lod_settings.reduced_rate_interval = config["physics_lod_interval"].toNumber<int>();
+        scenegraph_->bullet_world_->EnableSimulationLOD(lod_settings);
+        scenegraph_->plant_bullet_world_->EnableSimulationLOD(lod_settings);
+    }
+    scenegraph_->parallel_animation = config["parallel_animation"].toBool();
+
     // sound.AttachBulletWorld(scenegraph_->bullet_world_);
 
     AddLoadingText("Loading level...");
@@ -5539,7 +5613,8 @@ void Engine::LoadLevelData(const Path& level_path) {
 
     PreloadAssets(level_path);
 
-    // Clear all unused assets, after loading new level.
+    // Clear all unused assets, after loading new level. With an asset memory
+    // budget set this only evicts down to the budget, keeping the rest cached.
     while (asset_manager.UnloadUnreferenced(0, 0)) {
     }
 
@@ -5553,6 +5628,9 @@ void Engine::LoadLevelData(const Path& level_path) {
     }
 
     finished_loading_time = (float)SDL_TS_GetTicks();
+    FileFingerprintStore::Instance().Save();
+    VFSIndex::Stats vfs_stats = VFSIndex::Instance().GetStats();
+    LOGI << "Level loaded in " << (SDL_TS_GetTicks() - load_start_ticks) << "ms, file index answered " << vfs_stats.hits << " lookups, " << vfs_stats.misses << " missed" << std::endl;
     loading_in_progress_ = false;
     waiting_for_input_ = true;
     scenegraph_->map_editor->QueueSaveHistoryState();
@@ -5575,6 +5653,7 @@ void Engine::ClearLoadedLevel() {
     Online::Instance()->ClearIDTranslations();
 
     asset_manager.Update();
+    asset_manager.StopLoadTrace();
     asset_manager.DumpLoadWarningData("asset_manager_warnings.xml");
     ActiveCameras::Get()->SetCameraObject(NULL);
     level_loaded_ = false;
@@ -5584,7 +5663,7 @@ void Engine::ClearLoadedLevel() {
         LOGI << "Unloading all unreferenced assets after clearing level [full_level_unload: true]..." << std::endl;
         size_t pre_count = asset_manager.GetLoadedAssetCount();
         size_t tex_pre_count = asset_manager.GetAssetTypeCount(TEXTURE_ASSET);
-        while (asset_manager.UnloadUnreferenced(0, 0)) {
+        while (asset_manager.UnloadAllUnreferenced()) {
         }
         Textures::Instance()->DeleteUnusedTextures();
         LOGI << (pre_count - asset_manager.GetLoadedAssetCount()) << " Assets were unloaded" << std::endl;
@@ -5946,6 +6025,7 @@ void Engine::Initialize() {
     }
 #endif
     AssetPreload::Instance().Initialize();
+    FileFingerprintStore::Instance().Load(GetWritePath(CoreGameModID) + "file_fingerprints.bin");
 #if ENABLE_STEAMWORKS
     Steamworks::Instance()->Initialize();
 #endif
@@ -6009,6 +6089,17 @@ void Engine::Initialize() {
     Input::Instance()->Initialize();
     Input::Instance()->cursor = &cursor;
     LoadConfigFile();
+    asset_manager.SetWorkerThreadCount(config["asset_io_threads"].toNumber<int>(), config["asset_decode_threads"].toNumber<int>());
+    WorkerPool::Instance()->SetThreadCount(config["worker_threads"].toNumber<int>());
+    WorkerPoolTaskScheduler::Instance()->Install();
+    asset_manager.SetMemoryBudget((size_t)config["asset_memory_budget_mb"].toNumber<int>() * 1024 * 1024);
+    for (int i = 1; i < (int)ASSET_TYPE_FINAL; i++) {
+        std::string budget_key = std::string("asset_memory_budget_mb_") + GetAssetTypeString((AssetType)i);
+        if (config.HasKey(budget_key)) {
+            asset_manager.SetMemoryBudget((AssetType)i, (size_t)config[budget_key].toNumber<int>() * 1024 * 1024);
+        }
+    }
+    ModelCache::SetUseCompression(config["model_cache_compression"].toBool());
     AnimationRetargeter::Instance()->Load("Data/Animations/retarget.xml");
 
     ModLoading::Instance().Initialize();
@@ -6130,6 +6221,23 @@ void Engine::Initialize() {
     FontRenderer::Instance(&font_renderer);
 
     CHECK_GL_ERROR();
+    if (!config["replay_input"].str().empty()) {
+        if (input_recording_.LoadReplay(config["replay_input"].str())) {
+            std::string timings_path = config["replay_timings"].str();
+            if (timings_path.empty()) {
+                timings_path = config["replay_input"].str() + ".csv";
+            }
+            StepTimings::Instance()->Open(timings_path);
+            std::stringstream ss;
+            ss << "debug_load_level: " << input_recording_.level_path() << std::endl;
+            config.Load(ss, false, true);
+        } else {
+            quitting_ = true;
+        }
+    } else if (!config["record_input"].str().empty()) {
+        input_recording_.StartRecording(config["record_input"].str());
+    }
+
     if (config["load_all_levels"].toNumber<bool>()) {
         ManifestXMLParser mp;
 
@@ -25,6 +25,7 @@
 #include <Main/scenegraph.h>
 
 #include <UserInput/input.h>
+#include <UserInput/inputrecording.h>
 
 #include <Graphics/Cursor.h>
 #include <Graphics/graphics.h>
@@ -296,6 +297,8 @@ class Engine : public ModLoadingCallback {
 
     AvatarControlManager avatar_control_manager;
 
+    InputRecording input_recording_;
+
    public:
     void DrawScene(DrawingViewport drawing_viewport, PostEffectsType post_effects_type, SceneGraph::SceneDrawType scene_draw_type);
 
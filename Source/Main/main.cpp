@@ -336,6 +336,15 @@ int main(int argc, char* argv[]) {
         TCLAP::ValueArg<std::string> ogdaManifest("", "ogda-manifest", "Ogda generated manifest of game assets.", false, "", "string");
         cmd.add(ogdaManifest);
 
+        TCLAP::ValueArg<std::string> recordInputArg("", "record-input", "Record the input of every game step in the first level played to a file", false, "", "string");
+        cmd.add(recordInputArg);
+
+        TCLAP::ValueArg<std::string> replayInputArg("", "replay-input", "Replay recorded input in its level without rendering, then quit", false, "", "string");
+        cmd.add(replayInputArg);
+
+        TCLAP::ValueArg<std::string> replayTimingsArg("", "replay-timings", "CSV file for the per step timings of --replay-input, defaults to the recording path with .csv added", false, "", "string");
+        cmd.add(replayTimingsArg);
+
         TCLAP::SwitchArg ddsconvertSwitch("", "ddsconvert", "Start game with DDSConvert.", cmd, false);
         TCLAP::SwitchArg debugOutput("d", "debug-output", "Start game with debug output", cmd, false);
         TCLAP::SwitchArg spamOutput("s", "spam-output", "Start game with spammy debug output", cmd, false);
@@ -359,6 +368,9 @@ int main(int argc, char* argv[]) {
         std::string levelname = levelArg.getValue();
         std::string configuration = configurationArg.getValue();
         std::string manifest = ogdaManifest.getValue();
+        std::string record_input = recordInputArg.getValue();
+        std::string replay_input = replayInputArg.getValue();
+        std::string replay_timings = replayTimingsArg.getValue();
 
         overloadedWriteDir = writeDirArg.getValue();
         overloadedWorkingDir = workingDirArg.getValue();
@@ -390,6 +402,25 @@ int main(int argc, char* argv[]) {
             config.Load(ss, false, true);
         }
 
+        if (!record_input.empty()) {
+            std::stringstream ss;
+            ss << "record_input: " << record_input << std::endl;
+            config.Load(ss, false, true);
+        }
+
+        // The engine loads the level the recording was made in
+        if (!replay_input.empty()) {
+            disable_rendering = true;
+            std::stringstream ss;
+            ss << "replay_input: " << replay_input << std::endl;
+            ss << "main_menu: false" << std::endl;
+            ss << "skip_loading_pause: true" << std::endl;
+            if (!replay_timings.empty()) {
+                ss << "replay_timings: " << replay_timings << std::endl;
+            }
+            config.Load(ss, false, true);
+        }
+
         if (quit_after_load) {
             std::stringstream ss;
             ss << "quit_after_load: true" << std::endl;
@@ -49,6 +49,8 @@
 #include <Physics/bulletworld.h>
 #include <Physics/bulletcollision.h>
 #include <Physics/bulletobject.h>
+#include <Physics/bulletoverlaptracker.h>
+#include <Physics/bulletsimulationlod.h>
 #include <Physics/physics.h>
 
 #include <Math/vec2math.h>
@@ -59,12 +61,16 @@
 #include <Internal/common.h>
 #include <Internal/profiler.h>
 #include <Internal/config.h>
+#include <Internal/timer.h>
 
 #include <Editors/map_editor.h>
 #include <Editors/actors_editor.h>
 
 #include <Timing/timingevent.h>
 #include <Timing/intel_gl_perf.h>
+#include <Timing/steptimings.h>
+
+#include <Threading/worker_pool.h>
 
 #include <Main/engine.h>
 #include <Internal/stopwatch.h>
@@ -81,11 +87,13 @@
 
 #include <cassert>
 #include <algorithm>
+#include <cmath>
 #include <cstring>
 
 extern const bool kUseShadowCache;
 static const bool _draw_collision_shapes = false;
 
+extern Timer game_timer;
 extern bool g_draw_vr;
 extern bool g_simple_water;
 extern bool g_disable_fog;
@@ -166,9 +174,11 @@ SceneGraph::SceneGraph()
     : particle_system(NULL),
       terrain_object_(NULL),
       num_update_objects(0),
+      parallel_animation(false),
       bullet_world_(NULL),
       abstract_bullet_world_(NULL),
       plant_bullet_world_(NULL),
+      character_bounds_dirty_(true),
       queued_level_reset_(false),
       nav_mesh_(NULL),
       haze_mult(0.0008f),
@@ -303,6 +313,7 @@ void SceneGraph::LinkObject(Object* new_object) {
     }
 
     objects_.push_back(new_object);
+    InsertLineCheckProxy(new_object);
     if (new_object->collidable) {
         collide_objects_.push_back(new_object);
     }
@@ -325,6 +336,7 @@ void SceneGraph::LinkObject(Object* new_object) {
         }
         case _movement_object:
             movement_objects_.push_back(new_object);
+            character_bounds_dirty_ = true;
             break;
         case _item_object:
             item_objects_.push_back(new_object);
@@ -374,61 +386,113 @@ void SceneGraph::QueueLevelReset() {
     queued_level_reset_ = true;
 }
 
-Collision SceneGraph::lineCheck(const vec3& start, const vec3& end) {
-    std::vector<Collision> collisions;
-    LineCheckAll(start, end, &collisions);
-    Collision* closest = NULL;
-    float closest_distance;
-    for (auto& c : collisions) {
-        float dist = distance_squared(start, c.hit_where);
-        if (!closest || dist < closest_distance) {
-            closest = &c;
-            closest_distance = dist;
-        }
-    }
-    if (closest) {
-        return *closest;
-    } else {
-        return Collision();
+static bool LineCheckObject(Object* obj, const vec3& start, const vec3& end, Collision* c) {
+    vec3 point, normal;
+    int collision_tri = obj->lineCheck(start, end, &point, &normal);
+    if (collision_tri == -1) {
+        return false;
     }
+    c->hit = true;
+    c->hit_normal = normal;
+    c->hit_what = obj;
+    c->hit_how = collision_tri;
+    c->hit_where = point;
+    return true;
 }
 
-Collision SceneGraph::lineCheckCollidable(const vec3& start, const vec3& end, Object* not_hit) {
-    std::vector<Collision> collisions;
-    LineCheckAll(start, end, &collisions);
-    Collision* closest = NULL;
-    float closest_distance;
-    for (auto& c : collisions) {
-        if (c.hit_what->collidable && c.hit_what != not_hit) {
-            float dist = distance_squared(start, c.hit_where);
-            if (!closest || dist < closest_distance) {
-                closest = &c;
-                closest_distance = dist;
+namespace {
+class ClosestLineCheckCallback : public AABBTreeRayCallback {
+   public:
+    ClosestLineCheckCallback(const vec3& start, const vec3& end, bool collidable_only, Object* not_hit)
+        : start_(start),
+          end_(end),
+          segment_length_squared_(distance_squared(start, end)),
+          collidable_only_(collidable_only),
+          not_hit_(not_hit) {
+    }
+
+    // Returns the fraction of the segment up to the closest hit so far
+    float Test(Object* obj) {
+        if (!collidable_only_ || (obj->collidable && obj != not_hit_)) {
+            // Nothing past the closest hit can replace it, so only check up to there
+            Collision c;
+            if (LineCheckObject(obj, start_, closest_.hit ? closest_.hit_where : end_, &c)) {
+                if (!closest_.hit || distance_squared(start_, c.hit_where) < distance_squared(start_, closest_.hit_where)) {
+                    closest_ = c;
+                }
             }
         }
+        if (!closest_.hit || segment_length_squared_ == 0.0f) {
+            return 1.0f;
+        }
+        return sqrtf(distance_squared(start_, closest_.hit_where) / segment_length_squared_);
     }
-    if (closest) {
-        return *closest;
-    } else {
-        return Collision();
+
+    float Process(void* user_data, float max_fraction) override {
+        return Test((Object*)user_data);
+    }
+
+    const Collision& GetClosest() const { return closest_; }
+
+   private:
+    vec3 start_;
+    vec3 end_;
+    float segment_length_squared_;
+    bool collidable_only_;
+    Object* not_hit_;
+    Collision closest_;
+};
+
+class AllLineCheckCallback : public AABBTreeRayCallback {
+   public:
+    AllLineCheckCallback(const vec3& start, const vec3& end, std::vector<Collision>* collisions)
+        : start_(start),
+          end_(end),
+          collisions_(collisions) {
+    }
+
+    float Process(void* user_data, float max_fraction) override {
+        Collision c;
+        if (LineCheckObject((Object*)user_data, start_, end_, &c)) {
+            collisions_->push_back(c);
+        }
+        return max_fraction;
+    }
+
+   private:
+    vec3 start_;
+    vec3 end_;
+    std::vector<Collision>* collisions_;
+};
+}  // namespace
+
+Collision SceneGraph::lineCheck(const vec3& start, const vec3& end) {
+    return LineCheckClosest(start, end, false, NULL);
+}
+
+Collision SceneGraph::lineCheckCollidable(const vec3& start, const vec3& end, Object* not_hit) {
+    return LineCheckClosest(start, end, true, not_hit);
+}
+
+Collision SceneGraph::LineCheckClosest(const vec3& start, const vec3& end, bool collidable_only, Object* not_hit) {
+    PROFILER_ZONE(g_profiler_ctx, "SceneGraph::lineCheck");
+    ClosestLineCheckCallback callback(start, end, collidable_only, not_hit);
+    // Objects without bounds first, a terrain hit cuts the segment short for everything else
+    float max_fraction = 1.0f;
+    for (auto obj : unbounded_line_check_objects_) {
+        max_fraction = callback.Test(obj);
     }
+    line_check_tree_.RayCast(start, end, &callback, max_fraction);
+    return callback.GetClosest();
 }
 
 void SceneGraph::LineCheckAll(const vec3& start, const vec3& end, std::vector<Collision>* collisions) {
     PROFILER_ZONE(g_profiler_ctx, "SceneGraph::LineCheckAll");
-    for (auto obj : objects_) {
-        vec3 point, normal;
-        int collision_tri = obj->lineCheck(start, end, &point, &normal);
-        if (collision_tri != -1) {
-            Collision c;
-            c.hit = true;
-            c.hit_normal = normal;
-            c.hit_what = obj;
-            c.hit_how = collision_tri;
-            c.hit_where = point;
-            collisions->push_back(c);
-        }
+    AllLineCheckCallback callback(start, end, collisions);
+    for (auto obj : unbounded_line_check_objects_) {
+        callback.Process(obj, 1.0f);
     }
+    line_check_tree_.RayCast(start, end, &callback);
 }
 
 static std::vector<EnvObject*>* g_static_mesh_draw_sort_entries = NULL;
@@ -905,33 +969,53 @@ void SceneGraph::Update(float timestep, float curr_game_time) {
     if (queued_level_reset_) {
         PROFILER_ZONE(g_profiler_ctx, "Resetting level");
         queued_level_reset_ = false;
-        Level::CollisionPtrMap blank;
-        level->HandleCollisions(blank, *this);
+        // Everything that is still touching after the reset begins again on the next update
+        abstract_bullet_world_->overlap_tracker_->ResetTouching();
+        level->ClearCollisions(*this);
         SendMessageToAllObjects(OBJECT_MSG::RESET);
         level->Message("post_reset");
     }
 
+    UpdateSimulationFocus();
+
     // uint64_t start_count = SDL_GetPerformanceCounter();
     {
         PROFILER_ZONE(g_profiler_ctx, "Bullet world update");
+        ScopedStepTiming step_timing(StepTimings::kPhysics);
         bullet_world_->Update(timestep);
     }
     // uint64_t end_count = SDL_GetPerformanceCounter();
-    plant_bullet_world_->Update(timestep);
+    {
+        ScopedStepTiming step_timing(StepTimings::kPhysics);
+        plant_bullet_world_->Update(timestep);
+    }
 
     {
         PROFILER_ZONE(g_profiler_ctx, "Abstract world collisions");
-        level->HandleCollisions(abstract_bullet_world_->GetCollisions(), *this);
+        BulletOverlapTracker* overlaps;
+        {
+            ScopedStepTiming step_timing(StepTimings::kPhysics);
+            overlaps = abstract_bullet_world_->UpdateOverlaps();
+        }
+        level->HandleCollisions(*overlaps, *this);
+        overlaps->ClearEvents();
     }
 
     {
         // Only updating specific subtypes of objects? -Max
         PROFILER_ZONE(g_profiler_ctx, "Object updates");
+        split_update_ids_.clear();
         for (int i = 0; i < num_update_objects; ++i) {
             Object* obj = update_objects_[i];
             PROFILER_ZONE(g_profiler_ctx, "%s %d update", CStringFromEntityType(obj->GetType()), obj->GetID());
-            obj->ReceiveObjectMessage(OBJECT_MSG::UPDATE, timestep);
+            if (parallel_animation && obj->GetType() == _movement_object) {
+                static_cast<MovementObject*>(obj)->BeginUpdate(timestep);
+                split_update_ids_.push_back(obj->GetID());
+            } else {
+                obj->ReceiveObjectMessage(OBJECT_MSG::UPDATE, timestep);
+            }
         }
+        UpdateCharacterAnimation(timestep);
         /*
         for(object_list::iterator it = objects_.begin(); it != objects_.end();) {
             Object* obj = *it;
@@ -1115,10 +1199,12 @@ void SceneGraph::UnlinkObject(Object* o) {
     RemoveDerivedObjFromListAndIndex(_env_object, o, &visible_static_meshes_, &visible_static_meshes_shadow_cache_bounds_, &visible_static_mesh_indices_);
     RemoveDerivedObjFromList(_terrain_type, o, &terrain_objects_, &terrain_objects_shadow_cache_bounds_);
     RemoveObjFromList(o, &collide_objects_);
-    RemoveObjFromList(o, &movement_objects_);
+    if (RemoveObjFromList(o, &movement_objects_))
+        character_bounds_dirty_ = true;
     RemoveObjFromList(o, &item_objects_);
     RemoveObjFromList(o, &decal_objects_);
     RemoveObjFromList(o, &objects_);
+    RemoveLineCheckProxy(o);
     if (RemoveObjFromList(o, &hotspots_))
         hotspots_modified_ = true;
     RemoveObjFromList(o, &navmesh_hints_);
@@ -1142,6 +1228,48 @@ void SceneGraph::UnlinkObject(Object* o) {
     }
 }
 
+static bool GetObjectLineCheckBounds(Object* obj, vec3* min, vec3* max) {
+    if (!obj->GetLineCheckBounds(min, max)) {
+        return false;
+    }
+    for (int i = 0; i < 3; ++i) {
+        if (!std::isfinite((*min)[i]) || !std::isfinite((*max)[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void SceneGraph::InsertLineCheckProxy(Object* obj) {
+    vec3 min, max;
+    if (GetObjectLineCheckBounds(obj, &min, &max)) {
+        obj->line_check_proxy = line_check_tree_.CreateProxy(min, max, obj);
+    } else {
+        obj->line_check_proxy = Object::kLineCheckUnbounded;
+        unbounded_line_check_objects_.push_back(obj);
+    }
+}
+
+void SceneGraph::RemoveLineCheckProxy(Object* obj) {
+    if (obj->line_check_proxy == Object::kLineCheckUnbounded) {
+        RemoveObjFromList(obj, &unbounded_line_check_objects_);
+    } else if (obj->line_check_proxy != Object::kLineCheckNotLinked) {
+        line_check_tree_.DestroyProxy(obj->line_check_proxy);
+    }
+    obj->line_check_proxy = Object::kLineCheckNotLinked;
+}
+
+void SceneGraph::UpdateLineCheckProxy(Object* obj) {
+    vec3 min, max;
+    bool bounded = GetObjectLineCheckBounds(obj, &min, &max);
+    if (bounded && obj->line_check_proxy >= 0) {
+        line_check_tree_.MoveProxy(obj->line_check_proxy, min, max);
+    } else if (bounded || obj->line_check_proxy >= 0) {
+        RemoveLineCheckProxy(obj);
+        InsertLineCheckProxy(obj);
+    }
+}
+
 Object* SceneGraph::GetObjectFromID(int object_id) {
     Object* object_at_id = GetIdToObjectMapValue(object_from_id_map_, object_id);
     if (object_at_id != NULL) {
@@ -1582,22 +1710,52 @@ float SceneGraph::GetMaterialSharpPenetration(const vec3& pos, Object* excluded_
     return closest_obj->GetMaterial(pos, &hit_tri)->GetSharpPenetration();
 }
 
-void SceneGraph::GetSweptSphereCollisionCharacters(const vec3& pos, const vec3& pos2, float radius, SphereCollision& as_col) {
-    vec3 end = pos2;
+void SceneGraph::RefreshCharacterBounds() {
+    if (!character_bounds_dirty_) {
+        return;
+    }
+    character_bounds_dirty_ = false;
+    character_bounds_.Clear();
     for (auto& movement_object : movement_objects_) {
         MovementObject* mo = (MovementObject*)movement_object;
-        mo->rigged_object()->skeleton().GetSweptSphereCollisionCharacter(pos, end, radius, as_col);
-        end = as_col.position;
+        vec3 center;
+        float radius;
+        if (!mo->rigged_object()->skeleton().GetCollisionBounds(&center, &radius)) {
+            radius = -1.0f;
+        }
+        character_bounds_.Add(center, radius);
+    }
+}
+
+void SceneGraph::GetSweptSphereCollisionCharacters(const vec3& pos, const vec3& pos2, float radius, SphereCollision& as_col) {
+    as_col.contacts.clear();
+    as_col.position = pos2;
+    as_col.adjusted_position = pos2;
+    RefreshCharacterBounds();
+    character_candidates_.clear();
+    character_bounds_.SegmentQuery(pos, pos2, radius, &character_candidates_);
+    vec3 end = pos2;
+    SphereCollision character_col;
+    for (int index : character_candidates_) {
+        MovementObject* mo = (MovementObject*)movement_objects_[index];
+        mo->rigged_object()->skeleton().GetSweptSphereCollisionCharacter(pos, end, radius, character_col);
+        if (!character_col.contacts.empty()) {
+            as_col = character_col;
+            end = character_col.position;
+        }
     }
 }
 
 int SceneGraph::CheckRayCollisionCharacters(const vec3& start, const vec3& end, vec3* point, vec3* normal, int* bone) {
+    RefreshCharacterBounds();
+    character_candidates_.clear();
+    character_bounds_.SegmentQuery(start, end, 0.0f, &character_candidates_);
     vec3 new_end = end;
     vec3 temp_point;
     vec3 temp_normal;
     int char_id = -1;
-    for (auto& movement_object : movement_objects_) {
-        MovementObject* mo = (MovementObject*)movement_object;
+    for (int index : character_candidates_) {
+        MovementObject* mo = (MovementObject*)movement_objects_[index];
         const btCollisionObject* bone_col = mo->rigged_object()->skeleton().CheckRayCollision(start, new_end, &temp_point, &temp_normal);
         if (bone_col != NULL) {
             if (point) {
@@ -1650,6 +1808,62 @@ void SceneGraph::SendScriptMessageToAllObjects(std::string& msg) {
     }
 }
 
+void SceneGraph::UpdateSimulationFocus() {
+    if (!bullet_world_->simulation_lod_ && !plant_bullet_world_->simulation_lod_) {
+        return;
+    }
+    simulation_focus_.clear();
+    for (int i = 0, len = ActiveCameras::NumCameras(); i < len; ++i) {
+        simulation_focus_.push_back(ActiveCameras::GetCamera(i)->GetPos());
+    }
+    for (Object* obj : movement_objects_) {
+        MovementObject* mo = static_cast<MovementObject*>(obj);
+        if (mo->controlled) {
+            simulation_focus_.push_back(mo->position);
+        }
+    }
+    if (bullet_world_->simulation_lod_) {
+        bullet_world_->simulation_lod_->SetFocus(simulation_focus_);
+    }
+    if (plant_bullet_world_->simulation_lod_) {
+        plant_bullet_world_->simulation_lod_->SetFocus(simulation_focus_);
+    }
+}
+
+void SceneGraph::UpdateCharacterAnimation(float timestep) {
+    if (split_update_ids_.empty()) {
+        return;
+    }
+    // Scripts that ran since the characters began their update can delete them
+    animation_evaluations_.clear();
+    for (int id : split_update_ids_) {
+        Object* obj = DoesObjectWithIdExist(id) ? GetObjectFromID(id) : NULL;
+        if (obj && obj->GetType() == _movement_object) {
+            animation_evaluations_.push_back(static_cast<MovementObject*>(obj)->rigged_object());
+        }
+    }
+    {
+        PROFILER_ZONE(g_profiler_ctx, "Evaluate character animation");
+        ScopedStepTiming step_timing(StepTimings::kAnimation);
+        std::vector<RiggedObject*>& evaluations = animation_evaluations_;
+        // A single character's blend tree is already worth handing to a worker
+        WorkerPool::Instance()->ParallelFor((int)evaluations.size(), 1, [&evaluations](int begin, int end) {
+            for (int i = begin; i < end; ++i) {
+                evaluations[i]->EvaluateAnimation();
+            }
+        });
+    }
+    // Scripts run in the same order as the first part of the update
+    for (int id : split_update_ids_) {
+        Object* obj = DoesObjectWithIdExist(id) ? GetObjectFromID(id) : NULL;
+        if (obj && obj->GetType() == _movement_object) {
+            PROFILER_ZONE(g_profiler_ctx, "%s %d finish update", CStringFromEntityType(obj->GetType()), obj->GetID());
+            static_cast<MovementObject*>(obj)->FinishUpdate(timestep);
+            obj->walltime_last_update = game_timer.GetWallTime();
+        }
+    }
+}
+
 std::vector<MovementObject*> SceneGraph::GetControlledMovementObjects() {
     std::vector<MovementObject*> controlled_objects;
     for (Object* obj : movement_objects_) {
@@ -1842,6 +2056,8 @@ void SceneGraph::Dispose() {
         delete object;
     }
     object_from_id_map_.clear();
+    line_check_tree_.Clear();
+    unbounded_line_check_objects_.clear();
     if (bullet_world_) {
         bullet_world_->Dispose();
         delete bullet_world_;
@@ -32,6 +32,8 @@
 #include <Editors/object_sanity_state.h>
 
 #include <Math/vec4.h>
+#include <Math/aabbtree.h>
+#include <Math/boundingspheres.h>
 #include <Objects/object_msg.h>
 #include <Asset/Asset/material.h>
 #include <Internal/collisiondetection.h>
@@ -57,6 +59,7 @@ class Textures;
 class EnvObject;
 class LightVolumeObject;
 class MovementObject;
+class RiggedObject;
 
 struct SceneLight {
     vec3 pos;
@@ -106,6 +109,8 @@ class SceneGraph {
     static const int kMaxUpdateObjects = 1024;
     Object *update_objects_[kMaxUpdateObjects];
     int num_update_objects;
+    // Evaluate every character's animation at once on the worker pool, between the rest of their updates
+    bool parallel_animation;
 
     typedef std::vector<Object *> object_list;
     object_list objects_;
@@ -181,6 +186,8 @@ class SceneGraph {
     std::vector<Object *> GetObjectsOfType(enum EntityType type);
     void UnlinkObject(Object *o);
     void LinkObject(Object *new_object);
+    // Refits the object in the line check tree after its bounds changed
+    void UpdateLineCheckProxy(Object *obj);
     void CreateNavMesh();
     void SaveNavMesh();
     bool LoadNavMesh();
@@ -201,6 +208,8 @@ class SceneGraph {
     void QueueLevelReset();
     void GetSweptSphereCollisionCharacters(const vec3 &pos, const vec3 &pos2, float radius, SphereCollision &as_col);
     int CheckRayCollisionCharacters(const vec3 &start, const vec3 &end, vec3 *point, vec3 *normal, int *bone);
+    // Call when a character's collision world moves, or characters come and go
+    void InvalidateCharacterBounds() { character_bounds_dirty_ = true; }
     void GetPlayerCharacterIDs(int *num_avatars, int avatar_ids[], int max_avatars);
     void GetNPCCharacterIDs(int *num_avatars, int avatar_ids[], int max_avatars);
     void GetCharacterIDs(int *num_avatars, int avatar_ids[], int max_avatars);
@@ -260,6 +269,29 @@ class SceneGraph {
     void PreloadShaders();
 
    private:
+    Collision LineCheckClosest(const vec3 &start, const vec3 &end, bool collidable_only, Object *not_hit);
+    void InsertLineCheckProxy(Object *obj);
+    void RemoveLineCheckProxy(Object *obj);
+
+    // Broadphase for line checks against objects_, objects without bounds are kept in a list instead
+    AABBTree line_check_tree_;
+    object_list unbounded_line_check_objects_;
+
+    // Bounding spheres of the movement_objects_ collision worlds, in the same order, rebuilt on demand
+    void RefreshCharacterBounds();
+    BoundingSphereArray character_bounds_;
+    std::vector<int> character_candidates_;
+    bool character_bounds_dirty_;
+
+    // Where the players and cameras are, for the bullet worlds' simulation LOD
+    void UpdateSimulationFocus();
+    std::vector<vec3> simulation_focus_;
+
+    // Characters whose update was split around the parallel animation evaluation
+    void UpdateCharacterAnimation(float timestep);
+    std::vector<int> split_update_ids_;
+    std::vector<RiggedObject *> animation_evaluations_;
+
     bool visible_objects_need_sort;
     bool queued_level_reset_;
     typedef std::vector<Object *> IDMap;
@@ -0,0 +1,392 @@
+//-----------------------------------------------------------------------------
+//           Name: aabbtree.cpp
+//      Developer: Wolfire Games LLC
+//    Description: Dynamic bounding box tree for proxies that are added,
+//                 moved and removed at runtime.
+//        License: Read below
+//-----------------------------------------------------------------------------
+//
+//
+//   Copyright 2022 Wolfire Games LLC
+//
+//   Licensed under the Apache License, Version 2.0 (the "License");
+//   you may not use this file except in compliance with the License.
+//   You may obtain a copy of the License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//   Unless required by applicable law or agreed to in writing, software
+//   distributed under the License is distributed on an "AS IS" BASIS,
+//   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//   See the License for the specific language governing permissions and
+//   limitations under the License.
+//
+//-----------------------------------------------------------------------------
+#include "aabbtree.h"
+
+#include <Math/vec3math.h>
+#include <Utility/assert.h>
+
+#include <algorithm>
+#include <cmath>
+
+const float AABBTree::kMargin = 0.1f;
+
+static const int kMaxTraversalDepth = 256;
+
+static float HalfArea(const vec3& min, const vec3& max) {
+    float x = max[0] - min[0], y = max[1] - min[1], z = max[2] - min[2];
+    return x * y + y * z + z * x;
+}
+
+static float UnionHalfArea(const AABBTreeNode& a, const AABBTreeNode& b) {
+    vec3 min, max;
+    for (int i = 0; i < 3; i++) {
+        min[i] = std::min(a.min[i], b.min[i]);
+        max[i] = std::max(a.max[i], b.max[i]);
+    }
+    return HalfArea(min, max);
+}
+
+static void SetUnion(AABBTreeNode& dst, const AABBTreeNode& a, const AABBTreeNode& b) {
+    for (int i = 0; i < 3; i++) {
+        dst.min[i] = std::min(a.min[i], b.min[i]);
+        dst.max[i] = std::max(a.max[i], b.max[i]);
+    }
+}
+
+static bool Contains(const AABBTreeNode& node, const vec3& min, const vec3& max) {
+    for (int i = 0; i < 3; i++) {
+        if (min[i] < node.min[i] || max[i] > node.max[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Slab test, returns the fraction of the segment where it enters the box
+static bool SegmentEntry(const vec3& start, const vec3& inv_dir, const AABBTreeNode& node, float max_fraction, float* entry) {
+    float t_min = 0.0f;
+    float t_max = max_fraction;
+    for (int i = 0; i < 3; i++) {
+        float t1 = (node.min[i] - start[i]) * inv_dir[i];
+        float t2 = (node.max[i] - start[i]) * inv_dir[i];
+        if (t1 > t2) {
+            std::swap(t1, t2);
+        }
+        t_min = std::max(t_min, t1);
+        t_max = std::min(t_max, t2);
+        if (t_min > t_max) {
+            return false;
+        }
+    }
+    *entry = t_min;
+    return true;
+}
+
+AABBTree::AABBTree()
+    : root(-1),
+      free_list(-1),
+      num_proxies(0) {
+}
+
+void AABBTree::Clear() {
+    nodes.clear();
+    root = -1;
+    free_list = -1;
+    num_proxies = 0;
+}
+
+int AABBTree::GetHeight() const {
+    return root == -1 ? 0 : nodes[root].height;
+}
+
+int AABBTree::AllocateNode() {
+    int node;
+    if (free_list == -1) {
+        node = (int)nodes.size();
+        nodes.push_back(AABBTreeNode());
+    } else {
+        node = free_list;
+        free_list = nodes[node].parent;
+    }
+    AABBTreeNode& n = nodes[node];
+    n.user_data = NULL;
+    n.parent = -1;
+    n.children[0] = -1;
+    n.children[1] = -1;
+    n.height = 0;
+    return node;
+}
+
+void AABBTree::FreeNode(int node) {
+    nodes[node].parent = free_list;
+    nodes[node].height = -1;
+    free_list = node;
+}
+
+int AABBTree::CreateProxy(const vec3& min, const vec3& max, void* user_data) {
+    int proxy = AllocateNode();
+    AABBTreeNode& node = nodes[proxy];
+    node.min = min - vec3(kMargin);
+    node.max = max + vec3(kMargin);
+    node.user_data = user_data;
+    InsertLeaf(proxy);
+    num_proxies++;
+    return proxy;
+}
+
+void AABBTree::DestroyProxy(int proxy) {
+    LOG_ASSERT(proxy >= 0 && proxy < (int)nodes.size() && nodes[proxy].height == 0);
+    RemoveLeaf(proxy);
+    FreeNode(proxy);
+    num_proxies--;
+}
+
+bool AABBTree::MoveProxy(int proxy, const vec3& min, const vec3& max) {
+    LOG_ASSERT(proxy >= 0 && proxy < (int)nodes.size() && nodes[proxy].height == 0);
+    if (Contains(nodes[proxy], min, max)) {
+        return false;
+    }
+    RemoveLeaf(proxy);
+    nodes[proxy].min = min - vec3(kMargin);
+    nodes[proxy].max = max + vec3(kMargin);
+    InsertLeaf(proxy);
+    return true;
+}
+
+void AABBTree::InsertLeaf(int leaf) {
+    if (root == -1) {
+        root = leaf;
+        nodes[root].parent = -1;
+        return;
+    }
+
+    // Walk down to the sibling that adds the least surface area to the tree
+    const AABBTreeNode& leaf_node = nodes[leaf];
+    int index = root;
+    while (nodes[index].height > 0) {
+        const AABBTreeNode& node = nodes[index];
+        float area = HalfArea(node.min, node.max);
+        float combined_area = UnionHalfArea(node, leaf_node);
+        float cost = 2.0f * combined_area;
+        float inheritance_cost = 2.0f * (combined_area - area);
+
+        float child_costs[2];
+        for (int i = 0; i < 2; i++) {
+            const AABBTreeNode& child = nodes[node.children[i]];
+            child_costs[i] = UnionHalfArea(child, leaf_node) + inheritance_cost;
+            if (child.height > 0) {
+                child_costs[i] -= HalfArea(child.min, child.max);
+            }
+        }
+        if (cost < child_costs[0] && cost < child_costs[1]) {
+            break;
+        }
+        index = child_costs[0] < child_costs[1] ? node.children[0] : node.children[1];
+    }
+    int sibling = index;
+
+    int old_parent = nodes[sibling].parent;
+    int new_parent = AllocateNode();
+    AABBTreeNode& parent_node = nodes[new_parent];
+    parent_node.parent = old_parent;
+    SetUnion(parent_node, nodes[leaf], nodes[sibling]);
+    parent_node.height = nodes[sibling].height + 1;
+    parent_node.children[0] = sibling;
+    parent_node.children[1] = leaf;
+    nodes[sibling].parent = new_parent;
+    nodes[leaf].parent = new_parent;
+    if (old_parent != -1) {
+        AABBTreeNode& old_parent_node = nodes[old_parent];
+        old_parent_node.children[old_parent_node.children[0] == sibling ? 0 : 1] = new_parent;
+    } else {
+        root = new_parent;
+    }
+
+    RefitUpwards(nodes[leaf].parent);
+}
+
+void AABBTree::RemoveLeaf(int leaf) {
+    if (leaf == root) {
+        root = -1;
+        return;
+    }
+
+    int parent = nodes[leaf].parent;
+    int grand_parent = nodes[parent].parent;
+    int sibling = nodes[parent].children[0] == leaf ? nodes[parent].children[1] : nodes[parent].children[0];
+    FreeNode(parent);
+    if (grand_parent != -1) {
+        AABBTreeNode& grand_parent_node = nodes[grand_parent];
+        grand_parent_node.children[grand_parent_node.children[0] == parent ? 0 : 1] = sibling;
+        nodes[sibling].parent = grand_parent;
+        RefitUpwards(grand_parent);
+    } else {
+        root = sibling;
+        nodes[sibling].parent = -1;
+    }
+}
+
+void AABBTree::RefitUpwards(int index) {
+    while (index != -1) {
+        index = Balance(index);
+        AABBTreeNode& node = nodes[index];
+        const AABBTreeNode& a = nodes[node.children[0]];
+        const AABBTreeNode& b = nodes[node.children[1]];
+        node.height = 1 + std::max(a.height, b.height);
+        SetUnion(node, a, b);
+        index = node.parent;
+    }
+}
+
+// Rotates the taller child of node_a up if the children differ in height by
+// more than one, returns the index of the new subtree root.
+int AABBTree::Balance(int node_a) {
+    AABBTreeNode& a = nodes[node_a];
+    if (a.height < 2) {
+        return node_a;
+    }
+
+    int node_b = a.children[0];
+    int node_c = a.children[1];
+    AABBTreeNode& b = nodes[node_b];
+    AABBTreeNode& c = nodes[node_c];
+    int balance = c.height - b.height;
+
+    if (balance > 1) {
+        // Rotate c up
+        int node_f = c.children[0];
+        int node_g = c.children[1];
+        AABBTreeNode& f = nodes[node_f];
+        AABBTreeNode& g = nodes[node_g];
+
+        c.children[0] = node_a;
+        c.parent = a.parent;
+        a.parent = node_c;
+        if (c.parent != -1) {
+            AABBTreeNode& parent = nodes[c.parent];
+            parent.children[parent.children[0] == node_a ? 0 : 1] = node_c;
+        } else {
+            root = node_c;
+        }
+
+        if (f.height > g.height) {
+            c.children[1] = node_f;
+            a.children[1] = node_g;
+            g.parent = node_a;
+            SetUnion(a, b, g);
+            SetUnion(c, a, f);
+            a.height = 1 + std::max(b.height, g.height);
+            c.height = 1 + std::max(a.height, f.height);
+        } else {
+            c.children[1] = node_g;
+            a.children[1] = node_f;
+            f.parent = node_a;
+            SetUnion(a, b, f);
+            SetUnion(c, a, g);
+            a.height = 1 + std::max(b.height, f.height);
+            c.height = 1 + std::max(a.height, g.height);
+        }
+        return node_c;
+    }
+
+    if (balance < -1) {
+        // Rotate b up
+        int node_d = b.children[0];
+        int node_e = b.children[1];
+        AABBTreeNode& d = nodes[node_d];
+        AABBTreeNode& e = nodes[node_e];
+
+        b.children[0] = node_a;
+        b.parent = a.parent;
+        a.parent = node_b;
+        if (b.parent != -1) {
+            AABBTreeNode& parent = nodes[b.parent];
+            parent.children[parent.children[0] == node_a ? 0 : 1] = node_b;
+        } else {
+            root = node_b;
+        }
+
+        if (d.height > e.height) {
+            b.children[1] = node_d;
+            a.children[0] = node_e;
+            e.parent = node_a;
+            SetUnion(a, c, e);
+            SetUnion(b, a, d);
+            a.height = 1 + std::max(c.height, e.height);
+            b.height = 1 + std::max(a.height, d.height);
+        } else {
+            b.children[1] = node_e;
+            a.children[0] = node_d;
+            d.parent = node_a;
+            SetUnion(a, c, d);
+            SetUnion(b, a, e);
+            a.height = 1 + std::max(c.height, d.height);
+            b.height = 1 + std::max(a.height, e.height);
+        }
+        return node_b;
+    }
+
+    return node_a;
+}
+
+void AABBTree::RayCast(const vec3& start, const vec3& end, AABBTreeRayCallback* callback, float max_fraction) const {
+    if (root == -1 || max_fraction <= 0.0f) {
+        return;
+    }
+
+    vec3 inv_dir;
+    for (int i = 0; i < 3; i++) {
+        float dir = end[i] - start[i];
+        // Axis parallel segments get a huge but finite slope, so the slab test needs no special case
+        inv_dir[i] = std::fabs(dir) > 1e-20f ? 1.0f / dir : 1e20f;
+    }
+
+    struct StackEntry {
+        int node;
+        float entry;
+    };
+    StackEntry stack[kMaxTraversalDepth];
+    int stack_size = 0;
+
+    float entry;
+    if (!SegmentEntry(start, inv_dir, nodes[root], max_fraction, &entry)) {
+        return;
+    }
+    stack[stack_size].node = root;
+    stack[stack_size].entry = entry;
+    stack_size++;
+
+    while (stack_size > 0) {
+        stack_size--;
+        if (stack[stack_size].entry > max_fraction) {
+            continue;  // Behind the closest hit found since it was pushed
+        }
+        const AABBTreeNode& node = nodes[stack[stack_size].node];
+        if (node.height == 0) {
+            max_fraction = std::min(max_fraction, callback->Process(node.user_data, max_fraction));
+            if (max_fraction <= 0.0f) {
+                return;
+            }
+            continue;
+        }
+
+        float entries[2];
+        bool hit[2];
+        for (int i = 0; i < 2; i++) {
+            hit[i] = SegmentEntry(start, inv_dir, nodes[node.children[i]], max_fraction, &entries[i]);
+        }
+        // Push the far child first so the near one is searched first
+        int near = (hit[0] && hit[1] && entries[1] < entries[0]) ? 1 : 0;
+        int order[2] = {1 - near, near};
+        for (int i : order) {
+            if (hit[i]) {
+                LOG_ASSERT(stack_size < kMaxTraversalDepth);
+                stack[stack_size].node = node.children[i];
+                stack[stack_size].entry = entries[i];
+                stack_size++;
+            }
+        }
+    }
+}
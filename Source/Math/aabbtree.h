@@ -0,0 +1,87 @@
+//-----------------------------------------------------------------------------
+//           Name: aabbtree.h
+//      Developer: Wolfire Games LLC
+//    Description: Dynamic bounding box tree for proxies that are added,
+//                 moved and removed at runtime.
+//        License: Read below
+//-----------------------------------------------------------------------------
+//
+//
+//   Copyright 2022 Wolfire Games LLC
+//
+//   Licensed under the Apache License, Version 2.0 (the "License");
+//   you may not use this file except in compliance with the License.
+//   You may obtain a copy of the License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//   Unless required by applicable law or agreed to in writing, software
+//   distributed under the License is distributed on an "AS IS" BASIS,
+//   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//   See the License for the specific language governing permissions and
+//   limitations under the License.
+//
+//-----------------------------------------------------------------------------
+#pragma once
+
+#include <Math/vec3.h>
+
+#include <vector>
+
+struct AABBTreeNode {
+    vec3 min;
+    vec3 max;
+    void* user_data;
+    int parent;  // Next entry of the free list for unused nodes
+    int children[2];
+    int height;  // Zero for leaves, -1 for unused nodes
+};
+
+class AABBTreeRayCallback {
+   public:
+    virtual ~AABBTreeRayCallback() {}
+    // Called for each proxy whose box the segment crosses, nearest box first.
+    // Returns the fraction of the segment that still has to be searched, so a
+    // closest hit query returns the fraction of its best hit so far.
+    virtual float Process(void* user_data, float max_fraction) = 0;
+};
+
+/*
+ * Leaves store their bounds grown by a margin, so small movements don't
+ * touch the tree at all. Leaves are inserted next to the sibling that grows
+ * the total surface area the least, and the tree is kept balanced with
+ * rotations on the way back up, like the broadphase in Box2D.
+ */
+class AABBTree {
+   public:
+    AABBTree();
+
+    // Returns the proxy id, stable until DestroyProxy.
+    int CreateProxy(const vec3& min, const vec3& max, void* user_data);
+    void DestroyProxy(int proxy);
+    // Returns true if the proxy had to be reinserted.
+    bool MoveProxy(int proxy, const vec3& min, const vec3& max);
+    void Clear();
+
+    void* GetUserData(int proxy) const { return nodes[proxy].user_data; }
+    int GetNumProxies() const { return num_proxies; }
+    int GetHeight() const;
+
+    // Proxies entered past max_fraction of the segment are skipped.
+    void RayCast(const vec3& start, const vec3& end, AABBTreeRayCallback* callback, float max_fraction = 1.0f) const;
+
+    static const float kMargin;
+
+   private:
+    int AllocateNode();
+    void FreeNode(int node);
+    void InsertLeaf(int leaf);
+    void RemoveLeaf(int leaf);
+    int Balance(int node);
+    void RefitUpwards(int node);
+
+    std::vector<AABBTreeNode> nodes;
+    int root;
+    int free_list;
+    int num_proxies;
+};
@@ -0,0 +1,107 @@
+//-----------------------------------------------------------------------------
+//           Name: boundingspheres.cpp
+//      Developer: Wolfire Games LLC
+//    Description: Flat arrays of bounding spheres for rejecting most of a
+//                 small set of objects before an expensive query.
+//        License: Read below
+//-----------------------------------------------------------------------------
+//
+//
+//   Copyright 2022 Wolfire Games LLC
+//
+//   Licensed under the Apache License, Version 2.0 (the "License");
+//   you may not use this file except in compliance with the License.
+//   You may obtain a copy of the License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//   Unless required by applicable law or agreed to in writing, software
+//   distributed under the License is distributed on an "AS IS" BASIS,
+//   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//   See the License for the specific language governing permissions and
+//   limitations under the License.
+//
+//-----------------------------------------------------------------------------
+#include "boundingspheres.h"
+
+#include <Math/vec3math.h>
+
+#include <xmmintrin.h>
+
+BoundingSphereArray::BoundingSphereArray() : count(0) {
+}
+
+void BoundingSphereArray::Clear() {
+    count = 0;
+    center_x.clear();
+    center_y.clear();
+    center_z.clear();
+    radius.clear();
+}
+
+int BoundingSphereArray::Add(const vec3& center, float sphere_radius) {
+    int index = count++;
+    if (index == (int)radius.size()) {
+        // Grow by a whole group, the unused entries can't be hit
+        center_x.resize(index + 4, 0.0f);
+        center_y.resize(index + 4, 0.0f);
+        center_z.resize(index + 4, 0.0f);
+        radius.resize(index + 4, -1.0f);
+    }
+    Set(index, center, sphere_radius);
+    return index;
+}
+
+void BoundingSphereArray::Set(int index, const vec3& center, float sphere_radius) {
+    center_x[index] = center[0];
+    center_y[index] = center[1];
+    center_z[index] = center[2];
+    radius[index] = sphere_radius;
+}
+
+void BoundingSphereArray::SegmentQuery(const vec3& start, const vec3& end, float sweep_radius, std::vector<int>* hits) const {
+    vec3 dir = end - start;
+    float length_squared = dot(dir, dir);
+    // A zero length segment is tested as a point
+    float inv_length_squared = length_squared > 0.0f ? 1.0f / length_squared : 0.0f;
+
+    __m128 start_x = _mm_set1_ps(start[0]);
+    __m128 start_y = _mm_set1_ps(start[1]);
+    __m128 start_z = _mm_set1_ps(start[2]);
+    __m128 dir_x = _mm_set1_ps(dir[0]);
+    __m128 dir_y = _mm_set1_ps(dir[1]);
+    __m128 dir_z = _mm_set1_ps(dir[2]);
+    __m128 inv_len_sq = _mm_set1_ps(inv_length_squared);
+    __m128 sweep = _mm_set1_ps(sweep_radius);
+    __m128 zero = _mm_setzero_ps();
+    __m128 one = _mm_set1_ps(1.0f);
+
+    for (int i = 0; i < count; i += 4) {
+        __m128 to_center_x = _mm_sub_ps(_mm_loadu_ps(&center_x[i]), start_x);
+        __m128 to_center_y = _mm_sub_ps(_mm_loadu_ps(&center_y[i]), start_y);
+        __m128 to_center_z = _mm_sub_ps(_mm_loadu_ps(&center_z[i]), start_z);
+        // Closest point on the segment to each center
+        __m128 t = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(to_center_x, dir_x),
+                                                    _mm_mul_ps(to_center_y, dir_y)),
+                                         _mm_mul_ps(to_center_z, dir_z)),
+                              inv_len_sq);
+        t = _mm_min_ps(_mm_max_ps(t, zero), one);
+        __m128 offset_x = _mm_sub_ps(to_center_x, _mm_mul_ps(t, dir_x));
+        __m128 offset_y = _mm_sub_ps(to_center_y, _mm_mul_ps(t, dir_y));
+        __m128 offset_z = _mm_sub_ps(to_center_z, _mm_mul_ps(t, dir_z));
+        __m128 dist_squared = _mm_add_ps(_mm_add_ps(_mm_mul_ps(offset_x, offset_x),
+                                                    _mm_mul_ps(offset_y, offset_y)),
+                                         _mm_mul_ps(offset_z, offset_z));
+        __m128 reach = _mm_add_ps(_mm_loadu_ps(&radius[i]), sweep);
+        __m128 touching = _mm_and_ps(_mm_cmple_ps(dist_squared, _mm_mul_ps(reach, reach)),
+                                     _mm_cmpge_ps(_mm_loadu_ps(&radius[i]), zero));
+        int mask = _mm_movemask_ps(touching);
+        if (mask) {
+            for (int lane = 0; lane < 4; ++lane) {
+                if (mask & (1 << lane)) {
+                    hits->push_back(i + lane);
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,56 @@
+//-----------------------------------------------------------------------------
+//           Name: boundingspheres.h
+//      Developer: Wolfire Games LLC
+//    Description: Flat arrays of bounding spheres for rejecting most of a
+//                 small set of objects before an expensive query.
+//        License: Read below
+//-----------------------------------------------------------------------------
+//
+//
+//   Copyright 2022 Wolfire Games LLC
+//
+//   Licensed under the Apache License, Version 2.0 (the "License");
+//   you may not use this file except in compliance with the License.
+//   You may obtain a copy of the License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//   Unless required by applicable law or agreed to in writing, software
+//   distributed under the License is distributed on an "AS IS" BASIS,
+//   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//   See the License for the specific language governing permissions and
+//   limitations under the License.
+//
+//-----------------------------------------------------------------------------
+#pragma once
+
+#include <Math/vec3.h>
+
+#include <vector>
+
+/*
+ * Sphere centers and radii are kept in separate arrays, padded to a
+ * multiple of four, so a segment is tested against four spheres at a time
+ * with SSE. Spheres with a negative radius are never hit, which keeps the
+ * indices lined up with whatever list the spheres were built from.
+ */
+class BoundingSphereArray {
+   public:
+    BoundingSphereArray();
+
+    void Clear();
+    // Returns the index of the new sphere
+    int Add(const vec3& center, float radius);
+    void Set(int index, const vec3& center, float radius);
+    int size() const { return count; }
+
+    // Appends, in index order, every sphere that a sphere of sweep_radius moving from start to end touches
+    void SegmentQuery(const vec3& start, const vec3& end, float sweep_radius, std::vector<int>* hits) const;
+
+   private:
+    int count;
+    std::vector<float> center_x;
+    std::vector<float> center_y;
+    std::vector<float> center_z;
+    std::vector<float> radius;
+};
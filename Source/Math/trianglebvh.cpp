@@ -0,0 +1,362 @@
+//-----------------------------------------------------------------------------
+//           Name: trianglebvh.cpp
+//      Developer: Wolfire Games LLC
+//    Description:
+//        License: Read below
+//-----------------------------------------------------------------------------
+//
+//
+//   Copyright 2022 Wolfire Games LLC
+//
+//   Licensed under the Apache License, Version 2.0 (the "License");
+//   you may not use this file except in compliance with the License.
+//   You may obtain a copy of the License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//   Unless required by applicable law or agreed to in writing, software
+//   distributed under the License is distributed on an "AS IS" BASIS,
+//   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//   See the License for the specific language governing permissions and
+//   limitations under the License.
+//
+//-----------------------------------------------------------------------------
+#include "trianglebvh.h"
+
+#include <Internal/collisiondetection.h>
+#include <Internal/profiler.h>
+#include <Math/vec3math.h>
+
+#include <xmmintrin.h>
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+static const int kNumBins = 16;
+static const int kMinSplitTriangles = 3;   // Fewer than this are always a leaf
+static const int kMaxLeafTriangles = 8;    // More than this are always split
+static const int kMaxSAHDepth = 64;        // Below this, split at the median to bound the depth
+static const int kMaxTraversalDepth = 128;
+static const float kTraversalCost = 1.0f;  // Relative to one triangle test
+
+namespace {
+struct Bounds {
+    float min[3];
+    float max[3];
+
+    void Reset() {
+        for (int i = 0; i < 3; i++) {
+            min[i] = FLT_MAX;
+            max[i] = -FLT_MAX;
+        }
+    }
+
+    void Grow(const float* point_min, const float* point_max) {
+        for (int i = 0; i < 3; i++) {
+            min[i] = std::min(min[i], point_min[i]);
+            max[i] = std::max(max[i], point_max[i]);
+        }
+    }
+
+    float HalfArea() const {
+        if (min[0] > max[0]) {
+            return 0.0f;
+        }
+        float x = max[0] - min[0], y = max[1] - min[1], z = max[2] - min[2];
+        return x * y + y * z + z * x;
+    }
+};
+
+struct Bin {
+    Bounds bounds;
+    int count;
+};
+}  // namespace
+
+TriangleBVH::TriangleBVH() {
+}
+
+void TriangleBVH::Clear() {
+    nodes.clear();
+    triangles.clear();
+}
+
+void TriangleBVH::Build(const float* vertices, const unsigned* faces, int num_faces) {
+    PROFILER_ZONE(g_profiler_ctx, "TriangleBVH::Build");
+    Clear();
+    if (num_faces <= 0) {
+        return;
+    }
+
+    std::vector<BuildTriangle> build(num_faces);
+    for (int i = 0; i < num_faces; i++) {
+        BuildTriangle& tri = build[i];
+        const float* a = &vertices[faces[i * 3 + 0] * 3];
+        const float* b = &vertices[faces[i * 3 + 1] * 3];
+        const float* c = &vertices[faces[i * 3 + 2] * 3];
+        for (int k = 0; k < 3; k++) {
+            tri.min[k] = std::min(a[k], std::min(b[k], c[k]));
+            tri.max[k] = std::max(a[k], std::max(b[k], c[k]));
+            tri.centroid[k] = (tri.min[k] + tri.max[k]) * 0.5f;
+        }
+        tri.face = (uint32_t)i;
+    }
+
+    nodes.reserve(num_faces * 2);
+    triangles.reserve(num_faces);
+    BuildNode(build, 0, num_faces, 0);
+}
+
+void TriangleBVH::BuildNode(std::vector<BuildTriangle>& build, int begin, int end, int depth) {
+    int node_index = (int)nodes.size();
+    nodes.resize(nodes.size() + 1);
+
+    Bounds bounds, centroid_bounds;
+    bounds.Reset();
+    centroid_bounds.Reset();
+    for (int i = begin; i < end; i++) {
+        bounds.Grow(build[i].min, build[i].max);
+        centroid_bounds.Grow(build[i].centroid, build[i].centroid);
+    }
+    for (int k = 0; k < 3; k++) {
+        nodes[node_index].min[k] = bounds.min[k];
+        nodes[node_index].max[k] = bounds.max[k];
+    }
+
+    int count = end - begin;
+    int split_axis = -1;
+    int split_bin = 0;
+    float split_cost = FLT_MAX;
+    if (count >= kMinSplitTriangles && depth < kMaxSAHDepth) {
+        for (int axis = 0; axis < 3; axis++) {
+            float extent = centroid_bounds.max[axis] - centroid_bounds.min[axis];
+            if (extent <= 0.0f) {
+                continue;
+            }
+            float scale = kNumBins / extent;
+
+            Bin bins[kNumBins];
+            for (int b = 0; b < kNumBins; b++) {
+                bins[b].bounds.Reset();
+                bins[b].count = 0;
+            }
+            for (int i = begin; i < end; i++) {
+                int b = std::min(kNumBins - 1, (int)((build[i].centroid[axis] - centroid_bounds.min[axis]) * scale));
+                bins[b].bounds.Grow(build[i].min, build[i].max);
+                bins[b].count++;
+            }
+
+            // Sweep from the right to get the cost of everything above each split
+            float right_cost[kNumBins];
+            Bounds right;
+            right.Reset();
+            int right_count = 0;
+            for (int b = kNumBins - 1; b > 0; b--) {
+                right.Grow(bins[b].bounds.min, bins[b].bounds.max);
+                right_count += bins[b].count;
+                right_cost[b] = right.HalfArea() * right_count;
+            }
+
+            Bounds left;
+            left.Reset();
+            int left_count = 0;
+            for (int b = 0; b < kNumBins - 1; b++) {
+                left.Grow(bins[b].bounds.min, bins[b].bounds.max);
+                left_count += bins[b].count;
+                if (left_count == 0 || left_count == count) {
+                    continue;
+                }
+                float cost = left.HalfArea() * left_count + right_cost[b + 1];
+                if (cost < split_cost) {
+                    split_cost = cost;
+                    split_axis = axis;
+                    split_bin = b + 1;
+                }
+            }
+        }
+    }
+
+    float leaf_cost = bounds.HalfArea() * count;
+    split_cost += kTraversalCost * bounds.HalfArea();
+
+    int mid = -1;
+    if (split_axis != -1 && (split_cost < leaf_cost || count > kMaxLeafTriangles)) {
+        float extent = centroid_bounds.max[split_axis] - centroid_bounds.min[split_axis];
+        float scale = kNumBins / extent;
+        float min = centroid_bounds.min[split_axis];
+        BuildTriangle* split = std::partition(&build[begin], &build[0] + end, [=](const BuildTriangle& tri) {
+            return std::min(kNumBins - 1, (int)((tri.centroid[split_axis] - min) * scale)) < split_bin;
+        });
+        mid = (int)(split - &build[0]);
+    } else if (count > kMaxLeafTriangles) {
+        // No useful split, either too deep or all the centroids are in the same place
+        int axis = 0;
+        for (int k = 1; k < 3; k++) {
+            if (centroid_bounds.max[k] - centroid_bounds.min[k] > centroid_bounds.max[axis] - centroid_bounds.min[axis]) {
+                axis = k;
+            }
+        }
+        mid = begin + count / 2;
+        std::nth_element(&build[begin], &build[mid], &build[0] + end, [=](const BuildTriangle& a, const BuildTriangle& b) {
+            return a.centroid[axis] < b.centroid[axis];
+        });
+    }
+
+    if (mid <= begin || mid >= end) {
+        nodes[node_index].first = (uint32_t)triangles.size();
+        nodes[node_index].count = (uint32_t)count;
+        for (int i = begin; i < end; i++) {
+            triangles.push_back(build[i].face);
+        }
+        return;
+    }
+
+    nodes[node_index].count = 0;
+    BuildNode(build, begin, mid, depth + 1);
+    nodes[node_index].first = (uint32_t)nodes.size();
+    BuildNode(build, mid, end, depth + 1);
+}
+
+bool TriangleBVH::Assign(const TriangleBVHNode* new_nodes, int num_nodes, const uint32_t* new_triangles, int num_triangles, int num_faces) {
+    Clear();
+    if (num_nodes <= 0 || num_triangles != num_faces) {
+        return false;
+    }
+    for (int i = 0; i < num_triangles; i++) {
+        if (new_triangles[i] >= (uint32_t)num_faces) {
+            return false;
+        }
+    }
+    for (int i = 0; i < num_nodes; i++) {
+        const TriangleBVHNode& node = new_nodes[i];
+        if (node.count > 0) {
+            if (node.first > (uint32_t)num_triangles || node.count > (uint32_t)num_triangles - node.first) {
+                return false;
+            }
+        } else if (node.first <= (uint32_t)i + 1 || node.first >= (uint32_t)num_nodes) {
+            return false;
+        }
+    }
+    nodes.assign(new_nodes, new_nodes + num_nodes);
+    triangles.assign(new_triangles, new_triangles + num_triangles);
+    return true;
+}
+
+// Slab test of the segment against a node's box, four lanes at a time.
+// Returns the entry distance along the segment, or a negative value on a miss.
+static inline float IntersectNode(const TriangleBVHNode& node, __m128 origin, __m128 inv_dir, float t_max) {
+    __m128 t0 = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(node.min), origin), inv_dir);
+    __m128 t1 = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(node.max), origin), inv_dir);
+    __m128 near_t = _mm_min_ps(t0, t1);
+    __m128 far_t = _mm_max_ps(t0, t1);
+    // The fourth lane holds first or count, leave it out
+    __m128 entry = _mm_max_ss(_mm_max_ss(near_t, _mm_shuffle_ps(near_t, near_t, _MM_SHUFFLE(1, 1, 1, 1))),
+                              _mm_max_ss(_mm_shuffle_ps(near_t, near_t, _MM_SHUFFLE(2, 2, 2, 2)), _mm_setzero_ps()));
+    __m128 exit = _mm_min_ss(_mm_min_ss(far_t, _mm_shuffle_ps(far_t, far_t, _MM_SHUFFLE(1, 1, 1, 1))),
+                             _mm_min_ss(_mm_shuffle_ps(far_t, far_t, _MM_SHUFFLE(2, 2, 2, 2)), _mm_set_ss(t_max)));
+    float entry_t = _mm_cvtss_f32(entry);
+    return entry_t <= _mm_cvtss_f32(exit) ? entry_t : -1.0f;
+}
+
+int TriangleBVH::LineCheck(const vec3& start, const vec3& end, const float* vertices, const unsigned* faces, const vec3* face_normals,
+                           vec3* point, vec3* normal) const {
+    if (nodes.empty()) {
+        return -1;
+    }
+
+    vec3 dir = end - start;
+    float dir_length_squared = dot(dir, dir);
+    if (dir_length_squared == 0.0f) {
+        return -1;
+    }
+
+    float inv[4];
+    for (int k = 0; k < 3; k++) {
+        // Keep the slab distances finite for axis aligned segments
+        float d = std::fabs(dir[k]) < 1e-20f ? (dir[k] < 0.0f ? -1e-20f : 1e-20f) : dir[k];
+        inv[k] = 1.0f / d;
+    }
+    inv[3] = 0.0f;
+    __m128 origin = _mm_set_ps(0.0f, start[2], start[1], start[0]);
+    __m128 inv_dir = _mm_loadu_ps(inv);
+
+    int closest = -1;
+    float closest_distance = 0.0f;
+    float t_max = 1.0f;
+    vec3 segment_end = end;
+    vec3 hit;
+    vec3 points[3];
+
+    struct StackEntry {
+        int node;
+        float entry_t;
+    };
+    StackEntry stack[kMaxTraversalDepth];
+    int stack_size = 0;
+    float root_t = IntersectNode(nodes[0], origin, inv_dir, t_max);
+    if (root_t >= 0.0f) {
+        stack[stack_size].node = 0;
+        stack[stack_size].entry_t = root_t;
+        stack_size++;
+    }
+
+    while (stack_size > 0) {
+        StackEntry entry = stack[--stack_size];
+        if (entry.entry_t > t_max) {
+            // A closer hit was found since this node was pushed
+            continue;
+        }
+        int node_index = entry.node;
+        const TriangleBVHNode& node = nodes[node_index];
+        if (node.count > 0) {
+            for (uint32_t i = node.first; i < node.first + node.count; i++) {
+                int face = (int)triangles[i];
+                for (int k = 0; k < 3; k++) {
+                    const float* vert = &vertices[faces[face * 3 + k] * 3];
+                    points[k] = vec3(vert[0], vert[1], vert[2]);
+                }
+                if (LineFacet(start, segment_end, points[0], points[1], points[2], &hit, face_normals[face])) {
+                    float distance = distance_squared(start, hit);
+                    if (closest == -1 || distance < closest_distance || (distance == closest_distance && face < closest)) {
+                        closest = face;
+                        closest_distance = distance;
+                        segment_end = hit;
+                        // Slightly past the hit, so boxes holding a face at the same distance still get tested for ties
+                        t_max = dot(hit - start, dir) / dir_length_squared * 1.0001f + 1e-6f;
+                    }
+                }
+            }
+            continue;
+        }
+
+        int children[2] = {node_index + 1, (int)node.first};
+        float child_t[2];
+        for (int c = 0; c < 2; c++) {
+            child_t[c] = IntersectNode(nodes[children[c]], origin, inv_dir, t_max);
+        }
+        // Push the far child first so the near one is popped next
+        int near_child = (child_t[1] >= 0.0f && (child_t[0] < 0.0f || child_t[1] < child_t[0])) ? 1 : 0;
+        int far_child = 1 - near_child;
+        if (child_t[far_child] >= 0.0f) {
+            stack[stack_size].node = children[far_child];
+            stack[stack_size].entry_t = child_t[far_child];
+            stack_size++;
+        }
+        if (child_t[near_child] >= 0.0f) {
+            stack[stack_size].node = children[near_child];
+            stack[stack_size].entry_t = child_t[near_child];
+            stack_size++;
+        }
+    }
+
+    if (closest != -1) {
+        if (point) {
+            *point = segment_end;
+        }
+        if (normal) {
+            *normal = face_normals[closest];
+        }
+    }
+    return closest;
+}
@@ -0,0 +1,77 @@
+//-----------------------------------------------------------------------------
+//           Name: trianglebvh.h
+//      Developer: Wolfire Games LLC
+//    Description: Bounding volume hierarchy over the triangles of a mesh,
+//                 for line checks that don't have to test every face.
+//        License: Read below
+//-----------------------------------------------------------------------------
+//
+//
+//   Copyright 2022 Wolfire Games LLC
+//
+//   Licensed under the Apache License, Version 2.0 (the "License");
+//   you may not use this file except in compliance with the License.
+//   You may obtain a copy of the License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//   Unless required by applicable law or agreed to in writing, software
+//   distributed under the License is distributed on an "AS IS" BASIS,
+//   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//   See the License for the specific language governing permissions and
+//   limitations under the License.
+//
+//-----------------------------------------------------------------------------
+#pragma once
+
+#include <Math/vec3.h>
+#include <Internal/integer.h>
+
+#include <vector>
+
+struct TriangleBVHNode {
+    float min[3];
+    // Leaves: first entry in TriangleBVH::triangles. Inner nodes: index of the
+    // second child, the first child is always the next node.
+    uint32_t first;
+    float max[3];
+    uint32_t count;  // Triangles in a leaf, zero for inner nodes
+};
+
+/*
+ * Built top down with binned surface area heuristic splits, nodes are laid
+ * out depth first in a single array. Traversal keeps its own stack and visits
+ * the nearer child first, so most faces behind the closest hit are never tested.
+ */
+class TriangleBVH {
+   public:
+    TriangleBVH();
+
+    void Build(const float* vertices, const unsigned* faces, int num_faces);
+    // Adopts a hierarchy loaded from a cache, returns false if it doesn't fit num_faces.
+    bool Assign(const TriangleBVHNode* nodes, int num_nodes, const uint32_t* triangles, int num_triangles, int num_faces);
+    void Clear();
+
+    bool IsBuilt() const { return !nodes.empty(); }
+    int GetNumFaces() const { return (int)triangles.size(); }
+
+    /*
+     * Same result as testing every face with LineFacet() in order: the index of
+     * the closest face hit, with the lowest index winning ties, or -1.
+     */
+    int LineCheck(const vec3& start, const vec3& end, const float* vertices, const unsigned* faces, const vec3* face_normals,
+                  vec3* point, vec3* normal) const;
+
+    std::vector<TriangleBVHNode> nodes;
+    std::vector<uint32_t> triangles;
+
+   private:
+    struct BuildTriangle {
+        float min[3];
+        float max[3];
+        float centroid[3];
+        uint32_t face;
+    };
+
+    void BuildNode(std::vector<BuildTriangle>& build, int begin, int end, int depth);
+};
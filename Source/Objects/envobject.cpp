@@ -1947,6 +1947,7 @@ bool EnvObject::SetFromDesc(const EntityDescription& desc) {
             vec3 max = model.max_coords;
             box_.center = model.center_coords;
             box_.dims = max - min;
+            LineCheckBoundsChanged();
         }
     }
     return ret;
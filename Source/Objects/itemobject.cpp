@@ -252,6 +252,7 @@ bool ItemObject::Initialize() {
     vec3 max = item_model.max_coords;
     box_.center = (max + min) * 0.5f;
     box_.dims = max - min;
+    LineCheckBoundsChanged();
 
     return true;
 }
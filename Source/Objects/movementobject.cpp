@@ -71,6 +71,7 @@
 #include <Logging/logdata.h>
 #include <UserInput/input.h>
 #include <AI/navmesh.h>
+#include <Timing/steptimings.h>
 
 #include <angelscript.h>
 #include <SDL.h>
@@ -869,6 +870,13 @@ void MovementObject::Moved(Object::MoveType type) {
 }
 
 void MovementObject::Update(float timestep) {
+    if (BeginUpdate(timestep)) {
+        rigged_object_->EvaluateAnimation();
+    }
+    FinishUpdate(timestep);
+}
+
+bool MovementObject::BeginUpdate(float timestep) {
     // GridTest(position, scenegraph_->bullet_world_, 0.45f);
     ThreadedSound* si = Engine::Instance()->GetSound();
     Online* online = Online::Instance();
@@ -938,6 +946,7 @@ void MovementObject::Update(float timestep) {
         args.Add(update_script_period);
         {
             PROFILER_ZONE(g_profiler_ctx, "Angelscript Update()");
+            ScopedStepTiming step_timing(StepTimings::kScripts);
 
             as_context->CallScriptFunction(as_funcs.update, &args);
             angle_script_ready = true;
@@ -1049,86 +1058,100 @@ void MovementObject::Update(float timestep) {
         vec3 ground_pos = position - vec3(0.0f, _leg_sphere_size + rigged_object_->floor_height, 0.0f);
         rigged_object_->SetTranslation(ground_pos);
         rigged_object_->static_char = static_char;
-        rigged_object_->Update(timestep);
-
-        position += rigged_object_->FetchCenterOffset();
-        float rot = rigged_object_->FetchRotation();
-        if (rot) {
-            mat4 rot_mat;
-            rot_mat.SetRotationY(rot);
-            rigged_object_->anim_client.SetRotationMatrix(
-                rot_mat * rigged_object_->anim_client.GetRotationMatrix());
-        }
+        finish_update_pending_ = true;
+        ScopedStepTiming step_timing(StepTimings::kAnimation);
+        return rigged_object_->BeginUpdate(timestep);
+    }
+    return false;
+}
 
-        char_sphere->SetPosition(position);
-        char_sphere->body->setInterpolationWorldTransform(char_sphere->body->getWorldTransform());
-        char_sphere->UpdateTransform();
-        char_sphere->Activate();
-        /*DebugDraw::Instance()->AddWireSphere(char_sphere->GetPosition(), _leg_sphere_size, vec3(1.0), _delete_on_update);
-        btVector3 min_val, max_val;
-        {
-                char_sphere->body->getAabb(min_val, max_val);
-                vec3 a(min_val[0], min_val[1], min_val[2]);
-                vec3 b(max_val[0], max_val[1], max_val[2]);
-                DebugDraw::Instance()->AddWireBox((b+a)*0.5, b-a, vec3(1.0), _delete_on_update);
-        }
-        {
-                min_val = char_sphere->body->getBroadphaseProxy()->m_aabbMin;
-                max_val = char_sphere->body->getBroadphaseProxy()->m_aabbMax;
-                vec3 a(min_val[0], min_val[1], min_val[2]);
-                vec3 b(max_val[0], max_val[1], max_val[2]);
-                DebugDraw::Instance()->AddWireBox((b+a)*0.5, b-a, vec3(1.0), _delete_on_update);
-        }*/
+void MovementObject::FinishUpdate(float timestep) {
+    // Clients got everything done in BeginUpdate()
+    if (!finish_update_pending_) {
+        return;
+    }
+    finish_update_pending_ = false;
 
-        /*if(Input::Instance()->getKeyboard().wasKeyPressed(SDLK_h)){
-                soft_body = scenegraph_->bullet_world_->AddCloth(position);
-                soft_body_attach = new btRigidBody(0.0f, NULL, NULL);
-                btTransform transform;
-                transform.setIdentity();
-                transform.setOrigin(btVector3(position[0], position[1], position[2]));
-                soft_body_attach->setWorldTransform(transform);
-                for(int i=0; i<31; ++i){
-                        soft_body->appendAnchor(i, soft_body_attach, btVector3(0+i*1.6/32.0f,0,0), false, 1.0f);
-                }
-        }
+    {
+        ScopedStepTiming step_timing(StepTimings::kAnimation);
+        rigged_object_->FinishUpdate(timestep);
+    }
 
-        if(soft_body){
-                int num_nodes = soft_body->m_nodes.size();
-                for(int i=0;i<num_nodes;++i) {
-                        const btVector3 &point = soft_body->m_nodes[i].m_x;
-                        DebugDraw::Instance()->AddWireSphere(vec3(point[0], point[1], point[2]), 0.01f, vec4(1.0f), _delete_on_update);
-                }
-                btTransform transform;
-                transform.setIdentity();
-                transform.setOrigin(btVector3(position[0], position[1]+0.5f, position[2]));
-                soft_body_attach->setWorldTransform(transform);
-        }*/
+    position += rigged_object_->FetchCenterOffset();
+    float rot = rigged_object_->FetchRotation();
+    if (rot) {
+        mat4 rot_mat;
+        rot_mat.SetRotationY(rot);
+        rigged_object_->anim_client.SetRotationMatrix(
+            rot_mat * rigged_object_->anim_client.GetRotationMatrix());
+    }
 
-        if (was_controlled != controlled && scenegraph_) {
-            std::vector<Object*>::iterator hotit;
-            for (hotit = scenegraph_->hotspots_.begin();
-                 hotit != scenegraph_->hotspots_.end();
-                 hotit++) {
-                Hotspot* hs = static_cast<Hotspot*>(*hotit);
-                if (controlled) {
-                    hs->HandleEvent("engaged_player_control", this);
-                } else {
-                    hs->HandleEvent("disengaged_player_control", this);
-                }
+    char_sphere->SetPosition(position);
+    char_sphere->body->setInterpolationWorldTransform(char_sphere->body->getWorldTransform());
+    char_sphere->UpdateTransform();
+    char_sphere->Activate();
+    /*DebugDraw::Instance()->AddWireSphere(char_sphere->GetPosition(), _leg_sphere_size, vec3(1.0), _delete_on_update);
+    btVector3 min_val, max_val;
+    {
+            char_sphere->body->getAabb(min_val, max_val);
+            vec3 a(min_val[0], min_val[1], min_val[2]);
+            vec3 b(max_val[0], max_val[1], max_val[2]);
+            DebugDraw::Instance()->AddWireBox((b+a)*0.5, b-a, vec3(1.0), _delete_on_update);
+    }
+    {
+            min_val = char_sphere->body->getBroadphaseProxy()->m_aabbMin;
+            max_val = char_sphere->body->getBroadphaseProxy()->m_aabbMax;
+            vec3 a(min_val[0], min_val[1], min_val[2]);
+            vec3 b(max_val[0], max_val[1], max_val[2]);
+            DebugDraw::Instance()->AddWireBox((b+a)*0.5, b-a, vec3(1.0), _delete_on_update);
+    }*/
+
+    /*if(Input::Instance()->getKeyboard().wasKeyPressed(SDLK_h)){
+            soft_body = scenegraph_->bullet_world_->AddCloth(position);
+            soft_body_attach = new btRigidBody(0.0f, NULL, NULL);
+            btTransform transform;
+            transform.setIdentity();
+            transform.setOrigin(btVector3(position[0], position[1], position[2]));
+            soft_body_attach->setWorldTransform(transform);
+            for(int i=0; i<31; ++i){
+                    soft_body->appendAnchor(i, soft_body_attach, btVector3(0+i*1.6/32.0f,0,0), false, 1.0f);
             }
-            was_controlled = controlled;
-        }
+    }
+
+    if(soft_body){
+            int num_nodes = soft_body->m_nodes.size();
+            for(int i=0;i<num_nodes;++i) {
+                    const btVector3 &point = soft_body->m_nodes[i].m_x;
+                    DebugDraw::Instance()->AddWireSphere(vec3(point[0], point[1], point[2]), 0.01f, vec4(1.0f), _delete_on_update);
+            }
+            btTransform transform;
+            transform.setIdentity();
+            transform.setOrigin(btVector3(position[0], position[1]+0.5f, position[2]));
+            soft_body_attach->setWorldTransform(transform);
+    }*/
 
-        /*
-        if (9 == GetID()) {
-            static float y = 0.f;
-            y += 0.002f * timestep; // timestep
-            position.y() = y;
+    if (was_controlled != controlled && scenegraph_) {
+        std::vector<Object*>::iterator hotit;
+        for (hotit = scenegraph_->hotspots_.begin();
+             hotit != scenegraph_->hotspots_.end();
+             hotit++) {
+            Hotspot* hs = static_cast<Hotspot*>(*hotit);
+            if (controlled) {
+                hs->HandleEvent("engaged_player_control", this);
+            } else {
+                hs->HandleEvent("disengaged_player_control", this);
+            }
         }
-        */
+        was_controlled = controlled;
     }
 
-    return;
+    /*
+    if (9 == GetID()) {
+        static float y = 0.f;
+        y += 0.002f * timestep; // timestep
+        position.y() = y;
+    }
+    */
 }
 
 mat4 RotationFromVectors(const vec3& front,
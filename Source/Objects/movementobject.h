@@ -179,6 +179,9 @@ class MovementObject : public Object {
     void GetShaderNames(std::map<std::string, int>& shaders) override;
 
     void Update(float timestep) override;
+    // Update() split around the animation evaluation, see RiggedObject::BeginUpdate()
+    bool BeginUpdate(float timestep);
+    void FinishUpdate(float timestep);
     void Draw() override;
     void ClientBeforeDraw();
     virtual void HandleTransformationOccured();
@@ -254,6 +257,7 @@ class MovementObject : public Object {
     AttackHistory attack_history;
 
     uint64_t last_timestamp = 0;
+    bool finish_update_pending_ = false;
 
     struct {
         ASFunctionHandle init;
@@ -31,6 +31,7 @@
 #include <Objects/prefab.h>
 #include <Asset/Asset/material.h>
 #include <Game/level.h>
+#include <Main/scenegraph.h>
 #include <Editors/map_editor.h>
 #include <Utility/ieee.h>
 #include <GUI/gui.h>
@@ -39,6 +40,8 @@
 #include <tinyxml.h>
 #include <SDL_assert.h>
 
+#include <algorithm>
+#include <cfloat>
 #include <cstdarg>
 
 extern Timer game_timer;
@@ -77,6 +80,26 @@ int Object::LineCheckEditorCube(const vec3 &start, const vec3 &end, vec3 *point,
     return intersecting;
 }
 
+bool Object::GetLineCheckBounds(vec3 *min, vec3 *max) {
+    // Object::lineCheck() only hits the editor box
+    *min = vec3(FLT_MAX);
+    *max = vec3(-FLT_MAX);
+    for (int i = 0; i < Box::NUM_POINTS; ++i) {
+        vec3 point = transform_ * box_.GetPoint(i);
+        for (int j = 0; j < 3; ++j) {
+            (*min)[j] = std::min((*min)[j], point[j]);
+            (*max)[j] = std::max((*max)[j], point[j]);
+        }
+    }
+    return true;
+}
+
+void Object::LineCheckBoundsChanged() {
+    if (scenegraph_ && line_check_proxy != kLineCheckNotLinked) {
+        scenegraph_->UpdateLineCheckProxy(this);
+    }
+}
+
 void Object::HandleTransformationOccurred() {
     Online *online = Online::Instance();
     if (online->IsActive()) {
@@ -387,6 +410,7 @@ void Object::Moved(Object::MoveType type) {
     if (parent) {
         parent->ChildMoved(type);
     }
+    LineCheckBoundsChanged();
 
     online_transform_dirty = true;
 }
@@ -476,6 +500,7 @@ void Object::SetTranslationRotationFast(const vec3 &trans, const quaternion &rot
     }
     if (changed_something) {
         UpdateTransform();
+        LineCheckBoundsChanged();
     }
 }
 
@@ -90,6 +90,10 @@ class Object {
         kCTNavmeshConnections,
         kCTHotspots
     };
+    enum LineCheckProxy {
+        kLineCheckNotLinked = -1,
+        kLineCheckUnbounded = -2  // Linked, tested by every scenegraph line check
+    };
 
     // Transforms
     const vec3& GetTranslation() const { return translation_; }
@@ -142,6 +146,8 @@ class Object {
     bool exclude_from_undo;
     bool exclude_from_save;
     int update_list_entry;
+    // Leaf in the scenegraph line check tree, or one of LineCheckProxy
+    int line_check_proxy;
     Object* parent;
     std::vector<int> unfinalized_connected_from;
     std::vector<int> unfinalized_connected_to;
@@ -165,6 +171,7 @@ class Object {
           exclude_from_undo(false),
           exclude_from_save(false),
           update_list_entry(-1),
+          line_check_proxy(kLineCheckNotLinked),
           enabled_(true),
           parent(NULL),
           scenegraph_(parent_scenegraph),
@@ -223,6 +230,8 @@ class Object {
     virtual void SetImposter(bool set) {}
     virtual void drawShadow(vec3 origin, float distance) {}
     virtual int lineCheck(const vec3& start, const vec3& end, vec3* point, vec3* normal = 0);
+    // World space box around everything lineCheck() can hit, false if there is no such box
+    virtual bool GetLineCheckBounds(vec3* min, vec3* max);
     virtual bool AcceptConnectionsFrom(ConnectionType type, Object& object) { return false; }
     virtual bool ConnectTo(Object& other, bool checking_other = false);
     virtual bool Disconnect(Object& other, bool from_socket = false, bool checking_other = false);
@@ -297,6 +306,8 @@ class Object {
     virtual void Reset() {}
     virtual void ToggleImposter() {}
     int LineCheckEditorCube(const vec3& start, const vec3& end, vec3* point, vec3* normal);
+    // Call when something GetLineCheckBounds() depends on changes outside of Moved()
+    void LineCheckBoundsChanged();
 
    private:
     int receive_depth;
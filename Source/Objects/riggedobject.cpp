@@ -64,7 +64,7 @@
 #include <GUI/IMUI/imui.h>
 
 #include <Internal/varstring.h>
-#include <Internal/checksum.h>
+#include <Internal/filefingerprint.h>
 #include <Internal/memwrite.h>
 #include <Internal/filesystem.h>
 #include <Internal/profiler.h>
@@ -187,6 +187,8 @@ RiggedObject::RiggedObject() : static_char(false),
     collidable = false;
 
     animated = false;
+    animation_evaluation_pending_ = false;
+    animation_evaluated_ = false;
 
     stab_texture = Engine::Instance()->GetAssetManager()->LoadSync<TextureAsset>("Data/Textures/stabdecal.tga");
 }
@@ -1217,9 +1219,15 @@ void UpdateAttachedItemRagdoll(AttachedItem& stuck_item, const Skeleton& skeleto
 }
 
 void RiggedObject::Update(float timestep) {
-    PROFILER_ZONE(g_profiler_ctx, "RiggedObject Update()");
+    if (BeginUpdate(timestep)) {
+        EvaluateAnimation();
+    }
+    FinishUpdate(timestep);
+}
+
+bool RiggedObject::BeginUpdate(float timestep) {
+    PROFILER_ZONE(g_profiler_ctx, "RiggedObject BeginUpdate()");
 
-    Model* model = &Models::Instance()->GetModel(model_id[0]);
     // blood_surface.CreateDripInTri(RangedRandomInt(0, model->faces.size()/3-1), vec3(1.0f/3.0f), 1.0f, 0.0f, true, SurfaceWalker::WATER);
     {
         if (game_timer.game_time < blood_surface.sleep_time) {
@@ -1257,14 +1265,121 @@ void RiggedObject::Update(float timestep) {
     --curr_anim_update_time;
     --prev_anim_update_time;
 
+    animation_evaluation_pending_ = false;
+    animation_evaluated_ = false;
     if (time_until_next_anim_update <= 0) {
         for (auto& morph_target : morph_targets) {
             morph_target.UpdateForInterpolation();
         }
+        if (animated) {
+            HandleLipSyncMorphTargets(timestep);
+            bool drawn_recently = last_draw_time > game_timer.game_time - 1.0f;
+            animation_evaluation_pending_ = cached_animation_frame_bone_matrices.empty() || drawn_recently || !static_char;
+        }
+    }
+    return animation_evaluation_pending_;
+}
+
+void RiggedObject::EvaluateAnimation() {
+    // Scripts may have ragdolled this character since BeginUpdate(), FinishUpdate() then does without
+    if (!animation_evaluation_pending_ || !animated) {
+        return;
+    }
+    PROFILER_ZONE(g_profiler_ctx, "RiggedObject EvaluateAnimation()");
+    animation_evaluation_pending_ = false;
+    EvaluatePose();
+    animation_evaluated_ = true;
+}
+
+void RiggedObject::EvaluatePose() {
+    AnimOutput& anim_output = blended_anim_output;
+    // Get results from animation blend tree
+    {
+        PROFILER_ZONE(g_profiler_ctx, "anim_client.GetMatrices()");
+        anim_client.GetMatrices(anim_output, &skeleton_.parents);
+    }
+    for (auto& matrice : anim_output.matrices) {
+        matrice.origin *= model_char_scale;
+    }
+    for (auto& ik_bone : anim_output.ik_bones) {
+        ik_bone.transform.origin *= model_char_scale;
+    }
+    weap_anim_info_map = anim_output.weap_anim_info_map;
+    // Bone transforms for further manipulation
+    std::vector<BoneTransform>& transforms = anim_output.matrices;
+    // Get info for moving and rotating entire character based on animation
+    total_center_offset += vec3(anim_output.delta_offset[0],
+                                anim_output.delta_offset[1],
+                                anim_output.delta_offset[2]) *
+                           model_char_scale;
+    total_rotation += anim_output.delta_rotation;
+
+    unmodified_transforms = anim_output.unmodified_matrices;
+
+    // Apply full-character rotation to bone and weapon transforms
+    vec4 angle_axis(0.0f, 1.0f, 0.0f, total_rotation);
+    quaternion rot(angle_axis);
+    mat4 rotmat4 = Mat4FromQuaternion(rot);
+    for (auto& transform : transforms) {
+        transform = rotmat4 * transform;
+    }
+    for (auto& ik_bone : anim_output.ik_bones) {
+        ik_bone.transform = rotmat4 * ik_bone.transform;
+    }
+    for (auto& entry : weap_anim_info_map) {
+        WeapAnimInfo& weap_anim_info = entry.info;
+        if (weap_anim_info.relative_id == -1) {
+            weap_anim_info.bone_transform = rotmat4 * weap_anim_info.bone_transform;
+        }
+    }
+
+    // Apply full-character translation to bone and weapon transforms
+    for (unsigned i = 0; i < transforms.size(); i++) {
+        transforms[i].origin += total_center_offset;
+        animation_frame_bone_matrices[i] = transforms[i];
+    }
+    for (auto& ik_bone : anim_output.ik_bones) {
+        ik_bone.transform.origin += total_center_offset;
+    }
+    for (auto& entry : weap_anim_info_map) {
+        WeapAnimInfo& weap_anim_info = entry.info;
+        if (weap_anim_info.relative_id == -1) {
+            weap_anim_info.bone_transform.origin += total_center_offset;
+        } else {
+            weap_anim_info.matrix = weap_anim_info.bone_transform.GetMat4();
+        }
+    }
+
+    // Apply animation morphs
+    std::map<std::string, MorphTarget*> morph_target_names;
+    for (auto& morph_target : morph_targets) {
+        morph_target_names[morph_target.name] = &morph_target;
+    }
+    for (auto& skb : anim_output.shape_keys) {
+        const std::string& label = skb.label;
+        if (morph_target_names.find(label) != morph_target_names.end()) {
+            morph_target_names[label]->anim_weight = skb.weight * skb.weight_weight;
+        }
+    }
+
+    // Apply status keys
+    status_keys.clear();
+    for (const auto& key : anim_output.status_keys) {
+        status_keys[key.label] = key.weight * key.weight_weight;
+    }
+
+    blended_bone_paths = anim_output.ik_bones;
+    cached_animation_frame_bone_matrices = animation_frame_bone_matrices;
+}
+
+void RiggedObject::FinishUpdate(float timestep) {
+    PROFILER_ZONE(g_profiler_ctx, "RiggedObject FinishUpdate()");
+
+    if (time_until_next_anim_update <= 0) {
         if (!animated) {
             PROFILER_ZONE(g_profiler_ctx, "Update ragdoll animation");
             // Get results from animation blend tree
-            AnimOutput anim_output;
+            AnimOutput& anim_output = blended_anim_output;
             anim_client.GetMatrices(anim_output, &skeleton_.parents);
             if (!anim_output.matrices.empty()) {
                 // Store animation frame
@@ -1309,89 +1424,14 @@ void RiggedObject::Update(float timestep) {
             }
         } else if (animated) {
             PROFILER_ZONE(g_profiler_ctx, "Update animation");
-            HandleLipSyncMorphTargets(timestep);
-            AnimOutput anim_output;
-            // Get results from animation blend tree
             bool drawn_recently = last_draw_time > game_timer.game_time - 1.0f;
-            if (cached_animation_frame_bone_matrices.empty() || drawn_recently || !static_char) {
-                {
-                    PROFILER_ZONE(g_profiler_ctx, "anim_client.GetMatrices()");
-                    anim_client.GetMatrices(anim_output, &skeleton_.parents);
-                }
-                for (auto& matrice : anim_output.matrices) {
-                    matrice.origin *= model_char_scale;
-                }
-                for (auto& ik_bone : anim_output.ik_bones) {
-                    ik_bone.transform.origin *= model_char_scale;
-                }
-                weap_anim_info_map = anim_output.weap_anim_info_map;
-                // Copy bone transforms for further manipulation
-                std::vector<BoneTransform> transforms = anim_output.matrices;
-                // Get info for moving and rotating entire character based on animation
-                total_center_offset += vec3(anim_output.delta_offset[0],
-                                            anim_output.delta_offset[1],
-                                            anim_output.delta_offset[2]) *
-                                       model_char_scale;
-                total_rotation += anim_output.delta_rotation;
-
-                unmodified_transforms = anim_output.unmodified_matrices;
-
-                // Apply full-character rotation to bone and weapon transforms
-                vec4 angle_axis(0.0f, 1.0f, 0.0f, total_rotation);
-                quaternion rot(angle_axis);
-                mat4 rotmat4 = Mat4FromQuaternion(rot);
-                for (auto& transform : transforms) {
-                    transform = rotmat4 * transform;
-                }
-                for (auto& ik_bone : anim_output.ik_bones) {
-                    ik_bone.transform = rotmat4 * ik_bone.transform;
-                }
-                for (auto& iter : weap_anim_info_map) {
-                    WeapAnimInfo& weap_anim_info = iter.second;
-                    if (weap_anim_info.relative_id == -1) {
-                        weap_anim_info.bone_transform = rotmat4 * weap_anim_info.bone_transform;
-                    }
-                }
-
-                // Apply full-character translation to bone and weapon transforms
-                for (unsigned i = 0; i < transforms.size(); i++) {
-                    transforms[i].origin += total_center_offset;
-                    animation_frame_bone_matrices[i] = transforms[i];
-                }
-                for (auto& ik_bone : anim_output.ik_bones) {
-                    ik_bone.transform.origin += total_center_offset;
-                }
-                for (auto& iter : weap_anim_info_map) {
-                    WeapAnimInfo& weap_anim_info = iter.second;
-                    if (weap_anim_info.relative_id == -1) {
-                        weap_anim_info.bone_transform.origin += total_center_offset;
-                    } else {
-                        weap_anim_info.matrix = weap_anim_info.bone_transform.GetMat4();
-                    }
-                }
-
-                // Apply animation morphs
-                std::map<std::string, MorphTarget*> morph_target_names;
-                for (auto& morph_target : morph_targets) {
-                    morph_target_names[morph_target.name] = &morph_target;
-                }
-                for (auto& skb : anim_output.shape_keys) {
-                    const std::string& label = skb.label;
-                    if (morph_target_names.find(label) != morph_target_names.end()) {
-                        morph_target_names[label]->anim_weight = skb.weight * skb.weight_weight;
-                    }
-                }
-
-                // Apply status keys
-                status_keys.clear();
-                for (auto key : anim_output.status_keys) {
-                    status_keys[key.label] = key.weight * key.weight_weight;
+            if (!animation_evaluated_) {
+                // Not evaluated ahead of time, or only just stopped being a ragdoll
+                if (cached_animation_frame_bone_matrices.empty() || drawn_recently || !static_char) {
+                    EvaluatePose();
+                } else {
+                    animation_frame_bone_matrices = cached_animation_frame_bone_matrices;
                 }
-
-                blended_bone_paths = anim_output.ik_bones;
-                cached_animation_frame_bone_matrices = animation_frame_bone_matrices;
-            } else {
-                animation_frame_bone_matrices = cached_animation_frame_bone_matrices;
             }
 
             ASArglist args;
@@ -1448,6 +1488,8 @@ void RiggedObject::Update(float timestep) {
             item.item.SetInterpInfo(GetTimeSinceLastAnimUpdate(), GetTimeBetweenLastTwoAnimUpdates());
         }
     }
+    animation_evaluation_pending_ = false;
+    animation_evaluated_ = false;
 }
 
 namespace {
@@ -2789,7 +2831,7 @@ void MorphTarget::Load(const std::string& base_model_name,
         if (FindFilePath(path.c_str(), abs_path, kPathSize, kDataPaths | kModPaths) == -1) {
             FatalError("Error", "Could not find %s", path.c_str());
         }
-        checksum = Checksum(abs_path);
+        checksum = FileFingerprintStore::Instance().GetChecksum(abs_path);
         model_copy[0] = false;
         if (model_id[0] == -1) {
             return;
@@ -2883,6 +2925,7 @@ void MorphTarget::PreDrawCamera(int num, int progress, int lod_level, uint32_t c
                 model.tex_coords[tc_index + 1] += morph_model_end.tex_coords[tc_index + 1] * new_weight;
             }
         }
+        model.VerticesChanged();
         disp_weight = max(0.0f, min(1.0f, interp_weight * (float)(num_parts)));
     } else {
         disp_weight = max(0.0f, min(1.0f, interp_weight));
@@ -3296,9 +3339,9 @@ void UpdateAttachedItem(AttachedItem& attached_item, const Skeleton& skeleton, f
     weap_mat.SetTranslationPart(weap_mat.GetTranslationPart() * char_scale);
     mat4 the_weap_mat = bone_mat * weap_mat;
     if (item->state() == ItemObject::kWielded) {
-        WeapAnimInfoMap::const_iterator iter = weap_anim_info_map.find(item->GetID());
-        if (iter != weap_anim_info_map.end()) {
-            const WeapAnimInfo& weap_anim_info = iter->second;
+        const WeapAnimInfo* found_weap_anim_info = weap_anim_info_map.find(item->GetID());
+        if (found_weap_anim_info) {
+            const WeapAnimInfo& weap_anim_info = *found_weap_anim_info;
             mat4 anim_mat = weap_anim_info.matrix;
             if (weap_anim_info.relative_id != -1) {
                 anim_mat = skeleton.physics_bones[weap_anim_info.relative_id].bullet_object->GetTransform() * anim_mat;
@@ -3637,6 +3680,9 @@ void RiggedObject::UpdateCollisionObjects() {
         cbo->UpdateTransform();
     }
     skeleton_.UpdateCollisionWorldAABB();
+    if (scenegraph_) {
+        scenegraph_->InvalidateCharacterBounds();
+    }
 }
 
 void RiggedObject::AddBloodAtPoint(const vec3& point) {
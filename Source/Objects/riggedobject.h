@@ -182,7 +182,6 @@ class RiggedTransformedVertexGetter : public BloodSurface::TransformedVertexGett
 };
 
 typedef std::list<AttachmentSlot> AttachmentSlotList;
-typedef std::map<int, WeapAnimInfo> WeapAnimInfoMap;
 struct NetworkBone;
 struct MorphTargetStateStorage;
 class RiggedObject : public Object {
@@ -265,6 +264,7 @@ class RiggedObject : public Object {
     Skeleton skeleton_;
     // Animation data
     AnimationClient anim_client;
+    AnimOutput blended_anim_output;  // Kept around so its buffers are reused every update
     bool animated;
     std::vector<BoneTransform> animation_frame_bone_matrices;
     std::vector<BoneTransform> cached_animation_frame_bone_matrices;
@@ -275,7 +275,7 @@ class RiggedObject : public Object {
     bool ik_enabled;
     vec3 total_center_offset;
     float total_rotation;
-    std::vector<BlendedBonePath> blended_bone_paths;
+    ReusableVector<BlendedBonePath> blended_bone_paths;
     std::vector<MorphTarget> morph_targets;
     std::vector<AttachedEnvObject> children;
     std::map<std::string, float> status_keys;
@@ -309,6 +309,13 @@ class RiggedObject : public Object {
 
     bool Initialize() override;
     void Update(float timestep) override;
+    // Update() in three steps, so many characters can have their animation
+    // evaluated at once between the first and last. EvaluateAnimation() only
+    // touches this character's own pose and can run on a worker thread, the
+    // other two run scripts and move physics objects.
+    bool BeginUpdate(float timestep);  // Whether EvaluateAnimation() has work to do
+    void EvaluateAnimation();
+    void FinishUpdate(float timestep);
 
     // Drawing
     void DrawRiggedObject(const mat4 &proj_view_matrix, DrawType type);
@@ -428,7 +435,10 @@ class RiggedObject : public Object {
     RiggedTransformedVertexGetter transformed_vertex_getter_;
     float char_scale;
     float model_char_scale;
+    bool animation_evaluation_pending_;
+    bool animation_evaluated_;  // Since BeginUpdate()
     void UpdateAttachedItems();
+    void EvaluatePose();
 
     RiggedObject(const RiggedObject &other);
     RiggedObject &operator=(const RiggedObject &other);
@@ -133,6 +133,11 @@ int TerrainObject::lineCheck(const vec3& start, const vec3& end, vec3* point, ve
     return -1;
 }
 
+bool TerrainObject::GetLineCheckBounds(vec3* min, vec3* max) {
+    // The terrain covers most of the level, no point in putting it in a tree
+    return false;
+}
+
 void TerrainObject::ReceiveObjectMessageVAList(OBJECT_MSG::Type type, va_list args) {
     switch (type) {
         case OBJECT_MSG::LIGHTING_CHANGED:
@@ -347,52 +352,10 @@ TerrainObject::~TerrainObject() {
 }
 
 void TerrainObject::PreparePhysicsMesh() {
-    static const bool kCachePhysicsShape = false;
     if (!added_to_physics_scene_) {
-        btBvhTriangleMeshShape* cached_shape = NULL;
-        const char* cache_path = "terrain_serialize.bullet";
-        if (kCachePhysicsShape) {
-            /*char abs_path[kPathSize];
-            if(FindFilePath(cache_path, abs_path, kPathSize, kDataPaths|kModPaths|kWriteDir|kModWriteDirs) != -1) {
-                btBulletWorldImporter import(0);//don't store info into the world
-                PROFILER_ZONE(g_profiler_ctx, "Loading cache file");
-                if (import.loadFile(abs_path)){
-                    int numShape = import.getNumCollisionShapes();
-                    if (numShape) {
-                        cached_shape = (btBvhTriangleMeshShape*)import.getCollisionShapeByIndex(0);
-                    }
-                }
-            }*/
-        }
-        if (cached_shape) {
-            PROFILER_ZONE(g_profiler_ctx, "Adding cached shape to physics scene");
-            SharedShapePtr shape;
-            shape.reset(cached_shape);
-            BulletObject* obj = scenegraph_->bullet_world_->CreateRigidBody(shape, 0.0f, BW_NO_FLAGS);
-            obj->body->setCollisionFlags(obj->body->getCollisionFlags() | btCollisionObject::CF_CUSTOM_MATERIAL_CALLBACK);
-            bullet_object_ = obj;
-        } else {
-            PROFILER_ZONE(g_profiler_ctx, "Creating new static mesh");
-            bullet_object_ = scenegraph_->bullet_world_->CreateStaticMesh(&terrain_.GetModel(), -1, BW_NO_FLAGS);
-
-            if (kCachePhysicsShape) {
-                /*PROFILER_ZONE(g_profiler_ctx, "Serializing cached mesh to disk");
-                int maxSerializeBufferSize = 1024*1024*10;
-                btDefaultSerializer*    serializer = new btDefaultSerializer(maxSerializeBufferSize);
-
-                serializer->startSerialization();
-                bullet_object_->shape->serializeSingleShape(serializer);
-                serializer->finishSerialization();
-
-                char path[kPathSize];
-                FormatString(path, kPathSize, "%s%s", GetWritePath(CoreGameModID).c_str(), cache_path);
-                FILE* file = my_fopen(path, "wb");
-                fwrite(serializer->getBufferPointer(),serializer->getCurrentBufferSize(),1, file);
-                fclose(file);
-
-                delete serializer;*/
-            }
-        }
+        // The BVH and edge info are cached on disk by BulletWorld::CreateMeshShape
+        PROFILER_ZONE(g_profiler_ctx, "Creating new static mesh");
+        bullet_object_ = scenegraph_->bullet_world_->CreateStaticMesh(&terrain_.GetModel(), -1, BW_NO_FLAGS);
         bullet_object_->owner_object = this;
         added_to_physics_scene_ = true;
     }
@@ -52,6 +52,7 @@ class TerrainObject : public Object {
     void Draw() override;
     void DrawDepthMap(const mat4& proj_view_matrix, const vec4* cull_planes, int num_cull_planes, Object::DrawType draw_type) override;
     int lineCheck(const vec3& start, const vec3& end, vec3* point, vec3* normal = 0) override;
+    bool GetLineCheckBounds(vec3* min, vec3* max) override;
     bool Initialize() override;
     void GetShaderNames(std::map<std::string, int>& preload_shaders) override;
     const MaterialEvent& GetMaterialEvent(const std::string& the_event, const vec3& event_pos, int* tri) override;
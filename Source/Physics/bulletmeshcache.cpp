@@ -0,0 +1,177 @@
+//-----------------------------------------------------------------------------
+//           Name: bulletmeshcache.cpp
+//      Developer: Wolfire Games LLC
+//    Description: On-disk cache of the quantized BVH and internal edge info
+//                 Bullet builds for static triangle meshes.
+//        License: Read below
+//-----------------------------------------------------------------------------
+//
+//
+//   Copyright 2022 Wolfire Games LLC
+//
+//   Licensed under the Apache License, Version 2.0 (the "License");
+//   you may not use this file except in compliance with the License.
+//   You may obtain a copy of the License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//   Unless required by applicable law or agreed to in writing, software
+//   distributed under the License is distributed on an "AS IS" BASIS,
+//   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//   See the License for the specific language governing permissions and
+//   limitations under the License.
+//
+//-----------------------------------------------------------------------------
+#include "bulletmeshcache.h"
+
+#include <Physics/bulletobject.h>
+#include <Graphics/model.h>
+#include <Compat/fileio.h>
+#include <Internal/filesystem.h>
+#include <Internal/profiler.h>
+#include <Logging/logdata.h>
+
+#include <btBulletDynamicsCommon.h>
+#include <BulletCollision/CollisionDispatch/btInternalEdgeUtility.h>
+
+#include <sys/stat.h>
+#include <cstring>
+
+static const char kBulletMeshCacheMagic[4] = {'O', 'G', 'B', 'C'};
+
+struct BulletMeshCacheHeader {
+    char magic[4];
+    uint32_t version;
+    // The BVH is stored in Bullet's in-memory layout, so it only loads into a build with the same one.
+    uint32_t bullet_version;
+    uint32_t bvh_struct_size;
+    uint32_t scalar_size;
+    uint32_t pointer_size;
+    uint32_t bvh_size;
+    uint32_t num_triangle_infos;
+    uint64_t mesh_hash[2];
+};
+
+static void InitHeader(BulletMeshCacheHeader* header, const MurmurHash& mesh_hash) {
+    memset(header, 0, sizeof(*header));
+    memcpy(header->magic, kBulletMeshCacheMagic, sizeof(header->magic));
+    header->version = _bullet_mesh_cache_version;
+    header->bullet_version = BT_BULLET_VERSION;
+    header->bvh_struct_size = sizeof(btOptimizedBvh);
+    header->scalar_size = sizeof(btScalar);
+    header->pointer_size = sizeof(void*);
+    header->mesh_hash[0] = mesh_hash.hash[0];
+    header->mesh_hash[1] = mesh_hash.hash[1];
+}
+
+std::string GetBulletMeshCachePath(const Model& mesh) {
+    if (mesh.path.empty()) {
+        return std::string();
+    }
+    return GetWritePath(mesh.modsource_) + SanitizePath(mesh.path) + ".bullet.cache";
+}
+
+MurmurHash GetBulletMeshHash(const std::vector<int>& faces, const float* vertices, int num_vertices) {
+    MurmurHashStream stream;
+    int num_faces = (int)faces.size();
+    stream.Update(&num_faces, sizeof(num_faces));
+    stream.Update(&num_vertices, sizeof(num_vertices));
+    if (!faces.empty()) {
+        stream.Update(&faces[0], faces.size() * sizeof(int));
+    }
+    stream.Update(vertices, num_vertices * 3 * sizeof(float));
+    return stream.Finish();
+}
+
+bool LoadBulletMeshCache(const char* abs_path, const MurmurHash& mesh_hash, ShapeDisposalData& data) {
+    PROFILER_ZONE(g_profiler_ctx, "LoadBulletMeshCache");
+    FILE* file = my_fopen(abs_path, "rb");
+    if (file == NULL) {
+        return false;
+    }
+
+    BulletMeshCacheHeader expected;
+    InitHeader(&expected, mesh_hash);
+    BulletMeshCacheHeader header;
+    struct stat buf;
+    if (fstat(fileno(file), &buf) != 0 || fread(&header, sizeof(header), 1, file) != 1) {
+        fclose(file);
+        return false;
+    }
+    uint64_t expected_size = sizeof(header) + (uint64_t)header.bvh_size +
+                             (uint64_t)header.num_triangle_infos * (sizeof(int) + sizeof(btTriangleInfo));
+    expected.bvh_size = header.bvh_size;
+    expected.num_triangle_infos = header.num_triangle_infos;
+    if (memcmp(&header, &expected, sizeof(header)) != 0 || (uint64_t)buf.st_size != expected_size) {
+        // Stale, from another build or a different mesh, rebuilt and overwritten by the caller
+        fclose(file);
+        return false;
+    }
+
+    void* bvh_buffer = btAlignedAlloc(header.bvh_size, 16);
+    std::vector<int> keys(header.num_triangle_infos);
+    std::vector<btTriangleInfo> infos(header.num_triangle_infos);
+    bool ok = fread(bvh_buffer, header.bvh_size, 1, file) == 1;
+    if (ok && header.num_triangle_infos > 0) {
+        ok = fread(&keys[0], sizeof(int), keys.size(), file) == keys.size() &&
+             fread(&infos[0], sizeof(btTriangleInfo), infos.size(), file) == infos.size();
+    }
+    fclose(file);
+
+    btOptimizedBvh* bvh = NULL;
+    if (ok) {
+        bvh = btOptimizedBvh::deSerializeInPlace(bvh_buffer, header.bvh_size, false);
+    }
+    if (bvh == NULL) {
+        LOGW << "Failed to read bullet mesh cache " << abs_path << std::endl;
+        btAlignedFree(bvh_buffer);
+        return false;
+    }
+
+    data.bvh_buffer = bvh_buffer;
+    data.bvh = bvh;
+    data.triangle_info_map = new btTriangleInfoMap();
+    for (size_t i = 0; i < keys.size(); ++i) {
+        data.triangle_info_map->insert(btHashInt(keys[i]), infos[i]);
+    }
+    return true;
+}
+
+bool SaveBulletMeshCache(const char* abs_path, const MurmurHash& mesh_hash, const btOptimizedBvh& bvh, const btTriangleInfoMap& triangle_info_map) {
+    PROFILER_ZONE(g_profiler_ctx, "SaveBulletMeshCache");
+    BulletMeshCacheHeader header;
+    InitHeader(&header, mesh_hash);
+    header.bvh_size = bvh.calculateSerializeBufferSize();
+    header.num_triangle_infos = triangle_info_map.size();
+
+    void* bvh_buffer = btAlignedAlloc(header.bvh_size, 16);
+    if (!bvh.serializeInPlace(bvh_buffer, header.bvh_size, false)) {
+        btAlignedFree(bvh_buffer);
+        return false;
+    }
+    std::vector<int> keys(header.num_triangle_infos);
+    std::vector<btTriangleInfo> infos(header.num_triangle_infos);
+    for (int i = 0; i < (int)header.num_triangle_infos; ++i) {
+        keys[i] = triangle_info_map.getKeyAtIndex(i).getUid1();
+        infos[i] = *triangle_info_map.getAtIndex(i);
+    }
+
+    CreateParentDirs(abs_path);
+    FILE* file = my_fopen(abs_path, "wb");
+    bool ok = file != NULL;
+    if (ok) {
+        ok = fwrite(&header, sizeof(header), 1, file) == 1 &&
+             fwrite(bvh_buffer, header.bvh_size, 1, file) == 1;
+        if (ok && !keys.empty()) {
+            ok = fwrite(&keys[0], sizeof(int), keys.size(), file) == keys.size() &&
+                 fwrite(&infos[0], sizeof(btTriangleInfo), infos.size(), file) == infos.size();
+        }
+        ok = fclose(file) == 0 && ok;
+        if (!ok) {
+            LOGW << "Failed to write bullet mesh cache " << abs_path << std::endl;
+            deletefile(abs_path);
+        }
+    }
+    btAlignedFree(bvh_buffer);
+    return ok;
+}
@@ -0,0 +1,51 @@
+//-----------------------------------------------------------------------------
+//           Name: bulletmeshcache.h
+//      Developer: Wolfire Games LLC
+//    Description: On-disk cache of the quantized BVH and internal edge info
+//                 Bullet builds for static triangle meshes.
+//        License: Read below
+//-----------------------------------------------------------------------------
+//
+//
+//   Copyright 2022 Wolfire Games LLC
+//
+//   Licensed under the Apache License, Version 2.0 (the "License");
+//   you may not use this file except in compliance with the License.
+//   You may obtain a copy of the License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//   Unless required by applicable law or agreed to in writing, software
+//   distributed under the License is distributed on an "AS IS" BASIS,
+//   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//   See the License for the specific language governing permissions and
+//   limitations under the License.
+//
+//-----------------------------------------------------------------------------
+#pragma once
+
+#include <Utility/hash.h>
+
+#include <string>
+#include <vector>
+
+class Model;
+class btOptimizedBvh;
+struct btTriangleInfoMap;
+struct ShapeDisposalData;
+
+const uint32_t _bullet_mesh_cache_version = 1;
+
+// Where the cache for a model goes, empty if the model has no source path to name it after.
+std::string GetBulletMeshCachePath(const Model& mesh);
+
+// Hash of the triangles as they are handed to Bullet, a cache is only used if it was built from the same data.
+MurmurHash GetBulletMeshHash(const std::vector<int>& faces, const float* vertices, int num_vertices);
+
+/*
+ * On success data.bvh points into data.bvh_buffer, which the BVH was
+ * deserialized into in place, and data.triangle_info_map is filled in. Both
+ * have to stay alive for as long as the shape using them.
+ */
+bool LoadBulletMeshCache(const char* abs_path, const MurmurHash& mesh_hash, ShapeDisposalData& data);
+bool SaveBulletMeshCache(const char* abs_path, const MurmurHash& mesh_hash, const btOptimizedBvh& bvh, const btTriangleInfoMap& triangle_info_map);
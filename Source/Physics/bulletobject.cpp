@@ -382,6 +382,8 @@ void BulletObject::Freeze() {
 
 void BulletObject::Sleep() {
     body->setActivationState(ISLAND_SLEEPING);
+    // Stays asleep when the simulation LOD would have let it go
+    lod.held = false;
 }
 
 void BulletObject::NoSleep() {
@@ -389,6 +391,7 @@ void BulletObject::NoSleep() {
 }
 
 void BulletObject::CanSleep() {
+    lod.saved_activation_state = ACTIVE_TAG;
     body->forceActivationState(ACTIVE_TAG);
     body->activate(true);
 }
@@ -419,6 +422,12 @@ void BulletObject::SetShape(SharedShapePtr _shape) {
     body->setCollisionShape(shape.get());
 }
 
+SimulationLODState::SimulationLODState() : held(false),
+                                           saved_activation_state(ACTIVE_TAG),
+                                           saved_linear_velocity(0.0f),
+                                           saved_angular_velocity(0.0f),
+                                           frames_skipped(0) {}
+
 BulletObject::BulletObject() : body(NULL),
                                com_offset(0.0f),
                                owner_object(NULL),
@@ -585,9 +594,15 @@ void BulletObject::SetMass(float mass) {
 }
 
 ShapeDisposalData::ShapeDisposalData() : index_vert_array(NULL),
-                                         triangle_info_map(NULL) {}
+                                         triangle_info_map(NULL),
+                                         bvh(NULL),
+                                         bvh_buffer(NULL) {}
 
 ShapeDisposalData::~ShapeDisposalData() {
     delete index_vert_array;
     delete triangle_info_map;
+    if (bvh) {
+        bvh->~btOptimizedBvh();
+    }
+    btAlignedFree(bvh_buffer);
 }
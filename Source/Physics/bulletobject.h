@@ -38,17 +38,30 @@ struct CollideInfo;
 enum CDLItype { _CDLI_CAPSULE };
 
 class btTriangleIndexVertexArray;
+class btOptimizedBvh;
 struct btTriangleInfoMap;
 struct ShapeDisposalData {
     std::vector<int> faces;
     btTriangleIndexVertexArray *index_vert_array;
     btTriangleInfoMap *triangle_info_map;
+    btOptimizedBvh *bvh;  // Set when the BVH was loaded from a cache, in place in bvh_buffer
+    void *bvh_buffer;
     ShapeDisposalData();
     ~ShapeDisposalData();
 };
 
 typedef std::shared_ptr<btCollisionShape> SharedShapePtr;
 
+// Bookkeeping for BulletSimulationLOD
+struct SimulationLODState {
+    bool held;  // Put to sleep by the simulation LOD rather than by bullet or the game
+    int saved_activation_state;
+    vec3 saved_linear_velocity;
+    vec3 saved_angular_velocity;
+    int frames_skipped;  // Steps held since the body was last simulated
+    SimulationLODState();
+};
+
 class BulletObject {
    public:
     mat4 transform;
@@ -65,6 +78,7 @@ class BulletObject {
     vec3 color;
     bool linked;
     bool keep_history;
+    SimulationLODState lod;
 
     BulletObject();
     ~BulletObject();
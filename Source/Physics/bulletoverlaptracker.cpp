@@ -0,0 +1,211 @@
+//-----------------------------------------------------------------------------
+//           Name: bulletoverlaptracker.cpp
+//      Developer: Wolfire Games LLC
+//    Description: Keeps track of which objects in a bullet world are touching,
+//                 and reports when they start and stop.
+//        License: Read below
+//-----------------------------------------------------------------------------
+//
+//
+//   Copyright 2022 Wolfire Games LLC
+//
+//   Licensed under the Apache License, Version 2.0 (the "License");
+//   you may not use this file except in compliance with the License.
+//   You may obtain a copy of the License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//   Unless required by applicable law or agreed to in writing, software
+//   distributed under the License is distributed on an "AS IS" BASIS,
+//   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//   See the License for the specific language governing permissions and
+//   limitations under the License.
+//
+//-----------------------------------------------------------------------------
+#include "bulletoverlaptracker.h"
+
+#include <Physics/bulletobject.h>
+
+#include <btBulletDynamicsCommon.h>
+
+#include <algorithm>
+
+static Object* GetOwner(const btBroadphaseProxy* proxy) {
+    const btCollisionObject* col_obj = static_cast<const btCollisionObject*>(proxy->m_clientObject);
+    BulletObject* bullet_object = col_obj ? (BulletObject*)col_obj->getUserPointer() : NULL;
+    return bullet_object ? bullet_object->owner_object : NULL;
+}
+
+static const int kInitialIndexSlots = 64;
+
+BulletOverlapTracker::BulletOverlapTracker() {
+    IndexSlot empty = {0, -1};
+    index_slots_.resize(kInitialIndexSlots, empty);
+}
+
+uint64_t BulletOverlapTracker::GetPairKey(const btBroadphaseProxy* proxy0, const btBroadphaseProxy* proxy1) {
+    uint32_t id0 = (uint32_t)proxy0->m_uniqueId;
+    uint32_t id1 = (uint32_t)proxy1->m_uniqueId;
+    if (id0 > id1) {
+        std::swap(id0, id1);
+    }
+    return ((uint64_t)id0 << 32) | id1;
+}
+
+static inline int HashSlot(uint64_t key, int num_slots) {
+    return (int)((key * 0x9E3779B97F4A7C15ULL) >> 32) & (num_slots - 1);
+}
+
+int BulletOverlapTracker::FindSlot(uint64_t key) const {
+    int num_slots = (int)index_slots_.size();
+    for (int slot = HashSlot(key, num_slots);; slot = (slot + 1) & (num_slots - 1)) {
+        if (index_slots_[slot].index == -1) {
+            return -1;
+        }
+        if (index_slots_[slot].key == key) {
+            return slot;
+        }
+    }
+}
+
+void BulletOverlapTracker::InsertIndex(uint64_t key, int index) {
+    // Keep at least half the slots empty so probes stay short
+    if ((int)pairs_.size() * 2 >= (int)index_slots_.size()) {
+        GrowIndex();
+    }
+    int num_slots = (int)index_slots_.size();
+    int slot = HashSlot(key, num_slots);
+    while (index_slots_[slot].index != -1) {
+        slot = (slot + 1) & (num_slots - 1);
+    }
+    index_slots_[slot].key = key;
+    index_slots_[slot].index = index;
+}
+
+void BulletOverlapTracker::EraseIndex(uint64_t key) {
+    int slot = FindSlot(key);
+    if (slot == -1) {
+        return;
+    }
+    // Shift later entries of the probe run back, so lookups never have to skip over holes
+    int num_slots = (int)index_slots_.size();
+    int hole = slot;
+    for (int next = (hole + 1) & (num_slots - 1); index_slots_[next].index != -1; next = (next + 1) & (num_slots - 1)) {
+        int home = HashSlot(index_slots_[next].key, num_slots);
+        bool can_move = hole <= next ? (home <= hole || home > next) : (home <= hole && home > next);
+        if (can_move) {
+            index_slots_[hole] = index_slots_[next];
+            hole = next;
+        }
+    }
+    index_slots_[hole].index = -1;
+}
+
+void BulletOverlapTracker::GrowIndex() {
+    IndexSlot empty = {0, -1};
+    index_slots_.assign(index_slots_.size() * 2, empty);
+    int num_slots = (int)index_slots_.size();
+    for (int i = 0, len = (int)pairs_.size(); i < len; ++i) {
+        uint64_t key = GetPairKey(pairs_[i].proxy0, pairs_[i].proxy1);
+        int slot = HashSlot(key, num_slots);
+        while (index_slots_[slot].index != -1) {
+            slot = (slot + 1) & (num_slots - 1);
+        }
+        index_slots_[slot].key = key;
+        index_slots_[slot].index = i;
+    }
+}
+
+btBroadphasePair* BulletOverlapTracker::addOverlappingPair(btBroadphaseProxy* proxy0, btBroadphaseProxy* proxy1) {
+    uint64_t key = GetPairKey(proxy0, proxy1);
+    if (FindSlot(key) == -1) {
+        InsertIndex(key, (int)pairs_.size());
+        TrackedPair pair;
+        pair.proxy0 = proxy0;
+        pair.proxy1 = proxy1;
+        pair.owners.a = NULL;
+        pair.owners.b = NULL;
+        pair.touching = false;
+        pairs_.push_back(pair);
+    }
+    // The pair cache owns the actual pair, this is just listening
+    return NULL;
+}
+
+void* BulletOverlapTracker::removeOverlappingPair(btBroadphaseProxy* proxy0, btBroadphaseProxy* proxy1, btDispatcher* dispatcher) {
+    int slot = FindSlot(GetPairKey(proxy0, proxy1));
+    if (slot != -1) {
+        RemovePair(index_slots_[slot].index);
+    }
+    return NULL;
+}
+
+void BulletOverlapTracker::removeOverlappingPairsContainingProxy(btBroadphaseProxy* proxy, btDispatcher* dispatcher) {
+    for (int i = (int)pairs_.size() - 1; i >= 0; --i) {
+        if (pairs_[i].proxy0 == proxy || pairs_[i].proxy1 == proxy) {
+            RemovePair(i);
+        }
+    }
+}
+
+void BulletOverlapTracker::RemovePair(int index) {
+    TrackedPair& pair = pairs_[index];
+    if (pair.touching) {
+        end_events_.push_back(pair.owners);
+    }
+    EraseIndex(GetPairKey(pair.proxy0, pair.proxy1));
+    int last = (int)pairs_.size() - 1;
+    if (index != last) {
+        pairs_[index] = pairs_[last];
+        index_slots_[FindSlot(GetPairKey(pairs_[index].proxy0, pairs_[index].proxy1))].index = index;
+    }
+    pairs_.pop_back();
+}
+
+void BulletOverlapTracker::Update(btOverlappingPairCache* pair_cache) {
+    touching_.clear();
+    for (auto& pair : pairs_) {
+        bool touching = false;
+        btBroadphasePair* bt_pair = pair_cache->findPair(pair.proxy0, pair.proxy1);
+        if (bt_pair && bt_pair->m_algorithm) {
+            manifolds_.resize(0);
+            bt_pair->m_algorithm->getAllContactManifolds(manifolds_);
+            for (int i = 0; i < manifolds_.size() && !touching; ++i) {
+                touching = manifolds_[i]->getNumContacts() > 0;
+            }
+        }
+        if (touching && !pair.touching) {
+            Object* a = GetOwner(pair.proxy0);
+            Object* b = GetOwner(pair.proxy1);
+            if (!a || !b) {
+                // Objects without an owner never report anything
+                continue;
+            }
+            if (b < a) {
+                std::swap(a, b);
+            }
+            pair.owners.a = a;
+            pair.owners.b = b;
+            begin_events_.push_back(pair.owners);
+        } else if (!touching && pair.touching) {
+            end_events_.push_back(pair.owners);
+        }
+        pair.touching = touching;
+        if (touching) {
+            touching_.push_back(pair.owners);
+        }
+    }
+}
+
+void BulletOverlapTracker::ClearEvents() {
+    begin_events_.clear();
+    end_events_.clear();
+}
+
+void BulletOverlapTracker::ResetTouching() {
+    for (auto& pair : pairs_) {
+        pair.touching = false;
+    }
+    touching_.clear();
+    ClearEvents();
+}
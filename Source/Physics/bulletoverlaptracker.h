@@ -0,0 +1,100 @@
+//-----------------------------------------------------------------------------
+//           Name: bulletoverlaptracker.h
+//      Developer: Wolfire Games LLC
+//    Description: Keeps track of which objects in a bullet world are touching,
+//                 and reports when they start and stop.
+//        License: Read below
+//-----------------------------------------------------------------------------
+//
+//
+//   Copyright 2022 Wolfire Games LLC
+//
+//   Licensed under the Apache License, Version 2.0 (the "License");
+//   you may not use this file except in compliance with the License.
+//   You may obtain a copy of the License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//   Unless required by applicable law or agreed to in writing, software
+//   distributed under the License is distributed on an "AS IS" BASIS,
+//   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//   See the License for the specific language governing permissions and
+//   limitations under the License.
+//
+//-----------------------------------------------------------------------------
+#pragma once
+
+#include <BulletCollision/BroadphaseCollision/btBroadphaseProxy.h>
+#include <BulletCollision/BroadphaseCollision/btOverlappingPairCallback.h>
+#include <LinearMath/btAlignedObjectArray.h>
+
+#include <vector>
+#include <cstdint>
+
+class Object;
+class btOverlappingPairCache;
+class btPersistentManifold;
+
+// The owners of two touching bullet objects, a < b
+struct OverlapPair {
+    Object* a;
+    Object* b;
+};
+
+/*
+ * Registered as the ghost pair callback of a broadphase pair cache, so it
+ * only ever hears about pairs whose bounding boxes start or stop overlapping.
+ * Update() checks the contact manifolds of just those pairs to see which
+ * ones are actually touching. Begin and end events accumulate until
+ * ClearEvents(), end events included for pairs that were removed between
+ * updates because one of their objects left the world; their owners may
+ * have been deleted since, so end events should only be compared against
+ * pointers, never dereferenced.
+ */
+class BulletOverlapTracker : public btOverlappingPairCallback {
+   public:
+    BulletOverlapTracker();
+
+    btBroadphasePair* addOverlappingPair(btBroadphaseProxy* proxy0, btBroadphaseProxy* proxy1) override;
+    void* removeOverlappingPair(btBroadphaseProxy* proxy0, btBroadphaseProxy* proxy1, btDispatcher* dispatcher) override;
+    void removeOverlappingPairsContainingProxy(btBroadphaseProxy* proxy, btDispatcher* dispatcher) override;
+
+    // Call after the world has dispatched its collision pairs
+    void Update(btOverlappingPairCache* pair_cache);
+    void ClearEvents();
+    // Forget what is touching without ending it, so everything begins again on the next update
+    void ResetTouching();
+
+    const std::vector<OverlapPair>& GetBeginEvents() const { return begin_events_; }
+    const std::vector<OverlapPair>& GetEndEvents() const { return end_events_; }
+    const std::vector<OverlapPair>& GetTouching() const { return touching_; }
+    int GetNumTrackedPairs() const { return (int)pairs_.size(); }
+
+   private:
+    struct TrackedPair {
+        btBroadphaseProxy* proxy0;
+        btBroadphaseProxy* proxy1;
+        OverlapPair owners;  // Only valid while touching
+        bool touching;
+    };
+
+    // Open addressing with linear probing, so pairs coming and going don't allocate once the table has grown
+    struct IndexSlot {
+        uint64_t key;
+        int index;  // -1 for empty slots
+    };
+
+    static uint64_t GetPairKey(const btBroadphaseProxy* proxy0, const btBroadphaseProxy* proxy1);
+    void RemovePair(int index);
+    int FindSlot(uint64_t key) const;
+    void InsertIndex(uint64_t key, int index);
+    void EraseIndex(uint64_t key);
+    void GrowIndex();
+
+    std::vector<TrackedPair> pairs_;
+    std::vector<IndexSlot> index_slots_;
+    std::vector<OverlapPair> begin_events_;
+    std::vector<OverlapPair> end_events_;
+    std::vector<OverlapPair> touching_;
+    btAlignedObjectArray<btPersistentManifold*> manifolds_;
+};
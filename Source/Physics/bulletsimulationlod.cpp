@@ -0,0 +1,221 @@
+//-----------------------------------------------------------------------------
+//           Name: bulletsimulationlod.cpp
+//      Developer: Wolfire Games LLC
+//    Description: Steps bodies far away from the players less often, or not
+//                 at all, until something comes near them again.
+//        License: Read below
+//-----------------------------------------------------------------------------
+//
+//
+//   Copyright 2022 Wolfire Games LLC
+//
+//   Licensed under the Apache License, Version 2.0 (the "License");
+//   you may not use this file except in compliance with the License.
+//   You may obtain a copy of the License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//   Unless required by applicable law or agreed to in writing, software
+//   distributed under the License is distributed on an "AS IS" BASIS,
+//   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//   See the License for the specific language governing permissions and
+//   limitations under the License.
+//
+//-----------------------------------------------------------------------------
+#include "bulletsimulationlod.h"
+
+#include <Physics/bulletobject.h>
+#include <Physics/bulletcollision.h>
+#include <Math/vec3math.h>
+#include <Math/enginemath.h>
+
+#include <btBulletDynamicsCommon.h>
+
+#include <algorithm>
+#include <cfloat>
+#include <climits>
+
+SimulationLODSettings::SimulationLODSettings() : reduced_rate_radius(40.0f),
+                                                 sleep_radius(0.0f),
+                                                 reduced_rate_interval(4) {
+}
+
+BulletSimulationLOD::BulletSimulationLOD(const SimulationLODSettings& settings) : settings_(settings),
+                                                                                 frame_(0) {
+    settings_.reduced_rate_interval = std::max(1, settings_.reduced_rate_interval);
+    std::fill(counts_, counts_ + kNumLevels, 0);
+}
+
+void BulletSimulationLOD::SetFocus(const std::vector<vec3>& points) {
+    focus_ = points;
+}
+
+BulletSimulationLOD::Level BulletSimulationLOD::GetLevel(const vec3& position) const {
+    if (focus_.empty()) {
+        return kFullRate;
+    }
+    float closest = FLT_MAX;
+    for (const vec3& point : focus_) {
+        closest = std::min(closest, distance_squared(position, point));
+    }
+    if (closest <= square(settings_.reduced_rate_radius)) {
+        return kFullRate;
+    }
+    if (settings_.sleep_radius > 0.0f && closest > square(settings_.sleep_radius)) {
+        return kAsleep;
+    }
+    return kReducedRate;
+}
+
+int BulletSimulationLOD::FindGroup(int index) {
+    while (groups_[index] != index) {
+        groups_[index] = groups_[groups_[index]];
+        index = groups_[index];
+    }
+    return index;
+}
+
+void BulletSimulationLOD::UniteGroups(int a, int b) {
+    a = FindGroup(a);
+    b = FindGroup(b);
+    if (a != b) {
+        groups_[std::max(a, b)] = std::min(a, b);
+    }
+}
+
+bool BulletSimulationLOD::IsAwake(const BulletObject* object) {
+    int activation_state = object->body->getActivationState();
+    return activation_state == ACTIVE_TAG ||
+           activation_state == WANTS_DEACTIVATION ||
+           activation_state == DISABLE_DEACTIVATION;
+}
+
+void BulletSimulationLOD::Hold(BulletObject* object) {
+    btRigidBody* body = object->body;
+    object->lod.held = true;
+    object->lod.saved_activation_state = body->getActivationState();
+    object->lod.saved_linear_velocity = ToVec3(body->getLinearVelocity());
+    object->lod.saved_angular_velocity = ToVec3(body->getAngularVelocity());
+    body->forceActivationState(ISLAND_SLEEPING);
+}
+
+void BulletSimulationLOD::Release(BulletObject* object) {
+    btRigidBody* body = object->body;
+    int activation_state = body->getActivationState();
+    if (activation_state == ISLAND_SLEEPING) {
+        body->forceActivationState(object->lod.saved_activation_state);
+        body->setDeactivationTime(0.0f);
+    } else if (activation_state != DISABLE_DEACTIVATION && object->lod.saved_activation_state == DISABLE_DEACTIVATION) {
+        // Woken by bullet, which doesn't know the game never wanted it to sleep
+        body->forceActivationState(DISABLE_DEACTIVATION);
+    }
+    // Bullet zeroes the velocity of sleeping bodies, so anything it has now was done to it while it was held
+    body->setLinearVelocity(body->getLinearVelocity() + ToBtVector3(object->lod.saved_linear_velocity));
+    body->setAngularVelocity(body->getAngularVelocity() + ToBtVector3(object->lod.saved_angular_velocity));
+    object->lod.held = false;
+}
+
+void BulletSimulationLOD::BeforeStep(const std::list<BulletObject*>& dynamic_objects) {
+    objects_.clear();
+    for (auto object : dynamic_objects) {
+        btRigidBody* body = object->body;
+        // Unlinked and frozen bodies keep whatever they had until they are back
+        if (!body || !body->isInWorld() || body->isStaticOrKinematicObject() || body->getActivationState() == DISABLE_SIMULATION) {
+            continue;
+        }
+        body->setUserIndex((int)objects_.size());
+        objects_.push_back(object);
+    }
+    int count = (int)objects_.size();
+
+    // Group everything that was in the same simulation island last step, or is jointed together
+    groups_.resize(count);
+    island_members_.clear();
+    for (int i = 0; i < count; ++i) {
+        groups_[i] = i;
+    }
+    for (int i = 0; i < count; ++i) {
+        btRigidBody* body = objects_[i]->body;
+        int island = body->getIslandTag();
+        if (island >= 0) {
+            if (island >= (int)island_members_.size()) {
+                island_members_.resize(island + 1, -1);
+            }
+            if (island_members_[island] == -1) {
+                island_members_[island] = i;
+            } else {
+                UniteGroups(i, island_members_[island]);
+            }
+        }
+        // Bullet doesn't join the islands of sleeping bodies, so a held ragdoll relies on these
+        for (int j = 0, len = body->getNumConstraintRefs(); j < len; ++j) {
+            btTypedConstraint* constraint = body->getConstraintRef(j);
+            const btRigidBody* other = &constraint->getRigidBodyA() == body ? &constraint->getRigidBodyB() : &constraint->getRigidBodyA();
+            int other_index = other->getUserIndex();
+            if (other_index >= 0 && other_index < count && objects_[other_index]->body == other) {
+                UniteGroups(i, other_index);
+            }
+        }
+    }
+
+    group_levels_.assign(count, kAsleep);
+    group_frames_skipped_.assign(count, INT_MAX);
+    for (int i = 0; i < count; ++i) {
+        BulletObject* object = objects_[i];
+        int group = FindGroup(i);
+        group_levels_[group] = std::min(group_levels_[group], (int)GetLevel(object->GetPosition()));
+        if (object->lod.held || IsAwake(object)) {
+            group_frames_skipped_[group] = std::min(group_frames_skipped_[group], object->lod.frames_skipped);
+        }
+    }
+
+    bool reduced_rate_step = (frame_ % settings_.reduced_rate_interval) == 0;
+    ++frame_;
+    std::fill(counts_, counts_ + kNumLevels, 0);
+    scaled_.clear();
+    for (int i = 0; i < count; ++i) {
+        BulletObject* object = objects_[i];
+        int group = FindGroup(i);
+        Level level = (Level)group_levels_[group];
+        ++counts_[level];
+        if (level == kFullRate || (level == kReducedRate && reduced_rate_step)) {
+            if (object->lod.held) {
+                Release(object);
+            }
+            int frames_skipped = group_frames_skipped_[group];
+            if (level == kReducedRate && frames_skipped > 0 && frames_skipped != INT_MAX && IsAwake(object)) {
+                btRigidBody* body = object->body;
+                ScaledBody scaled;
+                scaled.object = object;
+                scaled.gravity = body->getGravity();
+                scaled.scale = (float)(frames_skipped + 1);
+                body->setLinearVelocity(body->getLinearVelocity() * scaled.scale);
+                body->setAngularVelocity(body->getAngularVelocity() * scaled.scale);
+                body->setGravity(scaled.gravity * scaled.scale * scaled.scale);
+                scaled_.push_back(scaled);
+            }
+            object->lod.frames_skipped = 0;
+        } else if (object->lod.held && object->body->getActivationState() != ISLAND_SLEEPING) {
+            // Something woke it up, so it gets this step at full rate and is held again on the next
+            Release(object);
+            object->lod.frames_skipped = 0;
+        } else {
+            if (!object->lod.held && IsAwake(object)) {
+                Hold(object);
+            }
+            if (object->lod.held) {
+                ++object->lod.frames_skipped;
+            }
+        }
+    }
+}
+
+void BulletSimulationLOD::AfterStep() {
+    for (auto& scaled : scaled_) {
+        btRigidBody* body = scaled.object->body;
+        body->setLinearVelocity(body->getLinearVelocity() / scaled.scale);
+        body->setAngularVelocity(body->getAngularVelocity() / scaled.scale);
+        body->setGravity(scaled.gravity);
+    }
+    scaled_.clear();
+}
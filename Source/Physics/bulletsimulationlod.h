@@ -0,0 +1,104 @@
+//-----------------------------------------------------------------------------
+//           Name: bulletsimulationlod.h
+//      Developer: Wolfire Games LLC
+//    Description: Steps bodies far away from the players less often, or not
+//                 at all, until something comes near them again.
+//        License: Read below
+//-----------------------------------------------------------------------------
+//
+//
+//   Copyright 2022 Wolfire Games LLC
+//
+//   Licensed under the Apache License, Version 2.0 (the "License");
+//   you may not use this file except in compliance with the License.
+//   You may obtain a copy of the License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//   Unless required by applicable law or agreed to in writing, software
+//   distributed under the License is distributed on an "AS IS" BASIS,
+//   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//   See the License for the specific language governing permissions and
+//   limitations under the License.
+//
+//-----------------------------------------------------------------------------
+#pragma once
+
+#include <Math/vec3.h>
+
+#include <LinearMath/btVector3.h>
+
+#include <list>
+#include <vector>
+
+class BulletObject;
+
+struct SimulationLODSettings {
+    float reduced_rate_radius;  // Bodies further than this from every focus point are stepped less often
+    float sleep_radius;         // and further than this not at all, zero to never put them to sleep
+    int reduced_rate_interval;  // Frames per step at the reduced rate
+
+    SimulationLODSettings();
+};
+
+/*
+ * Bodies are held still by forcing bullet's ISLAND_SLEEPING state on them,
+ * which keeps them out of integration and the solver, and remembering the
+ * velocity they had. Held bodies are let go when they come back in range,
+ * when game code wakes them, or when bullet wakes them because an awake
+ * body touched them or a joint connects them to one. Anything joined or
+ * touching (going by last step's simulation islands) shares the level of
+ * its nearest member, so a ragdoll or a pile is never stepped at two rates.
+ *
+ * On the frames reduced rate bodies are stepped, their velocities are
+ * scaled by the number of frames they missed and gravity by its square,
+ * so one normal length step moves them as far as the missed ones would
+ * have. AfterStep() scales them back.
+ */
+class BulletSimulationLOD {
+   public:
+    enum Level {
+        kFullRate,
+        kReducedRate,
+        kAsleep,
+        kNumLevels
+    };
+
+    explicit BulletSimulationLOD(const SimulationLODSettings& settings);
+
+    // Usually where the players and cameras are, everything is at full rate without any
+    void SetFocus(const std::vector<vec3>& points);
+    void BeforeStep(const std::list<BulletObject*>& dynamic_objects);
+    void AfterStep();
+
+    // Bodies at each level as of the last BeforeStep(), asleep or not
+    int GetCount(Level level) const { return counts_[level]; }
+    const SimulationLODSettings& settings() const { return settings_; }
+
+   private:
+    struct ScaledBody {
+        BulletObject* object;
+        btVector3 gravity;
+        float scale;
+    };
+
+    Level GetLevel(const vec3& position) const;
+    int FindGroup(int index);
+    void UniteGroups(int a, int b);
+    static bool IsAwake(const BulletObject* object);
+    static void Hold(BulletObject* object);
+    static void Release(BulletObject* object);
+
+    SimulationLODSettings settings_;
+    std::vector<vec3> focus_;
+    unsigned frame_;
+    int counts_[kNumLevels];
+
+    // Scratch space, kept around so a frame doesn't allocate
+    std::vector<BulletObject*> objects_;
+    std::vector<int> groups_;
+    std::vector<int> island_members_;
+    std::vector<int> group_levels_;
+    std::vector<int> group_frames_skipped_;
+    std::vector<ScaledBody> scaled_;
+};
@@ -0,0 +1,82 @@
+//-----------------------------------------------------------------------------
+//           Name: bullettaskscheduler.cpp
+//      Developer: Wolfire Games LLC
+//    Description: Runs bullet's parallel loops on the engine worker pool.
+//        License: Read below
+//-----------------------------------------------------------------------------
+//
+//
+//   Copyright 2022 Wolfire Games LLC
+//
+//   Licensed under the Apache License, Version 2.0 (the "License");
+//   you may not use this file except in compliance with the License.
+//   You may obtain a copy of the License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//   Unless required by applicable law or agreed to in writing, software
+//   distributed under the License is distributed on an "AS IS" BASIS,
+//   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//   See the License for the specific language governing permissions and
+//   limitations under the License.
+//
+//-----------------------------------------------------------------------------
+#include "bullettaskscheduler.h"
+
+#include <Threading/worker_pool.h>
+#include <Logging/logdata.h>
+
+#include <algorithm>
+#include <mutex>
+
+WorkerPoolTaskScheduler::WorkerPoolTaskScheduler() : btITaskScheduler("WorkerPool") {
+}
+
+void WorkerPoolTaskScheduler::Install() {
+    if (IsInstalled()) {
+        return;
+    }
+    btSetTaskScheduler(this);
+    if (IsInstalled()) {
+        LOGI << "Bullet using the worker pool with " << getNumThreads() << " threads" << std::endl;
+    } else {
+        LOGE << "Could not install the bullet task scheduler, it has to be done from the main thread" << std::endl;
+    }
+}
+
+bool WorkerPoolTaskScheduler::IsInstalled() const {
+    return btGetTaskScheduler() == this;
+}
+
+int WorkerPoolTaskScheduler::getMaxNumThreads() const {
+    return BT_MAX_THREAD_COUNT;
+}
+
+int WorkerPoolTaskScheduler::getNumThreads() const {
+    // The calling thread runs ranges too
+    return std::min(WorkerPool::Instance()->GetThreadCount() + 1, (int)BT_MAX_THREAD_COUNT);
+}
+
+void WorkerPoolTaskScheduler::setNumThreads(int num_threads) {
+    // Zero would mean one worker per core to the pool
+    if (num_threads > 1) {
+        WorkerPool::Instance()->SetThreadCount(std::min(num_threads, (int)BT_MAX_THREAD_COUNT) - 1);
+    }
+}
+
+void WorkerPoolTaskScheduler::parallelFor(int begin, int end, int grain_size, const btIParallelForBody& body) {
+    WorkerPool::Instance()->ParallelFor(end - begin, grain_size, [&](int range_begin, int range_end) {
+        body.forLoop(begin + range_begin, begin + range_end);
+    });
+}
+
+btScalar WorkerPoolTaskScheduler::parallelSum(int begin, int end, int grain_size, const btIParallelSumBody& body) {
+    std::mutex sum_mutex;
+    btScalar sum = btScalar(0);
+    WorkerPool::Instance()->ParallelFor(end - begin, grain_size, [&](int range_begin, int range_end) {
+        btScalar range_sum = body.sumLoop(begin + range_begin, begin + range_end);
+        std::lock_guard<std::mutex> lock(sum_mutex);
+        sum += range_sum;
+    });
+    return sum;
+}
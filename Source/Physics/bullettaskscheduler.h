@@ -0,0 +1,53 @@
+//-----------------------------------------------------------------------------
+//           Name: bullettaskscheduler.h
+//      Developer: Wolfire Games LLC
+//    Description: Runs bullet's parallel loops on the engine worker pool.
+//        License: Read below
+//-----------------------------------------------------------------------------
+//
+//
+//   Copyright 2022 Wolfire Games LLC
+//
+//   Licensed under the Apache License, Version 2.0 (the "License");
+//   you may not use this file except in compliance with the License.
+//   You may obtain a copy of the License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//   Unless required by applicable law or agreed to in writing, software
+//   distributed under the License is distributed on an "AS IS" BASIS,
+//   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//   See the License for the specific language governing permissions and
+//   limitations under the License.
+//
+//-----------------------------------------------------------------------------
+#pragma once
+
+#include <LinearMath/btThreads.h>
+
+/*
+ * Lets the multithreaded bullet classes (btDiscreteDynamicsWorldMt and
+ * friends) use WorkerPool instead of starting threads of their own. Bullet
+ * numbers threads in the order they first call into it and expects the main
+ * thread to be number zero, so Install() has to be called from the main
+ * thread before any other thread touches bullet.
+ */
+class WorkerPoolTaskScheduler : public btITaskScheduler {
+   public:
+    static WorkerPoolTaskScheduler* Instance() {
+        static WorkerPoolTaskScheduler instance;
+        return &instance;
+    }
+
+    void Install();
+    bool IsInstalled() const;
+
+    int getMaxNumThreads() const override;
+    int getNumThreads() const override;
+    void setNumThreads(int num_threads) override;
+    void parallelFor(int begin, int end, int grain_size, const btIParallelForBody& body) override;
+    btScalar parallelSum(int begin, int end, int grain_size, const btIParallelSumBody& body) override;
+
+   private:
+    WorkerPoolTaskScheduler();
+};
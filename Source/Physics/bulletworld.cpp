@@ -25,6 +25,10 @@
 #include <Physics/physics.h>
 #include <Physics/bulletobject.h>
 #include <Physics/bulletcollision.h>
+#include <Physics/bulletmeshcache.h>
+#include <Physics/bulletoverlaptracker.h>
+#include <Physics/bulletsimulationlod.h>
+#include <Physics/bullettaskscheduler.h>
 
 #include <Graphics/camera.h>
 #include <Graphics/geometry.h>
@@ -41,6 +45,8 @@
 #include <Internal/profiler.h>
 #include <Internal/timer.h>
 
+#include <Threading/worker_pool.h>
+
 #include <Sound/sound.h>
 #include <UserInput/input.h>
 #include <Math/vec3math.h>
@@ -64,12 +70,14 @@
 #include <BulletCollision/Gimpact/btGImpactShape.h>
 #include <BulletCollision/Gimpact/btGImpactCollisionAlgorithm.h>
 #include <BulletCollision/NarrowPhaseCollision/btRaycastCallback.h>
+#include <BulletDynamics/Dynamics/btDiscreteDynamicsWorldMt.h>
 
 #if defined(__GNUC__)
 #pragma GCC diagnostic pop
 #endif
 
 #include <set>
+#include <mutex>
 
 extern bool g_simple_shadows;
 extern bool g_level_shadows;
@@ -112,7 +120,7 @@ static bool CustomMaterialCombinerCallback(btManifoldPoint &cp, const btCollisio
 }
 
 extern ContactAddedCallback gContactAddedCallback;
-void BulletWorld::Init() {
+void BulletWorld::Init(bool multithreaded) {
     Dispose();
     gContactAddedCallback = CustomMaterialCombinerCallback;
     // collision_configuration_ = new btDefaultCollisionConfiguration(); // 4 mb ram
@@ -124,17 +132,37 @@ void BulletWorld::Init() {
     collision_dispatcher_ = new btCollisionDispatcher(collision_configuration_);
     btGImpactCollisionAlgorithm::registerAlgorithm(collision_dispatcher_);
     broadphase_interface_ = new btDbvtBroadphase();
-    constraint_solver_ = new btSequentialImpulseConstraintSolver;
 #ifdef ALLOW_SOFTBODY
+    if (multithreaded) {
+        LOGW << "Multithreaded physics is not available in soft body builds" << std::endl;
+    }
+    constraint_solver_ = new btSequentialImpulseConstraintSolver;
     dynamics_world_ = new btSoftRigidDynamicsWorld(collision_dispatcher_,
                                                    broadphase_interface_,
                                                    constraint_solver_,
                                                    collision_configuration_);
 #else
-    dynamics_world_ = new btDiscreteDynamicsWorld(collision_dispatcher_,
-                                                  broadphase_interface_,
-                                                  constraint_solver_,
-                                                  collision_configuration_);
+    if (multithreaded && !WorkerPoolTaskScheduler::Instance()->IsInstalled()) {
+        LOGW << "Bullet task scheduler is not installed, falling back to single threaded physics" << std::endl;
+        multithreaded = false;
+    }
+    if (multithreaded) {
+        // Each simulation island gets solved on whichever thread picks it up, with a solver per thread.
+        // Narrowphase stays on the calling thread, GImpact shapes can't be collided from two threads at once
+        btConstraintSolverPoolMt *solver_pool = new btConstraintSolverPoolMt(WorkerPoolTaskScheduler::Instance()->getNumThreads());
+        constraint_solver_ = solver_pool;
+        dynamics_world_ = new btDiscreteDynamicsWorldMt(collision_dispatcher_,
+                                                        broadphase_interface_,
+                                                        solver_pool,
+                                                        NULL,
+                                                        collision_configuration_);
+    } else {
+        constraint_solver_ = new btSequentialImpulseConstraintSolver;
+        dynamics_world_ = new btDiscreteDynamicsWorld(collision_dispatcher_,
+                                                      broadphase_interface_,
+                                                      constraint_solver_,
+                                                      collision_configuration_);
+    }
 #endif
     dynamics_world_->setForceUpdateAllAabbs(false);
 
@@ -198,6 +226,10 @@ void BulletWorld::Dispose() {
     constraint_solver_ = NULL;
     delete broadphase_interface_;
     broadphase_interface_ = NULL;
+    delete overlap_tracker_;
+    overlap_tracker_ = NULL;
+    delete simulation_lod_;
+    simulation_lod_ = NULL;
     delete collision_dispatcher_;
     collision_dispatcher_ = NULL;
     delete collision_configuration_;
@@ -220,104 +252,48 @@ void BulletWorld::Dispose() {
 
 void BulletWorld::Update(float timestep) {
     if (dynamics_world_) {
-        dynamics_world_->stepSimulation(1.0f, 1, timestep);
+        if (simulation_lod_) {
+            {
+                PROFILER_ZONE(g_profiler_ctx, "Simulation LOD");
+                simulation_lod_->BeforeStep(dynamic_objects_);
+            }
+            PROFILER_ZONE(g_profiler_ctx, "Step (%d full rate, %d reduced rate, %d asleep)",
+                          simulation_lod_->GetCount(BulletSimulationLOD::kFullRate),
+                          simulation_lod_->GetCount(BulletSimulationLOD::kReducedRate),
+                          simulation_lod_->GetCount(BulletSimulationLOD::kAsleep));
+            dynamics_world_->stepSimulation(1.0f, 1, timestep);
+            simulation_lod_->AfterStep();
+        } else {
+            dynamics_world_->stepSimulation(1.0f, 1, timestep);
+        }
         HandleCollisionEffects();
         UpdateBulletObjectTransforms();
         RemoveTempConstraints();
     }
 }
 
-std::map<void *, std::set<void *> > &BulletWorld::GetCollisions() {
-    PROFILER_ZONE(g_profiler_ctx, "BulletWorld::GetCollisions()");
-    collision_report_.clear();
-    if (false) {
-        // PROFILER_ZONE(g_profiler_ctx, "performDiscreteCollisionDetection");
-        // dynamics_world_->performDiscreteCollisionDetection();
-        PROFILER_ENTER(g_profiler_ctx, "getDispatchInfo");
-        btDispatcherInfo &dispatchInfo = dynamics_world_->getDispatchInfo();
-        PROFILER_LEAVE(g_profiler_ctx);
-
-        dynamics_world_->setForceUpdateAllAabbs(true);
-
-        PROFILER_ENTER(g_profiler_ctx, "updateAabbs");
-        dynamics_world_->updateAabbs();
-        PROFILER_LEAVE(g_profiler_ctx);
-
-        PROFILER_ENTER(g_profiler_ctx, "computeOverlappingPairs");
-        dynamics_world_->computeOverlappingPairs();
-        PROFILER_LEAVE(g_profiler_ctx);
-
-        PROFILER_ENTER(g_profiler_ctx, "getDispatcher");
-        btDispatcher *dispatcher = dynamics_world_->getDispatcher();
-        PROFILER_LEAVE(g_profiler_ctx);
-        {
-            BT_PROFILE("dispatchAllCollisionPairs");
-            if (dispatcher) {
-                PROFILER_ENTER(g_profiler_ctx, "dispatchAllCollisionPairs");
-                dispatcher->dispatchAllCollisionPairs(dynamics_world_->m_broadphasePairCache->getOverlappingPairCache(), dispatchInfo, dynamics_world_->m_dispatcher1);
-                PROFILER_LEAVE(g_profiler_ctx);
-            }
-        }
+BulletOverlapTracker *BulletWorld::UpdateOverlaps() {
+    PROFILER_ZONE(g_profiler_ctx, "BulletWorld::UpdateOverlaps()");
+    LOG_ASSERT(overlap_tracker_);
+    // Nothing in an overlap world responds to contacts, so collision detection is all a step would do
+    dynamics_world_->performDiscreteCollisionDetection();
+    {
+        PROFILER_ZONE(g_profiler_ctx, "Update tracked pairs");
+        overlap_tracker_->Update(broadphase_interface_->getOverlappingPairCache());
     }
+    return overlap_tracker_;
+}
 
-    PROFILER_ENTER(g_profiler_ctx, "stepSimulation");
-    dynamics_world_->stepSimulation(1, 1, (btScalar)0.000001);
-    PROFILER_LEAVE(g_profiler_ctx);
-    /*
-    btOverlappingPairCache* pairs = dynamics_world_->m_broadphasePairCache->getOverlappingPairCache();
-    btBroadphasePairArray& pair_array = pairs->getOverlappingPairArray();
-    for(int i=0, len=pair_array.size(); i<len; ++i){
-            btVector3 a = (pair_array[i].m_pProxy0->m_aabbMin + pair_array[i].m_pProxy0->m_aabbMax)*0.5;
-            btVector3 b = (pair_array[i].m_pProxy1->m_aabbMin + pair_array[i].m_pProxy1->m_aabbMax)*0.5;
-            DebugDraw::Instance()->AddLine(*((vec3*)&a),*((vec3*)&b), vec4(0.0f, 1.0f, 0.0f, 1.0f), vec4(0.0f, 1.0f, 0.0f, 1.0f), _delete_on_update);
-            btVector3 size = pair_array[i].m_pProxy0->m_aabbMax - pair_array[i].m_pProxy0->m_aabbMin;
-            DebugDraw::Instance()->AddWireBox(*((vec3*)&a),*((vec3*)&size), vec4(1.0f,0.0f,0.0f,0.3f), _delete_on_update);
-            size = pair_array[i].m_pProxy1->m_aabbMax - pair_array[i].m_pProxy1->m_aabbMin;
-            DebugDraw::Instance()->AddWireBox(*((vec3*)&b),*((vec3*)&size), vec4(1.0f,0.0f,0.0f,0.3f), _delete_on_update);
-    }*/
+void BulletWorld::EnableSimulationLOD(const SimulationLODSettings &settings) {
+    delete simulation_lod_;
+    simulation_lod_ = new BulletSimulationLOD(settings);
+}
 
-    {
-        PROFILER_ZONE(g_profiler_ctx, "Prepare report");
-        int numManifolds = collision_dispatcher_->getNumManifolds();
-        for (int i = 0; i < numManifolds; i++) {
-            btPersistentManifold *contactManifold =
-                collision_dispatcher_->getManifoldByIndexInternal(i);
-            int numContacts = contactManifold->getNumContacts();
-            if (numContacts == 0) {
-                continue;
-            }
-            const btCollisionObject *obA =
-                static_cast<const btCollisionObject *>(contactManifold->getBody0());
-            const btCollisionObject *obB =
-                static_cast<const btCollisionObject *>(contactManifold->getBody1());
-            void *ptrA = obA->getUserPointer();
-            void *ptrB = obB->getUserPointer();
-            if (!ptrA || !ptrB) {
-                continue;
-            }
-            ptrA = ((BulletObject *)ptrA)->owner_object;
-            ptrB = ((BulletObject *)ptrB)->owner_object;
-            if (!ptrA || !ptrB) {
-                continue;
-            }
-            if (ptrA < ptrB) {
-                collision_report_[ptrA].insert(ptrB);
-            } else {
-                collision_report_[ptrB].insert(ptrA);
-            }
-            /*
-            for (int j=0;j<numContacts;j++)
-            {
-                    btManifoldPoint& pt = contactManifold->getContactPoint(j);
-                    const btVector3& ptA = pt.getPositionWorldOnA();
-                    const btVector3& ptB = pt.getPositionWorldOnB();
-                    btVector3 bt_col = (ptA + ptB)*0.5f;
-                    vec3 collision_point(bt_col[0], bt_col[1], bt_col[2]);
-                    DebugDraw::Instance()->AddWireSphere(collision_point,0.1f,vec4(1.0f,0.0f,0.0f,1.0f),_delete_on_update);
-            }*/
-        }
+void BulletWorld::EnableOverlapTracking() {
+    if (!overlap_tracker_) {
+        overlap_tracker_ = new BulletOverlapTracker();
+        broadphase_interface_->getOverlappingPairCache()->setInternalGhostPairCallback(overlap_tracker_);
     }
-    return collision_report_;
 }
 
 void BulletWorld::GetConvexHullCollisions(const std::string &path, const mat4 &transform, btCollisionWorld::ContactResultCallback &cb) {
@@ -652,6 +628,19 @@ btBvhTriangleMeshShape *BulletWorld::CreateMeshShape(const Model *the_mesh, Shap
                                                            vertex_stride);
     PROFILER_LEAVE(g_profiler_ctx);
 
+    std::string cache_path = GetBulletMeshCachePath(mesh);
+    MurmurHash mesh_hash;
+    if (!cache_path.empty()) {
+        PROFILER_ZONE(g_profiler_ctx, "GetBulletMeshHash");
+        mesh_hash = GetBulletMeshHash(faces, &mesh.vertices[0], mesh.vertices.size() / 3);
+        if (LoadBulletMeshCache(cache_path.c_str(), mesh_hash, data)) {
+            btBvhTriangleMeshShape *shape = new btBvhTriangleMeshShape(data.index_vert_array, true, false);
+            shape->setOptimizedBvh(data.bvh);
+            shape->setTriangleInfoMap(data.triangle_info_map);
+            return shape;
+        }
+    }
+
     PROFILER_ENTER(g_profiler_ctx, "Creating btBvhTriangleMeshShape");
     btBvhTriangleMeshShape *shape = new btBvhTriangleMeshShape(data.index_vert_array, true);
     PROFILER_LEAVE(g_profiler_ctx);
@@ -661,6 +650,10 @@ btBvhTriangleMeshShape *BulletWorld::CreateMeshShape(const Model *the_mesh, Shap
     btGenerateInternalEdgeInfo(shape, data.triangle_info_map);
     PROFILER_LEAVE(g_profiler_ctx);
 
+    if (!cache_path.empty()) {
+        SaveBulletMeshCache(cache_path.c_str(), mesh_hash, *shape->getOptimizedBvh(), *data.triangle_info_map);
+    }
+
     return shape;
 }
 
@@ -729,7 +722,9 @@ BulletWorld::BulletWorld() : dynamics_world_(NULL),
                              broadphase_interface_(NULL),
                              collision_dispatcher_(NULL),
                              constraint_solver_(NULL),
-                             collision_configuration_(NULL) {
+                             collision_configuration_(NULL),
+                             overlap_tracker_(NULL),
+                             simulation_lod_(NULL) {
 }
 
 BulletWorld::~BulletWorld() {
@@ -1066,6 +1061,132 @@ const btCollisionObject *BulletWorld::CheckRayCollision(const vec3 &start,
     return callback.m_collisionObject;
 }
 
+namespace {
+struct BatchRayResultCallback : public btCollisionWorld::RayResultCallback {
+    btVector3 hit_normal;
+
+    btScalar addSingleResult(btCollisionWorld::LocalRayResult &ray_result, bool normal_in_world_space) override {
+        m_closestHitFraction = ray_result.m_hitFraction;
+        m_collisionObject = ray_result.m_collisionObject;
+        if (normal_in_world_space) {
+            hit_normal = ray_result.m_hitNormalLocal;
+        } else {
+            hit_normal = m_collisionObject->getWorldTransform().getBasis() * ray_result.m_hitNormalLocal;
+        }
+        return ray_result.m_hitFraction;
+    }
+};
+
+// GImpact shapes lock and unlock their vertex data with a shared counter while being queried
+std::mutex gimpact_query_mutex;
+
+// Narrowphase for every broadphase leaf the query's swept box crosses, like btCollisionWorld::rayTest does
+struct BatchQueryCollider : public btDbvt::ICollide {
+    btTransform from;
+    btTransform to;
+    btSphereShape *sphere;
+    btCollisionWorld::RayResultCallback *ray_callback;
+    btCollisionWorld::ConvexResultCallback *sphere_callback;
+
+    void Process(const btDbvtNode *leaf) override {
+        btBroadphaseProxy *proxy = (btBroadphaseProxy *)leaf->data;
+        btCollisionObject *col_obj = (btCollisionObject *)proxy->m_clientObject;
+        const btCollisionShape *shape = col_obj->getCollisionShape();
+        std::unique_lock<std::mutex> lock(gimpact_query_mutex, std::defer_lock);
+        if (shape->getShapeType() == GIMPACT_SHAPE_PROXYTYPE) {
+            lock.lock();
+        }
+        if (sphere) {
+            if (sphere_callback->m_closestHitFraction > 0.0f && sphere_callback->needsCollision(proxy)) {
+                btCollisionWorld::objectQuerySingle(sphere, from, to, col_obj, shape, col_obj->getWorldTransform(), *sphere_callback, 0.0f);
+            }
+        } else {
+            if (ray_callback->m_closestHitFraction > 0.0f && ray_callback->needsCollision(proxy)) {
+                btCollisionWorld::rayTestSingle(from, to, col_obj, shape, col_obj->getWorldTransform(), *ray_callback);
+            }
+        }
+    }
+};
+
+struct RayQueryBatch {
+    const btDbvtBroadphase *broadphase;
+    const RayQuery *queries;
+    RayQueryResult *results;
+};
+
+void CheckRayCollisionRange(int begin, int end, void *userdata) {
+    const RayQueryBatch &batch = *(const RayQueryBatch *)userdata;
+    btAlignedObjectArray<const btDbvtNode *> stack;
+    stack.reserve(128);
+    for (int i = begin; i < end; ++i) {
+        const RayQuery &query = batch.queries[i];
+        RayQueryResult &result = batch.results[i];
+        result.object = NULL;
+        result.point = query.end;
+        result.normal = vec3(0.0f);
+        result.fraction = 1.0f;
+
+        btVector3 bt_start = ToBtVector3(query.start);
+        btVector3 bt_end = ToBtVector3(query.end);
+        btVector3 dir = bt_end - bt_start;
+        btScalar length = dir.length();
+        if (length <= std::numeric_limits<float>::epsilon()) {
+            continue;
+        }
+        dir /= length;
+        btVector3 dir_inverse;
+        unsigned int signs[3];
+        for (int j = 0; j < 3; ++j) {
+            dir_inverse[j] = dir[j] == 0.0f ? BT_LARGE_FLOAT : 1.0f / dir[j];
+            signs[j] = dir_inverse[j] < 0.0f;
+        }
+        btVector3 extent(query.radius, query.radius, query.radius);
+
+        BatchQueryCollider collider;
+        collider.from.setIdentity();
+        collider.from.setOrigin(bt_start);
+        collider.to.setIdentity();
+        collider.to.setOrigin(bt_end);
+        BatchRayResultCallback ray_callback;
+        btCollisionWorld::ClosestConvexResultCallback sphere_callback(bt_start, bt_end);
+        btSphereShape sphere(query.radius);
+        if (query.static_only) {
+            ray_callback.m_collisionFilterMask = btBroadphaseProxy::StaticFilter;
+            sphere_callback.m_collisionFilterMask = btBroadphaseProxy::StaticFilter;
+        }
+        collider.sphere = query.radius > 0.0f ? &sphere : NULL;
+        collider.ray_callback = &ray_callback;
+        collider.sphere_callback = &sphere_callback;
+        for (int j = 0; j < 2; ++j) {
+            const btDbvt &tree = batch.broadphase->m_sets[j];
+            tree.rayTestInternal(tree.m_root, bt_start, bt_end, dir_inverse, signs, length, -extent, extent, stack, collider);
+        }
+
+        if (collider.sphere && sphere_callback.hasHit()) {
+            result.object = sphere_callback.m_hitCollisionObject;
+            result.normal = ToVec3(sphere_callback.m_hitNormalWorld);
+            result.fraction = sphere_callback.m_closestHitFraction;
+        } else if (!collider.sphere && ray_callback.hasHit()) {
+            result.object = ray_callback.m_collisionObject;
+            result.normal = ToVec3(ray_callback.hit_normal);
+            result.fraction = ray_callback.m_closestHitFraction;
+        }
+        result.point = query.end * result.fraction + query.start * (1.0f - result.fraction);
+    }
+}
+}  // namespace
+
+void BulletWorld::CheckRayCollisionBatch(const RayQuery *queries, int count, RayQueryResult *results) const {
+    PROFILER_ZONE(g_profiler_ctx, "BulletWorld::CheckRayCollisionBatch");
+    RayQueryBatch batch;
+    batch.broadphase = (const btDbvtBroadphase *)broadphase_interface_;
+    batch.queries = queries;
+    batch.results = results;
+    // 32 rays against level geometry are around 0.2ms of work, plenty to be worth handing to a worker
+    const int kQueriesPerRange = 32;
+    WorkerPool::Instance()->ParallelFor(count, kQueriesPerRange, CheckRayCollisionRange, &batch);
+}
+
 int BulletWorld::CheckRayCollisionObj(const vec3 &start,
                                       const vec3 &end,
                                       const BulletObject &obj,
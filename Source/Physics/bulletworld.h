@@ -74,6 +74,9 @@ class btConvexHullShape;
 class btConvexShape;
 class btRigidBody;
 class btGImpactMeshShape;
+class BulletOverlapTracker;
+class BulletSimulationLOD;
+struct SimulationLODSettings;
 
 typedef unsigned char BWFlags;
 
@@ -84,6 +87,20 @@ struct CollideInfo {
     bool true_impact;
 };
 
+struct RayQuery {
+    vec3 start;
+    vec3 end;
+    float radius;  // Zero for a ray, otherwise a sphere swept from start to end
+    bool static_only;
+};
+
+struct RayQueryResult {
+    const btCollisionObject *object;  // NULL if nothing was hit
+    vec3 point;                       // Where the ray or sphere center stopped, end if nothing was hit
+    vec3 normal;                      // World space surface normal at the hit
+    float fraction;                   // Of the way from start to end
+};
+
 enum BWFlagValues {
     BW_NO_FLAGS = 0,
     BW_NO_STATIC_COLLISIONS = (1 << 0),
@@ -98,7 +115,9 @@ class BulletWorld {
     BulletWorld();
     ~BulletWorld();
 
-    void Init();
+    // Multithreaded worlds solve their simulation islands in parallel on the worker pool,
+    // which needs WorkerPoolTaskScheduler to be installed first
+    void Init(bool multithreaded = false);
     void Dispose();
 
     void Update(float timestep);
@@ -110,6 +129,9 @@ class BulletWorld {
     const btCollisionObject *CheckRayCollision(const vec3 &start, const vec3 &end, vec3 *point = NULL, vec3 *normal = NULL, bool static_col = true) const;
     void CheckRayCollisionInfo(const vec3 &start, const vec3 &end, SimpleRayResultCallbackInfo &cb, bool static_only = true);
     void CheckRayTriCollisionInfo(const vec3 &start, const vec3 &end, SimpleRayTriResultCallback &cb, bool static_only = true);
+    // Runs the queries on the worker pool and writes one result per query. The world is only read,
+    // so this must not overlap with stepping it or adding and removing objects.
+    void CheckRayCollisionBatch(const RayQuery *queries, int count, RayQueryResult *results) const;
     vec3 CheckSphereCollisionSlide(const vec3 &start, float radius);
     void GetSphereCollisions(const vec3 &pos, float radius, btCollisionWorld::ContactResultCallback &cb);
     void GetSweptSphereCollisions(const vec3 &start, const vec3 &end, float radius, SweptSlideCallback &callback);
@@ -126,7 +148,8 @@ class BulletWorld {
     void GetBoxCollisions(const vec3 &pos, const vec3 &dimensions, btCollisionWorld::ContactResultCallback &cb);
     void GetPairCollisions(btCollisionObject &a, btCollisionObject &b, btCollisionWorld::ContactResultCallback &cb);
     void GetScaledSphereCollisions(const vec3 &pos, float radius, const vec3 &scale, btCollisionWorld::ContactResultCallback &callback);
-    std::map<void *, std::set<void *> > &GetCollisions();
+    // Detects collisions without stepping the simulation, and reports them to the overlap tracker
+    BulletOverlapTracker *UpdateOverlaps();
     void GetConvexHullCollisions(const std::string &path, const mat4 &transform, btCollisionWorld::ContactResultCallback &cb);
     // Collision response
     vec3 ApplySphereSlide(const vec3 &pos, float radius, SlideCollisionInfo &info);
@@ -182,6 +205,9 @@ class BulletWorld {
     void UpdateSingleAABB(BulletObject *bullet_object);
     int NumObjects();
     void FinalizeStaticEntries();
+    void EnableOverlapTracking();
+    // Steps bodies far from the focus points set on simulation_lod_ less often, or not at all
+    void EnableSimulationLOD(const SimulationLODSettings &settings);
     static mat4 GetCapsuleTransform(vec3 start, vec3 end);
     static btGImpactMeshShape *CreateDynamicMeshShape(std::vector<int> &indices, std::vector<float> &vertices, ShapeDisposalData &data);
     btSoftBody *AddCloth(const vec3 &pos);
@@ -217,7 +243,8 @@ class BulletWorld {
     std::vector<float> vertices;
     BulletObject *merged_obj;
 
-    std::map<void *, std::set<void *> > collision_report_;
+    BulletOverlapTracker *overlap_tracker_;
+    BulletSimulationLOD *simulation_lod_;
     typedef std::map<std::string, btConvexHullShape *> HullShapeCacheMap;
     HullShapeCacheMap hull_shape_cache_;
 
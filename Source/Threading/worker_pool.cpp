@@ -0,0 +1,140 @@
+//-----------------------------------------------------------------------------
+//           Name: worker_pool.cpp
+//      Developer: Wolfire Games LLC
+//    Description: Persistent worker threads for splitting per-frame work
+//                 into ranges that run in parallel.
+//        License: Read below
+//-----------------------------------------------------------------------------
+//
+//   Copyright 2022 Wolfire Games LLC
+//
+//   Licensed under the Apache License, Version 2.0 (the "License");
+//   you may not use this file except in compliance with the License.
+//   You may obtain a copy of the License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//   Unless required by applicable law or agreed to in writing, software
+//   distributed under the License is distributed on an "AS IS" BASIS,
+//   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//   See the License for the specific language governing permissions and
+//   limitations under the License.
+//
+//-----------------------------------------------------------------------------
+#include "worker_pool.h"
+
+#include <Threading/thread_name.h>
+#include <Logging/logdata.h>
+
+#include <algorithm>
+
+// Set on workers, and on the calling thread while it runs ranges itself
+static thread_local bool running_ranges = false;
+
+WorkerPool::WorkerPool() : stop(false),
+                           generation(0),
+                           job_open(false),
+                           active_workers(0),
+                           func(NULL),
+                           userdata(NULL),
+                           count(0),
+                           grain(1),
+                           next(0) {
+}
+
+WorkerPool::~WorkerPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stop = true;
+    }
+    job_available.notify_all();
+    for (auto& thread : threads) {
+        thread->join();
+        delete thread;
+    }
+    threads.clear();
+}
+
+void WorkerPool::SetThreadCount(int thread_count) {
+    if (thread_count <= 0) {
+        int cores = (int)std::thread::hardware_concurrency();
+        thread_count = std::max(0, std::min(cores - 1, 8));
+    }
+    if ((int)threads.size() >= thread_count) {
+        return;
+    }
+    while ((int)threads.size() < thread_count) {
+        threads.push_back(new std::thread(Operate, this));
+    }
+    LOGI << "Worker pool using " << threads.size() << " threads" << std::endl;
+}
+
+void WorkerPool::Operate(WorkerPool* pool) {
+    NameCurrentThread("Worker");
+    running_ranges = true;
+    unsigned seen_generation = 0;
+    std::unique_lock<std::mutex> lock(pool->mutex);
+    while (true) {
+        while (!pool->stop && !(pool->job_open && pool->generation != seen_generation)) {
+            pool->job_available.wait(lock);
+        }
+        if (pool->stop) {
+            return;
+        }
+        seen_generation = pool->generation;
+        pool->active_workers++;
+        lock.unlock();
+        pool->RunRanges();
+        lock.lock();
+        pool->active_workers--;
+        if (pool->active_workers == 0) {
+            pool->job_done.notify_all();
+        }
+    }
+}
+
+void WorkerPool::RunRanges() {
+    while (true) {
+        int begin = next.fetch_add(grain);
+        if (begin >= count) {
+            return;
+        }
+        func(begin, std::min(begin + grain, count), userdata);
+    }
+}
+
+void WorkerPool::ParallelFor(int count, int grain, WorkerRangeFunc func, void* userdata) {
+    if (count <= 0) {
+        return;
+    }
+    grain = std::max(1, grain);
+    if (threads.empty() || count <= grain || running_ranges || !job_mutex.try_lock()) {
+        for (int begin = 0; begin < count; begin += grain) {
+            func(begin, std::min(begin + grain, count), userdata);
+        }
+        return;
+    }
+    std::lock_guard<std::mutex> job_lock(job_mutex, std::adopt_lock);
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        this->func = func;
+        this->userdata = userdata;
+        this->count = count;
+        this->grain = grain;
+        next = 0;
+        job_open = true;
+        ++generation;
+    }
+    job_available.notify_all();
+
+    running_ranges = true;
+    RunRanges();
+    running_ranges = false;
+
+    // Workers that wake up after this don't join, and the ones that did are finishing their last range
+    std::unique_lock<std::mutex> lock(mutex);
+    job_open = false;
+    while (active_workers > 0) {
+        job_done.wait(lock);
+    }
+}
@@ -0,0 +1,88 @@
+//-----------------------------------------------------------------------------
+//           Name: worker_pool.h
+//      Developer: Wolfire Games LLC
+//    Description: Persistent worker threads for splitting per-frame work
+//                 into ranges that run in parallel.
+//        License: Read below
+//-----------------------------------------------------------------------------
+//
+//   Copyright 2022 Wolfire Games LLC
+//
+//   Licensed under the Apache License, Version 2.0 (the "License");
+//   you may not use this file except in compliance with the License.
+//   You may obtain a copy of the License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//   Unless required by applicable law or agreed to in writing, software
+//   distributed under the License is distributed on an "AS IS" BASIS,
+//   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//   See the License for the specific language governing permissions and
+//   limitations under the License.
+//
+//-----------------------------------------------------------------------------
+#pragma once
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <vector>
+
+typedef void (*WorkerRangeFunc)(int begin, int end, void* userdata);
+
+/*
+ * ParallelFor splits [0, count) into ranges of at most grain items and runs
+ * them on the workers and the calling thread, returning once all of them
+ * are done. Only one ParallelFor runs at a time; a call made from inside a
+ * range, or while another thread has the pool, runs inline on the calling
+ * thread instead, so it is always safe to call.
+ */
+class WorkerPool {
+   public:
+    static WorkerPool* Instance() {
+        static WorkerPool instance;
+        return &instance;
+    }
+
+    ~WorkerPool();
+
+    // Zero or less picks one worker per core, leaving one for the main thread. Only grows the pool.
+    void SetThreadCount(int thread_count);
+    int GetThreadCount() const { return (int)threads.size(); }
+
+    void ParallelFor(int count, int grain, WorkerRangeFunc func, void* userdata);
+
+    template <typename Func>
+    void ParallelFor(int count, int grain, const Func& func) {
+        ParallelFor(count, grain, &CallRange<Func>, (void*)&func);
+    }
+
+   private:
+    WorkerPool();
+
+    template <typename Func>
+    static void CallRange(int begin, int end, void* userdata) {
+        (*(const Func*)userdata)(begin, end);
+    }
+
+    static void Operate(WorkerPool* pool);
+    void RunRanges();
+
+    std::vector<std::thread*> threads;
+    std::mutex job_mutex;  // Held by the thread running a ParallelFor
+    std::mutex mutex;
+    std::condition_variable job_available;
+    std::condition_variable job_done;
+    bool stop;
+
+    // The current job, read by workers once they have joined it
+    unsigned generation;
+    bool job_open;
+    int active_workers;
+    WorkerRangeFunc func;
+    void* userdata;
+    int count;
+    int grain;
+    std::atomic<int> next;
+};
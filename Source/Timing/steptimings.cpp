@@ -0,0 +1,90 @@
+//-----------------------------------------------------------------------------
+//           Name: steptimings.cpp
+//      Developer: Wolfire Games LLC
+//    Description: Per game step time spent in each engine subsystem, written
+//                 out as CSV when replaying a recorded session.
+//        License: Read below
+//-----------------------------------------------------------------------------
+//
+//   Copyright 2022 Wolfire Games LLC
+//
+//   Licensed under the Apache License, Version 2.0 (the "License");
+//   you may not use this file except in compliance with the License.
+//   You may obtain a copy of the License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//   Unless required by applicable law or agreed to in writing, software
+//   distributed under the License is distributed on an "AS IS" BASIS,
+//   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//   See the License for the specific language governing permissions and
+//   limitations under the License.
+//
+//-----------------------------------------------------------------------------
+#include "steptimings.h"
+
+#include <Compat/fileio.h>
+#include <Logging/logdata.h>
+
+static double ToMilliseconds(uint64_t precision_time) {
+    return ToNanoseconds(precision_time) / 1000000.0;
+}
+
+StepTimings::StepTimings() : enabled_(false),
+                             step_(0),
+                             step_start_(0) {
+    for (auto& total : totals_) {
+        total = 0;
+    }
+}
+
+bool StepTimings::Open(const std::string& path) {
+    Close();
+    my_ofstream_open(csv_output_, path);
+    if (!csv_output_.is_open()) {
+        LOGE << "Unable to open " << path << " for writing step timings" << std::endl;
+        return false;
+    }
+    csv_output_ << "step,total_ms,physics_ms,scripts_ms,animation_ms,audio_ms" << std::endl;
+    step_ = 0;
+    enabled_ = true;
+    BeginFrame();
+    LOGI << "Writing step timings to " << path << std::endl;
+    return true;
+}
+
+void StepTimings::Close() {
+    if (enabled_) {
+        csv_output_.close();
+        enabled_ = false;
+    }
+}
+
+void StepTimings::BeginFrame() {
+    if (!enabled_) {
+        return;
+    }
+    step_start_ = GetPrecisionTime();
+    for (auto& total : totals_) {
+        total = 0;
+    }
+}
+
+void StepTimings::Add(Category category, uint64_t precision_time) {
+    totals_[category] += precision_time;
+}
+
+void StepTimings::EndStep() {
+    if (!enabled_) {
+        return;
+    }
+    uint64_t now = GetPrecisionTime();
+    csv_output_ << step_ << "," << ToMilliseconds(now - step_start_);
+    for (auto& total : totals_) {
+        csv_output_ << "," << ToMilliseconds(total);
+        total = 0;
+    }
+    csv_output_ << "\n";
+    step_start_ = now;
+    ++step_;
+}
@@ -0,0 +1,81 @@
+//-----------------------------------------------------------------------------
+//           Name: steptimings.h
+//      Developer: Wolfire Games LLC
+//    Description: Per game step time spent in each engine subsystem, written
+//                 out as CSV when replaying a recorded session.
+//        License: Read below
+//-----------------------------------------------------------------------------
+//
+//   Copyright 2022 Wolfire Games LLC
+//
+//   Licensed under the Apache License, Version 2.0 (the "License");
+//   you may not use this file except in compliance with the License.
+//   You may obtain a copy of the License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//   Unless required by applicable law or agreed to in writing, software
+//   distributed under the License is distributed on an "AS IS" BASIS,
+//   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//   See the License for the specific language governing permissions and
+//   limitations under the License.
+//
+//-----------------------------------------------------------------------------
+#pragma once
+
+#include <Compat/time.h>
+
+#include <atomic>
+#include <fstream>
+#include <string>
+
+class StepTimings {
+   public:
+    enum Category {
+        kPhysics,
+        kScripts,
+        kAnimation,
+        kAudio,
+        kNumCategories
+    };
+
+    StepTimings();
+
+    static StepTimings* Instance() {
+        static StepTimings instance;
+        return &instance;
+    }
+
+    // Starts writing a row per step to a CSV file at path
+    bool Open(const std::string& path);
+    void Close();
+    bool IsOpen() const { return enabled_; }
+
+    // Time before the first step of a frame, like the audio update, is counted towards that step
+    void BeginFrame();
+    void Add(Category category, uint64_t precision_time);
+    void EndStep();
+
+   private:
+    bool enabled_;
+    std::ofstream csv_output_;
+    int step_;
+    uint64_t step_start_;
+    std::atomic<uint64_t> totals_[kNumCategories];
+};
+
+// Adds the time until it goes out of scope to a category, if timings are being written
+class ScopedStepTiming {
+   public:
+    explicit ScopedStepTiming(StepTimings::Category category) : category_(category),
+                                                                start_(StepTimings::Instance()->IsOpen() ? GetPrecisionTime() : 0) {}
+    ~ScopedStepTiming() {
+        if (start_ != 0) {
+            StepTimings::Instance()->Add(category_, GetPrecisionTime() - start_);
+        }
+    }
+
+   private:
+    StepTimings::Category category_;
+    uint64_t start_;
+};
@@ -0,0 +1,179 @@
+//-----------------------------------------------------------------------------
+//           Name: aabb_tree_test.cpp
+//      Developer: Wolfire Games LLC
+//    Description:
+//        License: Read below
+//-----------------------------------------------------------------------------
+//
+//
+//   Copyright 2022 Wolfire Games LLC
+//
+//   Licensed under the Apache License, Version 2.0 (the "License");
+//   you may not use this file except in compliance with the License.
+//   You may obtain a copy of the License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//   Unless required by applicable law or agreed to in writing, software
+//   distributed under the License is distributed on an "AS IS" BASIS,
+//   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//   See the License for the specific language governing permissions and
+//   limitations under the License.
+//
+//-----------------------------------------------------------------------------
+
+#include <Math/aabbtree.h>
+#include <Math/vec3math.h>
+#include <Logging/logdata.h>
+#include <Wrappers/tut.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <vector>
+
+namespace tut {
+struct AABBTreeTestData  //
+{
+    struct TestBox {
+        vec3 min;
+        vec3 max;
+        int proxy;
+    };
+    std::vector<TestBox> boxes;
+    AABBTree tree;
+
+    static float RandomFloat(float range) {
+        return (rand() / (float)RAND_MAX * 2.0f - 1.0f) * range;
+    }
+
+    void PlaceBox(TestBox& box) {
+        box.min = vec3(RandomFloat(200.0f), RandomFloat(10.0f), RandomFloat(200.0f));
+        box.max = box.min + vec3(1.0f) + vec3(fabsf(RandomFloat(8.0f)), fabsf(RandomFloat(4.0f)), fabsf(RandomFloat(8.0f)));
+    }
+
+    // A level sized scatter of objects, spread out more than up
+    AABBTreeTestData() {
+        srand(4321);
+        boxes.resize(5000);
+        for (size_t i = 0; i < boxes.size(); i++) {
+            PlaceBox(boxes[i]);
+            boxes[i].proxy = tree.CreateProxy(boxes[i].min, boxes[i].max, &boxes[i]);
+        }
+    }
+
+    static bool SegmentHitsBox(const vec3& start, const vec3& end, const vec3& min, const vec3& max, float* entry) {
+        float t_min = 0.0f, t_max = 1.0f;
+        for (int i = 0; i < 3; i++) {
+            float dir = end[i] - start[i];
+            if (dir == 0.0f) {
+                if (start[i] < min[i] || start[i] > max[i]) {
+                    return false;
+                }
+                continue;
+            }
+            float t1 = (min[i] - start[i]) / dir;
+            float t2 = (max[i] - start[i]) / dir;
+            t_min = std::max(t_min, std::min(t1, t2));
+            t_max = std::min(t_max, std::max(t1, t2));
+        }
+        *entry = t_min;
+        return t_min <= t_max;
+    }
+};
+
+typedef test_group<AABBTreeTestData> tg;
+tg test_group_aabb_tree("AABB tree");
+
+typedef tg::object aabb_tree_test;
+
+// Collects every box the segment really crosses, and counts how many leaves were visited to find them
+class CollectCallback : public AABBTreeRayCallback {
+   public:
+    vec3 start, end;
+    std::vector<void*> hits;
+    int visited;
+
+    CollectCallback(const vec3& start, const vec3& end) : start(start), end(end), visited(0) {}
+
+    float Process(void* user_data, float max_fraction) override {
+        visited++;
+        AABBTreeTestData::TestBox* box = (AABBTreeTestData::TestBox*)user_data;
+        float entry;
+        if (AABBTreeTestData::SegmentHitsBox(start, end, box->min, box->max, &entry)) {
+            hits.push_back(box);
+        }
+        return max_fraction;
+    }
+};
+
+// Stops at the box the segment enters first
+class ClosestCallback : public CollectCallback {
+   public:
+    float closest;
+
+    ClosestCallback(const vec3& start, const vec3& end) : CollectCallback(start, end), closest(1.0f) {}
+
+    float Process(void* user_data, float max_fraction) override {
+        visited++;
+        AABBTreeTestData::TestBox* box = (AABBTreeTestData::TestBox*)user_data;
+        float entry;
+        if (AABBTreeTestData::SegmentHitsBox(start, end, box->min, box->max, &entry) && entry < closest) {
+            closest = entry;
+        }
+        return closest;
+    }
+};
+
+template <>
+template <>
+void aabb_tree_test::test<1>() {
+    ensure_equals("Every box has a proxy", tree.GetNumProxies(), (int)boxes.size());
+    ensure("Tree is balanced", tree.GetHeight() < 40);
+
+    // Move half the boxes and remove a few, then compare against testing every box
+    for (size_t i = 0; i < boxes.size(); i += 2) {
+        PlaceBox(boxes[i]);
+        tree.MoveProxy(boxes[i].proxy, boxes[i].min, boxes[i].max);
+    }
+    for (size_t i = 1; i < boxes.size(); i += 10) {
+        tree.DestroyProxy(boxes[i].proxy);
+        boxes[i].proxy = -1;
+    }
+
+    int total_visited = 0;
+    int total_hits = 0;
+    const int kNumRays = 500;
+    for (int r = 0; r < kNumRays; r++) {
+        // Picking rays from above the level, down to the other side of it
+        vec3 start = vec3(RandomFloat(200.0f), 30.0f, RandomFloat(200.0f));
+        vec3 end = vec3(RandomFloat(200.0f), -30.0f, RandomFloat(200.0f));
+
+        std::vector<void*> brute_hits;
+        float brute_closest = 1.0f;
+        for (auto& box : boxes) {
+            float entry;
+            if (box.proxy != -1 && SegmentHitsBox(start, end, box.min, box.max, &entry)) {
+                brute_hits.push_back(&box);
+                brute_closest = std::min(brute_closest, entry);
+            }
+        }
+
+        CollectCallback all(start, end);
+        tree.RayCast(start, end, &all);
+        std::sort(all.hits.begin(), all.hits.end());
+        std::sort(brute_hits.begin(), brute_hits.end());
+        ensure("Same boxes hit", all.hits == brute_hits);
+
+        ClosestCallback closest(start, end);
+        tree.RayCast(start, end, &closest);
+        ensure_equals("Same closest box", closest.closest, brute_closest);
+
+        total_visited += closest.visited;
+        total_hits += (int)brute_hits.size();
+    }
+
+    LOGI << "AABB tree: " << tree.GetNumProxies() << " proxies, height " << tree.GetHeight() << ". Closest hit queries visited "
+         << total_visited / (float)kNumRays << " leaves per ray, for " << total_hits / (float)kNumRays << " boxes crossed" << std::endl;
+    ensure("Only boxes near the ray are visited", total_visited < kNumRays * 10);
+}
+}  // namespace tut
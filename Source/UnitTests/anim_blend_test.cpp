@@ -0,0 +1,127 @@
+//-----------------------------------------------------------------------------
+//           Name: anim_blend_test.cpp
+//      Developer: Wolfire Games LLC
+//    Description:
+//        License: Read below
+//-----------------------------------------------------------------------------
+//
+//
+//   Copyright 2022 Wolfire Games LLC
+//
+//   Licensed under the Apache License, Version 2.0 (the "License");
+//   you may not use this file except in compliance with the License.
+//   You may obtain a copy of the License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//   Unless required by applicable law or agreed to in writing, software
+//   distributed under the License is distributed on an "AS IS" BASIS,
+//   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//   See the License for the specific language governing permissions and
+//   limitations under the License.
+//
+//-----------------------------------------------------------------------------
+
+#include <Asset/Asset/animation.h>
+#include <Wrappers/tut.h>
+
+#include <cmath>
+#include <string>
+
+namespace tut {
+struct AnimBlendTestData  //
+{
+    static void AddShapeKey(AnimOutput& anim_output, const std::string& label, float weight) {
+        ShapeKeyBlend shape_key;
+        shape_key.label = label;
+        shape_key.weight = weight;
+        shape_key.weight_weight = 1.0f;
+        anim_output.shape_keys.push_back(shape_key);
+    }
+
+    static void SetPose(AnimOutput& anim_output, float x) {
+        anim_output.matrices.resize(2);
+        anim_output.matrices[0].origin = vec3(x, 0.0f, 0.0f);
+        anim_output.matrices[1].origin = vec3(0.0f, x, 0.0f);
+        anim_output.center_offset = vec3(0.0f);
+        anim_output.rotation = 0.0f;
+        anim_output.delta_offset = vec3(0.0f);
+        anim_output.delta_rotation = 0.0f;
+        anim_output.shape_keys.clear();
+        anim_output.weap_anim_info_map.clear();
+    }
+
+    static bool Near(float a, float b) {
+        return fabsf(a - b) < 0.0001f;
+    }
+};
+
+typedef test_group<AnimBlendTestData> tg;
+tg test_group_anim_blend("Animation blending");
+
+typedef tg::object anim_blend_test;
+
+template <>
+template <>
+void anim_blend_test::test<1>() {
+    AnimOutput a;
+    AnimOutput b;
+    SetPose(a, 0.0f);
+    AddShapeKey(a, "smile", 1.0f);
+    AddShapeKey(a, "blink", 0.0f);
+    SetPose(b, 1.0f);
+    AddShapeKey(b, "frown", 1.0f);
+    AddShapeKey(b, "blink", 1.0f);
+    a.weap_anim_info_map.insert(7)->weight = 1.0f;
+    b.weap_anim_info_map.insert(3)->weight = 1.0f;
+    b.weap_anim_info_map.insert(7)->weight = 0.0f;
+
+    mix_in_place(a, b, 0.25f);
+    ensure("Bones blended", Near(a.matrices[0].origin[0], 0.25f) && Near(a.matrices[1].origin[1], 0.25f));
+    ensure_equals("Shape keys merged", a.shape_keys.size(), 3u);
+    ensure_equals("Shape keys sorted", a.shape_keys[0].label, std::string("blink"));
+    ensure_equals("Shape keys sorted", a.shape_keys[1].label, std::string("frown"));
+    ensure_equals("Shape keys sorted", a.shape_keys[2].label, std::string("smile"));
+    ensure("Shared key blended", Near(a.shape_keys[0].weight, 0.25f) && Near(a.shape_keys[0].weight_weight, 1.0f));
+    ensure("Key only in b faded in", Near(a.shape_keys[1].weight_weight, 0.25f));
+    ensure("Key only in a faded out", Near(a.shape_keys[2].weight_weight, 0.75f));
+    ensure_equals("Items merged", a.weap_anim_info_map.size(), 2);
+    ensure_equals("Items sorted", a.weap_anim_info_map.begin()->item_id, 3);
+    ensure("Item only in b faded in", Near(a.weap_anim_info_map.find(3)->weight, 0.25f));
+    ensure("Shared item blended", Near(a.weap_anim_info_map.find(7)->weight, 0.75f));
+
+    // Layers blend on top of an output that has been used before
+    SetPose(a, 0.0f);
+    AddShapeKey(a, "smile", 1.0f);
+    add_mix_in_place(a, b, 0.5f);
+    ensure("Layer added", Near(a.matrices[0].origin[0], 0.5f));
+    ensure_equals("Layer keys merged", a.shape_keys.size(), 3u);
+    ensure("Layer key added at its weight", Near(a.shape_keys[0].weight_weight, 0.5f));
+    ensure("Base key kept", Near(a.shape_keys[2].weight, 1.0f) && Near(a.shape_keys[2].weight_weight, 1.0f));
+}
+
+template <>
+template <>
+void anim_blend_test::test<2>() {
+    WeapAnimInfoMap weap_anim_info_map;
+    for (int i = WeapAnimInfoMap::kCapacity; i > 0; --i) {
+        ensure("Room for item", weap_anim_info_map.insert(i * 10) != NULL);
+    }
+    ensure("Existing item found when full", weap_anim_info_map.insert(50) != NULL);
+    ensure("No room for more", weap_anim_info_map.insert(5) == NULL);
+    int last_id = 0;
+    for (const auto& entry : weap_anim_info_map) {
+        ensure("Kept in order", entry.item_id > last_id);
+        last_id = entry.item_id;
+    }
+
+    AnimOutputPool pool;
+    AnimOutput* first;
+    {
+        ScopedAnimOutput scoped(&pool);
+        first = &scoped.get();
+    }
+    ScopedAnimOutput again(&pool);
+    ensure("Pool reuses outputs", &again.get() == first);
+}
+}  // namespace tut
@@ -0,0 +1,114 @@
+//-----------------------------------------------------------------------------
+//           Name: asset_lookup_test.cpp
+//      Developer: Wolfire Games LLC
+//    Description:
+//        License: Read below
+//-----------------------------------------------------------------------------
+//
+//
+//   Copyright 2022 Wolfire Games LLC
+//
+//   Licensed under the Apache License, Version 2.0 (the "License");
+//   you may not use this file except in compliance with the License.
+//   You may obtain a copy of the License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//   Unless required by applicable law or agreed to in writing, software
+//   distributed under the License is distributed on an "AS IS" BASIS,
+//   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//   See the License for the specific language governing permissions and
+//   limitations under the License.
+//
+//-----------------------------------------------------------------------------
+
+#include <Asset/assetlookuptable.h>
+#include <Logging/logdata.h>
+#include <Wrappers/tut.h>
+
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+static std::string AssetLookupTestPath(uint32_t i) {
+    char buffer[64];
+    snprintf(buffer, sizeof(buffer), "Data/Textures/test/asset_%u.png", i);
+    return std::string(buffer);
+}
+
+// Nanoseconds per lookup with count assets registered.
+static double MeasureAssetLookup(uint32_t count) {
+    AssetLookupTable table;
+    std::vector<std::string> paths;
+    paths.reserve(count);
+    for (uint32_t i = 0; i < count; i++) {
+        paths.push_back(AssetLookupTestPath(i));
+        table.Insert(TEXTURE_ASSET, 0, paths[i], i + 1, i);
+    }
+
+    const uint32_t kLookups = 200000;
+    uint32_t found = 0;
+    std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+    for (uint32_t i = 0; i < kLookups; i++) {
+        uint32_t index = (i * 2654435761U) % count;
+        found += table.FindSlot(TEXTURE_ASSET, 0, paths[index]) == index;
+        found += table.GetSlot(index + 1) == index;
+    }
+    std::chrono::high_resolution_clock::time_point end = std::chrono::high_resolution_clock::now();
+
+    if (found != kLookups * 2) {
+        return -1.0;
+    }
+    return std::chrono::duration<double, std::nano>(end - start).count() / (double)kLookups;
+}
+
+namespace tut {
+struct AssetLookupTestData  //
+{
+};
+
+typedef test_group<AssetLookupTestData> tg;
+tg test_group_al("Asset lookup table");
+
+typedef tg::object asset_lookup_test;
+
+template <>
+template <>
+void asset_lookup_test::test<1>() {
+    AssetLookupTable table;
+    std::string path = "Data/Models/box.obj";
+
+    ensure_equals("Empty lookup", table.FindSlot(OBJECT_FILE_ASSET, 0, path), AssetLookupTable::kInvalidSlot);
+
+    uint32_t name_id = table.Insert(OBJECT_FILE_ASSET, 0, path, 7, 3);
+    table.Insert(OBJECT_FILE_ASSET, 1, path, 8, 4);
+    table.Insert(TEXTURE_ASSET, 0, path, 9, 5);
+
+    ensure_equals("Exact key", table.FindSlot(OBJECT_FILE_ASSET, 0, path), 3U);
+    ensure_equals("Load flags are part of key", table.FindSlot(OBJECT_FILE_ASSET, 1, path), 4U);
+    ensure_equals("Type is part of key", table.FindSlot(TEXTURE_ASSET, 0, path), 5U);
+    ensure_equals("Id to slot", table.GetSlot(8), 4U);
+
+    table.SetSlot(9, 0);
+    ensure_equals("Moved slot", table.FindSlot(TEXTURE_ASSET, 0, path), 0U);
+
+    table.Remove(OBJECT_FILE_ASSET, 0, name_id, 7);
+    ensure_equals("Removed key", table.FindSlot(OBJECT_FILE_ASSET, 0, path), AssetLookupTable::kInvalidSlot);
+    ensure_equals("Removed id", table.GetSlot(7), AssetLookupTable::kInvalidSlot);
+    ensure_equals("Other flags kept", table.FindSlot(OBJECT_FILE_ASSET, 1, path), 4U);
+}
+
+template <>
+template <>
+void asset_lookup_test::test<2>() {
+    // Every asset resolves in a small and a large table. The timings are only logged, lookup cost
+    // should stay flat as the resident asset count grows but wall clock time is too noisy to assert on.
+    double small = MeasureAssetLookup(16384);
+    double large = MeasureAssetLookup(262144);
+
+    ensure("Lookups resolve", small >= 0.0 && large >= 0.0);
+
+    LOGI << "Asset lookup: " << small << "ns with 16384 assets, " << large << "ns with 262144 assets" << std::endl;
+}
+}  // namespace tut
@@ -0,0 +1,125 @@
+//-----------------------------------------------------------------------------
+//           Name: bone_blend_benchmark_test.cpp
+//      Developer: Wolfire Games LLC
+//    Description:
+//        License: Read below
+//-----------------------------------------------------------------------------
+//
+//
+//   Copyright 2022 Wolfire Games LLC
+//
+//   Licensed under the Apache License, Version 2.0 (the "License");
+//   you may not use this file except in compliance with the License.
+//   You may obtain a copy of the License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//   Unless required by applicable law or agreed to in writing, software
+//   distributed under the License is distributed on an "AS IS" BASIS,
+//   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//   See the License for the specific language governing permissions and
+//   limitations under the License.
+//
+//-----------------------------------------------------------------------------
+
+#include <Graphics/bonetransformblend.h>
+#include <Math/vec3math.h>
+#include <Math/enginemath.h>
+#include <Logging/logdata.h>
+#include <Wrappers/tut.h>
+
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <vector>
+
+namespace tut {
+struct BoneBlendBenchmarkTestData  //
+{
+    enum {
+        kNumBones = 62,  // Odd sized on purpose, so the last group is padded
+        kNumPoses = 8,
+        kNumBlends = 4000
+    };
+
+    std::vector<std::vector<BoneTransform> > poses;
+    std::vector<float> physics_weights;
+
+    static float RandomFloat(float range) {
+        return (rand() / (float)RAND_MAX * 2.0f - 1.0f) * range;
+    }
+
+    BoneBlendBenchmarkTestData() {
+        srand(1357);
+        poses.resize(kNumPoses);
+        for (auto& pose : poses) {
+            pose.resize(kNumBones);
+            for (auto& bone : pose) {
+                vec4 axis_angle(normalize(vec3(RandomFloat(1.0f), RandomFloat(1.0f), RandomFloat(1.0f))), RandomFloat(3.0f));
+                bone.rotation = quaternion(axis_angle);
+                bone.origin = vec3(RandomFloat(1.0f), RandomFloat(1.0f), RandomFloat(1.0f));
+            }
+        }
+        for (int i = 0; i < kNumBones - 10; ++i) {
+            physics_weights.push_back((rand() % 3) * 0.5f);
+        }
+    }
+
+    static float Difference(const BoneTransform& a, const BoneTransform& b) {
+        float diff = distance(a.origin, b.origin);
+        for (int i = 0; i < 4; ++i) {
+            diff = std::max(diff, fabsf(a.rotation[i] - b.rotation[i]));
+        }
+        return diff;
+    }
+};
+
+typedef test_group<BoneBlendBenchmarkTestData> tg;
+tg test_group_bone_blend_benchmark("Bone blend benchmark");
+
+typedef tg::object bone_blend_benchmark_test;
+
+template <>
+template <>
+void bone_blend_benchmark_test::test<1>() {
+    // Fade-outs overshoot a little, so check weights outside 0 to 1 too
+    float max_difference = 0.0f;
+    for (int i = 0; i < 200; ++i) {
+        const std::vector<BoneTransform>& a = poses[i % kNumPoses];
+        const std::vector<BoneTransform>& b = poses[(i + 1) % kNumPoses];
+        float alpha = -0.5f + i / 100.0f;
+        std::vector<BoneTransform> blended = a;
+        bool weighted = i % 2 == 1;
+        BlendBoneTransforms(&blended[0], &b[0], kNumBones, alpha, weighted ? &physics_weights[0] : NULL, weighted ? physics_weights.size() : 0);
+        for (int j = 0; j < kNumBones; ++j) {
+            float weight = weighted && j < (int)physics_weights.size() ? physics_weights[j] : 1.0f;
+            max_difference = std::max(max_difference, Difference(blended[j], mix(a[j], b[j], alpha * weight)));
+        }
+    }
+    ensure("Close to mix()", max_difference < 0.0001f);
+
+    std::vector<BoneTransform> scalar_pose = poses[0];
+    std::vector<BoneTransform> batch_pose = poses[0];
+    std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i < kNumBlends; ++i) {
+        const std::vector<BoneTransform>& b = poses[i % kNumPoses];
+        for (int j = 0; j < kNumBones; ++j) {
+            scalar_pose[j] = mix(scalar_pose[j], b[j], 0.3f);
+        }
+    }
+    double scalar_ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+    start = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i < kNumBlends; ++i) {
+        BlendBoneTransforms(&batch_pose[0], &poses[i % kNumPoses][0], kNumBones, 0.3f);
+    }
+    double batch_ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+    float drift = 0.0f;
+    for (int j = 0; j < kNumBones; ++j) {
+        drift = std::max(drift, Difference(scalar_pose[j], batch_pose[j]));
+    }
+    ensure("Repeated blends stay close", drift < 0.001f);
+
+    LOGI << kNumBlends << " blends of " << kNumBones << " bones: " << scalar_ms << "ms with mix(), " << batch_ms
+         << "ms with BlendBoneTransforms(), largest difference " << max_difference << std::endl;
+}
+}  // namespace tut
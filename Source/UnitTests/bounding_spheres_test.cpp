@@ -0,0 +1,126 @@
+//-----------------------------------------------------------------------------
+//           Name: bounding_spheres_test.cpp
+//      Developer: Wolfire Games LLC
+//    Description:
+//        License: Read below
+//-----------------------------------------------------------------------------
+//
+//
+//   Copyright 2022 Wolfire Games LLC
+//
+//   Licensed under the Apache License, Version 2.0 (the "License");
+//   you may not use this file except in compliance with the License.
+//   You may obtain a copy of the License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//   Unless required by applicable law or agreed to in writing, software
+//   distributed under the License is distributed on an "AS IS" BASIS,
+//   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//   See the License for the specific language governing permissions and
+//   limitations under the License.
+//
+//-----------------------------------------------------------------------------
+
+
+#include <Math/boundingspheres.h>
+#include <Math/vec3math.h>
+#include <Wrappers/tut.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <vector>
+
+namespace tut {
+struct BoundingSpheresTestData  //
+{
+    std::vector<vec3> centers;
+    std::vector<float> radii;
+    BoundingSphereArray spheres;
+
+    static float RandomFloat(float range) {
+        return (rand() / (float)RAND_MAX * 2.0f - 1.0f) * range;
+    }
+
+    // About as many characters as a big level has, with an odd count so the last group is padded,
+    // and a few without a collision world
+    BoundingSpheresTestData() {
+        srand(2468);
+        for (int i = 0; i < 23; i++) {
+            centers.push_back(vec3(RandomFloat(30.0f), 1.0f + RandomFloat(1.0f), RandomFloat(30.0f)));
+            radii.push_back(i % 7 == 3 ? -1.0f : 0.8f + fabsf(RandomFloat(0.6f)));
+            spheres.Add(centers.back(), radii.back());
+        }
+    }
+
+    bool SegmentTouches(const vec3& start, const vec3& end, float sweep_radius, int index) const {
+        if (radii[index] < 0.0f) {
+            return false;
+        }
+        vec3 dir = end - start;
+        float length_squared = dot(dir, dir);
+        float t = length_squared > 0.0f ? dot(centers[index] - start, dir) / length_squared : 0.0f;
+        t = std::max(0.0f, std::min(1.0f, t));
+        float reach = radii[index] + sweep_radius;
+        return distance_squared(start + dir * t, centers[index]) <= reach * reach;
+    }
+};
+
+typedef test_group<BoundingSpheresTestData> tg;
+tg test_group_bounding_spheres("Bounding spheres");
+
+typedef tg::object bounding_spheres_test;
+
+template <>
+template <>
+void bounding_spheres_test::test<1>() {
+    std::vector<int> hits;
+    int total_hits = 0;
+    for (int i = 0; i < 2000; i++) {
+        vec3 start(RandomFloat(40.0f), 1.0f + RandomFloat(2.0f), RandomFloat(40.0f));
+        // Mostly weapon and particle length segments, some long sight lines and a few points
+        vec3 end = start;
+        if (i % 10 != 0) {
+            float length = i % 3 == 0 ? 40.0f : 3.0f;
+            end += vec3(RandomFloat(length), RandomFloat(1.0f), RandomFloat(length));
+        }
+        float sweep_radius = i % 2 == 0 ? 0.0f : 0.3f;
+
+        hits.clear();
+        spheres.SegmentQuery(start, end, sweep_radius, &hits);
+        std::vector<int> expected;
+        for (int j = 0; j < spheres.size(); j++) {
+            if (SegmentTouches(start, end, sweep_radius, j)) {
+                expected.push_back(j);
+            }
+        }
+        ensure("Query finds the same spheres as testing each one", hits == expected);
+        total_hits += (int)hits.size();
+    }
+    ensure("Some segments touched spheres", total_hits > 0);
+}
+
+template <>
+template <>
+void bounding_spheres_test::test<2>() {
+    // Moving a sphere away, and taking away its collision world
+    std::vector<int> hits;
+    spheres.SegmentQuery(centers[0], centers[0], 0.0f, &hits);
+    ensure("Point at a center touches its sphere", std::find(hits.begin(), hits.end(), 0) != hits.end());
+
+    spheres.Set(0, centers[0] + vec3(1000.0f, 0.0f, 0.0f), radii[0]);
+    hits.clear();
+    spheres.SegmentQuery(centers[0], centers[0], 0.0f, &hits);
+    ensure("Moved sphere is not touched", std::find(hits.begin(), hits.end(), 0) == hits.end());
+
+    spheres.Set(1, centers[1], -1.0f);
+    hits.clear();
+    spheres.SegmentQuery(centers[1], centers[1], 100.0f, &hits);
+    ensure("Sphere with negative radius is never touched", std::find(hits.begin(), hits.end(), 1) == hits.end());
+
+    spheres.Clear();
+    hits.clear();
+    spheres.SegmentQuery(vec3(-100.0f), vec3(100.0f), 1000.0f, &hits);
+    ensure("Cleared array has no spheres", hits.empty() && spheres.size() == 0);
+}
+}  // namespace tut
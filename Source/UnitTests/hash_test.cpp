@@ -0,0 +1,66 @@
+//-----------------------------------------------------------------------------
+//           Name: hash_test.cpp
+//      Developer: Wolfire Games LLC
+//    Description:
+//        License: Read below
+//-----------------------------------------------------------------------------
+//
+//
+//   Copyright 2022 Wolfire Games LLC
+//
+//   Licensed under the Apache License, Version 2.0 (the "License");
+//   you may not use this file except in compliance with the License.
+//   You may obtain a copy of the License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//   Unless required by applicable law or agreed to in writing, software
+//   distributed under the License is distributed on an "AS IS" BASIS,
+//   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//   See the License for the specific language governing permissions and
+//   limitations under the License.
+//
+//-----------------------------------------------------------------------------
+
+#include <Utility/hash.h>
+#include <Wrappers/tut.h>
+
+#include <murmurhash3/MurmurHash3.h>
+
+#include <algorithm>
+#include <cstring>
+
+namespace tut {
+struct HashTestData  //
+{
+};
+
+typedef test_group<HashTestData> tg;
+tg test_group_hash("Hash");
+
+typedef tg::object hash_test;
+
+template <>
+template <>
+void hash_test::test<1>() {
+    unsigned char data[1024];
+    for (int i = 0; i < 1024; i++) {
+        data[i] = (unsigned char)(i * 131 + 7);
+    }
+
+    // Every tail length, fed in chunk sizes that straddle the 16 byte blocks differently.
+    for (int len = 0; len < 200; len++) {
+        uint64_t expected[2];
+        MurmurHash3_x86_128(data, len, 1337, expected);
+
+        for (int chunk = 1; chunk < 40; chunk += 3) {
+            MurmurHashStream stream;
+            for (int offset = 0; offset < len; offset += chunk) {
+                stream.Update(data + offset, std::min(chunk, len - offset));
+            }
+            MurmurHash hash = stream.Finish();
+            ensure("Streaming hash matches MurmurHash3_x86_128", memcmp(hash.hash, expected, sizeof(expected)) == 0);
+        }
+    }
+}
+}  // namespace tut
@@ -0,0 +1,369 @@
+//-----------------------------------------------------------------------------
+//           Name: model_cache_test.cpp
+//      Developer: Wolfire Games LLC
+//    Description:
+//        License: Read below
+//-----------------------------------------------------------------------------
+//
+//
+//   Copyright 2022 Wolfire Games LLC
+//
+//   Licensed under the Apache License, Version 2.0 (the "License");
+//   you may not use this file except in compliance with the License.
+//   You may obtain a copy of the License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//   Unless required by applicable law or agreed to in writing, software
+//   distributed under the License is distributed on an "AS IS" BASIS,
+//   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//   See the License for the specific language governing permissions and
+//   limitations under the License.
+//
+//-----------------------------------------------------------------------------
+
+#include <Graphics/model.h>
+#include <Graphics/modelcache.h>
+#include <Internal/filesystem.h>
+#include <Compat/fileio.h>
+#include <Logging/logdata.h>
+#include <Utility/hash.h>
+#include <Wrappers/tut.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace tut {
+struct ModelCacheTestData  //
+{
+    enum {
+        kNumVertices = 3000,
+        kNumFaces = 1000
+    };
+
+    MurmurHash source_hash;
+    Model original;
+
+    ModelCacheTestData() {
+        source_hash.hash[0] = 0x0123456789abcdefULL;
+        source_hash.hash[1] = 0xfedcba9876543210ULL;
+
+        // Repeating values, so the compressed cache has sections worth compressing.
+        original.ResizeVertices(kNumVertices);
+        original.tex_coords2.resize(kNumVertices * 2);
+        for (int i = 0; i < kNumVertices * 3; i++) {
+            original.vertices[i] = (float)(i % 97) * 0.25f;
+            original.normals[i] = (float)(i % 3 == 1);
+            original.tangents[i] = (float)(i % 3 == 0);
+            original.bitangents[i] = (float)(i % 3 == 2);
+        }
+        for (int i = 0; i < kNumVertices * 2; i++) {
+            original.tex_coords[i] = (float)(i % 64) / 64.0f;
+            original.tex_coords2[i] = (float)(i % 32) / 32.0f;
+        }
+        original.ResizeFaces(kNumFaces);
+        for (int i = 0; i < kNumFaces * 3; i++) {
+            original.faces[i] = i % kNumVertices;
+        }
+        for (int i = 0; i < kNumFaces; i++) {
+            original.face_normals[i] = vec3(0.0f, 1.0f, 0.0f);
+        }
+        original.precollapse_num_vertices = kNumVertices;
+        original.precollapse_vert_reorder.resize(kNumVertices);
+        original.optimize_vert_reorder.resize(kNumVertices);
+        for (int i = 0; i < kNumVertices; i++) {
+            original.precollapse_vert_reorder[i] = i;
+            original.optimize_vert_reorder[i] = kNumVertices - 1 - i;
+        }
+        original.min_coords = vec3(0.0f);
+        original.max_coords = vec3(24.0f);
+        original.center_coords = vec3(12.0f);
+        original.old_center = vec3(1.0f, 2.0f, 3.0f);
+        original.bounding_sphere_origin = vec3(12.0f);
+        original.bounding_sphere_radius = 20.8f;
+        original.texel_density = 0.5f;
+        original.average_triangle_edge_length = 1.5f;
+        original.checksum = 1234;
+    }
+
+    ~ModelCacheTestData() {
+        ModelCache::SetUseCompression(false);
+    }
+
+    static bool SameVec3(const vec3& a, const vec3& b) {
+        return a[0] == b[0] && a[1] == b[1] && a[2] == b[2];
+    }
+
+    static bool SameModel(const Model& a, const Model& b) {
+        return a.vertices == b.vertices && a.normals == b.normals && a.tangents == b.tangents && a.bitangents == b.bitangents &&
+               a.tex_coords == b.tex_coords && a.tex_coords2 == b.tex_coords2 && a.faces == b.faces &&
+               a.face_normals.size() == b.face_normals.size() &&
+               memcmp(&a.face_normals[0], &b.face_normals[0], a.face_normals.size() * sizeof(vec3)) == 0 &&
+               a.precollapse_num_vertices == b.precollapse_num_vertices && a.precollapse_vert_reorder == b.precollapse_vert_reorder &&
+               a.optimize_vert_reorder == b.optimize_vert_reorder && SameVec3(a.bounding_sphere_origin, b.bounding_sphere_origin) &&
+               a.bounding_sphere_radius == b.bounding_sphere_radius && SameVec3(a.min_coords, b.min_coords) && SameVec3(a.max_coords, b.max_coords) &&
+               a.texel_density == b.texel_density && a.average_triangle_edge_length == b.average_triangle_edge_length;
+    }
+
+    static std::vector<char> ReadAll(const char* path) {
+        std::vector<char> data;
+        FILE* file = my_fopen(path, "rb");
+        if (file) {
+            fseek(file, 0, SEEK_END);
+            data.resize(ftell(file));
+            fseek(file, 0, SEEK_SET);
+            if (!data.empty() && fread(&data[0], data.size(), 1, file) != 1) {
+                data.clear();
+            }
+            fclose(file);
+        }
+        return data;
+    }
+
+    static void WriteAll(const char* path, const char* data, size_t size) {
+        FILE* file = my_fopen(path, "wb");
+        if (file) {
+            fwrite(data, 1, size, file);
+            fclose(file);
+        }
+    }
+};
+
+typedef test_group<ModelCacheTestData> tg;
+tg test_group_model_cache("Model cache");
+
+typedef tg::object model_cache_test;
+
+static const char* kCachePath = "model_cache_test/model.cache";
+static const char* kBrokenCachePath = "model_cache_test/broken.cache";
+
+template <>
+template <>
+void model_cache_test::test<1>() {
+    // Round trip, with and without compression.
+    for (int compress = 0; compress < 2; compress++) {
+        ModelCache::SetUseCompression(compress != 0);
+        ensure("Written", original.WriteToCache(kCachePath, source_hash));
+
+        ModelCache cache;
+        ensure("Opened", cache.Open(kCachePath));
+        int num_compressed = 0;
+        for (int i = 0; i < kModelCacheNumSections; i++) {
+            num_compressed += cache.GetHeader().sections[i].compression == kModelCacheZstd;
+        }
+        ensure_equals("Compressed only when asked to", num_compressed > 0, compress != 0);
+        cache.Close();
+
+        Model loaded;
+        ensure("Read", loaded.ReadFromCacheFile(kCachePath, original.checksum, source_hash));
+        ensure("Same model", SameModel(original, loaded));
+    }
+    deletefile(kCachePath);
+}
+
+template <>
+template <>
+void model_cache_test::test<2>() {
+    // Broken or mismatched caches are rejected, not read.
+    ensure("Written", original.WriteToCache(kCachePath, source_hash));
+    std::vector<char> data = ReadAll(kCachePath);
+    ensure("Has sections", data.size() > sizeof(ModelCacheHeader));
+    ModelCache cache;
+    Model loaded;
+
+    WriteAll(kBrokenCachePath, &data[0], data.size() - 1);
+    ensure_not("Truncated section", cache.Open(kBrokenCachePath));
+    WriteAll(kBrokenCachePath, &data[0], sizeof(ModelCacheHeader) / 2);
+    ensure_not("Truncated header", cache.Open(kBrokenCachePath));
+
+    ModelCacheHeader header;
+    memcpy(&header, &data[0], sizeof(header));
+    std::vector<char> broken;
+
+    const int kNumBrokenHeaders = 6;
+    const char* names[kNumBrokenHeaders] = {"Section past the end", "Misaligned section", "Section size past the end",
+                                            "Stored and real size differ", "Wrong magic", "Wrong version"};
+    for (int i = 0; i < kNumBrokenHeaders; i++) {
+        ModelCacheHeader bad = header;
+        switch (i) {
+            case 0:
+                bad.sections[kModelCacheFaces].offset = data.size() + 16;
+                break;
+            case 1:
+                bad.sections[kModelCacheFaces].offset += 4;
+                break;
+            case 2:
+                bad.sections[kModelCacheVertices].stored_size = data.size();
+                bad.sections[kModelCacheVertices].size = data.size();
+                break;
+            case 3:
+                bad.sections[kModelCacheVertices].size += 4;
+                break;
+            case 4:
+                bad.magic[0] = 'X';
+                break;
+            case 5:
+                bad.version = _model_cache_v2_version + 1;
+                break;
+        }
+        broken = data;
+        memcpy(&broken[0], &bad, sizeof(bad));
+        WriteAll(kBrokenCachePath, &broken[0], broken.size());
+        ensure_not(names[i], cache.Open(kBrokenCachePath));
+        ensure_not(names[i], loaded.ReadFromCacheFile(kBrokenCachePath, original.checksum, source_hash));
+    }
+
+    MurmurHash other_hash = source_hash;
+    other_hash.hash[1]++;
+    ensure_not("Source hash mismatch", loaded.ReadFromCacheFile(kCachePath, original.checksum, other_hash));
+    ensure_not("Source checksum mismatch", loaded.ReadFromCacheFile(kCachePath, original.checksum + 1, source_hash));
+
+    deletefile(kCachePath);
+    deletefile(kBrokenCachePath);
+}
+
+template <>
+template <>
+void model_cache_test::test<3>() {
+    // Caches from before the version 2 format are still read with ReadFromFile.
+    FILE* file = my_fopen(kCachePath, "wb");
+    ensure("Opened", file != NULL);
+    fwrite(&original.checksum, sizeof(unsigned short), 1, file);
+    fwrite(&_model_cache_version, sizeof(unsigned short), 1, file);
+    original.WriteToFile(file);
+    fclose(file);
+
+    Model loaded;
+    ensure("Read old format", loaded.ReadFromCacheFile(kCachePath, original.checksum, source_hash));
+    ensure("Same model", SameModel(original, loaded));
+    ensure_not("Old format checksum mismatch", loaded.ReadFromCacheFile(kCachePath, original.checksum + 1, source_hash));
+    deletefile(kCachePath);
+}
+
+// Drops the file from the page cache so the next read comes from disk. Returns false where that isn't supported.
+static bool EvictFromPageCache(const std::string& path) {
+#ifdef __linux__
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    fdatasync(fd);
+    bool ok = posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED) == 0;
+    close(fd);
+    return ok;
+#else
+    return false;
+#endif
+}
+
+static double LoadV1(const std::vector<std::string>& paths, std::vector<Model>& models) {
+    std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+    for (size_t i = 0; i < paths.size(); i++) {
+        FILE* file = my_fopen(paths[i].c_str(), "rb");
+        if (file) {
+            unsigned short header[2];
+            fread(header, sizeof(header), 1, file);
+            models[i].ReadFromFile(file);
+            fclose(file);
+        }
+    }
+    return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+static double LoadV2(const std::vector<std::string>& paths, std::vector<Model>& models) {
+    std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+    ModelCache cache;
+    for (size_t i = 0; i < paths.size(); i++) {
+        if (cache.Open(paths[i].c_str())) {
+            models[i].ReadFromCache(cache);
+        }
+    }
+    return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+template <>
+template <>
+void model_cache_test::test<4>() {
+    // Cold and warm load benchmark of both cache formats over the models in the Data folder.
+    // Slow and needs the game data, so it only runs when asked for.
+    if (getenv("OG_MODEL_CACHE_BENCHMARK") == NULL) {
+        return;
+    }
+
+    std::vector<std::string> manifest;
+    GenerateManifest("Data/Models", manifest);
+    std::vector<std::string> model_paths;
+    for (size_t i = 0; i < manifest.size() && model_paths.size() < 300; i++) {
+        const std::string& name = manifest[i];
+        if (name.size() > 4 && name.compare(name.size() - 4, 4, ".obj") == 0 && name.find("_UV2") == std::string::npos) {
+            model_paths.push_back("Data/Models/" + name);
+        }
+    }
+    ensure("Models in the Data folder of the working directory", !model_paths.empty());
+
+    std::vector<std::string> v1_paths, v2_paths, v2_compressed_paths;
+    std::vector<Model> originals(model_paths.size());
+    char path[kPathSize];
+    for (size_t i = 0; i < model_paths.size(); i++) {
+        originals[i].LoadObj(model_paths[i]);
+
+        snprintf(path, kPathSize, "model_cache_test/model_%d.v1", (int)i);
+        FILE* file = my_fopen(path, "wb");
+        if (file) {
+            fwrite(&originals[i].checksum, sizeof(unsigned short), 1, file);
+            fwrite(&_model_cache_version, sizeof(unsigned short), 1, file);
+            originals[i].WriteToFile(file);
+            fclose(file);
+        }
+        v1_paths.push_back(path);
+
+        snprintf(path, kPathSize, "model_cache_test/model_%d.v2", (int)i);
+        ModelCache::SetUseCompression(false);
+        originals[i].WriteToCache(path, source_hash);
+        v2_paths.push_back(path);
+
+        snprintf(path, kPathSize, "model_cache_test/model_%d.v2z", (int)i);
+        ModelCache::SetUseCompression(true);
+        originals[i].WriteToCache(path, source_hash);
+        v2_compressed_paths.push_back(path);
+    }
+    ModelCache::SetUseCompression(false);
+
+    bool cold = true;
+    for (size_t i = 0; i < model_paths.size(); i++) {
+        cold = EvictFromPageCache(v1_paths[i]) && EvictFromPageCache(v2_paths[i]) && EvictFromPageCache(v2_compressed_paths[i]) && cold;
+    }
+
+    std::vector<Model> v1_models(model_paths.size());
+    std::vector<Model> v2_models(model_paths.size());
+    std::vector<Model> v2_compressed_models(model_paths.size());
+    double v1_cold_ms = LoadV1(v1_paths, v1_models);
+    double v2_cold_ms = LoadV2(v2_paths, v2_models);
+    double v2_compressed_cold_ms = LoadV2(v2_compressed_paths, v2_compressed_models);
+    double v1_warm_ms = LoadV1(v1_paths, v1_models);
+    double v2_warm_ms = LoadV2(v2_paths, v2_models);
+    double v2_compressed_warm_ms = LoadV2(v2_compressed_paths, v2_compressed_models);
+
+    if (cold) {
+        LOGI << "Model cache: " << model_paths.size() << " models, cold load v1 " << v1_cold_ms << "ms, v2 " << v2_cold_ms
+             << "ms, v2 compressed " << v2_compressed_cold_ms << "ms" << std::endl;
+    }
+    LOGI << "Model cache: " << model_paths.size() << " models, warm load v1 " << v1_warm_ms << "ms, v2 " << v2_warm_ms
+         << "ms, v2 compressed " << v2_compressed_warm_ms << "ms" << std::endl;
+
+    for (size_t i = 0; i < model_paths.size(); i++) {
+        deletefile(v1_paths[i].c_str());
+        deletefile(v2_paths[i].c_str());
+        deletefile(v2_compressed_paths[i].c_str());
+    }
+}
+}  // namespace tut
@@ -0,0 +1,123 @@
+//-----------------------------------------------------------------------------
+//           Name: packed_animation_clip_test.cpp
+//      Developer: Wolfire Games LLC
+//    Description:
+//        License: Read below
+//-----------------------------------------------------------------------------
+//
+//
+//   Copyright 2022 Wolfire Games LLC
+//
+//   Licensed under the Apache License, Version 2.0 (the "License");
+//   you may not use this file except in compliance with the License.
+//   You may obtain a copy of the License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//   Unless required by applicable law or agreed to in writing, software
+//   distributed under the License is distributed on an "AS IS" BASIS,
+//   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//   See the License for the specific language governing permissions and
+//   limitations under the License.
+//
+//-----------------------------------------------------------------------------
+
+#include <Asset/Asset/packedanimationclip.h>
+#include <Math/vec3math.h>
+#include <Logging/logdata.h>
+#include <Wrappers/tut.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <vector>
+
+namespace tut {
+struct PackedAnimationClipTestData  //
+{
+    enum {
+        kNumFrames = 40,
+        kNumTracks = 60,
+        kNumWeights = 50
+    };
+
+    std::vector<BoneTransform> transforms;
+    std::vector<float> weights;
+
+    static float RandomFloat(float range) {
+        return (rand() / (float)RAND_MAX * 2.0f - 1.0f) * range;
+    }
+
+    PackedAnimationClipTestData() {
+        srand(2468);
+        transforms.resize(kNumFrames * kNumTracks);
+        weights.resize(kNumFrames * kNumWeights);
+        for (int track = 0; track < kNumTracks; ++track) {
+            vec3 axis = normalize(vec3(RandomFloat(1.0f), RandomFloat(1.0f), RandomFloat(1.0f)));
+            vec3 origin(RandomFloat(1.0f), RandomFloat(1.0f) + 1.0f, RandomFloat(1.0f));
+            float swing = RandomFloat(3.0f);
+            bool still = track % 4 == 0;  // Some bones don't move at all
+            for (int frame = 0; frame < kNumFrames; ++frame) {
+                BoneTransform& transform = transforms[frame * kNumTracks + track];
+                float angle = still ? swing : swing * sinf(frame * 0.3f + track);
+                transform.rotation = quaternion(vec4(axis, angle));
+                if (track % 3 == 1) {
+                    // Either sign is the same rotation, keep whichever the animation had
+                    for (int i = 0; i < 4; ++i) {
+                        transform.rotation[i] *= -1.0f;
+                    }
+                }
+                transform.origin = still ? origin : origin + vec3(sinf(frame * 0.2f), cosf(frame * 0.1f + track), 0.0f);
+            }
+        }
+        for (int track = 0; track < kNumWeights; ++track) {
+            for (int frame = 0; frame < kNumFrames; ++frame) {
+                weights[frame * kNumWeights + track] = track % 2 == 0 ? 1.0f : frame / (float)kNumFrames;
+            }
+        }
+    }
+};
+
+typedef test_group<PackedAnimationClipTestData> tg;
+tg test_group_packed_animation_clip("Packed animation clip");
+
+typedef tg::object packed_animation_clip_test;
+
+template <>
+template <>
+void packed_animation_clip_test::test<1>() {
+    PackedAnimationClip clip;
+    clip.Pack(kNumFrames, kNumTracks, &transforms[0], kNumWeights, &weights[0]);
+    ensure_equals("Frames", clip.num_frames(), (int)kNumFrames);
+
+    float max_rotation_error = 0.0f;
+    float max_origin_error = 0.0f;
+    float max_weight_error = 0.0f;
+    for (int frame = 0; frame < kNumFrames; ++frame) {
+        for (int track = 0; track < kNumTracks; ++track) {
+            const BoneTransform& original = transforms[frame * kNumTracks + track];
+            BoneTransform unpacked = clip.GetTransform(frame, track);
+            for (int i = 0; i < 4; ++i) {
+                max_rotation_error = std::max(max_rotation_error, fabsf(unpacked.rotation[i] - original.rotation[i]));
+            }
+            // Origins move by at most 2 on each axis
+            max_origin_error = std::max(max_origin_error, distance(unpacked.origin, original.origin) / 2.0f);
+            if (track % 4 == 0) {
+                ensure("Still bones are kept exactly", unpacked == original);
+            }
+        }
+        for (int track = 0; track < kNumWeights; ++track) {
+            max_weight_error = std::max(max_weight_error, fabsf(clip.GetWeight(frame, track) - weights[frame * kNumWeights + track]));
+        }
+    }
+    ensure("Rotations within error budget", max_rotation_error <= PackedAnimationClip::kMaxRotationError);
+    ensure("Origins within error budget", max_origin_error <= PackedAnimationClip::kMaxRangeError * sqrtf(3.0f));
+    ensure("Weights within error budget", max_weight_error <= PackedAnimationClip::kMaxRangeError);
+
+    size_t unpacked_bytes = transforms.size() * sizeof(BoneTransform) + weights.size() * sizeof(float);
+    ensure("Less than half the size", clip.GetResidentBytes() * 2 < unpacked_bytes);
+
+    LOGI << "Packed " << unpacked_bytes << " bytes of keyframes into " << clip.GetResidentBytes() << ", largest rotation error "
+         << max_rotation_error << ", origin error " << max_origin_error << ", weight error " << max_weight_error << std::endl;
+}
+}  // namespace tut
@@ -0,0 +1,160 @@
+//-----------------------------------------------------------------------------
+//           Name: ragdoll_benchmark_test.cpp
+//      Developer: Wolfire Games LLC
+//    Description:
+//        License: Read below
+//-----------------------------------------------------------------------------
+//
+//
+//   Copyright 2022 Wolfire Games LLC
+//
+//   Licensed under the Apache License, Version 2.0 (the "License");
+//   you may not use this file except in compliance with the License.
+//   You may obtain a copy of the License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//   Unless required by applicable law or agreed to in writing, software
+//   distributed under the License is distributed on an "AS IS" BASIS,
+//   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//   See the License for the specific language governing permissions and
+//   limitations under the License.
+//
+//-----------------------------------------------------------------------------
+
+#include <Physics/bulletworld.h>
+#include <Physics/bullettaskscheduler.h>
+#include <Threading/worker_pool.h>
+#include <Math/vec3math.h>
+#include <Logging/logdata.h>
+#include <Wrappers/tut.h>
+
+#include <chrono>
+#include <vector>
+
+namespace tut {
+struct RagdollBenchmarkTestData  //
+{
+    enum {
+        kNumRagdolls = 16,
+        kNumSteps = 240
+    };
+
+    // Roughly the bodies and joints Skeleton::CreatePhysicsSkeleton makes for a character
+    struct Ragdoll {
+        std::vector<BulletObject*> bones;
+        std::vector<btTypedConstraint*> joints;
+    };
+
+    static void AddLimb(BulletWorld& world, Ragdoll& ragdoll, BulletObject* parent, const vec3& root, const vec3& mid, const vec3& tip, const vec3& hinge_axis, float swing_limit) {
+        BulletObject* upper = world.CreateCapsule(root, mid, 0.06f, 3.0f);
+        BulletObject* lower = world.CreateCapsule(mid, tip, 0.05f, 2.0f);
+        ragdoll.bones.push_back(upper);
+        ragdoll.bones.push_back(lower);
+        ragdoll.joints.push_back(world.AddBallJoint(parent, upper, root));
+        ragdoll.joints.push_back(world.AddAngleConstraints(upper, parent, root, swing_limit));
+        ragdoll.joints.push_back(world.AddHingeJoint(upper, lower, mid, hinge_axis, 0.0f, 2.5f, NULL));
+    }
+
+    static void CreateRagdoll(BulletWorld& world, Ragdoll& ragdoll, const vec3& pos) {
+        BulletObject* pelvis = world.CreateCapsule(pos + vec3(0.0f, 1.0f, 0.0f), pos + vec3(0.0f, 1.2f, 0.0f), 0.12f, 10.0f);
+        BulletObject* chest = world.CreateCapsule(pos + vec3(0.0f, 1.25f, 0.0f), pos + vec3(0.0f, 1.5f, 0.0f), 0.14f, 15.0f);
+        BulletObject* head = world.CreateCapsule(pos + vec3(0.0f, 1.62f, 0.0f), pos + vec3(0.0f, 1.75f, 0.0f), 0.1f, 4.0f);
+        ragdoll.bones.push_back(pelvis);
+        ragdoll.bones.push_back(chest);
+        ragdoll.bones.push_back(head);
+        ragdoll.joints.push_back(world.AddBallJoint(pelvis, chest, pos + vec3(0.0f, 1.22f, 0.0f)));
+        ragdoll.joints.push_back(world.AddAngleConstraints(chest, pelvis, pos + vec3(0.0f, 1.22f, 0.0f), 0.5f));
+        ragdoll.joints.push_back(world.AddBallJoint(chest, head, pos + vec3(0.0f, 1.56f, 0.0f)));
+        ragdoll.joints.push_back(world.AddAngleConstraints(head, chest, pos + vec3(0.0f, 1.56f, 0.0f), 0.7f));
+        for (int side = -1; side <= 1; side += 2) {
+            AddLimb(world, ragdoll, chest, pos + vec3(side * 0.2f, 1.45f, 0.0f), pos + vec3(side * 0.45f, 1.45f, 0.0f), pos + vec3(side * 0.7f, 1.45f, 0.0f), vec3(0.0f, 0.0f, 1.0f), 1.2f);
+            AddLimb(world, ragdoll, pelvis, pos + vec3(side * 0.1f, 0.98f, 0.0f), pos + vec3(side * 0.1f, 0.55f, 0.0f), pos + vec3(side * 0.1f, 0.1f, 0.0f), vec3(1.0f, 0.0f, 0.0f), 1.0f);
+        }
+        // Give it a shove so it falls over instead of balancing
+        for (auto bone : ragdoll.bones) {
+            bone->SetLinearVelocity(vec3(1.5f, 0.0f, 0.5f));
+        }
+    }
+
+    static void CreateScene(BulletWorld& world, std::vector<Ragdoll>& ragdolls) {
+        world.SetGravity(vec3(0.0f, -9.8f, 0.0f));
+        world.CreatePlane(vec3(0.0f, 1.0f, 0.0f), 0.0f);
+        ragdolls.resize(kNumRagdolls);
+        for (int i = 0; i < kNumRagdolls; i++) {
+            // Some stand on their own, some in pairs that fall onto each other and share an island
+            vec3 pos((i / 2) * 4.0f, 0.0f, (i % 2) * ((i / 2) % 2 ? 0.8f : 4.0f));
+            CreateRagdoll(world, ragdolls[i], pos);
+        }
+    }
+
+    static double Simulate(BulletWorld& world, int num_steps) {
+        std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+        for (int i = 0; i < num_steps; i++) {
+            world.Update(1.0f / 120.0f);
+        }
+        return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+    }
+
+    static void DestroyScene(BulletWorld& world, std::vector<Ragdoll>& ragdolls) {
+        for (auto& ragdoll : ragdolls) {
+            for (auto& joint : ragdoll.joints) {
+                world.RemoveJoint(&joint);
+            }
+        }
+        world.Dispose();
+    }
+};
+
+typedef test_group<RagdollBenchmarkTestData> tg;
+tg test_group_ragdoll_benchmark("Ragdoll benchmark");
+
+typedef tg::object ragdoll_benchmark_test;
+
+template <>
+template <>
+void ragdoll_benchmark_test::test<1>() {
+    WorkerPool::Instance()->SetThreadCount(0);
+    WorkerPoolTaskScheduler::Instance()->Install();
+    ensure("Task scheduler installed", WorkerPoolTaskScheduler::Instance()->IsInstalled());
+
+    BulletWorld single_world;
+    std::vector<Ragdoll> single_ragdolls;
+    single_world.Init(false);
+    CreateScene(single_world, single_ragdolls);
+
+    BulletWorld multi_world;
+    std::vector<Ragdoll> multi_ragdolls;
+    multi_world.Init(true);
+    CreateScene(multi_world, multi_ragdolls);
+
+    // Solving islands separately only changes the order of float operations, which a pile of
+    // ragdolls amplifies over time, so compare the two right after they start falling
+    const int kCompareSteps = 10;
+    double single_ms = Simulate(single_world, kCompareSteps);
+    double multi_ms = Simulate(multi_world, kCompareSteps);
+    for (int i = 0; i < kNumRagdolls; i++) {
+        for (int j = 0; j < (int)single_ragdolls[i].bones.size(); j++) {
+            ensure("Same result on more threads", distance(single_ragdolls[i].bones[j]->GetPosition(), multi_ragdolls[i].bones[j]->GetPosition()) < 0.001f);
+        }
+    }
+
+    single_ms += Simulate(single_world, kNumSteps - kCompareSteps);
+    multi_ms += Simulate(multi_world, kNumSteps - kCompareSteps);
+    int num_bones = 0;
+    for (int i = 0; i < kNumRagdolls; i++) {
+        for (int j = 0; j < (int)single_ragdolls[i].bones.size(); j++) {
+            ensure("Ragdoll stayed above the floor", single_ragdolls[i].bones[j]->GetPosition()[1] > -0.1f);
+            ensure("Ragdoll stayed above the floor on more threads", multi_ragdolls[i].bones[j]->GetPosition()[1] > -0.1f);
+            ++num_bones;
+        }
+    }
+
+    LOGI << kNumRagdolls << " ragdolls (" << num_bones << " bodies, " << single_world.dynamics_world_->getNumConstraints()
+         << " joints), " << kNumSteps << " steps: " << single_ms << "ms single threaded, " << multi_ms << "ms on "
+         << WorkerPoolTaskScheduler::Instance()->getNumThreads() << " threads" << std::endl;
+
+    DestroyScene(single_world, single_ragdolls);
+    DestroyScene(multi_world, multi_ragdolls);
+}
+}  // namespace tut
@@ -0,0 +1,127 @@
+//-----------------------------------------------------------------------------
+//           Name: ray_batch_test.cpp
+//      Developer: Wolfire Games LLC
+//    Description:
+//        License: Read below
+//-----------------------------------------------------------------------------
+//
+//
+//   Copyright 2022 Wolfire Games LLC
+//
+//   Licensed under the Apache License, Version 2.0 (the "License");
+//   you may not use this file except in compliance with the License.
+//   You may obtain a copy of the License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//   Unless required by applicable law or agreed to in writing, software
+//   distributed under the License is distributed on an "AS IS" BASIS,
+//   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//   See the License for the specific language governing permissions and
+//   limitations under the License.
+//
+//-----------------------------------------------------------------------------
+
+#include <Physics/bulletworld.h>
+#include <Threading/worker_pool.h>
+#include <Math/vec3math.h>
+#include <Logging/logdata.h>
+#include <Wrappers/tut.h>
+
+#include <chrono>
+#include <cstdlib>
+#include <vector>
+
+namespace tut {
+struct RayBatchTestData  //
+{
+    BulletWorld world;
+
+    static float RandomFloat(float range) {
+        return (rand() / (float)RAND_MAX * 2.0f - 1.0f) * range;
+    }
+
+    // A level sized scatter of static boxes on a floor, with some dynamic spheres moving around in it
+    RayBatchTestData() {
+        srand(1234);
+        world.Init();
+        world.CreateBox(vec3(0.0f, -1.0f, 0.0f), vec3(400.0f, 2.0f, 400.0f), BW_STATIC);
+        for (int i = 0; i < 2000; i++) {
+            vec3 size(1.0f + fabsf(RandomFloat(6.0f)), 1.0f + fabsf(RandomFloat(8.0f)), 1.0f + fabsf(RandomFloat(6.0f)));
+            world.CreateBox(vec3(RandomFloat(200.0f), size[1] * 0.5f, RandomFloat(200.0f)), size, BW_STATIC);
+        }
+        for (int i = 0; i < 200; i++) {
+            world.CreateSphere(vec3(RandomFloat(200.0f), 1.0f, RandomFloat(200.0f)), 0.5f, BW_NO_FLAGS);
+        }
+        world.dynamics_world_->setForceUpdateAllAabbs(true);
+        world.UpdateAABB();
+    }
+
+    ~RayBatchTestData() {
+        world.Dispose();
+    }
+};
+
+typedef test_group<RayBatchTestData> tg;
+tg test_group_ray_batch("Ray batch");
+
+typedef tg::object ray_batch_test;
+
+template <>
+template <>
+void ray_batch_test::test<1>() {
+    WorkerPool::Instance()->SetThreadCount(0);
+
+    // Particle and sight line sized rays, some looking for anything and some only for the level
+    const int kNumQueries = 4096;
+    std::vector<RayQuery> queries(kNumQueries);
+    for (int i = 0; i < kNumQueries; i++) {
+        RayQuery& query = queries[i];
+        query.start = vec3(RandomFloat(200.0f), 1.0f + fabsf(RandomFloat(10.0f)), RandomFloat(200.0f));
+        query.end = query.start + vec3(RandomFloat(30.0f), RandomFloat(10.0f), RandomFloat(30.0f));
+        query.radius = 0.0f;
+        query.static_only = (i % 2) == 0;
+    }
+
+    std::vector<RayQueryResult> results(kNumQueries);
+    std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+    world.CheckRayCollisionBatch(&queries[0], kNumQueries, &results[0]);
+    double batch_ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+    std::vector<const btCollisionObject*> single_objects(kNumQueries);
+    std::vector<vec3> single_points(kNumQueries);
+    start = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i < kNumQueries; i++) {
+        single_objects[i] = world.CheckRayCollision(queries[i].start, queries[i].end, &single_points[i], NULL, queries[i].static_only);
+    }
+    double single_ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+    int hits = 0;
+    for (int i = 0; i < kNumQueries; i++) {
+        ensure("Same object hit", results[i].object == single_objects[i]);
+        ensure("Same hit point", distance(results[i].point, single_points[i]) < 0.001f);
+        hits += results[i].object ? 1 : 0;
+    }
+
+    // Swept spheres should stop no later than a ray along the same path
+    for (int i = 0; i < kNumQueries; i++) {
+        queries[i].radius = 0.3f;
+    }
+    std::vector<RayQueryResult> sphere_results(kNumQueries);
+    start = std::chrono::high_resolution_clock::now();
+    world.CheckRayCollisionBatch(&queries[0], kNumQueries, &sphere_results[0]);
+    double sphere_ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+    int sphere_hits = 0;
+    for (int i = 0; i < kNumQueries; i++) {
+        ensure("Sphere stops no later than the ray", sphere_results[i].fraction <= results[i].fraction + 0.001f);
+        if (results[i].object) {
+            ensure("Sphere hits whenever the ray does", sphere_results[i].object != NULL);
+        }
+        sphere_hits += sphere_results[i].object ? 1 : 0;
+    }
+
+    LOGI << kNumQueries << " rays (" << hits << " hits): " << single_ms << "ms one at a time, " << batch_ms << "ms batched on "
+         << WorkerPool::Instance()->GetThreadCount() + 1 << " threads. " << kNumQueries << " swept spheres (" << sphere_hits
+         << " hits): " << sphere_ms << "ms batched" << std::endl;
+}
+}  // namespace tut
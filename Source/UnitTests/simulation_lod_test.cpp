@@ -0,0 +1,136 @@
+//-----------------------------------------------------------------------------
+//           Name: simulation_lod_test.cpp
+//      Developer: Wolfire Games LLC
+//    Description:
+//        License: Read below
+//-----------------------------------------------------------------------------
+//
+//
+//   Copyright 2022 Wolfire Games LLC
+//
+//   Licensed under the Apache License, Version 2.0 (the "License");
+//   you may not use this file except in compliance with the License.
+//   You may obtain a copy of the License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//   Unless required by applicable law or agreed to in writing, software
+//   distributed under the License is distributed on an "AS IS" BASIS,
+//   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//   See the License for the specific language governing permissions and
+//   limitations under the License.
+//
+//-----------------------------------------------------------------------------
+
+#include <Physics/bulletworld.h>
+#include <Physics/bulletobject.h>
+#include <Physics/bulletsimulationlod.h>
+#include <Math/vec3math.h>
+#include <Wrappers/tut.h>
+
+#include <vector>
+
+namespace tut {
+struct SimulationLODTestData  //
+{
+    BulletWorld world;
+    BulletWorld reference_world;
+
+    SimulationLODTestData() {
+        world.Init();
+        world.SetGravity(vec3(0.0f, -9.8f, 0.0f));
+        reference_world.Init();
+        reference_world.SetGravity(vec3(0.0f, -9.8f, 0.0f));
+
+        SimulationLODSettings settings;
+        settings.reduced_rate_radius = 40.0f;
+        settings.sleep_radius = 80.0f;
+        settings.reduced_rate_interval = 4;
+        world.EnableSimulationLOD(settings);
+        world.simulation_lod_->SetFocus(std::vector<vec3>(1, vec3(0.0f)));
+    }
+
+    ~SimulationLODTestData() {
+        world.Dispose();
+        reference_world.Dispose();
+    }
+
+    static BulletObject* Throw(BulletWorld& bullet_world, const vec3& pos) {
+        BulletObject* ball = bullet_world.CreateSphere(pos, 0.5f, BW_NO_FLAGS);
+        ball->SetLinearVelocity(vec3(3.0f, 0.0f, 0.0f));
+        ball->SetAngularVelocity(vec3(0.0f, 0.0f, 2.0f));
+        return ball;
+    }
+
+    void Update(int frames) {
+        for (int i = 0; i < frames; i++) {
+            world.Update(1.0f / 120.0f);
+            reference_world.Update(1.0f / 120.0f);
+        }
+    }
+};
+
+typedef test_group<SimulationLODTestData> tg;
+tg test_group_simulation_lod("Simulation LOD");
+
+typedef tg::object simulation_lod_test;
+
+template <>
+template <>
+void simulation_lod_test::test<1>() {
+    BulletObject* near_ball = Throw(world, vec3(10.0f, 10.0f, 0.0f));
+    BulletObject* reduced_ball = Throw(world, vec3(50.0f, 10.0f, 0.0f));
+    BulletObject* asleep_ball = Throw(world, vec3(100.0f, 10.0f, 0.0f));
+    BulletObject* reference_ball = Throw(reference_world, vec3(0.0f, 10.0f, 0.0f));
+
+    // The reduced rate ball is stepped on the first of every four frames, so it has caught up after this one
+    Update(121);
+    ensure_equals("Full rate bodies", world.simulation_lod_->GetCount(BulletSimulationLOD::kFullRate), 1);
+    ensure_equals("Reduced rate bodies", world.simulation_lod_->GetCount(BulletSimulationLOD::kReducedRate), 1);
+    ensure_equals("Asleep bodies", world.simulation_lod_->GetCount(BulletSimulationLOD::kAsleep), 1);
+
+    vec3 reference_moved = reference_ball->GetPosition() - vec3(0.0f, 10.0f, 0.0f);
+    ensure("Full rate matches", distance(near_ball->GetPosition() - vec3(10.0f, 10.0f, 0.0f), reference_moved) < 0.0001f);
+    ensure("Reduced rate keeps up", distance(reduced_ball->GetPosition() - vec3(50.0f, 10.0f, 0.0f), reference_moved) < 0.2f);
+    ensure("Reduced rate keeps its velocity", distance(reduced_ball->GetLinearVelocity(), reference_ball->GetLinearVelocity()) < 0.01f);
+    ensure("Reduced rate keeps its spin", distance(reduced_ball->GetAngularVelocity(), reference_ball->GetAngularVelocity()) < 0.01f);
+    ensure("Asleep doesn't move", distance(asleep_ball->GetPosition(), vec3(100.0f, 10.0f, 0.0f)) < 0.0001f);
+    ensure("Asleep isn't active", !asleep_ball->IsActive());
+
+    // Coming back in range picks up where it left off
+    world.simulation_lod_->SetFocus(std::vector<vec3>(1, vec3(100.0f, 0.0f, 0.0f)));
+    Update(1);
+    ensure("Woken keeps its velocity", distance(asleep_ball->GetLinearVelocity(), vec3(3.0f, -9.8f / 120.0f, 0.0f)) < 0.01f);
+    ensure("Woken keeps its spin", distance(asleep_ball->GetAngularVelocity(), vec3(0.0f, 0.0f, 2.0f)) < 0.01f);
+    ensure("Woken moves", asleep_ball->GetPosition()[0] > 100.0f);
+    ensure("Woken is active", asleep_ball->IsActive());
+}
+
+template <>
+template <>
+void simulation_lod_test::test<2>() {
+    // A ragdoll straddling the radius is simulated at the rate of its nearest part
+    BulletObject* inside = world.CreateSphere(vec3(38.0f, 10.0f, 0.0f), 0.5f, BW_NO_FLAGS);
+    BulletObject* outside = world.CreateSphere(vec3(42.0f, 10.0f, 0.0f), 0.5f, BW_NO_FLAGS);
+    inside->NoSleep();
+    outside->NoSleep();
+    btTypedConstraint* joint = world.AddBallJoint(inside, outside, vec3(40.0f, 10.0f, 0.0f));
+
+    Update(10);
+    ensure_equals("Joined bodies share a level", world.simulation_lod_->GetCount(BulletSimulationLOD::kFullRate), 2);
+    ensure("Inside falls", inside->GetPosition()[1] < 10.0f);
+    ensure("Outside falls along", outside->GetPosition()[1] < 10.0f);
+
+    // Once all of it is out of range it is held, and still held when it comes back
+    world.simulation_lod_->SetFocus(std::vector<vec3>(1, vec3(-10.0f, 0.0f, 0.0f)));
+    Update(2);
+    ensure_equals("Joined bodies share a level", world.simulation_lod_->GetCount(BulletSimulationLOD::kReducedRate), 2);
+    ensure("Held bodies can't sleep", inside->lod.saved_activation_state == DISABLE_DEACTIVATION);
+    world.simulation_lod_->SetFocus(std::vector<vec3>(1, vec3(0.0f)));
+    Update(1);
+    ensure("Released bodies still can't sleep", inside->body->getActivationState() == DISABLE_DEACTIVATION);
+    ensure("Released bodies still can't sleep", outside->body->getActivationState() == DISABLE_DEACTIVATION);
+
+    world.RemoveJoint(&joint);
+}
+}  // namespace tut
@@ -0,0 +1,224 @@
+//-----------------------------------------------------------------------------
+//           Name: triangle_bvh_test.cpp
+//      Developer: Wolfire Games LLC
+//    Description:
+//        License: Read below
+//-----------------------------------------------------------------------------
+//
+//
+//   Copyright 2022 Wolfire Games LLC
+//
+//   Licensed under the Apache License, Version 2.0 (the "License");
+//   you may not use this file except in compliance with the License.
+//   You may obtain a copy of the License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//   Unless required by applicable law or agreed to in writing, software
+//   distributed under the License is distributed on an "AS IS" BASIS,
+//   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//   See the License for the specific language governing permissions and
+//   limitations under the License.
+//
+//-----------------------------------------------------------------------------
+
+#include <Math/trianglebvh.h>
+#include <Graphics/model.h>
+#include <Math/vec3math.h>
+#include <Internal/collisiondetection.h>
+#include <Logging/logdata.h>
+#include <Wrappers/tut.h>
+
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <vector>
+
+namespace tut {
+struct TriangleBVHTestData  //
+{
+    std::vector<float> vertices;
+    std::vector<unsigned> faces;
+    std::vector<vec3> face_normals;
+
+    vec3 Vertex(unsigned index) const {
+        return vec3(vertices[index * 3 + 0], vertices[index * 3 + 1], vertices[index * 3 + 2]);
+    }
+
+    // A bumpy sphere, about as hard to ray cast as a detailed rock
+    TriangleBVHTestData() {
+        const int kRings = 125;
+        const int kSegments = 200;
+        for (int r = 0; r <= kRings; r++) {
+            float theta = 3.14159265f * r / kRings;
+            for (int s = 0; s < kSegments; s++) {
+                float phi = 2.0f * 3.14159265f * s / kSegments;
+                float radius = 5.0f + 0.3f * sinf(theta * 17.0f) * cosf(phi * 13.0f);
+                vertices.push_back(radius * sinf(theta) * cosf(phi));
+                vertices.push_back(radius * cosf(theta));
+                vertices.push_back(radius * sinf(theta) * sinf(phi));
+            }
+        }
+        for (int r = 0; r < kRings; r++) {
+            for (int s = 0; s < kSegments; s++) {
+                unsigned a = r * kSegments + s;
+                unsigned b = r * kSegments + (s + 1) % kSegments;
+                unsigned c = a + kSegments;
+                unsigned d = b + kSegments;
+                unsigned tris[6] = {a, c, b, b, c, d};
+                for (int t = 0; t < 6; t += 3) {
+                    vec3 pa = Vertex(tris[t + 0]);
+                    vec3 pb = Vertex(tris[t + 1]);
+                    vec3 pc = Vertex(tris[t + 2]);
+                    vec3 n = cross(pb - pa, pc - pa);
+                    if (length_squared(n) == 0.0f) {
+                        continue;  // Collapsed at the poles
+                    }
+                    faces.insert(faces.end(), tris + t, tris + t + 3);
+                    face_normals.push_back(normalize(n));
+                }
+            }
+        }
+    }
+
+    // The loop Model::lineCheck runs without a hierarchy
+    int BruteForceLineCheck(const vec3& start, const vec3& end, vec3* point) const {
+        int closest = -1;
+        float closest_distance = 0.0f;
+        vec3 segment_end = end;
+        vec3 hit;
+        for (int i = 0, len = (int)faces.size() / 3; i < len; i++) {
+            vec3 pa = Vertex(faces[i * 3 + 0]);
+            vec3 pb = Vertex(faces[i * 3 + 1]);
+            vec3 pc = Vertex(faces[i * 3 + 2]);
+            if (LineFacet(start, segment_end, pa, pb, pc, &hit, face_normals[i])) {
+                float distance = distance_squared(start, hit);
+                if (distance < closest_distance || closest == -1) {
+                    closest_distance = distance;
+                    closest = i;
+                    segment_end = hit;
+                    *point = hit;
+                }
+            }
+        }
+        return closest;
+    }
+};
+
+typedef test_group<TriangleBVHTestData> tg;
+tg test_group_triangle_bvh("Triangle BVH");
+
+typedef tg::object triangle_bvh_test;
+
+static float RandomFloat(float range) {
+    return (rand() / (float)RAND_MAX * 2.0f - 1.0f) * range;
+}
+
+template <>
+template <>
+void triangle_bvh_test::test<1>() {
+    int num_faces = (int)faces.size() / 3;
+    std::chrono::high_resolution_clock::time_point start_time = std::chrono::high_resolution_clock::now();
+    TriangleBVH bvh;
+    bvh.Build(&vertices[0], &faces[0], num_faces);
+    double build_ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start_time).count();
+    ensure_equals("Every face is in a leaf", bvh.GetNumFaces(), num_faces);
+
+    const int kNumRays = 2000;
+    srand(1234);
+    std::vector<vec3> starts, ends;
+    for (int i = 0; i < kNumRays; i++) {
+        // Mix of rays through the middle, grazing rays, segments that stop short and misses
+        starts.push_back(vec3(RandomFloat(10.0f), RandomFloat(10.0f), RandomFloat(10.0f)));
+        ends.push_back(vec3(RandomFloat(10.0f), RandomFloat(10.0f), RandomFloat(10.0f)));
+    }
+    starts.push_back(vec3(0.0f, 20.0f, 0.0f));
+    ends.push_back(vec3(0.0f, -20.0f, 0.0f));
+
+    std::vector<int> brute_faces(starts.size());
+    std::vector<vec3> brute_points(starts.size());
+    start_time = std::chrono::high_resolution_clock::now();
+    for (size_t i = 0; i < starts.size(); i++) {
+        brute_faces[i] = BruteForceLineCheck(starts[i], ends[i], &brute_points[i]);
+    }
+    double brute_ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start_time).count();
+
+    std::vector<int> bvh_faces(starts.size());
+    std::vector<vec3> bvh_points(starts.size());
+    std::vector<vec3> bvh_normals(starts.size());
+    start_time = std::chrono::high_resolution_clock::now();
+    for (size_t i = 0; i < starts.size(); i++) {
+        bvh_faces[i] = bvh.LineCheck(starts[i], ends[i], &vertices[0], &faces[0], &face_normals[0], &bvh_points[i], &bvh_normals[i]);
+    }
+    double bvh_ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start_time).count();
+
+    LOGI << "Triangle BVH: " << num_faces << " faces, " << bvh.nodes.size() << " nodes built in " << build_ms << "ms. "
+         << starts.size() << " line checks took " << brute_ms << "ms brute force, " << bvh_ms << "ms with the BVH" << std::endl;
+
+    int hits = 0;
+    for (size_t i = 0; i < starts.size(); i++) {
+        ensure_equals("Same face", bvh_faces[i], brute_faces[i]);
+        if (brute_faces[i] != -1) {
+            hits++;
+            ensure("Same point", distance(bvh_points[i], brute_points[i]) < 1e-3f);
+            ensure("Face normal", bvh_normals[i] == face_normals[bvh_faces[i]]);
+        }
+    }
+    ensure("Some rays hit", hits > kNumRays / 4);
+}
+
+template <>
+template <>
+void triangle_bvh_test::test<2>() {
+    int num_faces = (int)faces.size() / 3;
+    TriangleBVH bvh;
+    bvh.Build(&vertices[0], &faces[0], num_faces);
+
+    TriangleBVH copy;
+    ensure("Round trip", copy.Assign(&bvh.nodes[0], (int)bvh.nodes.size(), &bvh.triangles[0], (int)bvh.triangles.size(), num_faces));
+    ensure("Wrong face count", !copy.Assign(&bvh.nodes[0], (int)bvh.nodes.size(), &bvh.triangles[0], (int)bvh.triangles.size(), num_faces + 1));
+
+    std::vector<TriangleBVHNode> bad_nodes = bvh.nodes;
+    bad_nodes[0].first = 0;
+    ensure("Child pointing backwards", !copy.Assign(&bad_nodes[0], (int)bad_nodes.size(), &bvh.triangles[0], (int)bvh.triangles.size(), num_faces));
+    ensure("Rejected data is dropped", !copy.IsBuilt());
+}
+
+template <>
+template <>
+void triangle_bvh_test::test<3>() {
+    // Moving the vertices of a model after its BVH was built, like the terrain does after loading.
+    Model model;
+    model.vertices = vertices;
+    model.faces = faces;
+    model.face_normals = face_normals;
+    model.bounding_sphere_origin = vec3(0.0f, -70.0f, 0.0f);
+    model.bounding_sphere_radius = 100.0f;
+
+    vec3 point;
+    ensure("Hit before moving", model.lineCheck(vec3(0.0f, 20.0f, 0.0f), vec3(0.0f, -20.0f, 0.0f), &point) != -1);
+
+    const float kShift = 140.0f;
+    for (size_t i = 1; i < vertices.size(); i += 3) {
+        vertices[i] -= kShift;
+        model.vertices[i] -= kShift;
+    }
+    model.VerticesChanged();
+
+    srand(4321);
+    int hits = 0;
+    for (int i = 0; i < 500; i++) {
+        vec3 start(RandomFloat(10.0f), RandomFloat(10.0f) - kShift, RandomFloat(10.0f));
+        vec3 end(RandomFloat(10.0f), RandomFloat(10.0f) - kShift, RandomFloat(10.0f));
+        vec3 brute_point, model_point;
+        int brute_face = BruteForceLineCheck(start, end, &brute_point);
+        ensure_equals("Same face as brute force", model.lineCheck(start, end, &model_point), brute_face);
+        if (brute_face != -1) {
+            hits++;
+            ensure("Same point as brute force", distance(model_point, brute_point) < 1e-3f);
+        }
+    }
+    ensure("Some rays hit", hits > 0);
+    ensure_equals("Old position is empty", model.lineCheck(vec3(0.0f, 20.0f, 0.0f), vec3(0.0f, -20.0f, 0.0f), &point), -1);
+}
+}  // namespace tut
@@ -0,0 +1,200 @@
+//-----------------------------------------------------------------------------
+//           Name: vfs_index_test.cpp
+//      Developer: Wolfire Games LLC
+//    Description:
+//        License: Read below
+//-----------------------------------------------------------------------------
+//
+//
+//   Copyright 2022 Wolfire Games LLC
+//
+//   Licensed under the Apache License, Version 2.0 (the "License");
+//   you may not use this file except in compliance with the License.
+//   You may obtain a copy of the License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//   Unless required by applicable law or agreed to in writing, software
+//   distributed under the License is distributed on an "AS IS" BASIS,
+//   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//   See the License for the specific language governing permissions and
+//   limitations under the License.
+//
+//-----------------------------------------------------------------------------
+
+#include <Internal/vfsindex.h>
+#include <Internal/filesystem.h>
+#include <Internal/path.h>
+#include <Compat/compat.h>
+#include <Compat/fileio.h>
+#include <Logging/logdata.h>
+#include <Wrappers/tut.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+namespace tut {
+struct VFSIndexTestData  //
+{
+};
+
+typedef test_group<VFSIndexTestData> tg;
+tg test_group_vfs("VFS index");
+
+typedef tg::object vfs_index_test;
+
+template <>
+template <>
+void vfs_index_test::test<1>() {
+    // Startup and lookup benchmark against the Data folder of the working directory,
+    // set up like a level load with a data path behind a list of mods that don't have the files.
+    // Slow and needs the game data, so it only runs when asked for.
+    if (getenv("OG_VFS_INDEX_BENCHMARK") == NULL) {
+        return;
+    }
+
+    std::vector<std::string> manifest;
+    GenerateManifest("Data", manifest);
+    if (manifest.empty()) {
+        LOGW << "No Data folder in the working directory, skipping VFS index benchmark" << std::endl;
+        return;
+    }
+
+    const int kNumMods = 50;
+    VFSIndex index;
+    std::vector<std::string> root_paths;
+    std::vector<int> roots;
+    char root_path[kPathSize];
+    for (int i = 0; i < kNumMods; i++) {
+        snprintf(root_path, kPathSize, "vfs_index_test_mod_%d/", i);
+        root_paths.push_back(root_path);
+        roots.push_back(index.AddRoot(root_path));
+    }
+
+    std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+    root_paths.push_back("./");
+    roots.push_back(index.AddRoot("./"));
+    double index_ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+    std::vector<std::string> paths;
+    for (size_t i = 0; i < manifest.size() && paths.size() < 2000; i++) {
+        paths.push_back("Data/" + manifest[i]);
+    }
+
+    char buf[kPathSize];
+    std::vector<std::string> legacy_results;
+    start = std::chrono::high_resolution_clock::now();
+    for (size_t i = 0; i < paths.size(); i++) {
+        std::string result;
+        for (size_t k = 0; k < root_paths.size(); k++) {
+            AssemblePath(root_paths[k].c_str(), paths[i].c_str(), buf, kPathSize);
+            caseCorrect(buf);
+            if (CheckFileAccess(buf)) {
+                result = buf;
+                break;
+            }
+        }
+        legacy_results.push_back(result);
+    }
+    double legacy_ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+    int found_root;
+    int matches = 0;
+    start = std::chrono::high_resolution_clock::now();
+    for (size_t i = 0; i < paths.size(); i++) {
+        if (index.Find(paths[i].c_str(), &roots[0], (int)roots.size(), buf, kPathSize, 1, &found_root) == 1 && legacy_results[i] == buf) {
+            matches++;
+        }
+    }
+    double indexed_ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+    LOGI << "VFS index: indexed " << manifest.size() << " files in " << index_ms << "ms. " << paths.size() << " lookups behind " << kNumMods << " mods took "
+         << legacy_ms << "ms from the filesystem, " << indexed_ms << "ms from the index" << std::endl;
+
+    ensure_equals("Index resolves the same paths as the filesystem", matches, (int)paths.size());
+
+    std::string upper = paths[0];
+    std::transform(upper.begin(), upper.end(), upper.begin(), ::toupper);
+    ensure_equals("Case insensitive", index.Find(upper.c_str(), &roots[0], (int)roots.size(), buf, kPathSize, 1, &found_root), 1);
+    ensure_equals("Found in data root", found_root, kNumMods);
+
+    index.RemoveRoot(roots[kNumMods]);
+    ensure_equals("Removed root", index.Find(paths[0].c_str(), &roots[0], (int)roots.size(), buf, kPathSize, 1, &found_root), 0);
+}
+
+template <>
+template <>
+void vfs_index_test::test<2>() {
+    // Files created after indexing shadow lower priority roots once added, deleted files stop matching.
+    const char* kModFile = "vfs_index_test_mod/Data/test.txt";
+    const char* kDataFile = "vfs_index_test_data/Data/test.txt";
+    fclose(my_fopen(kDataFile, "w"));
+
+    VFSIndex index;
+    int roots[2];
+    roots[0] = index.AddRoot("vfs_index_test_mod/");
+    roots[1] = index.AddRoot("vfs_index_test_data/");
+
+    char buf[kPathSize];
+    int found_root;
+    ensure_equals("Found in data root", index.Find("Data/test.txt", roots, 2, buf, kPathSize, 1, &found_root), 1);
+    ensure_equals("Data root", found_root, 1);
+
+    fclose(my_fopen(kModFile, "w"));
+    index.AddFile(kModFile);
+    ensure_equals("Found in mod root", index.Find("Data/test.txt", roots, 2, buf, kPathSize, 1, &found_root), 1);
+    ensure_equals("Mod root shadows data root", found_root, 0);
+
+    // deletefile() only tells the shared index.
+    deletefile(kModFile);
+    index.RemoveFile(kModFile);
+    ensure_equals("Deleted file dropped", index.Find("Data/test.txt", roots, 2, buf, kPathSize, 1, &found_root), 1);
+    ensure_equals("Back to data root", found_root, 1);
+
+    deletefile(kDataFile);
+    index.RemoveFile(kDataFile);
+    ensure_equals("Nothing left", index.Find("Data/test.txt", roots, 2, buf, kPathSize, 1, &found_root), 0);
+}
+
+template <>
+template <>
+void vfs_index_test::test<3>() {
+    // Changes made outside the game are picked up by Update() where they can be watched, by Rescan() otherwise.
+    const char* kFile = "vfs_index_test_external/Data/test.txt";
+    const char* kNestedFile = "vfs_index_test_external/Data/New/test.txt";
+    CreateParentDirs(kFile);
+
+    VFSIndex index;
+    int root = index.AddRoot("vfs_index_test_external/");
+
+    char buf[kPathSize];
+    int found_root;
+    ensure_equals("Nothing indexed", index.Find("Data/test.txt", &root, 1, buf, kPathSize, 1, &found_root), 0);
+    ensure_equals("Misses are final when watched", index.IsAuthoritative("Data/test.txt", &root, 1), index.IsWatching());
+
+    fclose(fopen(kFile, "w"));
+    CreateParentDirs(kNestedFile);
+    fclose(fopen(kNestedFile, "w"));
+    if (index.IsWatching()) {
+        index.Update();
+    } else {
+        index.Rescan();
+    }
+    ensure_equals("Created file found", index.Find("Data/test.txt", &root, 1, buf, kPathSize, 1, &found_root), 1);
+    ensure_equals("File in created directory found", index.Find("Data/New/test.txt", &root, 1, buf, kPathSize, 1, &found_root), 1);
+
+    remove(kNestedFile);
+    remove(kFile);
+    if (index.IsWatching()) {
+        index.Update();
+    } else {
+        index.Rescan();
+    }
+    ensure_equals("Deleted file dropped", index.Find("Data/test.txt", &root, 1, buf, kPathSize, 1, &found_root), 0);
+    ensure_equals("Deleted file in directory dropped", index.Find("Data/New/test.txt", &root, 1, buf, kPathSize, 1, &found_root), 0);
+}
+}  // namespace tut
@@ -0,0 +1,201 @@
+//-----------------------------------------------------------------------------
+//           Name: inputrecording.cpp
+//      Developer: Wolfire Games LLC
+//    Description: Records the player input of every game step so a session
+//                 can be played back exactly, e.g. as a benchmark.
+//        License: Read below
+//-----------------------------------------------------------------------------
+//
+//   Copyright 2022 Wolfire Games LLC
+//
+//   Licensed under the Apache License, Version 2.0 (the "License");
+//   you may not use this file except in compliance with the License.
+//   You may obtain a copy of the License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//   Unless required by applicable law or agreed to in writing, software
+//   distributed under the License is distributed on an "AS IS" BASIS,
+//   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//   See the License for the specific language governing permissions and
+//   limitations under the License.
+//
+//-----------------------------------------------------------------------------
+#include "inputrecording.h"
+
+#include <UserInput/input.h>
+#include <Threading/rand.h>
+#include <Compat/fileio.h>
+#include <Logging/logdata.h>
+
+#include <cstdlib>
+#include <ctime>
+#include <iomanip>
+#include <limits>
+#include <sstream>
+
+static const char* kHeader = "input_recording";
+static const int kVersion = 1;
+
+InputRecording::InputRecording() : mode_(kInactive),
+                                   seed_(0),
+                                   step_(0) {
+}
+
+void InputRecording::StartRecording(const std::string& path) {
+    Stop();
+    path_ = path;
+    level_path_.clear();
+    seed_ = (unsigned)time(NULL);
+    step_ = 0;
+    mode_ = kRecording;
+}
+
+bool InputRecording::LoadReplay(const std::string& path) {
+    Stop();
+    std::ifstream file;
+    my_ifstream_open(file, path);
+    if (!file.is_open()) {
+        LOGE << "Unable to open input recording " << path << std::endl;
+        return false;
+    }
+
+    std::string line;
+    std::string header;
+    int version = 0;
+    if (!std::getline(file, line) || !(std::istringstream(line) >> header >> version) || header != kHeader || version != kVersion) {
+        LOGE << path << " is not a version " << kVersion << " input recording" << std::endl;
+        return false;
+    }
+
+    keys_.clear();
+    step_starts_.clear();
+    level_path_.clear();
+    seed_ = 0;
+    int line_number = 1;
+    while (std::getline(file, line)) {
+        ++line_number;
+        std::istringstream ss(line);
+        std::string word;
+        if (!(ss >> word)) {
+            continue;
+        }
+        if (word == "step") {
+            step_starts_.push_back(keys_.size());
+        } else if (word == "level") {
+            ss >> std::ws;
+            std::getline(ss, level_path_);
+        } else if (word == "seed") {
+            ss >> seed_;
+        } else {
+            RecordedKey key;
+            std::istringstream key_ss(line);
+            if (step_starts_.empty() ||
+                !(key_ss >> key.controller_id >> key.state.count >> key.state.depth_count >> key.state.depth >> std::ws) ||
+                !std::getline(key_ss, key.name) || key.name.empty()) {
+                LOGE << "Unexpected line " << line_number << " in input recording " << path << std::endl;
+                keys_.clear();
+                step_starts_.clear();
+                return false;
+            }
+            keys_.push_back(key);
+        }
+    }
+
+    if (level_path_.empty()) {
+        LOGE << "Input recording " << path << " doesn't say which level it was made in" << std::endl;
+        return false;
+    }
+
+    LOGI << "Loaded " << step_starts_.size() << " steps of input in " << level_path_ << " from " << path << std::endl;
+    path_ = path;
+    step_ = 0;
+    mode_ = kReplaying;
+    return true;
+}
+
+void InputRecording::Stop() {
+    if (mode_ == kRecording && output_.is_open()) {
+        output_.close();
+        LOGI << "Recorded " << step_ << " steps of input to " << path_ << std::endl;
+    }
+    mode_ = kInactive;
+}
+
+bool InputRecording::IsReplayFinished() const {
+    return mode_ == kReplaying && step_ >= num_steps();
+}
+
+void InputRecording::Seed(unsigned seed) {
+    // Scripts and most of the engine use rand(), the rest rand_ts()
+    srand(seed);
+    rand_ts_seed(seed);
+}
+
+bool InputRecording::BeginRecording(const std::string& level_path) {
+    my_ofstream_open(output_, path_);
+    if (!output_.is_open()) {
+        LOGE << "Unable to open " << path_ << " for recording input" << std::endl;
+        return false;
+    }
+    level_path_ = level_path;
+    output_ << kHeader << " " << kVersion << "\n";
+    output_ << "level " << level_path_ << "\n";
+    output_ << "seed " << seed_ << "\n";
+    output_ << std::setprecision(std::numeric_limits<float>::max_digits10);
+    LOGI << "Recording input in " << level_path_ << " to " << path_ << std::endl;
+    return true;
+}
+
+void InputRecording::Step(Input* input, const std::string& level_path) {
+    if (mode_ == kRecording) {
+        if (step_ == 0) {
+            if (!BeginRecording(level_path)) {
+                mode_ = kInactive;
+                return;
+            }
+            Seed(seed_);
+        } else if (level_path != level_path_) {
+            LOGW << "Level changed to " << level_path << ", stopping the input recording" << std::endl;
+            Stop();
+            return;
+        }
+        output_ << "step\n";
+        for (int i = 0; PlayerInput* controller = input->GetController(i); ++i) {
+            if (!controller->enabled || controller->remote_controlled) {
+                continue;
+            }
+            for (const auto& key : controller->key_down) {
+                if (key.second.count != 0 || key.second.depth != 0.0f) {
+                    output_ << i << " " << key.second.count << " " << key.second.depth_count << " " << key.second.depth << " " << key.first << "\n";
+                }
+            }
+        }
+        ++step_;
+    } else if (mode_ == kReplaying && !IsReplayFinished()) {
+        if (step_ == 0) {
+            if (level_path != level_path_) {
+                LOGW << "Replaying input recorded in " << level_path_ << " in " << level_path << std::endl;
+            }
+            Seed(seed_);
+        }
+        for (int i = 0; PlayerInput* controller = input->GetController(i); ++i) {
+            if (!controller->enabled || controller->remote_controlled) {
+                continue;
+            }
+            // Keys that aren't down stay in the map, like they would after ProcessController()
+            for (auto& key : controller->key_down) {
+                key.second = KeyState();
+            }
+        }
+        size_t end = step_ + 1 < num_steps() ? step_starts_[step_ + 1] : keys_.size();
+        for (size_t i = step_starts_[step_]; i < end; ++i) {
+            const RecordedKey& key = keys_[i];
+            PlayerInput* controller = input->GetController(key.controller_id);
+            if (controller) {
+                controller->key_down[key.name] = key.state;
+            }
+        }
+        ++step_;
+    }
+}
@@ -0,0 +1,96 @@
+//-----------------------------------------------------------------------------
+//           Name: inputrecording.h
+//      Developer: Wolfire Games LLC
+//    Description: Records the player input of every game step so a session
+//                 can be played back exactly, e.g. as a benchmark.
+//        License: Read below
+//-----------------------------------------------------------------------------
+//
+//   Copyright 2022 Wolfire Games LLC
+//
+//   Licensed under the Apache License, Version 2.0 (the "License");
+//   you may not use this file except in compliance with the License.
+//   You may obtain a copy of the License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//   Unless required by applicable law or agreed to in writing, software
+//   distributed under the License is distributed on an "AS IS" BASIS,
+//   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//   See the License for the specific language governing permissions and
+//   limitations under the License.
+//
+//-----------------------------------------------------------------------------
+#pragma once
+
+#include <UserInput/joystick.h>
+
+#include <fstream>
+#include <string>
+#include <vector>
+
+class Input;
+
+/*
+ * A recording is a text file naming the level it was made in and the seed
+ * the random generators got when the level started, followed by the bound
+ * inputs (PlayerInput::key_down) that were held on each game step:
+ *
+ *   input_recording 1
+ *   level Data/Levels/some_level.xml
+ *   seed 1234
+ *   step
+ *   0 12 12 1 attack
+ *   step
+ *   ...
+ *
+ * Each input line is the controller, KeyState count, depth_count and depth,
+ * and the name last since it runs to the end of the line.
+ */
+class InputRecording {
+   public:
+    enum Mode {
+        kInactive,
+        kRecording,
+        kReplaying
+    };
+
+    InputRecording();
+
+    // Nothing is written until the first game step of a level
+    void StartRecording(const std::string& path);
+    bool LoadReplay(const std::string& path);
+    void Stop();
+
+    // Call after input has been processed on every game step. Writes the state of the
+    // local controllers out, or replaces it with what was recorded when replaying.
+    void Step(Input* input, const std::string& level_path);
+
+    Mode mode() const { return mode_; }
+    bool IsReplayFinished() const;
+    const std::string& level_path() const { return level_path_; }
+    unsigned seed() const { return seed_; }
+    int step() const { return step_; }
+    int num_steps() const { return (int)step_starts_.size(); }
+
+   private:
+    struct RecordedKey {
+        int controller_id;
+        KeyState state;
+        std::string name;
+    };
+
+    static void Seed(unsigned seed);
+    bool BeginRecording(const std::string& level_path);
+
+    Mode mode_;
+    std::string path_;
+    std::string level_path_;
+    unsigned seed_;
+    int step_;
+    std::ofstream output_;
+
+    // The keys of step i are keys_[step_starts_[i]] up to the start of the next one
+    std::vector<RecordedKey> keys_;
+    std::vector<size_t> step_starts_;
+};
@@ -23,13 +23,13 @@
 #include "hash.h"
 
 #include <Internal/filesystem.h>
-
-#include <murmurhash3/MurmurHash3.h>
+#include <Compat/fileio.h>
 
 #include <sstream>
 #include <string>
 #include <iomanip>
 #include <cstring>
+#include <algorithm>
 
 std::string MurmurHash::ToString() {
     std::stringstream ss;
@@ -39,17 +39,131 @@ std::string MurmurHash::ToString() {
     return ss.str();
 }
 
-MurmurHash GetFileHash(const char* file) {
-    std::vector<unsigned char> data = readFile(file);
+static const uint32_t kMurmurFileSeed = 1337;
+
+static inline uint32_t MurmurRotl32(uint32_t x, int8_t r) {
+    return (x << r) | (x >> (32 - r));
+}
+
+static inline uint32_t MurmurFmix32(uint32_t h) {
+    h ^= h >> 16;
+    h *= 0x85ebca6b;
+    h ^= h >> 13;
+    h *= 0xc2b2ae35;
+    h ^= h >> 16;
+    return h;
+}
+
+static const uint32_t kMurmurC1 = 0x239b961b;
+static const uint32_t kMurmurC2 = 0xab0e9789;
+static const uint32_t kMurmurC3 = 0x38b34ae5;
+static const uint32_t kMurmurC4 = 0xa1e38b93;
+
+MurmurHashStream::MurmurHashStream() : tail_len(0), total_len(0) {
+    h[0] = h[1] = h[2] = h[3] = kMurmurFileSeed;
+}
+
+void MurmurHashStream::ProcessBlock(const uint8_t* block) {
+    uint32_t k[4];
+    memcpy(k, block, sizeof(k));
+
+    k[0] *= kMurmurC1; k[0] = MurmurRotl32(k[0], 15); k[0] *= kMurmurC2; h[0] ^= k[0];
+    h[0] = MurmurRotl32(h[0], 19); h[0] += h[1]; h[0] = h[0] * 5 + 0x561ccd1b;
+    k[1] *= kMurmurC2; k[1] = MurmurRotl32(k[1], 16); k[1] *= kMurmurC3; h[1] ^= k[1];
+    h[1] = MurmurRotl32(h[1], 17); h[1] += h[2]; h[1] = h[1] * 5 + 0x0bcaa747;
+    k[2] *= kMurmurC3; k[2] = MurmurRotl32(k[2], 17); k[2] *= kMurmurC4; h[2] ^= k[2];
+    h[2] = MurmurRotl32(h[2], 15); h[2] += h[3]; h[2] = h[2] * 5 + 0x96cd1c35;
+    k[3] *= kMurmurC4; k[3] = MurmurRotl32(k[3], 18); k[3] *= kMurmurC1; h[3] ^= k[3];
+    h[3] = MurmurRotl32(h[3], 13); h[3] += h[0]; h[3] = h[3] * 5 + 0x32ac3b17;
+}
+
+void MurmurHashStream::Update(const void* data, size_t len) {
+    const uint8_t* bytes = (const uint8_t*)data;
+    total_len += len;
+
+    if (tail_len > 0) {
+        size_t fill = std::min(len, 16 - tail_len);
+        memcpy(tail + tail_len, bytes, fill);
+        tail_len += fill;
+        bytes += fill;
+        len -= fill;
+        if (tail_len < 16) {
+            return;
+        }
+        ProcessBlock(tail);
+        tail_len = 0;
+    }
+
+    while (len >= 16) {
+        ProcessBlock(bytes);
+        bytes += 16;
+        len -= 16;
+    }
+
+    memcpy(tail, bytes, len);
+    tail_len = len;
+}
+
+MurmurHash MurmurHashStream::Finish() {
+    uint32_t k[4] = {0, 0, 0, 0};
+    for (size_t i = 0; i < tail_len; i++) {
+        k[i / 4] ^= (uint32_t)tail[i] << ((i % 4) * 8);
+    }
+    // Same order as the tail switch in MurmurHash3_x86_128.
+    if (tail_len > 12) {
+        k[3] *= kMurmurC4; k[3] = MurmurRotl32(k[3], 18); k[3] *= kMurmurC1; h[3] ^= k[3];
+    }
+    if (tail_len > 8) {
+        k[2] *= kMurmurC3; k[2] = MurmurRotl32(k[2], 17); k[2] *= kMurmurC4; h[2] ^= k[2];
+    }
+    if (tail_len > 4) {
+        k[1] *= kMurmurC2; k[1] = MurmurRotl32(k[1], 16); k[1] *= kMurmurC3; h[1] ^= k[1];
+    }
+    if (tail_len > 0) {
+        k[0] *= kMurmurC1; k[0] = MurmurRotl32(k[0], 15); k[0] *= kMurmurC2; h[0] ^= k[0];
+    }
+
+    uint32_t len = (uint32_t)total_len;
+    uint32_t r[4] = {h[0] ^ len, h[1] ^ len, h[2] ^ len, h[3] ^ len};
+
+    r[0] += r[1]; r[0] += r[2]; r[0] += r[3];
+    r[1] += r[0]; r[2] += r[0]; r[3] += r[0];
+
+    r[0] = MurmurFmix32(r[0]);
+    r[1] = MurmurFmix32(r[1]);
+    r[2] = MurmurFmix32(r[2]);
+    r[3] = MurmurFmix32(r[3]);
+
+    r[0] += r[1]; r[0] += r[2]; r[0] += r[3];
+    r[1] += r[0]; r[2] += r[0]; r[3] += r[0];
 
+    MurmurHash hash;
+    memcpy(hash.hash, r, sizeof(hash.hash));
+    return hash;
+}
+
+MurmurHash GetFileHash(const char* file) {
     MurmurHash hash;
     memset(&hash, 0, sizeof(MurmurHash));
 
-    if (data.size() == 0) {
+    FILE* f = my_fopen(file, "rb");
+    if (f == NULL) {
         return hash;
     }
 
-    MurmurHash3_x86_128(&data[0], data.size(), 1337, hash.hash);
+    MurmurHashStream stream;
+    unsigned char buffer[64 * 1024];
+    size_t read;
+    size_t total = 0;
+    while ((read = fread(buffer, 1, sizeof(buffer), f)) > 0) {
+        stream.Update(buffer, read);
+        total += read;
+    }
+    fclose(f);
 
-    return hash;
+    // Empty files hash to zero, as they always have.
+    if (total == 0) {
+        return hash;
+    }
+    return stream.Finish();
 }
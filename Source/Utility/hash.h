@@ -31,4 +31,24 @@ struct MurmurHash {
     std::string ToString();
 };
 
+/*
+ * Incremental MurmurHash3_x86_128 with the seed GetFileHash() uses, so a
+ * file can be hashed in chunks and give the same result as hashing it whole.
+ */
+class MurmurHashStream {
+   public:
+    MurmurHashStream();
+
+    void Update(const void* data, size_t len);
+    MurmurHash Finish();
+
+   private:
+    void ProcessBlock(const uint8_t* block);
+
+    uint32_t h[4];
+    uint8_t tail[16];
+    size_t tail_len;
+    uint64_t total_len;
+};
+
 MurmurHash GetFileHash(const char* file);
@@ -0,0 +1,92 @@
+//-----------------------------------------------------------------------------
+//           Name: reusable_vector.h
+//      Developer: Wolfire Games LLC
+//    Description: Vector that keeps its elements alive when it shrinks
+//        License: Read below
+//-----------------------------------------------------------------------------
+//
+//   Copyright 2022 Wolfire Games LLC
+//
+//   Licensed under the Apache License, Version 2.0 (the "License");
+//   you may not use this file except in compliance with the License.
+//   You may obtain a copy of the License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//   Unless required by applicable law or agreed to in writing, software
+//   distributed under the License is distributed on an "AS IS" BASIS,
+//   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//   See the License for the specific language governing permissions and
+//   limitations under the License.
+//
+//-----------------------------------------------------------------------------
+#pragma once
+
+#include <algorithm>
+#include <vector>
+
+/*
+ * Shrinking a std::vector destroys the elements past the new size, so when
+ * they own memory themselves (strings, other vectors) growing it again has
+ * to allocate all of that anew. This one only ever grows its storage and
+ * keeps track of how much of it is in use, so refilling it every frame
+ * reuses what the elements allocated the last time.
+ *
+ * Elements that come back into use by resize() keep their old values.
+ */
+template <typename T>
+class ReusableVector {
+   public:
+    typedef T value_type;
+    typedef T* iterator;
+    typedef const T* const_iterator;
+
+    ReusableVector() : size_(0) {}
+
+    ReusableVector(const ReusableVector& other) : size_(0) {
+        *this = other;
+    }
+
+    ReusableVector& operator=(const ReusableVector& other) {
+        if (this != &other) {
+            resize(other.size_);
+            std::copy(other.begin(), other.end(), begin());
+        }
+        return *this;
+    }
+
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+
+    void resize(size_t size) {
+        if (size > elements_.size()) {
+            elements_.resize(size);
+        }
+        size_ = size;
+    }
+
+    void clear() { size_ = 0; }
+
+    void push_back(const T& value) {
+        if (size_ < elements_.size()) {
+            elements_[size_] = value;
+        } else {
+            elements_.push_back(value);
+        }
+        ++size_;
+    }
+
+    T& operator[](size_t index) { return elements_[index]; }
+    const T& operator[](size_t index) const { return elements_[index]; }
+    T& back() { return elements_[size_ - 1]; }
+    const T& back() const { return elements_[size_ - 1]; }
+
+    iterator begin() { return elements_.data(); }
+    iterator end() { return elements_.data() + size_; }
+    const_iterator begin() const { return elements_.data(); }
+    const_iterator end() const { return elements_.data() + size_; }
+
+   private:
+    std::vector<T> elements_;
+    size_t size_;
+};
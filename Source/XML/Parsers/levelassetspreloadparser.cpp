@@ -30,6 +30,8 @@
 
 #include <tinyxml.h>
 
+#include <cstdlib>
+
 uint32_t LevelAssetPreloadParser::Load(const std::string& path) {
     TiXmlDocument doc(path.c_str());
     doc.LoadFile();
@@ -57,6 +59,15 @@ uint32_t LevelAssetPreloadParser::Load(const std::string& path) {
 
                 string_flags_to_uint32(&a.load_flags, nullAsEmpty(e->Attribute("load_flags")));
 
+                const char* size = e->Attribute("size");
+                if (size) {
+                    a.size = strtoull(size, NULL, 10);
+                }
+                int load_time_us;
+                if (e->QueryIntAttribute("load_time_us", &load_time_us) == TIXML_SUCCESS) {
+                    a.load_time_us = (uint32_t)load_time_us;
+                }
+
                 assets.push_back(a);
 
                 e = e->NextSiblingElement("Asset");
@@ -67,13 +78,41 @@ uint32_t LevelAssetPreloadParser::Load(const std::string& path) {
 }
 
 bool LevelAssetPreloadParser::Save(const std::string& path) {
-    return false;
+    TiXmlDocument doc;
+    TiXmlDeclaration* decl = new TiXmlDeclaration("2.0", "", "");
+    TiXmlElement* root = new TiXmlElement("Assets");
+
+    for (const auto& asset : assets) {
+        TiXmlElement* e = new TiXmlElement("Asset");
+        e->SetAttribute("asset_type", GetAssetTypeString(asset.asset_type));
+        e->SetAttribute("path", asset.path.c_str());
+        if (asset.all_levels) {
+            e->SetAttribute("all_levels", "true");
+        } else {
+            e->SetAttribute("level_name", asset.level_name.c_str());
+        }
+        char flags[9];
+        flags_to_string(flags, asset.load_flags);
+        e->SetAttribute("load_flags", flags);
+        if (asset.size > 0) {
+            e->SetAttribute("size", std::to_string(asset.size).c_str());
+        }
+        if (asset.load_time_us > 0) {
+            e->SetAttribute("load_time_us", (int)asset.load_time_us);
+        }
+        root->LinkEndChild(e);
+    }
+
+    doc.LinkEndChild(decl);
+    doc.LinkEndChild(root);
+
+    return doc.SaveFile(path.c_str());
 }
 
 void LevelAssetPreloadParser::Clear() {
     assets.clear();
 }
 
-LevelAssetPreloadParser::Asset::Asset() : load_flags(0x0) {
+LevelAssetPreloadParser::Asset::Asset() : all_levels(false), load_flags(0x0), size(0), load_time_us(0) {
     asset_type = UNKNOWN;
 }
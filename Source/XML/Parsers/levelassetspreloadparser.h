@@ -39,6 +39,9 @@ class LevelAssetPreloadParser : public XMLParserBase {
         bool all_levels;
         AssetType asset_type;
         uint32_t load_flags;
+        // Only set in recorded manifests, informational.
+        uint64_t size;
+        uint32_t load_time_us;
     };
 
     std::vector<Asset> assets;